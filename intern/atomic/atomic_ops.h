@@ -87,6 +87,8 @@ ATOMIC_INLINE int32_t atomic_fetch_and_add_int32(int32_t *p, int32_t x);
 ATOMIC_INLINE int32_t atomic_fetch_and_or_int32(int32_t *p, int32_t x);
 ATOMIC_INLINE int32_t atomic_fetch_and_and_int32(int32_t *p, int32_t x);
 
+ATOMIC_INLINE int32_t atomic_load_int32(const int32_t *v);
+
 ATOMIC_INLINE int16_t atomic_fetch_and_or_int16(int16_t *p, int16_t b);
 ATOMIC_INLINE int16_t atomic_fetch_and_and_int16(int16_t *p, int16_t b);
 
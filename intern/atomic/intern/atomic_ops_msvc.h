@@ -162,6 +162,14 @@ ATOMIC_INLINE int32_t atomic_fetch_and_and_int32(int32_t *p, int32_t x)
   return InterlockedAnd((long *)p, x);
 }
 
+ATOMIC_INLINE int32_t atomic_load_int32(const int32_t *v)
+{
+  /* Aligned 32 bit loads are atomic, the barrier keeps the compiler from reordering them. */
+  const int32_t value = *(volatile const int32_t *)v;
+  _ReadWriteBarrier();
+  return value;
+}
+
 /******************************************************************************/
 /* 16-bit operations. */
 
@@ -322,6 +322,11 @@ ATOMIC_INLINE int32_t atomic_fetch_and_and_int32(int32_t *p, int32_t x)
   return __sync_fetch_and_and(p, x);
 }
 
+ATOMIC_INLINE int32_t atomic_load_int32(const int32_t *v)
+{
+  return __atomic_load_n(v, __ATOMIC_SEQ_CST);
+}
+
 #else
 #  error "Missing implementation for 32-bit atomic operations"
 #endif
@@ -557,6 +557,19 @@ TEST(atomic, atomic_fetch_and_and_int32)
   }
 }
 
+TEST(atomic, atomic_load_int32)
+{
+  {
+    const int32_t value = 12;
+    EXPECT_EQ(atomic_load_int32(&value), 12);
+  }
+
+  {
+    const int32_t value = -0x12345678;
+    EXPECT_EQ(atomic_load_int32(&value), -0x12345678);
+  }
+}
+
 /** \} */
 
 /** \name 16 bit signed int atomics
@@ -132,6 +132,11 @@ void evaluateFaceVarying(OpenSubdiv_Evaluator *evaluator,
       face_varying_channel, ptex_face_index, face_u, face_v, face_varying);
 }
 
+size_t getMemoryUsage(OpenSubdiv_Evaluator *evaluator)
+{
+  return evaluator->impl->memory_usage;
+}
+
 void assignFunctionPointers(OpenSubdiv_Evaluator *evaluator)
 {
   evaluator->setCoarsePositions = setCoarsePositions;
@@ -149,6 +154,8 @@ void assignFunctionPointers(OpenSubdiv_Evaluator *evaluator)
   evaluator->evaluateFaceVarying = evaluateFaceVarying;
 
   evaluator->evaluatePatchesLimit = evaluatePatchesLimit;
+
+  evaluator->getMemoryUsage = getMemoryUsage;
 }
 
 }  // namespace
@@ -751,7 +751,7 @@ void CpuEvalOutputAPI::evaluatePatchesLimit(const OpenSubdiv_PatchCoord *patch_c
 }  // namespace blender
 
 OpenSubdiv_EvaluatorImpl::OpenSubdiv_EvaluatorImpl()
-    : eval_output(NULL), patch_map(NULL), patch_table(NULL)
+    : eval_output(NULL), patch_map(NULL), patch_table(NULL), memory_usage(0)
 {
 }
 
@@ -762,6 +762,31 @@ OpenSubdiv_EvaluatorImpl::~OpenSubdiv_EvaluatorImpl()
   delete patch_table;
 }
 
+namespace {
+
+size_t getStencilTableMemoryUsage(const StencilTable *stencil_table)
+{
+  if (stencil_table == NULL) {
+    return 0;
+  }
+  return stencil_table->GetSizes().size() * sizeof(int) +
+         stencil_table->GetOffsets().size() * sizeof(OpenSubdiv::Far::Index) +
+         stencil_table->GetControlIndices().size() * sizeof(OpenSubdiv::Far::Index) +
+         stencil_table->GetWeights().size() * sizeof(float);
+}
+
+size_t getPatchTableMemoryUsage(const PatchTable *patch_table)
+{
+  // Control vertices and parameterization of every patch. The patch map is a
+  // quad-tree with about one node per patch.
+  const size_t num_patches = patch_table->GetNumPatchesTotal();
+  return patch_table->GetPatchControlVerticesTable().size() * sizeof(OpenSubdiv::Far::Index) +
+         num_patches * (sizeof(OpenSubdiv::Far::PatchParam) + sizeof(PatchMap::Handle) +
+                        4 * sizeof(int));
+}
+
+}  // namespace
+
 OpenSubdiv_EvaluatorImpl *openSubdiv_createEvaluatorInternal(
     OpenSubdiv_TopologyRefiner *topology_refiner)
 {
@@ -782,17 +807,11 @@ OpenSubdiv_EvaluatorImpl *openSubdiv_createEvaluatorInternal(
   const bool stencil_generate_offsets = true;
   const bool use_inf_sharp_patch = true;
   // Refine the topology with given settings.
-  // TODO(sergey): What if topology is already refined?
-  if (is_adaptive) {
-    TopologyRefiner::AdaptiveOptions options(level);
-    options.considerFVarChannels = has_face_varying_data;
-    options.useInfSharpPatch = use_inf_sharp_patch;
-    refiner->RefineAdaptive(options);
-  }
-  else {
-    TopologyRefiner::UniformOptions options(level);
-    refiner->RefineUniform(options);
-  }
+  //
+  // NOTE: Keep options in sync with TopologyRefinerImpl::refine(), which is
+  // used when the refinement is done in advance (topology refiner shared by
+  // multiple evaluators).
+  topology_refiner->impl->refine();
   // Generate stencil table to update the bi-cubic patches control vertices
   // after they have been re-posed (both for vertex & varying interpolation).
   //
@@ -866,6 +885,19 @@ OpenSubdiv_EvaluatorImpl *openSubdiv_createEvaluatorInternal(
       all_face_varying_stencils[face_varying_channel] = table;
     }
   }
+  // The evaluator keeps copies of the stencils, of the patch table and buffers
+  // for all vertices.
+  size_t memory_usage = getStencilTableMemoryUsage(vertex_stencils) +
+                        getStencilTableMemoryUsage(varying_stencils) +
+                        2 * getPatchTableMemoryUsage(patch_table);
+  memory_usage += 2 * 3 * sizeof(float) *
+                  size_t(vertex_stencils->GetNumControlVertices() +
+                         vertex_stencils->GetNumStencils());
+  for (const StencilTable *table : all_face_varying_stencils) {
+    memory_usage += getStencilTableMemoryUsage(table) +
+                    2 * sizeof(float) *
+                        size_t(table->GetNumControlVertices() + table->GetNumStencils());
+  }
   // Create OpenSubdiv's CPU side evaluator.
   // TODO(sergey): Make it possible to use different evaluators.
   blender::opensubdiv::CpuEvalOutput *eval_output = new blender::opensubdiv::CpuEvalOutput(
@@ -877,6 +909,7 @@ OpenSubdiv_EvaluatorImpl *openSubdiv_createEvaluatorInternal(
   evaluator_descr->eval_output = new blender::opensubdiv::CpuEvalOutputAPI(eval_output, patch_map);
   evaluator_descr->patch_map = patch_map;
   evaluator_descr->patch_table = patch_table;
+  evaluator_descr->memory_usage = memory_usage;
   // TOOD(sergey): Look into whether we've got duplicated stencils arrays.
   delete vertex_stencils;
   delete varying_stencils;
@@ -146,6 +146,8 @@ struct OpenSubdiv_EvaluatorImpl {
   blender::opensubdiv::CpuEvalOutputAPI *eval_output;
   const OpenSubdiv::Far::PatchMap *patch_map;
   const OpenSubdiv::Far::PatchTable *patch_table;
+  // Approximate size in bytes of all the above.
+  size_t memory_usage;
 
   MEM_CXX_CLASS_ALLOC_FUNCS("OpenSubdiv_EvaluatorImpl");
 };
@@ -194,6 +194,22 @@ const int *getFaceFVarValueIndices(const struct OpenSubdiv_TopologyRefiner *topo
   return &base_level.GetFaceFVarValues(face_index, channel)[0];
 }
 
+size_t getMemoryUsage(const struct OpenSubdiv_TopologyRefiner *topology_refiner)
+{
+  const OpenSubdiv::Far::TopologyRefiner *refiner = getOSDTopologyRefiner(topology_refiner);
+  size_t memory_usage = 0;
+  for (int level_index = 0; level_index < refiner->GetNumLevels(); ++level_index) {
+    const OpenSubdiv::Far::TopologyLevel &level = refiner->GetLevel(level_index);
+    // Face and edge relations are stored in both directions, with counts and
+    // offsets for the variable sized ones.
+    memory_usage += sizeof(int) * (6 * size_t(level.GetNumFaceVertices()) +
+                                   6 * size_t(level.GetNumEdges()) +
+                                   4 * size_t(level.GetNumVertices()) +
+                                   2 * size_t(level.GetNumFaces()));
+  }
+  return memory_usage;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Internal helpers.
 
@@ -221,6 +237,8 @@ void assignFunctionPointers(OpenSubdiv_TopologyRefiner *topology_refiner)
   topology_refiner->getFVarLinearInterpolation = getFVarLinearInterpolation;
   topology_refiner->getNumFVarValues = getNumFVarValues;
   topology_refiner->getFaceFVarValueIndices = getFaceFVarValueIndices;
+  // Statistics.
+  topology_refiner->getMemoryUsage = getMemoryUsage;
 }
 
 OpenSubdiv_TopologyRefiner *allocateTopologyRefiner()
@@ -255,6 +273,11 @@ void openSubdiv_deleteTopologyRefiner(OpenSubdiv_TopologyRefiner *topology_refin
   OBJECT_GUARDED_DELETE(topology_refiner, OpenSubdiv_TopologyRefiner);
 }
 
+void openSubdiv_topologyRefinerRefine(OpenSubdiv_TopologyRefiner *topology_refiner)
+{
+  topology_refiner->impl->refine();
+}
+
 bool openSubdiv_topologyRefinerCompareWithConverter(
     const OpenSubdiv_TopologyRefiner *topology_refiner, const OpenSubdiv_Converter *converter)
 {
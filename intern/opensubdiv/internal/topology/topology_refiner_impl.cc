@@ -21,7 +21,7 @@
 namespace blender {
 namespace opensubdiv {
 
-TopologyRefinerImpl::TopologyRefinerImpl() : topology_refiner(nullptr)
+TopologyRefinerImpl::TopologyRefinerImpl() : topology_refiner(nullptr), is_refined(false)
 {
 }
 
@@ -30,5 +30,27 @@ TopologyRefinerImpl::~TopologyRefinerImpl()
   delete topology_refiner;
 }
 
+void TopologyRefinerImpl::refine()
+{
+  using OpenSubdiv::Far::TopologyRefiner;
+  // NOTE: The number of levels can not be used to tell whether the refinement
+  // is done: refinement to level 0, or adaptive refinement of a regular mesh
+  // leaves a single level.
+  if (is_refined) {
+    return;
+  }
+  if (settings.is_adaptive) {
+    TopologyRefiner::AdaptiveOptions options(settings.level);
+    options.considerFVarChannels = (topology_refiner->GetNumFVarChannels() != 0);
+    options.useInfSharpPatch = true;
+    topology_refiner->RefineAdaptive(options);
+  }
+  else {
+    TopologyRefiner::UniformOptions options(settings.level);
+    topology_refiner->RefineUniform(options);
+  }
+  is_refined = true;
+}
+
 }  // namespace opensubdiv
 }  // namespace blender
@@ -49,8 +49,16 @@ class TopologyRefinerImpl {
   // Covers options, geometry, and geometry tags.
   bool isEqualToConverter(const OpenSubdiv_Converter *converter) const;
 
+  // Refine the topology for the settings it is created for, unless it is
+  // already refined.
+  void refine();
+
   OpenSubdiv::Far::TopologyRefiner *topology_refiner;
 
+  // Set once refine() is done. Only written before the refiner is shared with
+  // other threads, after that refine() does not modify the refiner anymore.
+  bool is_refined;
+
   // Subdivision settingsa this refiner is created for.
   OpenSubdiv_TopologyRefinerSettings settings;
 
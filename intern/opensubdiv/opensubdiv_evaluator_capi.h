@@ -19,6 +19,8 @@
 #ifndef OPENSUBDIV_EVALUATOR_CAPI_H_
 #define OPENSUBDIV_EVALUATOR_CAPI_H_
 
+#include <stddef.h>  // for size_t
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -122,6 +124,12 @@ typedef struct OpenSubdiv_Evaluator {
                                float *dPdu,
                                float *dPdv);
 
+  // Statistics.
+
+  // Approximate size in bytes of the stencils, patches and buffers owned by the
+  // evaluator.
+  size_t (*getMemoryUsage)(struct OpenSubdiv_Evaluator *evaluator);
+
   // Implementation of the evaluator.
   struct OpenSubdiv_EvaluatorImpl *impl;
 } OpenSubdiv_Evaluator;
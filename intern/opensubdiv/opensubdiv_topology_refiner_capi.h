@@ -19,6 +19,7 @@
 #ifndef OPENSUBDIV_TOPOLOGY_REFINER_CAPI_H_
 #define OPENSUBDIV_TOPOLOGY_REFINER_CAPI_H_
 
+#include <stddef.h>  // for size_t
 #include <stdint.h>  // for bool
 
 #include "opensubdiv_capi_type.h"
@@ -126,6 +127,13 @@ typedef struct OpenSubdiv_TopologyRefiner {
                                         const int face_index,
                                         const int channel);
 
+  //////////////////////////////////////////////////////////////////////////////
+  // Statistics.
+
+  // Approximate size in bytes of the topology of all levels, including the ones
+  // created by the refinement done when creating an evaluator.
+  size_t (*getMemoryUsage)(const struct OpenSubdiv_TopologyRefiner *topology_refiner);
+
   //////////////////////////////////////////////////////////////////////////////
   // Internal use.
 
@@ -140,6 +148,12 @@ OpenSubdiv_TopologyRefiner *openSubdiv_createTopologyRefinerFromConverter(
 
 void openSubdiv_deleteTopologyRefiner(OpenSubdiv_TopologyRefiner *topology_refiner);
 
+// Refine the topology for the settings the refiner was created for. Otherwise
+// this is done when creating the first evaluator. After the refinement the
+// topology refiner is not modified anymore, so it can be shared by evaluators
+// which are created from multiple threads.
+void openSubdiv_topologyRefinerRefine(OpenSubdiv_TopologyRefiner *topology_refiner);
+
 // Compare given topology refiner with converter. Returns truth if topology
 // refiner matches given converter, false otherwise.
 //
@@ -387,6 +387,10 @@ class NODE_MT_view(Menu):
         layout.prop(snode, "show_region_toolbar")
         layout.prop(snode, "show_region_ui")
 
+        if snode.tree_type == 'GeometryNodeTree':
+            layout.separator()
+            layout.prop(snode, "show_timings")
+
         layout.separator()
 
         sub = layout.column()
@@ -68,6 +68,11 @@ bool BKE_id_attribute_remove(struct ID *id,
 
 AttributeDomain BKE_id_attribute_domain(struct ID *id, struct CustomDataLayer *layer);
 int BKE_id_attribute_data_length(struct ID *id, struct CustomDataLayer *layer);
+/**
+ * Copy the data of the layer when it is shared with other data-blocks (see #CD_SHARE), so that it
+ * can be modified in place.
+ */
+void BKE_id_attribute_ensure_unshared(struct ID *id, struct CustomDataLayer *layer);
 bool BKE_id_attribute_required(struct ID *id, struct CustomDataLayer *layer);
 bool BKE_id_attribute_rename(struct ID *id,
                              struct CustomDataLayer *layer,
@@ -100,6 +100,8 @@ typedef enum BVHCacheType {
   BVHTREE_FROM_EM_EDGES,
   BVHTREE_FROM_EM_LOOPTRI,
 
+  BVHTREE_FROM_POINTCLOUD,
+
   /* Keep `BVHTREE_MAX_ITEM` as last item. */
   BVHTREE_MAX_ITEM,
 } BVHCacheType;
@@ -256,6 +258,9 @@ typedef struct BVHTreeFromPointCloud {
   BVHTree_NearestPointCallback nearest_callback;
 
   const float (*coords)[3];
+
+  /* Tree is owned by the point cloud runtime cache and must not be freed. */
+  bool cached;
 } BVHTreeFromPointCloud;
 
 BVHTree *BKE_bvhtree_from_pointcloud_get(struct BVHTreeFromPointCloud *data,
@@ -116,6 +116,8 @@ typedef struct bCallbackFuncStore {
   struct bCallbackFuncStore *next, *prev;
   void (*func)(struct Main *, struct PointerRNA **, const int num_pointers, void *arg);
   void *arg;
+  /** Optional, returns false when calling `func` would not do anything. */
+  bool (*poll)(void *arg);
   short alloc;
 } bCallbackFuncStore;
 
@@ -130,6 +132,7 @@ void BKE_callback_exec_id_depsgraph(struct Main *bmain,
                                     struct Depsgraph *depsgraph,
                                     eCbEvent evt);
 void BKE_callback_add(bCallbackFuncStore *funcstore, eCbEvent evt);
+bool BKE_callback_has_handlers(eCbEvent evt);
 
 void BKE_callback_global_init(void);
 void BKE_callback_global_finalize(void);
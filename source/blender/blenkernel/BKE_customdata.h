@@ -74,6 +74,13 @@ typedef enum eCDAllocType {
   CD_REFERENCE = 3,
   /** Do a full copy of all layers, only allowed if source has same number of elements. */
   CD_DUPLICATE = 4,
+  /**
+   * Share the data of the source layers, which are reference counted. The layers are flagged
+   * as referenced, so the data is only copied once it is modified (see
+   * #CustomData_duplicate_referenced_layer). Only layers which have been prepared with
+   * #CustomData_share_layers are shared, other layers are copied.
+   */
+  CD_SHARE = 5,
 } eCDAllocType;
 
 #define CD_TYPE_AS_MASK(_type) (CustomDataMask)((CustomDataMask)1 << (CustomDataMask)(_type))
@@ -148,6 +155,13 @@ bool CustomData_merge(const struct CustomData *source,
                       eCDAllocType alloctype,
                       int totelem);
 
+/* Make the data of the owned layers in the mask reference counted, so that #CD_SHARE copies can
+ * use it without copying. This is done by the owner of the data, because copies are made from
+ * const data, possibly from multiple threads at once. The layers are flagged as referenced, so
+ * writers have to copy them first (see #CustomData_duplicate_referenced_layer), which does not
+ * copy anything when there are no other users. */
+void CustomData_share_layers(struct CustomData *data, CustomDataMask mask, int totelem);
+
 /* Reallocate custom data to a new element count.
  * Only affects on data layers which are owned by the CustomData itself,
  * referenced data is kept unchanged,
@@ -405,6 +419,9 @@ void CustomData_set_layer_stencil_index(struct CustomData *data, int type, int n
 void CustomData_set_layer_flag(struct CustomData *data, int type, int flag);
 void CustomData_clear_layer_flag(struct CustomData *data, int type, int flag);
 
+/* Allocate a block from the pool without initializing the layers. The pool is not thread-safe,
+ * but blocks allocated up-front can be filled from multiple threads. */
+void CustomData_bmesh_alloc_block(struct CustomData *data, void **block);
 void CustomData_bmesh_set_default(struct CustomData *data, void **block);
 void CustomData_bmesh_free_block(struct CustomData *data, void **block);
 void CustomData_bmesh_free_block_data(struct CustomData *data, void *block);
@@ -74,6 +74,22 @@ void BKE_defvert_clear(struct MDeformVert *dvert);
 int BKE_defvert_find_shared(const struct MDeformVert *dvert_a, const struct MDeformVert *dvert_b);
 bool BKE_defvert_is_weight_zero(const struct MDeformVert *dvert, const int defgroup_tot);
 
+/**
+ * Weights of all vertices in compressed sparse row layout: the weights of vertex `i` are
+ * `weights[vert_offsets[i]]` up to (not including) `weights[vert_offsets[i + 1]]`, in the same
+ * order as in its #MDeformVert. Unlike an array of #MDeformVert all weights are stored in one
+ * contiguous array, which is faster to iterate over.
+ */
+typedef struct DeformWeightsCSR {
+  int verts_num;
+  int *vert_offsets;
+  struct MDeformWeight *weights;
+} DeformWeightsCSR;
+
+struct DeformWeightsCSR *BKE_defvert_weights_csr_create(const struct MDeformVert *dvert,
+                                                        int totvert);
+void BKE_defvert_weights_csr_free(struct DeformWeightsCSR *weights_csr);
+
 void BKE_defvert_array_free_elems(struct MDeformVert *dvert, int totvert);
 void BKE_defvert_array_free(struct MDeformVert *dvert, int totvert);
 void BKE_defvert_array_copy(struct MDeformVert *dst, const struct MDeformVert *src, int totvert);
@@ -46,6 +46,11 @@ void geometry_set_instances_attribute_foreach(const GeometrySet &geometry_set,
 void geometry_set_gather_instances(const GeometrySet &geometry_set,
                                    Vector<GeometryInstanceGroup> &r_instance_groups);
 
+void join_instance_groups_mesh(Span<GeometryInstanceGroup> set_groups,
+                               bool convert_points_to_vertices,
+                               GeometrySet &result);
+void join_instance_groups_pointcloud(Span<GeometryInstanceGroup> set_groups, GeometrySet &result);
+
 GeometrySet geometry_set_realize_mesh_for_modifier(const GeometrySet &geometry_set);
 GeometrySet geometry_set_realize_instances(const GeometrySet &geometry_set);
 
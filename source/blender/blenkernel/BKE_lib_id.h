@@ -122,6 +122,13 @@ enum {
   LIB_ID_COPY_CD_REFERENCE = 1 << 20,
   /** Do not copy id->override_library, used by ID datablock override routines. */
   LIB_ID_COPY_NO_LIB_OVERRIDE = 1 << 21,
+  /** Mesh, PointCloud: Share generic attribute layers with the source, they are copied when
+   * modified (see #CD_SHARE). The source has to prepare its layers for sharing first, e.g. with
+   * #BKE_mesh_share_custom_data, other layers are copied. */
+  LIB_ID_COPY_CD_SHARE_ATTRIBUTES = 1 << 22,
+  /** Mesh, PointCloud: Share all geometry layers with the source, like
+   * #LIB_ID_COPY_CD_SHARE_ATTRIBUTES. Used for copy-on-write datablocks. */
+  LIB_ID_COPY_CD_SHARE_GEOMETRY = 1 << 23,
 
   /* *** XXX Hackish/not-so-nice specific behaviors needed for some corner cases. *** */
   /* *** Ideally we should not have those, but we need them for now... *** */
@@ -125,6 +125,10 @@ void BKE_mesh_eval_delete(struct Mesh *mesh_eval);
  * optional referencing original arrays to reduce memory. */
 struct Mesh *BKE_mesh_copy_for_eval(struct Mesh *source, bool reference);
 
+/* Prepare the layers of the mesh that copies with the given `LIB_ID_COPY_CD_SHARE_*` flag share,
+ * see #CustomData_share_layers. Has to be called by the owner of the mesh before copying it. */
+void BKE_mesh_share_custom_data(struct Mesh *mesh, int flag);
+
 /* These functions construct a new Mesh,
  * contrary to BKE_mesh_to_curve_nurblist which modifies ob itself. */
 struct Mesh *BKE_mesh_new_nomain_from_curve(const struct Object *ob);
@@ -314,6 +318,9 @@ void BKE_mesh_calc_normals_poly(struct MVert *mverts,
                                 float (*r_polyNors)[3],
                                 const bool only_face_normals);
 void BKE_mesh_calc_normals(struct Mesh *me);
+void BKE_mesh_normals_tag_dirty(struct Mesh *mesh);
+void BKE_mesh_vert_normal_tag_dirty(struct Mesh *mesh, int vert_index);
+bool BKE_mesh_vert_normals_are_dirty(const struct Mesh *mesh);
 void BKE_mesh_ensure_normals(struct Mesh *me);
 void BKE_mesh_ensure_normals_for_display(struct Mesh *mesh);
 void BKE_mesh_calc_normals_looptri(struct MVert *mverts,
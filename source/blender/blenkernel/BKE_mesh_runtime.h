@@ -26,12 +26,15 @@
 
 //#include "BKE_customdata.h"  /* for CustomDataMask */
 
+#include "BLI_sys_types.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 struct CustomData;
 struct CustomData_MeshMasks;
+struct DeformWeightsCSR;
 struct Depsgraph;
 struct KeyBlock;
 struct MLoop;
@@ -46,11 +49,19 @@ void BKE_mesh_runtime_reset_on_copy(struct Mesh *mesh, const int flag);
 int BKE_mesh_runtime_looptri_len(const struct Mesh *mesh);
 void BKE_mesh_runtime_looptri_recalc(struct Mesh *mesh);
 const struct MLoopTri *BKE_mesh_runtime_looptri_ensure(const struct Mesh *mesh);
+const struct DeformWeightsCSR *BKE_mesh_runtime_deform_weights_ensure(const struct Mesh *mesh);
 bool BKE_mesh_runtime_ensure_edit_data(struct Mesh *mesh);
 bool BKE_mesh_runtime_clear_edit_data(struct Mesh *mesh);
 bool BKE_mesh_runtime_reset_edit_data(struct Mesh *mesh);
 void BKE_mesh_runtime_clear_geometry(struct Mesh *mesh);
 void BKE_mesh_runtime_clear_cache(struct Mesh *mesh);
+/**
+ * Returns a number that identifies the content of the mesh, or zero when it is unknown. Meshes
+ * with the same non-zero version have the same data. Only copies that still reference all layers
+ * of their source (see #LIB_ID_COPY_CD_REFERENCE) have a known version, because meshes owning
+ * their data may be modified in place.
+ */
+uint64_t BKE_mesh_runtime_content_version(const struct Mesh *mesh);
 
 void BKE_mesh_runtime_verttri_from_looptri(struct MVertTri *r_verttri,
                                            const struct MLoop *mloop,
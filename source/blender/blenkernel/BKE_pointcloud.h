@@ -44,6 +44,10 @@ struct BoundBox *BKE_pointcloud_boundbox_get(struct Object *ob);
 void BKE_pointcloud_minmax(const struct PointCloud *pointcloud, float r_min[3], float r_max[3]);
 
 void BKE_pointcloud_update_customdata_pointers(struct PointCloud *pointcloud);
+void BKE_pointcloud_tag_positions_changed(struct PointCloud *pointcloud);
+/* Prepare the layers that copies made with a `LIB_ID_COPY_CD_SHARE_*` flag share, see
+ * #CustomData_share_layers. Has to be called by the owner before copying. */
+void BKE_pointcloud_share_custom_data(struct PointCloud *pointcloud);
 bool BKE_pointcloud_customdata_required(struct PointCloud *pointcloud,
                                         struct CustomDataLayer *layer);
 
@@ -30,6 +30,7 @@ struct AviCodecData;
 struct Collection;
 struct Depsgraph;
 struct GHash;
+struct ID;
 struct Main;
 struct Object;
 struct RenderData;
@@ -160,6 +161,21 @@ void BKE_scene_view_layer_graph_evaluated_ensure(struct Main *bmain,
                                                  struct Scene *scene,
                                                  struct ViewLayer *view_layer);
 
+bool BKE_scene_frames_are_independent(struct Scene *scene);
+
+typedef void (*SceneFrameEvaluatedFn)(struct Depsgraph *depsgraph, float frame, void *user_data);
+void BKE_scene_graph_evaluate_frames(struct Main *bmain,
+                                     struct Scene *scene,
+                                     struct ViewLayer *view_layer,
+                                     struct ID **ids,
+                                     const int num_ids,
+                                     const bool for_render,
+                                     const float *frames,
+                                     const int frames_num,
+                                     int num_depsgraphs,
+                                     SceneFrameEvaluatedFn callback,
+                                     void *user_data);
+
 struct SceneRenderView *BKE_scene_add_render_view(struct Scene *sce, const char *name);
 bool BKE_scene_remove_render_view(struct Scene *scene, struct SceneRenderView *srv);
 
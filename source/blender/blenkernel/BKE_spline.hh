@@ -145,6 +145,15 @@ class Spline {
   blender::Span<blender::float3> evaluated_tangents() const;
   blender::Span<blender::float3> evaluated_normals() const;
 
+  /* Versions of the evaluation of the cached data above that write to the given arrays instead,
+   * used when evaluating many splines at once, see #CurveEval::evaluate. */
+  void calculate_evaluated_lengths(blender::Span<blender::float3> evaluated_positions,
+                                   blender::MutableSpan<float> r_lengths) const;
+  void calculate_evaluated_tangents(blender::Span<blender::float3> evaluated_positions,
+                                    blender::MutableSpan<blender::float3> r_tangents) const;
+  void calculate_evaluated_normals(blender::Span<blender::float3> evaluated_tangents,
+                                   blender::MutableSpan<blender::float3> r_normals) const;
+
   void bounds_min_max(blender::float3 &min, blender::float3 &max, const bool use_evaluated) const;
 
   struct LookupResult {
@@ -170,6 +179,8 @@ class Spline {
   LookupResult lookup_evaluated_length(const float length) const;
 
   blender::Array<float> sample_uniform_index_factors(const int samples_size) const;
+  blender::Array<float> sample_uniform_index_factors(blender::Span<float> evaluated_lengths,
+                                                     const int samples_size) const;
   LookupResult lookup_data_from_index_factor(const float index_factor) const;
 
   void sample_with_index_factors(const blender::fn::GVArray &src,
@@ -206,7 +217,7 @@ class Spline {
   }
 
  protected:
-  virtual void correct_end_tangents() const = 0;
+  virtual void correct_end_tangents(blender::MutableSpan<blender::float3> tangents) const = 0;
   virtual void copy_settings(Spline &dst) const = 0;
   virtual void copy_data(Spline &dst) const = 0;
 
@@ -351,7 +362,7 @@ class BezierSpline final : public Spline {
                                            const float parameter);
 
  private:
-  void correct_end_tangents() const final;
+  void correct_end_tangents(blender::MutableSpan<blender::float3> tangents) const final;
   void copy_settings(Spline &dst) const final;
   void copy_data(Spline &dst) const final;
 };
@@ -467,7 +478,7 @@ class NURBSpline final : public Spline {
   blender::fn::GVArrayPtr interpolate_to_evaluated(const blender::fn::GVArray &src) const final;
 
  protected:
-  void correct_end_tangents() const final;
+  void correct_end_tangents(blender::MutableSpan<blender::float3> tangents) const final;
   void copy_settings(Spline &dst) const final;
   void copy_data(Spline &dst) const final;
 
@@ -517,11 +528,47 @@ class PolySpline final : public Spline {
   blender::fn::GVArrayPtr interpolate_to_evaluated(const blender::fn::GVArray &src) const final;
 
  protected:
-  void correct_end_tangents() const final;
+  void correct_end_tangents(blender::MutableSpan<blender::float3> tangents) const final;
   void copy_settings(Spline &dst) const final;
   void copy_data(Spline &dst) const final;
 };
 
+/**
+ * Evaluated data of all splines in a curve, stored in flat arrays and computed in one parallel
+ * pass by #CurveEval::evaluate. Unlike the caches on every spline, this avoids separate
+ * allocations and locking for every spline, which matters when there are many small splines.
+ */
+struct CurveEvaluatedData {
+  /** Start index of the evaluated points of every spline. The last element is the total size. */
+  blender::Array<int> offsets;
+  blender::Array<blender::float3> positions;
+  /** Only calculated when requested, otherwise empty. */
+  blender::Array<blender::float3> tangents;
+  blender::Array<blender::float3> normals;
+  /**
+   * Accumulated lengths along the evaluated points, like #Spline::evaluated_lengths. The lengths
+   * use the same offsets as the points, so the last value of non-cyclic splines is unused.
+   */
+  blender::Array<float> lengths;
+
+  blender::IndexRange points_range(const int spline_index) const
+  {
+    return blender::IndexRange(offsets[spline_index],
+                               offsets[spline_index + 1] - offsets[spline_index]);
+  }
+
+  blender::Span<float> spline_lengths(const int spline_index, const Spline &spline) const
+  {
+    return lengths.as_span().slice(offsets[spline_index], spline.evaluated_edges_size());
+  }
+
+  float spline_length(const int spline_index, const Spline &spline) const
+  {
+    const blender::Span<float> lengths = this->spline_lengths(spline_index, spline);
+    return lengths.is_empty() ? 0.0f : lengths.last();
+  }
+};
+
 /**
  * A #CurveEval corresponds to the #Curve object data. The name is different for clarity, since
  * more of the data is stored in the splines, but also just to be different than the name in DNA.
@@ -556,6 +603,8 @@ struct CurveEval {
   blender::Array<int> control_point_offsets() const;
   blender::Array<int> evaluated_point_offsets() const;
 
+  CurveEvaluatedData evaluate(const bool calculate_directions) const;
+
   void assert_valid_point_attributes() const;
 };
 
@@ -191,6 +191,10 @@ typedef struct Subdiv {
      * faces created for preceding base faces. */
     int *face_ptex_offset;
   } cache_;
+
+  /* Topology refiner entry in the global cache, shared with all descriptors created for the same
+   * settings and topology. Owns the topology_refiner. */
+  struct SubdivSharedTopologyRefiner *shared_topology_refiner;
 } Subdiv;
 
 /* =================----====--===== MODULE ==========================------== */
@@ -199,6 +203,10 @@ typedef struct Subdiv {
 void BKE_subdiv_init(void);
 void BKE_subdiv_exit(void);
 
+/* Free all idle descriptors which are kept in the global topology cache.
+ * Topology refiners which are shared with live descriptors are freed with the descriptors. */
+void BKE_subdiv_cache_clear(void);
+
 /* ========================== CONVERSION HELPERS ============================ */
 
 /* NOTE: uv_smooth is eSubsurfUVSmooth. */
@@ -245,6 +253,13 @@ Subdiv *BKE_subdiv_update_from_mesh(Subdiv *subdiv,
                                     const SubdivSettings *settings,
                                     const struct Mesh *mesh);
 
+/* Release the descriptor.
+ *
+ * NOTE: Descriptors with a valid topology are moved to a memory-bounded global cache rather than
+ * being destroyed, so that creation of a descriptor for the same settings and topology (next frame
+ * of a geometry nodes evaluation, a topology change which is undone) re-uses the evaluator and only
+ * needs to update coarse positions. The topology refiner is shared by all live descriptors created
+ * for the same settings and topology, and is freed with the last one of them. */
 void BKE_subdiv_free(Subdiv *subdiv);
 
 /* ============================ DISPLACEMENT API ============================ */
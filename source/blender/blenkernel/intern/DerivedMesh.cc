@@ -1880,7 +1880,7 @@ static void mesh_build_extra_data(struct Depsgraph *depsgraph, Object *ob, Mesh
 static void mesh_runtime_check_normals_valid(const Mesh *mesh)
 {
   UNUSED_VARS_NDEBUG(mesh);
-  BLI_assert(!(mesh->runtime.cd_dirty_vert & CD_MASK_NORMAL));
+  BLI_assert(!BKE_mesh_vert_normals_are_dirty(mesh));
   BLI_assert(!(mesh->runtime.cd_dirty_loop & CD_MASK_NORMAL));
   BLI_assert(!(mesh->runtime.cd_dirty_poly & CD_MASK_NORMAL));
 }
@@ -2096,7 +2096,7 @@ Mesh *mesh_get_eval_final(struct Depsgraph *depsgraph,
   }
 
   if (mesh_eval != nullptr) {
-    BLI_assert(!(mesh_eval->runtime.cd_dirty_vert & CD_MASK_NORMAL));
+    BLI_assert(!BKE_mesh_vert_normals_are_dirty(mesh_eval));
   }
   return mesh_eval;
 }
@@ -51,8 +51,10 @@
 #include "BKE_deform.h"
 #include "BKE_editmesh.h"
 #include "BKE_lattice.h"
+#include "BKE_mesh_runtime.h"
 
 #include "DEG_depsgraph_build.h"
+#include "DEG_depsgraph_query.h"
 
 #include "CLG_log.h"
 
@@ -256,6 +258,9 @@ typedef struct ArmatureUserdata {
   const MDeformVert *dverts;
   int dverts_len;
 
+  /** Weights of #dverts in a compact layout, used instead of #dverts when set. */
+  const DeformWeightsCSR *dverts_csr;
+
   bPoseChannel **pchan_from_defbase;
   int defbase_len;
 
@@ -421,6 +426,16 @@ static void armature_vert_task(void *__restrict userdata,
 {
   const ArmatureUserdata *data = userdata;
   const MDeformVert *dvert;
+  if (data->dverts_csr) {
+    /* Wrap the weights, which are stored in the same format as in #MDeformVert. */
+    const int *offsets = data->dverts_csr->vert_offsets;
+    MDeformVert dvert_csr = {
+        .dw = &data->dverts_csr->weights[offsets[i]],
+        .totweight = offsets[i + 1] - offsets[i],
+    };
+    armature_vert_task_with_dvert(data, i, &dvert_csr);
+    return;
+  }
   if (data->use_dverts || data->armature_def_nr != -1) {
     if (data->me_target) {
       BLI_assert(i < data->me_target->totvert);
@@ -479,6 +494,7 @@ static void armature_deform_coords_impl(const Object *ob_arm,
   bArmature *arm = ob_arm->data;
   bPoseChannel **pchan_from_defbase = NULL;
   const MDeformVert *dverts = NULL;
+  const DeformWeightsCSR *dverts_csr = NULL;
   bDeformGroup *dg;
   const bool use_envelope = (deformflag & ARM_DEF_ENVELOPE) != 0;
   const bool use_quaternion = (deformflag & ARM_DEF_QUATERNION) != 0;
@@ -514,6 +530,16 @@ static void armature_deform_coords_impl(const Object *ob_arm,
         if (dverts) {
           dverts_len = me->totvert;
         }
+        /* The weights of the evaluated target mesh are cached in a compact layout on the mesh,
+         * which is kept across frames. Original meshes are skipped since their weights can be
+         * edited in place. Only use them when the deformed mesh still references the same
+         * weights, which is the case unless modifiers before this one changed the topology. */
+        const Mesh *me_weights = me_target ? me_target : me;
+        if (DEG_is_evaluated_id(&me->id) && me_weights->dvert != NULL &&
+            me_weights->dvert == me->dvert &&
+            me_weights->totvert == me->totvert && vert_coords_len <= me->totvert) {
+          dverts_csr = BKE_mesh_runtime_deform_weights_ensure(me);
+        }
       }
     }
     else if (ob_target->type == OB_LATTICE) {
@@ -578,6 +604,7 @@ static void armature_deform_coords_impl(const Object *ob_arm,
       .armature_def_nr = armature_def_nr,
       .dverts = dverts,
       .dverts_len = dverts_len,
+      .dverts_csr = (use_dverts || armature_def_nr != -1) ? dverts_csr : NULL,
       .pchan_from_defbase = pchan_from_defbase,
       .defbase_len = defbase_len,
       .bmesh =
@@ -41,6 +41,7 @@
 #include "BKE_customdata.h"
 #include "BKE_editmesh.h"
 #include "BKE_hair.h"
+#include "BKE_mesh.h"
 #include "BKE_pointcloud.h"
 #include "BKE_report.h"
 
@@ -272,6 +273,36 @@ int BKE_id_attribute_data_length(ID *id, CustomDataLayer *layer)
   return 0;
 }
 
+void BKE_id_attribute_ensure_unshared(ID *id, CustomDataLayer *layer)
+{
+  DomainInfo info[ATTR_DOMAIN_NUM];
+  get_domains(id, info);
+
+  for (AttributeDomain domain = 0; domain < ATTR_DOMAIN_NUM; domain++) {
+    CustomData *customdata = info[domain].customdata;
+    if (customdata && ARRAY_HAS_ITEM(layer, customdata->layers, customdata->totlayer)) {
+      if (layer->data == NULL || !(layer->flag & CD_FLAG_NOFREE)) {
+        return;
+      }
+      CustomData_duplicate_referenced_layer_named(
+          customdata, layer->type, layer->name, info[domain].length);
+      switch (GS(id->name)) {
+        case ID_ME:
+          BKE_mesh_update_customdata_pointers((Mesh *)id, false);
+          break;
+        case ID_PT:
+          BKE_pointcloud_update_customdata_pointers((PointCloud *)id);
+          break;
+        default:
+          break;
+      }
+      return;
+    }
+  }
+
+  BLI_assert_msg(0, "Custom data layer not found in geometry");
+}
+
 bool BKE_id_attribute_required(ID *id, CustomDataLayer *layer)
 {
   switch (GS(id->name)) {
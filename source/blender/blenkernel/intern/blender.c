@@ -56,6 +56,7 @@
 #include "BKE_studiolight.h"
 
 #include "DEG_depsgraph.h"
+#include "DEG_depsgraph_debug.h"
 
 #include "RE_pipeline.h"
 #include "RE_texture.h"
@@ -91,6 +92,7 @@ void BKE_blender_free(void)
   IMB_exit();
   BKE_cachefiles_exit();
   BKE_images_exit();
+  DEG_debug_trace_exit();
   DEG_free_node_types();
 
   BKE_brush_system_exit();
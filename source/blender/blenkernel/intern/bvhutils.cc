@@ -1602,6 +1602,7 @@ BVHTree *BKE_bvhtree_from_mesh_get(struct BVHTreeFromMesh *data,
     case BVHTREE_FROM_EM_VERTS:
     case BVHTREE_FROM_EM_EDGES:
     case BVHTREE_FROM_EM_LOOPTRI:
+    case BVHTREE_FROM_POINTCLOUD:
     case BVHTREE_MAX_ITEM:
       BLI_assert(false);
       break;
@@ -1717,6 +1718,7 @@ BVHTree *BKE_bvhtree_from_editmesh_get(BVHTreeFromEditMesh *data,
     case BVHTREE_FROM_LOOPTRI_NO_HIDDEN:
     case BVHTREE_FROM_LOOSEVERTS:
     case BVHTREE_FROM_LOOSEEDGES:
+    case BVHTREE_FROM_POINTCLOUD:
     case BVHTREE_MAX_ITEM:
       BLI_assert(false);
       break;
@@ -1785,31 +1787,67 @@ void free_bvhtree_from_mesh(struct BVHTreeFromMesh *data)
 /** \name Point Cloud BVH Building
  * \{ */
 
+static BVHTree *bvhtree_from_pointcloud_create(const PointCloud *pointcloud,
+                                               const int tree_type,
+                                               const bool isolate)
+{
+  BVHTree *tree = BLI_bvhtree_new(pointcloud->totpoint, 0.0f, tree_type, 6);
+  if (tree != nullptr) {
+    for (int i = 0; i < pointcloud->totpoint; i++) {
+      BLI_bvhtree_insert(tree, i, pointcloud->co[i], 1);
+    }
+    BLI_assert(BLI_bvhtree_get_len(tree) == pointcloud->totpoint);
+    bvhtree_balance(tree, isolate);
+  }
+  return tree;
+}
+
+/**
+ * Get a BVH tree of the points. The tree is cached in the point cloud runtime data, so that it is
+ * only built once when it is used by multiple users, possibly on different threads.
+ * #BKE_pointcloud_tag_positions_changed has to be called when the positions change.
+ *
+ * The cache holds a single tree, requesting another \a tree_type builds a tree which is owned by
+ * \a data instead.
+ */
 BVHTree *BKE_bvhtree_from_pointcloud_get(BVHTreeFromPointCloud *data,
                                          const PointCloud *pointcloud,
                                          const int tree_type)
 {
-  BVHTree *tree = BLI_bvhtree_new(pointcloud->totpoint, 0.0f, tree_type, 6);
-  if (!tree) {
-    return nullptr;
+  /* The cache is runtime data, which may be created lazily on const point clouds. */
+  BVHCache **bvh_cache_p = const_cast<BVHCache **>(&pointcloud->runtime.bvh_cache);
+  ThreadMutex *eval_mutex = static_cast<ThreadMutex *>(pointcloud->runtime.eval_mutex);
+
+  bool lock_started = false;
+  BVHTree *tree = nullptr;
+  if (!bvhcache_find(bvh_cache_p, BVHTREE_FROM_POINTCLOUD, &tree, &lock_started, eval_mutex)) {
+    tree = bvhtree_from_pointcloud_create(pointcloud, tree_type, true);
+    bvhcache_insert(*bvh_cache_p, tree, BVHTREE_FROM_POINTCLOUD);
+  }
+  bvhcache_unlock(*bvh_cache_p, lock_started);
+
+  bool cached = true;
+  if (tree != nullptr && BLI_bvhtree_get_tree_type(tree) != tree_type) {
+    tree = bvhtree_from_pointcloud_create(pointcloud, tree_type, false);
+    cached = false;
   }
 
-  for (int i = 0; i < pointcloud->totpoint; i++) {
-    BLI_bvhtree_insert(tree, i, pointcloud->co[i], 1);
+  memset(data, 0, sizeof(*data));
+  if (tree == nullptr) {
+    return nullptr;
   }
-  BLI_assert(BLI_bvhtree_get_len(tree) == pointcloud->totpoint);
-  bvhtree_balance(tree, false);
 
   data->coords = pointcloud->co;
   data->tree = tree;
   data->nearest_callback = nullptr;
+  data->cached = cached;
 
   return tree;
 }
 
 void free_bvhtree_from_pointcloud(BVHTreeFromPointCloud *data)
 {
-  if (data->tree) {
+  if (data->tree && !data->cached) {
     BLI_bvhtree_free(data->tree);
   }
   memset(data, 0, sizeof(*data));
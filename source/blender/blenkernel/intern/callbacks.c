@@ -80,6 +80,21 @@ void BKE_callback_add(bCallbackFuncStore *funcstore, eCbEvent evt)
   BLI_addtail(lb, funcstore);
 }
 
+/**
+ * Whether executing the callbacks of the event can have any effect, so that callers can skip
+ * work that is only needed to support them.
+ */
+bool BKE_callback_has_handlers(eCbEvent evt)
+{
+  ListBase *lb = &callback_slots[evt];
+  LISTBASE_FOREACH (bCallbackFuncStore *, funcstore, lb) {
+    if (funcstore->poll == NULL || funcstore->poll(funcstore->arg)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void BKE_callback_global_init(void)
 {
   /* do nothing */
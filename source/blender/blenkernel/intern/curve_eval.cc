@@ -141,6 +141,67 @@ blender::Array<int> CurveEval::evaluated_point_offsets() const
   return offsets;
 }
 
+/**
+ * Evaluate the positions and lengths of all splines in parallel, and optionally the tangents
+ * and normals, into flat arrays. The result is not stored in the caches of every spline, except
+ * for the positions of spline types that need them to interpolate attributes.
+ */
+CurveEvaluatedData CurveEval::evaluate(const bool calculate_directions) const
+{
+  CurveEvaluatedData data;
+  data.offsets.reinitialize(splines_.size() + 1);
+  MutableSpan<int> offsets = data.offsets;
+
+  /* Retrieving the size is not trivial for all spline types, so do that in parallel too. */
+  blender::threading::parallel_for(splines_.index_range(), 512, [&](IndexRange range) {
+    for (const int i : range) {
+      offsets[i] = splines_[i]->evaluated_points_size();
+    }
+  });
+  int offset = 0;
+  for (const int i : splines_.index_range()) {
+    const int size = offsets[i];
+    offsets[i] = offset;
+    offset += size;
+  }
+  offsets.last() = offset;
+
+  data.positions.reinitialize(offset);
+  data.lengths.reinitialize(offset);
+  if (calculate_directions) {
+    data.tangents.reinitialize(offset);
+    data.normals.reinitialize(offset);
+  }
+
+  blender::threading::parallel_for(splines_.index_range(), 128, [&](IndexRange range) {
+    for (const int i : range) {
+      const Spline &spline = *splines_[i];
+      const IndexRange points = data.points_range(i);
+      if (points.size() == 0) {
+        continue;
+      }
+
+      MutableSpan<float3> positions = data.positions.as_mutable_span().slice(points.start(),
+                                                                             points.size());
+      positions.copy_from(spline.evaluated_positions());
+      spline.calculate_evaluated_lengths(
+          positions,
+          data.lengths.as_mutable_span().slice(points.start(), spline.evaluated_edges_size()));
+
+      if (calculate_directions) {
+        MutableSpan<float3> tangents = data.tangents.as_mutable_span().slice(points.start(),
+                                                                             points.size());
+        MutableSpan<float3> normals = data.normals.as_mutable_span().slice(points.start(),
+                                                                           points.size());
+        spline.calculate_evaluated_tangents(positions, tangents);
+        spline.calculate_evaluated_normals(tangents, normals);
+      }
+    }
+  });
+
+  return data;
+}
+
 static BezierSpline::HandleType handle_type_from_dna_bezt(const eBezTriple_Handle dna_handle_type)
 {
   switch (dna_handle_type) {
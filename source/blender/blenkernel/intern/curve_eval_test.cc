@@ -0,0 +1,118 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "BKE_spline.hh"
+
+#include "testing/testing.h"
+
+namespace blender::bke::tests {
+
+static std::unique_ptr<CurveEval> create_test_curve()
+{
+  std::unique_ptr<CurveEval> curve = std::make_unique<CurveEval>();
+
+  std::unique_ptr<BezierSpline> bezier = std::make_unique<BezierSpline>();
+  bezier->set_resolution(4);
+  bezier->add_point({0.0f, 0.0f, 0.0f},
+                    BezierSpline::HandleType::Auto,
+                    {-1.0f, 0.0f, 0.0f},
+                    BezierSpline::HandleType::Free,
+                    {1.0f, 1.0f, 0.0f},
+                    1.0f,
+                    0.0f);
+  bezier->add_point({2.0f, 0.0f, 0.0f},
+                    BezierSpline::HandleType::Auto,
+                    {1.0f, 0.0f, 0.0f},
+                    BezierSpline::HandleType::Auto,
+                    {3.0f, 0.0f, 0.0f},
+                    1.0f,
+                    0.5f);
+  bezier->add_point({2.0f, 2.0f, 1.0f},
+                    BezierSpline::HandleType::Vector,
+                    {2.0f, 1.0f, 1.0f},
+                    BezierSpline::HandleType::Vector,
+                    {2.0f, 3.0f, 1.0f},
+                    1.0f,
+                    1.0f);
+  bezier->attributes.reallocate(bezier->size());
+  curve->add_spline(std::move(bezier));
+
+  std::unique_ptr<PolySpline> poly = std::make_unique<PolySpline>();
+  poly->set_cyclic(true);
+  poly->add_point({0.0f, 0.0f, 0.0f}, 1.0f, 0.0f);
+  poly->add_point({1.0f, 0.0f, 1.0f}, 1.0f, 0.0f);
+  poly->add_point({1.0f, 1.0f, 0.0f}, 1.0f, 0.0f);
+  poly->add_point({0.0f, 1.0f, 2.0f}, 1.0f, 0.0f);
+  poly->attributes.reallocate(poly->size());
+  curve->add_spline(std::move(poly));
+
+  std::unique_ptr<PolySpline> single_point = std::make_unique<PolySpline>();
+  single_point->add_point({5.0f, 5.0f, 5.0f}, 1.0f, 0.0f);
+  single_point->attributes.reallocate(single_point->size());
+  curve->add_spline(std::move(single_point));
+
+  curve->attributes.reallocate(curve->splines().size());
+  return curve;
+}
+
+static void expect_float3_near(const float3 &a, const float3 &b)
+{
+  EXPECT_NEAR(a.x, b.x, 1e-5f);
+  EXPECT_NEAR(a.y, b.y, 1e-5f);
+  EXPECT_NEAR(a.z, b.z, 1e-5f);
+}
+
+TEST(curve_eval, EvaluateMatchesSplineCaches)
+{
+  std::unique_ptr<CurveEval> curve = create_test_curve();
+  const CurveEvaluatedData evaluated = curve->evaluate(true);
+
+  Span<SplinePtr> splines = curve->splines();
+  EXPECT_EQ(evaluated.offsets.size(), splines.size() + 1);
+  EXPECT_EQ(evaluated.offsets.last(), curve->evaluated_point_offsets().last());
+
+  for (const int i : splines.index_range()) {
+    const Spline &spline = *splines[i];
+    const IndexRange points = evaluated.points_range(i);
+    EXPECT_EQ(points.size(), spline.evaluated_points_size());
+
+    for (const int i_point : IndexRange(points.size())) {
+      expect_float3_near(evaluated.positions[points[i_point]],
+                         spline.evaluated_positions()[i_point]);
+      expect_float3_near(evaluated.tangents[points[i_point]],
+                         spline.evaluated_tangents()[i_point]);
+      expect_float3_near(evaluated.normals[points[i_point]], spline.evaluated_normals()[i_point]);
+    }
+
+    Span<float> lengths = evaluated.spline_lengths(i, spline);
+    EXPECT_EQ(lengths.size(), spline.evaluated_lengths().size());
+    for (const int i_edge : lengths.index_range()) {
+      EXPECT_NEAR(lengths[i_edge], spline.evaluated_lengths()[i_edge], 1e-5f);
+    }
+    EXPECT_NEAR(evaluated.spline_length(i, spline), spline.length(), 1e-5f);
+  }
+}
+
+TEST(curve_eval, EvaluateWithoutDirections)
+{
+  std::unique_ptr<CurveEval> curve = create_test_curve();
+  const CurveEvaluatedData evaluated = curve->evaluate(false);
+  EXPECT_EQ(evaluated.positions.size(), evaluated.offsets.last());
+  EXPECT_TRUE(evaluated.tangents.is_empty());
+  EXPECT_TRUE(evaluated.normals.is_empty());
+}
+
+}  // namespace blender::bke::tests
@@ -26,6 +26,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 /* Since we have versioning code here (CustomData_verify_versions()). */
 #define DNA_DEPRECATED_ALLOW
 
@@ -2067,6 +2069,9 @@ static CustomDataLayer *customData_add_layer__internal(CustomData *data,
                                                        void *layerdata,
                                                        int totelem,
                                                        const char *name);
+static void *customData_duplicate_referenced_layer_index(CustomData *data,
+                                                         const int layer_index,
+                                                         const int totelem);
 
 void CustomData_update_typemap(CustomData *data)
 {
@@ -2085,6 +2090,74 @@ void CustomData_update_typemap(CustomData *data)
   }
 }
 
+/**
+ * Owner of layer data that is shared between layers of different custom data, see #CD_SHARE.
+ * The data is freed when the last layer using it releases it.
+ */
+typedef struct CustomDataSharedLayer {
+  /** Number of layers using the data, modified atomically. */
+  int users;
+  int type;
+  int totelem;
+  void *data;
+} CustomDataSharedLayer;
+
+static void customData_shared_layer_release(CustomDataSharedLayer *shared)
+{
+  if (atomic_sub_and_fetch_int32(&shared->users, 1) > 0) {
+    return;
+  }
+  if (shared->data) {
+    const LayerTypeInfo *typeInfo = layerType_getInfo(shared->type);
+    if (typeInfo->free) {
+      typeInfo->free(shared->data, shared->totelem, typeInfo->size);
+    }
+    MEM_freeN(shared->data);
+  }
+  MEM_freeN(shared);
+}
+
+void CustomData_share_layers(CustomData *data, CustomDataMask mask, int totelem)
+{
+  for (int i = 0; i < data->totlayer; i++) {
+    CustomDataLayer *layer = &data->layers[i];
+    if (!(mask & CD_TYPE_AS_MASK(layer->type))) {
+      continue;
+    }
+    /* Layers that only reference their data can't pass on its ownership. */
+    if (layer->shared != NULL || layer->data == NULL || (layer->flag & CD_FLAG_NOFREE)) {
+      continue;
+    }
+    CustomDataSharedLayer *shared = MEM_mallocN(sizeof(*shared), __func__);
+    shared->users = 1;
+    shared->type = layer->type;
+    shared->totelem = totelem;
+    shared->data = layer->data;
+    layer->shared = shared;
+    layer->flag |= CD_FLAG_NOFREE;
+  }
+}
+
+static CustomDataLayer *customData_add_shared_layer(CustomData *data,
+                                                    const CustomDataLayer *source_layer,
+                                                    int totelem)
+{
+  CustomDataSharedLayer *shared = source_layer->shared;
+  if (shared == NULL) {
+    return customData_add_layer__internal(
+        data, source_layer->type, CD_DUPLICATE, source_layer->data, totelem, source_layer->name);
+  }
+
+  CustomDataLayer *layer = customData_add_layer__internal(
+      data, source_layer->type, CD_REFERENCE, shared->data, totelem, source_layer->name);
+  if (layer) {
+    /* Only the reference count is modified, the source stays untouched. */
+    atomic_add_and_fetch_int32(&shared->users, 1);
+    layer->shared = shared;
+  }
+  return layer;
+}
+
 /* currently only used in BLI_assert */
 #ifndef NDEBUG
 static bool customdata_typemap_is_valid(const CustomData *data)
@@ -2145,6 +2218,7 @@ bool CustomData_merge(const struct CustomData *source,
       case CD_ASSIGN:
       case CD_REFERENCE:
       case CD_DUPLICATE:
+      case CD_SHARE:
         data = layer->data;
         break;
       default:
@@ -2156,6 +2230,9 @@ bool CustomData_merge(const struct CustomData *source,
       newlayer = customData_add_layer__internal(
           dest, type, CD_REFERENCE, data, totelem, layer->name);
     }
+    else if (alloctype == CD_SHARE) {
+      newlayer = customData_add_shared_layer(dest, layer, totelem);
+    }
     else {
       newlayer = customData_add_layer__internal(dest, type, alloctype, data, totelem, layer->name);
     }
@@ -2176,12 +2253,15 @@ bool CustomData_merge(const struct CustomData *source,
   return changed;
 }
 
-/* NOTE: Take care of referenced layers by yourself! */
+/* NOTE: Take care of referenced layers by yourself! Shared layers are copied. */
 void CustomData_realloc(CustomData *data, int totelem)
 {
   for (int i = 0; i < data->totlayer; i++) {
     CustomDataLayer *layer = &data->layers[i];
     const LayerTypeInfo *typeInfo;
+    if (layer->shared) {
+      customData_duplicate_referenced_layer_index(data, i, layer->shared->totelem);
+    }
     if (layer->flag & CD_FLAG_NOFREE) {
       continue;
     }
@@ -2209,7 +2289,11 @@ static void customData_free_layer__internal(CustomDataLayer *layer, int totelem)
 {
   const LayerTypeInfo *typeInfo;
 
-  if (!(layer->flag & CD_FLAG_NOFREE) && layer->data) {
+  if (layer->shared) {
+    customData_shared_layer_release(layer->shared);
+    layer->shared = NULL;
+  }
+  else if (!(layer->flag & CD_FLAG_NOFREE) && layer->data) {
     typeInfo = layerType_getInfo(layer->type);
 
     if (typeInfo->free) {
@@ -2583,6 +2667,7 @@ static CustomDataLayer *customData_add_layer__internal(CustomData *data,
   data->layers[index].type = type;
   data->layers[index].flag = flag;
   data->layers[index].data = newlayerdata;
+  data->layers[index].shared = NULL;
 
   /* Set default name if none exists. Note we only call DATA_()  once
    * we know there is a default name, to avoid overhead of locale lookups
@@ -2763,22 +2848,34 @@ static void *customData_duplicate_referenced_layer_index(CustomData *data,
   CustomDataLayer *layer = &data->layers[layer_index];
 
   if (layer->flag & CD_FLAG_NOFREE) {
-    /* MEM_dupallocN won't work in case of complex layers, like e.g.
-     * CD_MDEFORMVERT, which has pointers to allocated data...
-     * So in case a custom copy function is defined, use it!
-     */
-    const LayerTypeInfo *typeInfo = layerType_getInfo(layer->type);
-
-    if (typeInfo->copy) {
-      void *dst_data = MEM_malloc_arrayN(
-          (size_t)totelem, typeInfo->size, "CD duplicate ref layer");
-      typeInfo->copy(layer->data, dst_data, totelem);
-      layer->data = dst_data;
+    CustomDataSharedLayer *shared = layer->shared;
+    if (shared && atomic_load_int32(&shared->users) == 1) {
+      /* No other layer uses the shared data anymore, so it can be taken over without a copy. */
+      MEM_freeN(shared);
     }
     else {
-      layer->data = MEM_dupallocN(layer->data);
+      /* MEM_dupallocN won't work in case of complex layers, like e.g.
+       * CD_MDEFORMVERT, which has pointers to allocated data...
+       * So in case a custom copy function is defined, use it!
+       */
+      const LayerTypeInfo *typeInfo = layerType_getInfo(layer->type);
+
+      if (typeInfo->copy) {
+        void *dst_data = MEM_malloc_arrayN(
+            (size_t)totelem, typeInfo->size, "CD duplicate ref layer");
+        typeInfo->copy(layer->data, dst_data, totelem);
+        layer->data = dst_data;
+      }
+      else {
+        layer->data = MEM_dupallocN(layer->data);
+      }
+
+      if (shared) {
+        customData_shared_layer_release(shared);
+      }
     }
 
+    layer->shared = NULL;
     layer->flag &= ~CD_FLAG_NOFREE;
   }
 
@@ -3649,7 +3746,7 @@ void CustomData_bmesh_free_block_data(CustomData *data, void *block)
   }
 }
 
-static void CustomData_bmesh_alloc_block(CustomData *data, void **block)
+void CustomData_bmesh_alloc_block(CustomData *data, void **block)
 {
   if (*block) {
     CustomData_bmesh_free_block(data, block);
@@ -4266,7 +4363,10 @@ void CustomData_blend_write_prepare(CustomData *data,
         }
         write_layers_size += chunk_size;
       }
-      write_layers[j++] = *layer;
+      write_layers[j] = *layer;
+      /* Sharing is run-time state, the data is written like the data of any other layer. */
+      write_layers[j].shared = NULL;
+      j++;
     }
   }
   BLI_assert(j == data->totlayer);
@@ -5199,6 +5299,7 @@ void CustomData_blend_read(BlendDataReader *reader, CustomData *data, int count)
     }
 
     layer->flag &= ~CD_FLAG_NOFREE;
+    layer->shared = NULL;
 
     if (CustomData_verify_versions(data, i)) {
       BLO_read_data_address(reader, &layer->data);
@@ -0,0 +1,109 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "BKE_customdata.h"
+
+#include "DNA_customdata_types.h"
+
+#include "testing/testing.h"
+
+namespace blender::bke::tests {
+
+TEST(customdata, ShareLayers)
+{
+  const int size = 4;
+  CustomData source;
+  CustomData_reset(&source);
+  float *source_data = (float *)CustomData_add_layer_named(
+      &source, CD_PROP_FLOAT, CD_CALLOC, nullptr, size, "a");
+  for (int i = 0; i < size; i++) {
+    source_data[i] = (float)i;
+  }
+
+  CustomData_share_layers(&source, CD_MASK_PROP_ALL, size);
+  EXPECT_TRUE(CustomData_is_referenced_layer(&source, CD_PROP_FLOAT));
+  EXPECT_EQ(CustomData_get_layer_named(&source, CD_PROP_FLOAT, "a"), source_data);
+
+  CustomData copy_a;
+  CustomData copy_b;
+  CustomData_copy(&source, &copy_a, CD_MASK_PROP_ALL, CD_SHARE, size);
+  CustomData_copy(&copy_a, &copy_b, CD_MASK_PROP_ALL, CD_SHARE, size);
+  EXPECT_EQ(CustomData_get_layer_named(&copy_a, CD_PROP_FLOAT, "a"), source_data);
+  EXPECT_EQ(CustomData_get_layer_named(&copy_b, CD_PROP_FLOAT, "a"), source_data);
+
+  /* Modifying a copy must not change the other users of the data. */
+  float *data_a = (float *)CustomData_duplicate_referenced_layer_named(
+      &copy_a, CD_PROP_FLOAT, "a", size);
+  EXPECT_NE(data_a, source_data);
+  data_a[0] = 10.0f;
+  EXPECT_EQ(source_data[0], 0.0f);
+  EXPECT_EQ(data_a[3], 3.0f);
+
+  /* The last remaining user takes over the data without copying it. */
+  CustomData_free(&source, size);
+  float *data_b = (float *)CustomData_duplicate_referenced_layer_named(
+      &copy_b, CD_PROP_FLOAT, "a", size);
+  EXPECT_EQ(data_b, source_data);
+  EXPECT_FALSE(CustomData_is_referenced_layer(&copy_b, CD_PROP_FLOAT));
+
+  CustomData_free(&copy_a, size);
+  CustomData_free(&copy_b, size);
+}
+
+TEST(customdata, ShareReferencedLayer)
+{
+  const int size = 2;
+  float values[size] = {1.0f, 2.0f};
+  CustomData source;
+  CustomData_reset(&source);
+  CustomData_add_layer_named(&source, CD_PROP_FLOAT, CD_REFERENCE, values, size, "a");
+
+  /* Data that is not owned by the source can't be shared, so it is copied. */
+  CustomData_share_layers(&source, CD_MASK_PROP_ALL, size);
+  CustomData copy;
+  CustomData_copy(&source, &copy, CD_MASK_PROP_ALL, CD_SHARE, size);
+  const float *copy_data = (const float *)CustomData_get_layer_named(&copy, CD_PROP_FLOAT, "a");
+  EXPECT_NE(copy_data, values);
+  EXPECT_EQ(copy_data[1], 2.0f);
+  EXPECT_FALSE(CustomData_is_referenced_layer(&copy, CD_PROP_FLOAT));
+
+  CustomData_free(&source, size);
+  CustomData_free(&copy, size);
+}
+
+TEST(customdata, CopyUnpreparedLayer)
+{
+  const int size = 2;
+  CustomData source;
+  CustomData_reset(&source);
+  float *source_data = (float *)CustomData_add_layer_named(
+      &source, CD_PROP_FLOAT, CD_CALLOC, nullptr, size, "a");
+  source_data[1] = 2.0f;
+
+  /* The source is const, so layers that have not been prepared for sharing are copied. */
+  CustomData copy;
+  CustomData_copy(&source, &copy, CD_MASK_PROP_ALL, CD_SHARE, size);
+  const float *copy_data = (const float *)CustomData_get_layer_named(&copy, CD_PROP_FLOAT, "a");
+  EXPECT_NE(copy_data, source_data);
+  EXPECT_EQ(copy_data[1], 2.0f);
+  EXPECT_FALSE(CustomData_is_referenced_layer(&source, CD_PROP_FLOAT));
+  EXPECT_FALSE(CustomData_is_referenced_layer(&copy, CD_PROP_FLOAT));
+
+  CustomData_free(&source, size);
+  CustomData_free(&copy, size);
+}
+
+}  // namespace blender::bke::tests
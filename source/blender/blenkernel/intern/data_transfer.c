@@ -929,6 +929,10 @@ static bool data_transfer_layersmapping_generate(ListBase *r_map,
                                                  SpaceTransform *space_transform)
 {
   CustomData *cd_src, *cd_dst;
+  /* Layers of an evaluated destination reference the original data, and layers of an original
+   * destination may be shared with its copy-on-write mesh (see #LIB_ID_COPY_CD_SHARE_GEOMETRY).
+   * Copying referenced layers before writing to them is a no-op for layers owned by the mesh. */
+  const bool use_dupref_dst = true;
 
   cd_datatransfer_interp interp = NULL;
   void *interp_data = NULL;
@@ -948,7 +952,7 @@ static bool data_transfer_layersmapping_generate(ListBase *r_map,
                                                 use_delete,
                                                 cd_src,
                                                 cd_dst,
-                                                me_dst != ob_dst->data,
+                                                use_dupref_dst,
                                                 fromlayers,
                                                 tolayers,
                                                 interp,
@@ -1007,7 +1011,7 @@ static bool data_transfer_layersmapping_generate(ListBase *r_map,
                                                 ob_dst,
                                                 cd_src,
                                                 cd_dst,
-                                                me_dst != ob_dst->data,
+                                                use_dupref_dst,
                                                 fromlayers,
                                                 tolayers);
 
@@ -1036,7 +1040,7 @@ static bool data_transfer_layersmapping_generate(ListBase *r_map,
                                                 use_delete,
                                                 cd_src,
                                                 cd_dst,
-                                                me_dst != ob_dst->data,
+                                                use_dupref_dst,
                                                 fromlayers,
                                                 tolayers,
                                                 interp,
@@ -1162,7 +1166,7 @@ static bool data_transfer_layersmapping_generate(ListBase *r_map,
                                                 use_delete,
                                                 cd_src,
                                                 cd_dst,
-                                                me_dst != ob_dst->data,
+                                                use_dupref_dst,
                                                 fromlayers,
                                                 tolayers,
                                                 interp,
@@ -1194,7 +1198,7 @@ static bool data_transfer_layersmapping_generate(ListBase *r_map,
                                                 use_delete,
                                                 cd_src,
                                                 cd_dst,
-                                                me_dst != ob_dst->data,
+                                                use_dupref_dst,
                                                 fromlayers,
                                                 tolayers,
                                                 interp,
@@ -1850,6 +1854,11 @@ bool BKE_object_data_transfer_ex(struct Depsgraph *depsgraph,
     MEM_SAFE_FREE(weights[i]);
   }
 
+  if (changed) {
+    /* Referenced layers might have been copied. */
+    BKE_mesh_update_customdata_pointers(me_dst, false);
+  }
+
   return changed;
 
 #undef VDATA
@@ -1066,6 +1066,44 @@ void BKE_defvert_array_copy(MDeformVert *dst, const MDeformVert *src, int totver
   }
 }
 
+DeformWeightsCSR *BKE_defvert_weights_csr_create(const MDeformVert *dvert, int totvert)
+{
+  DeformWeightsCSR *weights_csr = MEM_callocN(sizeof(*weights_csr), __func__);
+  weights_csr->verts_num = totvert;
+  weights_csr->vert_offsets = MEM_malloc_arrayN(
+      (size_t)totvert + 1, sizeof(*weights_csr->vert_offsets), __func__);
+
+  int weights_num = 0;
+  for (int i = 0; i < totvert; i++) {
+    weights_csr->vert_offsets[i] = weights_num;
+    weights_num += dvert[i].totweight;
+  }
+  weights_csr->vert_offsets[totvert] = weights_num;
+
+  /* Allocate at least one element, so that every vertex has a valid weights pointer. */
+  weights_csr->weights = MEM_malloc_arrayN(
+      (size_t)max_ii(weights_num, 1), sizeof(*weights_csr->weights), __func__);
+  for (int i = 0; i < totvert; i++) {
+    if (dvert[i].totweight != 0) {
+      memcpy(&weights_csr->weights[weights_csr->vert_offsets[i]],
+             dvert[i].dw,
+             sizeof(*weights_csr->weights) * (size_t)dvert[i].totweight);
+    }
+  }
+
+  return weights_csr;
+}
+
+void BKE_defvert_weights_csr_free(DeformWeightsCSR *weights_csr)
+{
+  if (weights_csr == NULL) {
+    return;
+  }
+  MEM_freeN(weights_csr->vert_offsets);
+  MEM_freeN(weights_csr->weights);
+  MEM_freeN(weights_csr);
+}
+
 void BKE_defvert_array_free_elems(MDeformVert *dvert, int totvert)
 {
   /* Instead of freeing the verts directly,
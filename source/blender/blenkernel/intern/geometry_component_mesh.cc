@@ -22,6 +22,7 @@
 
 #include "BKE_attribute_access.hh"
 #include "BKE_attribute_math.hh"
+#include "BKE_bvhutils.h"
 #include "BKE_deform.h"
 #include "BKE_geometry_set.hh"
 #include "BKE_lib_id.h"
@@ -38,6 +39,14 @@ using blender::fn::GVArray;
 /** \name Geometry Component Implementation
  * \{ */
 
+/* Generic attributes of the copy share their data with the source mesh until they are modified
+ * through the attribute API, so that nodes only copy the attributes they write to. */
+static Mesh *copy_mesh_sharing_attributes(const Mesh *mesh)
+{
+  return (Mesh *)BKE_id_copy_ex(
+      nullptr, &mesh->id, nullptr, LIB_ID_COPY_LOCALIZE | LIB_ID_COPY_CD_SHARE_ATTRIBUTES);
+}
+
 MeshComponent::MeshComponent() : GeometryComponent(GEO_COMPONENT_TYPE_MESH)
 {
 }
@@ -51,7 +60,7 @@ GeometryComponent *MeshComponent::copy() const
 {
   MeshComponent *new_component = new MeshComponent();
   if (mesh_ != nullptr) {
-    new_component->mesh_ = BKE_mesh_copy_for_eval(mesh_, false);
+    new_component->mesh_ = copy_mesh_sharing_attributes(mesh_);
     new_component->ownership_ = GeometryOwnershipType::Owned;
   }
   return new_component;
@@ -80,6 +89,9 @@ void MeshComponent::replace(Mesh *mesh, GeometryOwnershipType ownership)
   this->clear();
   mesh_ = mesh;
   ownership_ = ownership;
+  if (mesh_ != nullptr && ownership_ == GeometryOwnershipType::Owned) {
+    BKE_mesh_share_custom_data(mesh_, LIB_ID_COPY_CD_SHARE_ATTRIBUTES);
+  }
 }
 
 /* Return the mesh and clear the component. The caller takes over responsibility for freeing the
@@ -105,9 +117,13 @@ Mesh *MeshComponent::get_for_write()
 {
   BLI_assert(this->is_mutable());
   if (ownership_ == GeometryOwnershipType::ReadOnly) {
-    mesh_ = BKE_mesh_copy_for_eval(mesh_, false);
+    mesh_ = copy_mesh_sharing_attributes(mesh_);
     ownership_ = GeometryOwnershipType::Owned;
   }
+  if (mesh_ != nullptr) {
+    /* Layers added since the last call can be shared with copies made later on. */
+    BKE_mesh_share_custom_data(mesh_, LIB_ID_COPY_CD_SHARE_ATTRIBUTES);
+  }
   return mesh_;
 }
 
@@ -125,7 +141,7 @@ void MeshComponent::ensure_owns_direct_data()
 {
   BLI_assert(this->is_mutable());
   if (ownership_ != GeometryOwnershipType::Owned) {
-    mesh_ = BKE_mesh_copy_for_eval(mesh_, false);
+    mesh_ = copy_mesh_sharing_attributes(mesh_);
     ownership_ = GeometryOwnershipType::Owned;
   }
 }
@@ -694,11 +710,16 @@ static void set_vertex_position(MVert &vert, float3 position)
   copy_v3_v3(vert.co, position);
 }
 
-static void tag_normals_dirty_when_writing_position(GeometryComponent &component)
+static void tag_component_positions_changed(GeometryComponent &component)
 {
   Mesh *mesh = get_mesh_from_component_for_write(component);
   if (mesh != nullptr) {
     mesh->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+    /* Cached BVH trees reference the old positions. */
+    if (mesh->runtime.bvh_cache) {
+      bvhcache_free(mesh->runtime.bvh_cache);
+      mesh->runtime.bvh_cache = nullptr;
+    }
   }
 }
 
@@ -1030,7 +1051,7 @@ static ComponentAttributeProviders create_attribute_providers_for_mesh()
       point_access,
       make_derived_read_attribute<MVert, float3, get_vertex_position>,
       make_derived_write_attribute<MVert, float3, get_vertex_position, set_vertex_position>,
-      tag_normals_dirty_when_writing_position);
+      tag_component_positions_changed);
 
   static NormalAttributeProvider normal;
 
@@ -27,6 +27,14 @@
 /** \name Geometry Component Implementation
  * \{ */
 
+/* Attributes of the copy share their data with the source point cloud until they are modified
+ * through the attribute API, so that nodes only copy the attributes they write to. */
+static PointCloud *copy_pointcloud_sharing_attributes(const PointCloud *pointcloud)
+{
+  return (PointCloud *)BKE_id_copy_ex(
+      nullptr, &pointcloud->id, nullptr, LIB_ID_COPY_LOCALIZE | LIB_ID_COPY_CD_SHARE_ATTRIBUTES);
+}
+
 PointCloudComponent::PointCloudComponent() : GeometryComponent(GEO_COMPONENT_TYPE_POINT_CLOUD)
 {
 }
@@ -40,7 +48,7 @@ GeometryComponent *PointCloudComponent::copy() const
 {
   PointCloudComponent *new_component = new PointCloudComponent();
   if (pointcloud_ != nullptr) {
-    new_component->pointcloud_ = BKE_pointcloud_copy_for_eval(pointcloud_, false);
+    new_component->pointcloud_ = copy_pointcloud_sharing_attributes(pointcloud_);
     new_component->ownership_ = GeometryOwnershipType::Owned;
   }
   return new_component;
@@ -69,6 +77,9 @@ void PointCloudComponent::replace(PointCloud *pointcloud, GeometryOwnershipType
   this->clear();
   pointcloud_ = pointcloud;
   ownership_ = ownership;
+  if (pointcloud_ != nullptr && ownership_ == GeometryOwnershipType::Owned) {
+    BKE_pointcloud_share_custom_data(pointcloud_);
+  }
 }
 
 /* Return the point cloud and clear the component. The caller takes over responsibility for freeing
@@ -96,9 +107,13 @@ PointCloud *PointCloudComponent::get_for_write()
 {
   BLI_assert(this->is_mutable());
   if (ownership_ == GeometryOwnershipType::ReadOnly) {
-    pointcloud_ = BKE_pointcloud_copy_for_eval(pointcloud_, false);
+    pointcloud_ = copy_pointcloud_sharing_attributes(pointcloud_);
     ownership_ = GeometryOwnershipType::Owned;
   }
+  if (pointcloud_ != nullptr) {
+    /* Layers added since the last call can be shared with copies made later on. */
+    BKE_pointcloud_share_custom_data(pointcloud_);
+  }
   return pointcloud_;
 }
 
@@ -116,7 +131,7 @@ void PointCloudComponent::ensure_owns_direct_data()
 {
   BLI_assert(this->is_mutable());
   if (ownership_ != GeometryOwnershipType::Owned) {
-    pointcloud_ = BKE_pointcloud_copy_for_eval(pointcloud_, false);
+    pointcloud_ = copy_pointcloud_sharing_attributes(pointcloud_);
     ownership_ = GeometryOwnershipType::Owned;
   }
 }
@@ -180,6 +195,14 @@ static ComponentAttributeProviders create_attribute_providers_for_point_cloud()
       },
       update_custom_data_pointers};
 
+  static auto tag_positions_changed = [](GeometryComponent &component) {
+    PointCloudComponent &pointcloud_component = static_cast<PointCloudComponent &>(component);
+    PointCloud *pointcloud = pointcloud_component.get_for_write();
+    if (pointcloud != nullptr) {
+      BKE_pointcloud_tag_positions_changed(pointcloud);
+    }
+  };
+
   static BuiltinCustomDataLayerProvider position("position",
                                                  ATTR_DOMAIN_POINT,
                                                  CD_PROP_FLOAT3,
@@ -190,7 +213,7 @@ static ComponentAttributeProviders create_attribute_providers_for_point_cloud()
                                                  point_access,
                                                  make_array_read_attribute<float3>,
                                                  make_array_write_attribute<float3>,
-                                                 nullptr);
+                                                 tag_positions_changed);
   static BuiltinCustomDataLayerProvider radius("radius",
                                                ATTR_DOMAIN_POINT,
                                                CD_PROP_FLOAT,
@@ -22,6 +22,8 @@
 #include "BKE_pointcloud.h"
 #include "BKE_spline.hh"
 
+#include "BLI_task.hh"
+
 #include "DNA_collection_types.h"
 #include "DNA_mesh_types.h"
 #include "DNA_meshdata_types.h"
@@ -338,7 +340,8 @@ void geometry_set_gather_instances_attribute_info(Span<GeometryInstanceGroup> se
           attribute_kind->data_type = meta_data.data_type;
         };
         auto modify_info = [&](AttributeKind *attribute_kind) {
-          attribute_kind->domain = meta_data.domain; /* TODO: Use highest priority domain. */
+          attribute_kind->domain = bke::attribute_domain_highest_priority(
+              {attribute_kind->domain, meta_data.domain});
           attribute_kind->data_type = bke::attribute_data_type_highest_complexity(
               {attribute_kind->data_type, meta_data.data_type});
         };
@@ -350,29 +353,147 @@ void geometry_set_gather_instances_attribute_info(Span<GeometryInstanceGroup> se
   }
 }
 
+/** Offsets of the elements of an instance in the realized mesh. */
+struct MeshElementOffsets {
+  int vert = 0;
+  int edge = 0;
+  int loop = 0;
+  int poly = 0;
+};
+
+/**
+ * A single instance of the geometry of a group in the joined result. The work is distributed
+ * over these instead of over the groups, so that many instances of the same small geometry are
+ * processed in parallel as well.
+ */
+struct InstanceItem {
+  int group_index;
+  int transform_index;
+  /** Index of the first element of this instance in the joined domain. */
+  int offset;
+};
+
+struct MeshInstanceItem {
+  int group_index;
+  int transform_index;
+  MeshElementOffsets offsets;
+};
+
+/** An instance of the attribute values of a component in the joined attribute. */
+struct AttributeInstanceItem {
+  /** Index of the group multiplied by the number of joined component types plus the index of the
+   * component type. */
+  int source_index;
+  int offset;
+  int size;
+};
+
+/** Instances are copied in chunks of this size, large meshes are split further when copied. */
+static constexpr int64_t instance_items_grain_size = 32;
+
+static void copy_transformed_mesh(const Mesh &mesh,
+                                  const float4x4 &transform,
+                                  Span<int> material_index_map,
+                                  const MeshElementOffsets &offsets,
+                                  Mesh &new_mesh)
+{
+  threading::parallel_for(IndexRange(mesh.totvert), 2048, [&](IndexRange range) {
+    for (const int i : range) {
+      const MVert &old_vert = mesh.mvert[i];
+      MVert &new_vert = new_mesh.mvert[offsets.vert + i];
+
+      new_vert = old_vert;
+
+      const float3 new_position = transform * float3(old_vert.co);
+      copy_v3_v3(new_vert.co, new_position);
+    }
+  });
+  threading::parallel_for(IndexRange(mesh.totedge), 2048, [&](IndexRange range) {
+    for (const int i : range) {
+      const MEdge &old_edge = mesh.medge[i];
+      MEdge &new_edge = new_mesh.medge[offsets.edge + i];
+      new_edge = old_edge;
+      new_edge.v1 += offsets.vert;
+      new_edge.v2 += offsets.vert;
+    }
+  });
+  threading::parallel_for(IndexRange(mesh.totloop), 2048, [&](IndexRange range) {
+    for (const int i : range) {
+      const MLoop &old_loop = mesh.mloop[i];
+      MLoop &new_loop = new_mesh.mloop[offsets.loop + i];
+      new_loop = old_loop;
+      new_loop.v += offsets.vert;
+      new_loop.e += offsets.edge;
+    }
+  });
+  threading::parallel_for(IndexRange(mesh.totpoly), 2048, [&](IndexRange range) {
+    for (const int i : range) {
+      const MPoly &old_poly = mesh.mpoly[i];
+      MPoly &new_poly = new_mesh.mpoly[offsets.poly + i];
+      new_poly = old_poly;
+      new_poly.loopstart += offsets.loop;
+      if (old_poly.mat_nr >= 0 && old_poly.mat_nr < mesh.totcol) {
+        new_poly.mat_nr = material_index_map[new_poly.mat_nr];
+      }
+      else {
+        /* The material index was invalid before. */
+        new_poly.mat_nr = 0;
+      }
+    }
+  });
+}
+
+static void copy_transformed_points_to_vertices(const PointCloud &pointcloud,
+                                                const float4x4 &transform,
+                                                const int vert_offset,
+                                                Mesh &new_mesh)
+{
+  const float3 point_normal{0.0f, 0.0f, 1.0f};
+  short point_normal_short[3];
+  normal_float_to_short_v3(point_normal_short, point_normal);
+
+  threading::parallel_for(IndexRange(pointcloud.totpoint), 2048, [&](IndexRange range) {
+    for (const int i : range) {
+      MVert &new_vert = new_mesh.mvert[vert_offset + i];
+      const float3 old_position = pointcloud.co[i];
+      const float3 new_position = transform * old_position;
+      copy_v3_v3(new_vert.co, new_position);
+      memcpy(&new_vert.no, point_normal_short, sizeof(point_normal_short));
+    }
+  });
+}
+
 static Mesh *join_mesh_topology_and_builtin_attributes(Span<GeometryInstanceGroup> set_groups,
                                                        const bool convert_points_to_vertices)
 {
-  int totverts = 0;
-  int totloops = 0;
-  int totedges = 0;
-  int totpolys = 0;
   int64_t cd_dirty_vert = 0;
   int64_t cd_dirty_poly = 0;
   int64_t cd_dirty_edge = 0;
   int64_t cd_dirty_loop = 0;
   VectorSet<Material *> materials;
 
-  for (const GeometryInstanceGroup &set_group : set_groups) {
-    const GeometrySet &set = set_group.geometry_set;
-    const int tot_transforms = set_group.transforms.size();
+  /* Compute where the elements of every instance start in the new mesh, so that all instances
+   * can be copied in parallel afterwards. Within a group, the mesh instances come before the
+   * point cloud instances, which is the order expected by #join_attributes. */
+  Vector<MeshInstanceItem> mesh_items;
+  Vector<InstanceItem> point_items;
+  MeshElementOffsets totals;
+  for (const int group_index : set_groups.index_range()) {
+    const GeometrySet &set = set_groups[group_index].geometry_set;
+    const int tot_transforms = set_groups[group_index].transforms.size();
     if (set.has_mesh()) {
       const Mesh &mesh = *set.get_mesh_for_read();
-      totverts += mesh.totvert * tot_transforms;
-      totloops += mesh.totloop * tot_transforms;
-      totedges += mesh.totedge * tot_transforms;
-      totpolys += mesh.totpoly * tot_transforms;
+      for (const int transform_index : IndexRange(tot_transforms)) {
+        mesh_items.append({group_index, transform_index, totals});
+        totals.vert += mesh.totvert;
+        totals.edge += mesh.totedge;
+        totals.loop += mesh.totloop;
+        totals.poly += mesh.totpoly;
+      }
       cd_dirty_vert |= mesh.runtime.cd_dirty_vert;
+      if (mesh.runtime.normals_dirty_verts) {
+        cd_dirty_vert |= CD_MASK_NORMAL;
+      }
       cd_dirty_poly |= mesh.runtime.cd_dirty_poly;
       cd_dirty_edge |= mesh.runtime.cd_dirty_edge;
       cd_dirty_loop |= mesh.runtime.cd_dirty_loop;
@@ -383,16 +504,19 @@ static Mesh *join_mesh_topology_and_builtin_attributes(Span<GeometryInstanceGrou
     }
     if (convert_points_to_vertices && set.has_pointcloud()) {
       const PointCloud &pointcloud = *set.get_pointcloud_for_read();
-      totverts += pointcloud.totpoint * tot_transforms;
+      for (const int transform_index : IndexRange(tot_transforms)) {
+        point_items.append({group_index, transform_index, totals.vert});
+        totals.vert += pointcloud.totpoint;
+      }
     }
   }
 
   /* Don't create an empty mesh. */
-  if ((totverts + totloops + totedges + totpolys) == 0) {
+  if ((totals.vert + totals.loop + totals.edge + totals.poly) == 0) {
     return nullptr;
   }
 
-  Mesh *new_mesh = BKE_mesh_new_nomain(totverts, totedges, 0, totloops, totpolys);
+  Mesh *new_mesh = BKE_mesh_new_nomain(totals.vert, totals.edge, 0, totals.loop, totals.poly);
   /* Copy settings from the first input geometry set with a mesh. */
   for (const GeometryInstanceGroup &set_group : set_groups) {
     const GeometrySet &set = set_group.geometry_set;
@@ -411,86 +535,43 @@ static Mesh *join_mesh_topology_and_builtin_attributes(Span<GeometryInstanceGrou
   new_mesh->runtime.cd_dirty_edge = cd_dirty_edge;
   new_mesh->runtime.cd_dirty_loop = cd_dirty_loop;
 
-  int vert_offset = 0;
-  int loop_offset = 0;
-  int edge_offset = 0;
-  int poly_offset = 0;
-  for (const GeometryInstanceGroup &set_group : set_groups) {
-    const GeometrySet &set = set_group.geometry_set;
-    if (set.has_mesh()) {
-      const Mesh &mesh = *set.get_mesh_for_read();
-
-      Array<int> material_index_map(mesh.totcol);
-      for (const int i : IndexRange(mesh.totcol)) {
-        Material *material = mesh.mat[i];
-        const int new_material_index = materials.index_of(material);
-        material_index_map[i] = new_material_index;
-      }
-
-      for (const float4x4 &transform : set_group.transforms) {
-        for (const int i : IndexRange(mesh.totvert)) {
-          const MVert &old_vert = mesh.mvert[i];
-          MVert &new_vert = new_mesh->mvert[vert_offset + i];
-
-          new_vert = old_vert;
-
-          const float3 new_position = transform * float3(old_vert.co);
-          copy_v3_v3(new_vert.co, new_position);
-        }
-        for (const int i : IndexRange(mesh.totedge)) {
-          const MEdge &old_edge = mesh.medge[i];
-          MEdge &new_edge = new_mesh->medge[edge_offset + i];
-          new_edge = old_edge;
-          new_edge.v1 += vert_offset;
-          new_edge.v2 += vert_offset;
-        }
-        for (const int i : IndexRange(mesh.totloop)) {
-          const MLoop &old_loop = mesh.mloop[i];
-          MLoop &new_loop = new_mesh->mloop[loop_offset + i];
-          new_loop = old_loop;
-          new_loop.v += vert_offset;
-          new_loop.e += edge_offset;
-        }
-        for (const int i : IndexRange(mesh.totpoly)) {
-          const MPoly &old_poly = mesh.mpoly[i];
-          MPoly &new_poly = new_mesh->mpoly[poly_offset + i];
-          new_poly = old_poly;
-          new_poly.loopstart += loop_offset;
-          if (old_poly.mat_nr >= 0 && old_poly.mat_nr < mesh.totcol) {
-            new_poly.mat_nr = material_index_map[new_poly.mat_nr];
-          }
-          else {
-            /* The material index was invalid before. */
-            new_poly.mat_nr = 0;
-          }
-        }
-
-        vert_offset += mesh.totvert;
-        loop_offset += mesh.totloop;
-        edge_offset += mesh.totedge;
-        poly_offset += mesh.totpoly;
-      }
+  Array<Array<int>> material_index_maps(set_groups.size());
+  for (const int group_index : set_groups.index_range()) {
+    const Mesh *mesh = set_groups[group_index].geometry_set.get_mesh_for_read();
+    if (mesh == nullptr) {
+      continue;
     }
-
-    const float3 point_normal{0.0f, 0.0f, 1.0f};
-    short point_normal_short[3];
-    normal_float_to_short_v3(point_normal_short, point_normal);
-
-    if (convert_points_to_vertices && set.has_pointcloud()) {
-      const PointCloud &pointcloud = *set.get_pointcloud_for_read();
-      for (const float4x4 &transform : set_group.transforms) {
-        for (const int i : IndexRange(pointcloud.totpoint)) {
-          MVert &new_vert = new_mesh->mvert[vert_offset + i];
-          const float3 old_position = pointcloud.co[i];
-          const float3 new_position = transform * old_position;
-          copy_v3_v3(new_vert.co, new_position);
-          memcpy(&new_vert.no, point_normal_short, sizeof(point_normal_short));
-        }
-        vert_offset += pointcloud.totpoint;
-      }
+    Array<int> &material_index_map = material_index_maps[group_index];
+    material_index_map.reinitialize(mesh->totcol);
+    for (const int i : IndexRange(mesh->totcol)) {
+      Material *material = mesh->mat[i];
+      const int new_material_index = materials.index_of(material);
+      material_index_map[i] = new_material_index;
     }
   }
 
+  threading::parallel_for(
+      mesh_items.index_range(), instance_items_grain_size, [&](IndexRange range) {
+        for (const MeshInstanceItem &item : mesh_items.as_span().slice(range)) {
+          const GeometryInstanceGroup &set_group = set_groups[item.group_index];
+          const Mesh &mesh = *set_group.geometry_set.get_mesh_for_read();
+          copy_transformed_mesh(mesh,
+                                set_group.transforms[item.transform_index],
+                                material_index_maps[item.group_index],
+                                item.offsets,
+                                *new_mesh);
+        }
+      });
+  threading::parallel_for(
+      point_items.index_range(), instance_items_grain_size, [&](IndexRange range) {
+        for (const InstanceItem &item : point_items.as_span().slice(range)) {
+          const GeometryInstanceGroup &set_group = set_groups[item.group_index];
+          const PointCloud &pointcloud = *set_group.geometry_set.get_pointcloud_for_read();
+          copy_transformed_points_to_vertices(
+              pointcloud, set_group.transforms[item.transform_index], item.offset, *new_mesh);
+        }
+      });
+
   return new_mesh;
 }
 
@@ -516,48 +597,81 @@ static void join_attributes(Span<GeometryInstanceGroup> set_groups,
 
     fn::GVMutableArray_GSpan dst_span{*write_attribute.varray};
 
+    /* Compute where the values of every instance start in the result first, so that the
+     * instances can be copied in parallel. */
+    const int64_t tot_sources = set_groups.size() * component_types.size();
+    Vector<AttributeInstanceItem> items;
     int offset = 0;
-    for (const GeometryInstanceGroup &set_group : set_groups) {
+    for (const int group_index : set_groups.index_range()) {
+      const GeometryInstanceGroup &set_group = set_groups[group_index];
       const GeometrySet &set = set_group.geometry_set;
-      for (const GeometryComponentType component_type : component_types) {
-        if (set.has(component_type)) {
-          const GeometryComponent &component = *set.get_component_for_read(component_type);
-          const int domain_size = component.attribute_domain_size(domain_output);
-          if (domain_size == 0) {
-            continue; /* Domain size is 0, so no need to increment the offset. */
-          }
-          GVArrayPtr source_attribute = component.attribute_try_get_for_read(
-              name, domain_output, data_type_output);
-
-          if (source_attribute) {
-            fn::GVArray_GSpan src_span{*source_attribute};
-            const void *src_buffer = src_span.data();
-            for (const int UNUSED(i) : set_group.transforms.index_range()) {
-              void *dst_buffer = dst_span[offset];
-              cpp_type->copy_assign_n(src_buffer, dst_buffer, domain_size);
-              offset += domain_size;
-            }
-          }
-          else {
-            offset += domain_size * set_group.transforms.size();
-          }
+      for (const int component_index : component_types.index_range()) {
+        const GeometryComponentType component_type = component_types[component_index];
+        if (!set.has(component_type)) {
+          continue;
+        }
+        const GeometryComponent &component = *set.get_component_for_read(component_type);
+        const int domain_size = component.attribute_domain_size(domain_output);
+        if (domain_size == 0) {
+          continue;
+        }
+        const int source_index = group_index * component_types.size() + component_index;
+        for (const int UNUSED(i) : set_group.transforms.index_range()) {
+          items.append({source_index, offset, domain_size});
+          offset += domain_size;
         }
       }
     }
 
+    /* The source attributes are shared by all instances of a group. */
+    Array<GVArrayPtr> source_attributes(tot_sources);
+    Array<std::unique_ptr<fn::GVArray_GSpan>> source_spans(tot_sources);
+    threading::parallel_for(IndexRange(tot_sources), 1, [&](IndexRange range) {
+      for (const int source_index : range) {
+        const GeometrySet &set = set_groups[source_index / component_types.size()].geometry_set;
+        const GeometryComponentType component_type =
+            component_types[source_index % component_types.size()];
+        if (!set.has(component_type)) {
+          continue;
+        }
+        const GeometryComponent &component = *set.get_component_for_read(component_type);
+        source_attributes[source_index] = component.attribute_try_get_for_read(
+            name, domain_output, data_type_output);
+        if (source_attributes[source_index]) {
+          source_spans[source_index] = std::make_unique<fn::GVArray_GSpan>(
+              *source_attributes[source_index]);
+        }
+      }
+    });
+
+    threading::parallel_for(items.index_range(), instance_items_grain_size, [&](IndexRange range) {
+      for (const AttributeInstanceItem &item : items.as_span().slice(range)) {
+        const fn::GVArray_GSpan *src_span = source_spans[item.source_index].get();
+        if (src_span == nullptr) {
+          continue;
+        }
+        cpp_type->copy_assign_n(src_span->data(), dst_span[item.offset], item.size);
+      }
+    });
+
     dst_span.save();
   }
 }
 
 static PointCloud *join_pointcloud_position_attribute(Span<GeometryInstanceGroup> set_groups)
 {
-  /* Count the total number of points. */
+  /* Count the total number of points and where the points of each instance start. */
+  Vector<InstanceItem> items;
   int totpoint = 0;
-  for (const GeometryInstanceGroup &set_group : set_groups) {
-    const GeometrySet &set = set_group.geometry_set;
-    if (set.has<PointCloudComponent>()) {
-      const PointCloudComponent &component = *set.get_component_for_read<PointCloudComponent>();
-      totpoint += component.attribute_domain_size(ATTR_DOMAIN_POINT);
+  for (const int group_index : set_groups.index_range()) {
+    const GeometryInstanceGroup &set_group = set_groups[group_index];
+    const PointCloud *pointcloud = set_group.geometry_set.get_pointcloud_for_read();
+    if (pointcloud == nullptr) {
+      continue;
+    }
+    for (const int transform_index : set_group.transforms.index_range()) {
+      items.append({group_index, transform_index, totpoint});
+      totpoint += pointcloud->totpoint;
     }
   }
   if (totpoint == 0) {
@@ -568,20 +682,18 @@ static PointCloud *join_pointcloud_position_attribute(Span<GeometryInstanceGroup
   MutableSpan new_positions{(float3 *)new_pointcloud->co, new_pointcloud->totpoint};
 
   /* Transform each instance's point locations into the new point cloud. */
-  int offset = 0;
-  for (const GeometryInstanceGroup &set_group : set_groups) {
-    const GeometrySet &set = set_group.geometry_set;
-    const PointCloud *pointcloud = set.get_pointcloud_for_read();
-    if (pointcloud == nullptr) {
-      continue;
-    }
-    for (const float4x4 &transform : set_group.transforms) {
-      for (const int i : IndexRange(pointcloud->totpoint)) {
-        new_positions[offset + i] = transform * float3(pointcloud->co[i]);
-      }
-      offset += pointcloud->totpoint;
+  threading::parallel_for(items.index_range(), instance_items_grain_size, [&](IndexRange range) {
+    for (const InstanceItem &item : items.as_span().slice(range)) {
+      const GeometryInstanceGroup &set_group = set_groups[item.group_index];
+      const PointCloud &pointcloud = *set_group.geometry_set.get_pointcloud_for_read();
+      const float4x4 &transform = set_group.transforms[item.transform_index];
+      threading::parallel_for(IndexRange(pointcloud.totpoint), 2048, [&](IndexRange points) {
+        for (const int i : points) {
+          new_positions[item.offset + i] = transform * float3(pointcloud.co[i]);
+        }
+      });
     }
-  }
+  });
 
   return new_pointcloud;
 }
@@ -617,9 +729,15 @@ static CurveEval *join_curve_splines_and_builtin_attributes(Span<GeometryInstanc
   return new_curve;
 }
 
-static void join_instance_groups_mesh(Span<GeometryInstanceGroup> set_groups,
-                                      bool convert_points_to_vertices,
-                                      GeometrySet &result)
+/**
+ * Join the meshes of all groups into a single mesh in the result, with every instance
+ * transformed. The groups are copied in parallel.
+ *
+ * \param convert_points_to_vertices: Also add the points of point clouds as loose vertices.
+ */
+void join_instance_groups_mesh(Span<GeometryInstanceGroup> set_groups,
+                               bool convert_points_to_vertices,
+                               GeometrySet &result)
 {
   Mesh *new_mesh = join_mesh_topology_and_builtin_attributes(set_groups,
                                                              convert_points_to_vertices);
@@ -647,8 +765,11 @@ static void join_instance_groups_mesh(Span<GeometryInstanceGroup> set_groups,
       set_groups, component_types, attributes, static_cast<GeometryComponent &>(dst_component));
 }
 
-static void join_instance_groups_pointcloud(Span<GeometryInstanceGroup> set_groups,
-                                            GeometrySet &result)
+/**
+ * Join the point clouds of all groups into a single point cloud in the result, with every
+ * instance transformed. The groups are copied in parallel.
+ */
+void join_instance_groups_pointcloud(Span<GeometryInstanceGroup> set_groups, GeometrySet &result)
 {
   PointCloud *new_pointcloud = join_pointcloud_position_attribute(set_groups);
   if (new_pointcloud == nullptr) {
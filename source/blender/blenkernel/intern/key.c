@@ -30,7 +30,9 @@
 #include "BLI_blenlib.h"
 #include "BLI_endian_switch.h"
 #include "BLI_math_vector.h"
+#include "BLI_simd.h"
 #include "BLI_string_utils.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BLT_translation.h"
@@ -878,6 +880,160 @@ static void cp_cu_key(Curve *cu,
   }
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Relative Shape Keys of Coordinates
+ *
+ * Specialized version of #key_evaluate_relative for meshes and lattices, where every element is
+ * a single coordinate. Rigs easily have hundreds of shape keys, so only keys which have an
+ * influence are gathered, and they are applied in chunks of elements which stay in cache while
+ * all keys are blended into them. Chunks are evaluated in parallel.
+ * \{ */
+
+#define KEY_BLEND_CHUNK_SIZE 256
+
+typedef struct KeyBlendTarget {
+  const float (*from)[3];
+  const float (*reffrom)[3];
+  /** Vertex group weights, NULL when the key affects all elements. */
+  const float *weights;
+  float influence;
+} KeyBlendTarget;
+
+typedef struct KeyBlendData {
+  float (*out)[3];
+  const KeyBlendTarget *targets;
+  int targets_num;
+  int start, end;
+} KeyBlendData;
+
+static void key_blend_target_range(float (*out)[3],
+                                   const KeyBlendTarget *target,
+                                   const int start,
+                                   const int end)
+{
+  const float(*from)[3] = target->from;
+  const float(*reffrom)[3] = target->reffrom;
+  const float *weights = target->weights;
+  int i = start;
+
+#ifdef BLI_HAVE_SSE2
+  /* Four coordinates are twelve floats, or three SSE registers. */
+  const __m128 influence = _mm_set1_ps(target->influence);
+  for (; i + 4 <= end; i += 4) {
+    __m128 fac[3];
+    if (weights) {
+      const __m128 w = _mm_mul_ps(_mm_loadu_ps(&weights[i]), influence);
+      fac[0] = _mm_shuffle_ps(w, w, _MM_SHUFFLE(1, 0, 0, 0));
+      fac[1] = _mm_shuffle_ps(w, w, _MM_SHUFFLE(2, 2, 1, 1));
+      fac[2] = _mm_shuffle_ps(w, w, _MM_SHUFFLE(3, 3, 3, 2));
+    }
+    else {
+      fac[0] = fac[1] = fac[2] = influence;
+    }
+
+    float *o = out[i];
+    const float *r = reffrom[i];
+    const float *f = from[i];
+    for (int j = 0; j < 3; j++) {
+      const __m128 delta = _mm_sub_ps(_mm_loadu_ps(r + j * 4), _mm_loadu_ps(f + j * 4));
+      const __m128 value = _mm_sub_ps(_mm_loadu_ps(o + j * 4), _mm_mul_ps(fac[j], delta));
+      _mm_storeu_ps(o + j * 4, value);
+    }
+  }
+#endif
+
+  for (; i < end; i++) {
+    const float fac = weights ? (weights[i] * target->influence) : target->influence;
+    rel_flerp(KEYELEM_FLOAT_LEN_COORD, out[i], reffrom[i], from[i], fac);
+  }
+}
+
+static void key_evaluate_relative_coords_cb(void *__restrict userdata,
+                                            const int chunk_index,
+                                            const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KeyBlendData *data = userdata;
+  const int chunk_start = data->start + chunk_index * KEY_BLEND_CHUNK_SIZE;
+  const int chunk_end = min_ii(chunk_start + KEY_BLEND_CHUNK_SIZE, data->end);
+
+  /* Keys are applied in the same order as in #key_evaluate_relative,
+   * so the result does not differ. */
+  for (int i = 0; i < data->targets_num; i++) {
+    key_blend_target_range(data->out, &data->targets[i], chunk_start, chunk_end);
+  }
+}
+
+static bool key_is_coords(const Key *key, const int mode, const int poinsize, const int step)
+{
+  return (mode == KEY_MODE_DUMMY) && (key->elemstr[1] == IPO_FLOAT) && (key->elemstr[2] == 0) &&
+         (key->elemsize == sizeof(float[KEYELEM_FLOAT_LEN_COORD])) &&
+         (poinsize == key->elemsize) && (step == 1);
+}
+
+static void key_evaluate_relative_coords(const int start,
+                                         const int end,
+                                         const int tot,
+                                         float (*out)[3],
+                                         Key *key,
+                                         KeyBlock *actkb,
+                                         float **per_keyblock_weights)
+{
+  KeyBlendTarget *targets = MEM_malloc_arrayN(key->totkey, sizeof(*targets), __func__);
+  char **freedata = MEM_calloc_arrayN(key->totkey, sizeof(*freedata), __func__);
+  int targets_num = 0;
+
+  KeyBlock *kb;
+  int keyblock_index;
+  for (kb = key->block.first, keyblock_index = 0; kb; kb = kb->next, keyblock_index++) {
+    /* Only with value, and no difference allowed. */
+    if (kb == key->refkey || (kb->flag & KEYBLOCK_MUTE) || kb->curval == 0.0f ||
+        kb->totelem != tot) {
+      continue;
+    }
+    /* Reference now can be any block. */
+    KeyBlock *refb = BLI_findlink(&key->block, kb->relative);
+    if (refb == NULL) {
+      continue;
+    }
+
+    KeyBlendTarget *target = &targets[targets_num++];
+    target->from = (const float(*)[3])key_block_get_data(
+        key, actkb, kb, &freedata[keyblock_index]);
+    /* For meshes, use the original values instead of the bmesh values to
+     * maintain a constant offset. */
+    target->reffrom = (const float(*)[3])refb->data;
+    target->weights = per_keyblock_weights ? per_keyblock_weights[keyblock_index] : NULL;
+    target->influence = kb->curval;
+  }
+
+  if (targets_num != 0) {
+    KeyBlendData data = {
+        .out = out,
+        .targets = targets,
+        .targets_num = targets_num,
+        .start = start,
+        .end = end,
+    };
+
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.use_threading = (end - start) > KEY_BLEND_CHUNK_SIZE * 4;
+    settings.min_iter_per_thread = 1;
+    const int chunks_num = (end - start + KEY_BLEND_CHUNK_SIZE - 1) / KEY_BLEND_CHUNK_SIZE;
+    BLI_task_parallel_range(0, chunks_num, &data, key_evaluate_relative_coords_cb, &settings);
+  }
+
+  for (int i = 0; i < key->totkey; i++) {
+    MEM_SAFE_FREE(freedata[i]);
+  }
+  MEM_freeN(freedata);
+  MEM_freeN(targets);
+}
+
+#undef KEY_BLEND_CHUNK_SIZE
+
+/** \} */
+
 static void key_evaluate_relative(const int start,
                                   int end,
                                   const int tot,
@@ -915,6 +1071,11 @@ static void key_evaluate_relative(const int start,
   cp_key(start, end, tot, basispoin, key, actkb, key->refkey, NULL, mode);
 
   /* step 2: do it */
+  if (key_is_coords(key, mode, poinsize, step)) {
+    key_evaluate_relative_coords(
+        start, end, tot, (float(*)[3])basispoin, key, actkb, per_keyblock_weights);
+    return;
+  }
 
   for (kb = key->block.first, keyblock_index = 0; kb; kb = kb->next, keyblock_index++) {
     if (kb != key->refkey) {
@@ -93,6 +93,42 @@ static void mesh_init_data(ID *id)
   mesh->face_sets_color_seed = BLI_hash_int(PIL_check_seconds_timer_i() & UINT_MAX);
 }
 
+/**
+ * Layers that are shared with copies made with the given #LIB_ID_COPY_CD_SHARE_ATTRIBUTES or
+ * #LIB_ID_COPY_CD_SHARE_GEOMETRY flag. Shared layers are flagged as referenced and have to be
+ * copied before they are written to (see #CustomData_duplicate_referenced_layer).
+ */
+static void mesh_shared_custom_data_mask(const int flag, CustomData_MeshMasks *r_mask)
+{
+  memset(r_mask, 0, sizeof(*r_mask));
+  if (flag & LIB_ID_COPY_CD_SHARE_GEOMETRY) {
+    /* Copy-on-write meshes share all layers with the original mesh. Tools that write to the
+     * original in place tag it for an update afterwards, which makes a new copy. Until then the
+     * copy sees the change already, which is what the update would do as well. Vertex normals
+     * are recalculated in place on the evaluated side, from the same shared positions.
+     *
+     * Multi-resolution data stays a copy, it is moved between meshes on conversion. */
+    *r_mask = CD_MASK_MESH;
+    r_mask->fmask = 0;
+    r_mask->lmask &= ~(CD_MASK_MDISPS | CD_MASK_GRID_PAINT_MASK);
+  }
+  else if (flag & LIB_ID_COPY_CD_SHARE_ATTRIBUTES) {
+    /* Generic attributes are copied by the attribute API before they are written to. Other
+     * layers of meshes in geometry components are often written to directly. */
+    r_mask->vmask = r_mask->emask = r_mask->lmask = r_mask->pmask = CD_MASK_PROP_ALL;
+  }
+}
+
+void BKE_mesh_share_custom_data(Mesh *mesh, const int flag)
+{
+  CustomData_MeshMasks mask;
+  mesh_shared_custom_data_mask(flag, &mask);
+  CustomData_share_layers(&mesh->vdata, mask.vmask, mesh->totvert);
+  CustomData_share_layers(&mesh->edata, mask.emask, mesh->totedge);
+  CustomData_share_layers(&mesh->ldata, mask.lmask, mesh->totloop);
+  CustomData_share_layers(&mesh->pdata, mask.pmask, mesh->totpoly);
+}
+
 static void mesh_copy_data(Main *bmain, ID *id_dst, const ID *id_src, const int flag)
 {
   Mesh *mesh_dst = (Mesh *)id_dst;
@@ -129,10 +165,50 @@ static void mesh_copy_data(Main *bmain, ID *id_dst, const ID *id_src, const int
   BKE_defgroup_copy_list(&mesh_dst->vertex_group_names, &mesh_src->vertex_group_names);
 
   const eCDAllocType alloc_type = (flag & LIB_ID_COPY_CD_REFERENCE) ? CD_REFERENCE : CD_DUPLICATE;
-  CustomData_copy(&mesh_src->vdata, &mesh_dst->vdata, mask.vmask, alloc_type, mesh_dst->totvert);
-  CustomData_copy(&mesh_src->edata, &mesh_dst->edata, mask.emask, alloc_type, mesh_dst->totedge);
-  CustomData_copy(&mesh_src->ldata, &mesh_dst->ldata, mask.lmask, alloc_type, mesh_dst->totloop);
-  CustomData_copy(&mesh_src->pdata, &mesh_dst->pdata, mask.pmask, alloc_type, mesh_dst->totpoly);
+  CustomData_MeshMasks shared_mask;
+  mesh_shared_custom_data_mask(flag, &shared_mask);
+  CustomData_copy(&mesh_src->vdata,
+                  &mesh_dst->vdata,
+                  mask.vmask & ~shared_mask.vmask,
+                  alloc_type,
+                  mesh_dst->totvert);
+  CustomData_copy(&mesh_src->edata,
+                  &mesh_dst->edata,
+                  mask.emask & ~shared_mask.emask,
+                  alloc_type,
+                  mesh_dst->totedge);
+  CustomData_copy(&mesh_src->ldata,
+                  &mesh_dst->ldata,
+                  mask.lmask & ~shared_mask.lmask,
+                  alloc_type,
+                  mesh_dst->totloop);
+  CustomData_copy(&mesh_src->pdata,
+                  &mesh_dst->pdata,
+                  mask.pmask & ~shared_mask.pmask,
+                  alloc_type,
+                  mesh_dst->totpoly);
+  if (flag & (LIB_ID_COPY_CD_SHARE_ATTRIBUTES | LIB_ID_COPY_CD_SHARE_GEOMETRY)) {
+    CustomData_merge(&mesh_src->vdata,
+                     &mesh_dst->vdata,
+                     mask.vmask & shared_mask.vmask,
+                     CD_SHARE,
+                     mesh_dst->totvert);
+    CustomData_merge(&mesh_src->edata,
+                     &mesh_dst->edata,
+                     mask.emask & shared_mask.emask,
+                     CD_SHARE,
+                     mesh_dst->totedge);
+    CustomData_merge(&mesh_src->ldata,
+                     &mesh_dst->ldata,
+                     mask.lmask & shared_mask.lmask,
+                     CD_SHARE,
+                     mesh_dst->totloop);
+    CustomData_merge(&mesh_src->pdata,
+                     &mesh_dst->pdata,
+                     mask.pmask & shared_mask.pmask,
+                     CD_SHARE,
+                     mesh_dst->totpoly);
+  }
   if (do_tessface) {
     CustomData_copy(&mesh_src->fdata, &mesh_dst->fdata, mask.fmask, alloc_type, mesh_dst->totface);
   }
@@ -1771,10 +1847,31 @@ void BKE_mesh_vert_coords_apply(Mesh *mesh, const float (*vert_coords)[3])
   /* This will just return the pointer if it wasn't a referenced layer. */
   MVert *mv = CustomData_duplicate_referenced_layer(&mesh->vdata, CD_MVERT, mesh->totvert);
   mesh->mvert = mv;
+  if ((mesh->runtime.cd_dirty_vert & CD_MASK_NORMAL) ||
+      !mesh->runtime.vert_normals_known_valid) {
+    /* Without valid normals for the current positions, the normals of vertices that didn't move
+     * can't be kept either. */
+    for (int i = 0; i < mesh->totvert; i++, mv++) {
+      copy_v3_v3(mv->co, vert_coords[i]);
+    }
+    BKE_mesh_normals_tag_dirty(mesh);
+    return;
+  }
+
+  /* Deformations often only move part of the mesh (hooks, vertex group influence, ...),
+   * only tag the moved vertices so the normals can be updated partially. */
+  int moved_verts_num = 0;
   for (int i = 0; i < mesh->totvert; i++, mv++) {
-    copy_v3_v3(mv->co, vert_coords[i]);
+    if (!equals_v3v3(mv->co, vert_coords[i])) {
+      copy_v3_v3(mv->co, vert_coords[i]);
+      BKE_mesh_vert_normal_tag_dirty(mesh, i);
+      moved_verts_num++;
+    }
+  }
+  if (moved_verts_num > mesh->totvert / 4) {
+    /* Recomputing everything is cheaper than finding the affected polygons. */
+    BKE_mesh_normals_tag_dirty(mesh);
   }
-  mesh->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
 }
 
 void BKE_mesh_vert_coords_apply_with_mat4(Mesh *mesh,
@@ -1787,7 +1884,7 @@ void BKE_mesh_vert_coords_apply_with_mat4(Mesh *mesh,
   for (int i = 0; i < mesh->totvert; i++, mv++) {
     mul_v3_m4v3(mv->co, mat, vert_coords[i]);
   }
-  mesh->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+  BKE_mesh_normals_tag_dirty(mesh);
 }
 
 void BKE_mesh_vert_normals_apply(Mesh *mesh, const short (*vert_normals)[3])
@@ -1799,6 +1896,8 @@ void BKE_mesh_vert_normals_apply(Mesh *mesh, const short (*vert_normals)[3])
     copy_v3_v3_short(mv->no, vert_normals[i]);
   }
   mesh->runtime.cd_dirty_vert &= ~CD_MASK_NORMAL;
+  mesh->runtime.vert_normals_known_valid = true;
+  MEM_SAFE_FREE(mesh->runtime.normals_dirty_verts);
 }
 
 /**
@@ -1851,6 +1950,7 @@ void BKE_mesh_calc_normals_split_ex(Mesh *mesh, MLoopNorSpaceArray *r_lnors_spac
                                polynors,
                                false);
     free_polynors = true;
+    mesh->runtime.vert_normals_known_valid = true;
   }
 
   BKE_mesh_normals_loop_split(mesh->mvert,
@@ -1876,6 +1976,7 @@ void BKE_mesh_calc_normals_split_ex(Mesh *mesh, MLoopNorSpaceArray *r_lnors_spac
   mesh->runtime.cd_dirty_vert &= ~CD_MASK_NORMAL;
   mesh->runtime.cd_dirty_poly &= ~CD_MASK_NORMAL;
   mesh->runtime.cd_dirty_loop &= ~CD_MASK_NORMAL;
+  MEM_SAFE_FREE(mesh->runtime.normals_dirty_verts);
 }
 
 void BKE_mesh_calc_normals_split(Mesh *mesh)
@@ -36,20 +36,25 @@
 
 #include "BLI_alloca.h"
 #include "BLI_bitmap.h"
+#include "BLI_float3.hh"
 
 #include "BLI_linklist.h"
 #include "BLI_linklist_stack.h"
+#include "BLI_map.hh"
 #include "BLI_math.h"
 #include "BLI_memarena.h"
 #include "BLI_stack.h"
 #include "BLI_task.h"
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
 
 #include "BKE_customdata.h"
 #include "BKE_editmesh_cache.h"
 #include "BKE_global.h"
 #include "BKE_mesh.h"
 
+#include "atomic_ops.h"
+
 // #define DEBUG_TIME
 
 #ifdef DEBUG_TIME
@@ -370,12 +375,212 @@ void BKE_mesh_calc_normals_poly(MVert *mverts,
   MEM_freeN(lnors_weighted);
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Partial Mesh Normal Calculation
+ *
+ * When only a few vertices moved, only the normals of the polygons using them and the normals of
+ * the vertices of those polygons change. Recomputing these is much cheaper than recomputing all
+ * normals, as the full mesh is only scanned for the topology, not for any normal computation.
+ * \{ */
+
+struct MeshCalcNormalsPartialData {
+  const MPoly *mpolys;
+  const MLoop *mloop;
+  const MVert *mverts;
+  const int *poly_indices;
+  float (*pnors)[3];
+};
+
+static void mesh_calc_normals_poly_partial_cb(void *__restrict userdata,
+                                              const int i,
+                                              const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  MeshCalcNormalsPartialData *data = (MeshCalcNormalsPartialData *)userdata;
+  const MPoly *mp = &data->mpolys[data->poly_indices[i]];
+  const MLoop *ml = &data->mloop[mp->loopstart];
+  const MVert *mverts = data->mverts;
+  float *pnor = data->pnors[i];
+
+  /* Newell's Method, matching #mesh_calc_normals_poly_prepare_cb exactly,
+   * so that partially updated normals don't differ from fully recomputed ones. */
+  const float *v_prev = mverts[ml[mp->totloop - 1].v].co;
+  zero_v3(pnor);
+  for (int j = 0; j < mp->totloop; j++) {
+    const float *v_curr = mverts[ml[j].v].co;
+    add_newell_cross_v3_v3v3(pnor, v_prev, v_curr);
+    v_prev = v_curr;
+  }
+  if (UNLIKELY(normalize_v3(pnor) == 0.0f)) {
+    pnor[2] = 1.0f;
+  }
+}
+
+static bool mesh_poly_uses_any_vert(const MPoly *mp, const MLoop *mloop, const BLI_bitmap *verts)
+{
+  const MLoop *ml = &mloop[mp->loopstart];
+  for (int i = 0; i < mp->totloop; i++, ml++) {
+    if (BLI_BITMAP_TEST(verts, ml->v)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Recompute the normals of the vertices in \a dirty_verts, assuming all other normals are valid.
+ * Polygon normals in \a r_polynors (optional) are updated for all polygons that are affected.
+ */
+static void mesh_calc_normals_poly_partial(MVert *mverts,
+                                           const int numVerts,
+                                           const MLoop *mloop,
+                                           const MPoly *mpolys,
+                                           const int numPolys,
+                                           const BLI_bitmap *dirty_verts,
+                                           float (*r_polynors)[3])
+{
+  using blender::float3;
+
+  /* Vertices sharing a polygon with a dirty vertex get a different normal as well. */
+  BLI_bitmap *update_verts = BLI_BITMAP_NEW(numVerts, __func__);
+  const MPoly *mp = mpolys;
+  for (int i = 0; i < numPolys; i++, mp++) {
+    if (mesh_poly_uses_any_vert(mp, mloop, dirty_verts)) {
+      const MLoop *ml = &mloop[mp->loopstart];
+      for (int j = 0; j < mp->totloop; j++, ml++) {
+        BLI_BITMAP_ENABLE(update_verts, ml->v);
+      }
+    }
+  }
+
+  /* All polygons around the updated vertices contribute to their normals. */
+  blender::Vector<int> poly_indices;
+  mp = mpolys;
+  for (int i = 0; i < numPolys; i++, mp++) {
+    if (mesh_poly_uses_any_vert(mp, mloop, update_verts)) {
+      poly_indices.append(i);
+    }
+  }
+
+  float(*pnors)[3] = (float(*)[3])MEM_malloc_arrayN(
+      (size_t)poly_indices.size(), sizeof(*pnors), __func__);
+
+  MeshCalcNormalsPartialData data;
+  data.mpolys = mpolys;
+  data.mloop = mloop;
+  data.mverts = mverts;
+  data.poly_indices = poly_indices.data();
+  data.pnors = pnors;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+  BLI_task_parallel_range(
+      0, (int)poly_indices.size(), &data, mesh_calc_normals_poly_partial_cb, &settings);
+
+  /* Accumulate angle weighted polygon normals, like #mesh_calc_normals_poly_prepare_cb. */
+  blender::Map<int, float3> vnors;
+  for (const int i : poly_indices.index_range()) {
+    mp = &mpolys[poly_indices[i]];
+    const MLoop *ml = &mloop[mp->loopstart];
+    const int nverts = mp->totloop;
+
+    if (r_polynors) {
+      copy_v3_v3(r_polynors[poly_indices[i]], pnors[i]);
+    }
+
+    float3 prev_edge = float3(mverts[ml[nverts - 1].v].co) - float3(mverts[ml[0].v].co);
+    normalize_v3(prev_edge);
+    for (int j = 0; j < nverts; j++) {
+      const int j_next = (j + 1) % nverts;
+      float3 cur_edge = float3(mverts[ml[j].v].co) - float3(mverts[ml[j_next].v].co);
+      normalize_v3(cur_edge);
+
+      if (BLI_BITMAP_TEST(update_verts, ml[j].v)) {
+        const float fac = saacos(-dot_v3v3(cur_edge, prev_edge));
+        madd_v3_v3fl(vnors.lookup_or_add_default(ml[j].v), pnors[i], fac);
+      }
+      prev_edge = cur_edge;
+    }
+  }
+
+  for (blender::Map<int, float3>::MutableItem item : vnors.items()) {
+    MVert *mv = &mverts[item.key];
+    float *no = item.value;
+    if (UNLIKELY(normalize_v3(no) == 0.0f)) {
+      normalize_v3_v3(no, mv->co);
+    }
+    normal_float_to_short_v3(mv->no, no);
+  }
+
+  /* Loose vertices, following #mesh_calc_normals_poly_finalize_cb. */
+  for (int i = 0; i < numVerts; i++) {
+    if (BLI_BITMAP_TEST(dirty_verts, i) && !BLI_BITMAP_TEST(update_verts, i)) {
+      MVert *mv = &mverts[i];
+      float no[3];
+      normalize_v3_v3(no, mv->co);
+      normal_float_to_short_v3(mv->no, no);
+    }
+  }
+
+  MEM_freeN(pnors);
+  MEM_freeN(update_verts);
+}
+
+/**
+ * Mark all vertex normals as outdated.
+ */
+void BKE_mesh_normals_tag_dirty(Mesh *mesh)
+{
+  mesh->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+  mesh->runtime.vert_normals_known_valid = false;
+  MEM_SAFE_FREE(mesh->runtime.normals_dirty_verts);
+}
+
+/**
+ * Mark the normal of a single vertex as outdated, e.g. because its position changed.
+ * The next #BKE_mesh_ensure_normals only recomputes normals around tagged vertices,
+ * unless all normals are dirty already.
+ */
+void BKE_mesh_vert_normal_tag_dirty(Mesh *mesh, const int vert_index)
+{
+  BLI_assert(vert_index >= 0 && vert_index < mesh->totvert);
+  if (mesh->runtime.cd_dirty_vert & CD_MASK_NORMAL) {
+    return;
+  }
+  if (mesh->runtime.normals_dirty_verts == nullptr) {
+    mesh->runtime.normals_dirty_verts = BLI_BITMAP_NEW(mesh->totvert, __func__);
+  }
+  BLI_BITMAP_ENABLE(mesh->runtime.normals_dirty_verts, vert_index);
+}
+
+/**
+ * Whether any vertex normal is outdated, either all of them or only some tagged vertices.
+ */
+bool BKE_mesh_vert_normals_are_dirty(const Mesh *mesh)
+{
+  return (mesh->runtime.cd_dirty_vert & CD_MASK_NORMAL) ||
+         (mesh->runtime.normals_dirty_verts != nullptr);
+}
+
+/** \} */
+
 void BKE_mesh_ensure_normals(Mesh *mesh)
 {
   if (mesh->runtime.cd_dirty_vert & CD_MASK_NORMAL) {
     BKE_mesh_calc_normals(mesh);
   }
-  BLI_assert((mesh->runtime.cd_dirty_vert & CD_MASK_NORMAL) == 0);
+  else if (mesh->runtime.normals_dirty_verts) {
+    mesh_calc_normals_poly_partial(mesh->mvert,
+                                   mesh->totvert,
+                                   mesh->mloop,
+                                   mesh->mpoly,
+                                   mesh->totpoly,
+                                   mesh->runtime.normals_dirty_verts,
+                                   nullptr);
+    MEM_SAFE_FREE(mesh->runtime.normals_dirty_verts);
+  }
+  mesh->runtime.vert_normals_known_valid = true;
+  BLI_assert(!BKE_mesh_vert_normals_are_dirty(mesh));
 }
 
 /**
@@ -403,8 +608,24 @@ void BKE_mesh_ensure_normals_for_display(Mesh *mesh)
   const bool do_poly_normals = (mesh->runtime.cd_dirty_poly & CD_MASK_NORMAL ||
                                 poly_nors == nullptr);
 
+  if (!do_vert_normals && !do_poly_normals && mesh->runtime.normals_dirty_verts) {
+    /* Only a few vertices moved, also updates the polygon normals around them. */
+    mesh_calc_normals_poly_partial(mesh->mvert,
+                                   mesh->totvert,
+                                   mesh->mloop,
+                                   mesh->mpoly,
+                                   mesh->totpoly,
+                                   mesh->runtime.normals_dirty_verts,
+                                   poly_nors);
+    MEM_SAFE_FREE(mesh->runtime.normals_dirty_verts);
+    mesh->runtime.vert_normals_known_valid = true;
+    return;
+  }
+
   if (do_vert_normals || do_poly_normals) {
     const bool do_add_poly_nors_cddata = (poly_nors == nullptr);
+    const bool only_face_normals = !do_vert_normals &&
+                                   mesh->runtime.normals_dirty_verts == nullptr;
     if (do_add_poly_nors_cddata) {
       poly_nors = (float(*)[3])MEM_malloc_arrayN(
           (size_t)mesh->totpoly, sizeof(*poly_nors), __func__);
@@ -419,7 +640,7 @@ void BKE_mesh_ensure_normals_for_display(Mesh *mesh)
                                mesh->totloop,
                                mesh->totpoly,
                                poly_nors,
-                               !do_vert_normals);
+                               only_face_normals);
 
     if (do_add_poly_nors_cddata) {
       CustomData_add_layer(&mesh->pdata, CD_NORMAL, CD_ASSIGN, poly_nors, mesh->totpoly);
@@ -427,6 +648,10 @@ void BKE_mesh_ensure_normals_for_display(Mesh *mesh)
 
     mesh->runtime.cd_dirty_vert &= ~CD_MASK_NORMAL;
     mesh->runtime.cd_dirty_poly &= ~CD_MASK_NORMAL;
+    MEM_SAFE_FREE(mesh->runtime.normals_dirty_verts);
+    if (!only_face_normals) {
+      mesh->runtime.vert_normals_known_valid = true;
+    }
   }
 }
 
@@ -450,6 +675,8 @@ void BKE_mesh_calc_normals(Mesh *mesh)
   TIMEIT_END_AVERAGED(BKE_mesh_calc_normals);
 #endif
   mesh->runtime.cd_dirty_vert &= ~CD_MASK_NORMAL;
+  mesh->runtime.vert_normals_known_valid = true;
+  MEM_SAFE_FREE(mesh->runtime.normals_dirty_verts);
 }
 
 void BKE_mesh_calc_normals_looptri(MVert *mverts,
@@ -825,6 +1052,8 @@ struct LoopSplitTaskDataCommon {
   MLoopNorSpaceArray *lnors_spacearr;
   float (*loopnors)[3];
   short (*clnors_data)[2];
+  /** Loops of cyclic smooth fans which have been walked already, set atomically. */
+  uint8_t *loops_done;
 
   /* Read-only. */
   const MVert *mverts;
@@ -845,113 +1074,170 @@ struct LoopSplitTaskDataCommon {
 /* See comment about edge_to_loops below. */
 #define IS_EDGE_SHARP(_e2l) (ELEM((_e2l)[1], INDEX_UNSET, INDEX_INVALID))
 
-static void mesh_edges_sharp_tag(LoopSplitTaskDataCommon *data,
-                                 const bool check_angle,
-                                 const float split_angle,
-                                 const bool do_sharp_edges_tag)
-{
-  const MVert *mverts = data->mverts;
-  const MEdge *medges = data->medges;
-  const MLoop *mloops = data->mloops;
-
-  const MPoly *mpolys = data->mpolys;
+#define EDGE_LOOPS_EMPTY UINT64_MAX
 
-  const int numEdges = data->numEdges;
-  const int numPolys = data->numPolys;
+struct EdgesSharpTagData {
+  LoopSplitTaskDataCommon *common_data;
+  /** The two lowest loop indices using each edge, packed to be updated atomically. */
+  uint64_t *edge_loops_lowest;
+  float split_angle_cos;
+  bool check_angle;
+  bool do_sharp_edges_tag;
+};
 
-  float(*loopnors)[3] = data->loopnors; /* NOTE: loopnors may be nullptr here. */
-  const float(*polynors)[3] = data->polynors;
+static void mesh_edges_sharp_tag_loops_cb(void *__restrict userdata,
+                                          const int mp_index,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  EdgesSharpTagData *data = (EdgesSharpTagData *)userdata;
+  LoopSplitTaskDataCommon *common_data = data->common_data;
+  const MVert *mverts = common_data->mverts;
+  const MLoop *mloops = common_data->mloops;
+  const MPoly *mp = &common_data->mpolys[mp_index];
+  float(*loopnors)[3] = common_data->loopnors; /* NOTE: loopnors may be nullptr here. */
+  int(*edge_to_loops)[2] = common_data->edge_to_loops;
+  int *loop_to_poly = common_data->loop_to_poly;
 
-  int(*edge_to_loops)[2] = data->edge_to_loops;
-  int *loop_to_poly = data->loop_to_poly;
+  const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
+  for (int ml_index = mp->loopstart; ml_index <= ml_last_index; ml_index++) {
+    const MLoop *ml = &mloops[ml_index];
 
-  BLI_bitmap *sharp_edges = do_sharp_edges_tag ? BLI_BITMAP_NEW(numEdges, __func__) : nullptr;
+    loop_to_poly[ml_index] = mp_index;
 
-  const MPoly *mp;
-  int mp_index;
+    /* Pre-populate all loop normals as if their verts were all-smooth,
+     * this way we don't have to compute those later!
+     */
+    if (loopnors) {
+      normal_short_to_float_v3(loopnors[ml_index], mverts[ml->v].no);
+    }
 
-  const float split_angle_cos = check_angle ? cosf(split_angle) : -1.0f;
+    /* Count the loops using the edge, the count is replaced by the actual loop index later. */
+    atomic_add_and_fetch_int32(&edge_to_loops[ml->e][0], 1);
+
+    /* Keep track of the two lowest loop indices of the edge, so that the result does not depend
+     * on the order in which polygons are processed. */
+    uint64_t *lowest = &data->edge_loops_lowest[ml->e];
+    const uint64_t loop = (uint64_t)ml_index;
+    uint64_t lowest_old = *lowest;
+    while (true) {
+      const uint64_t first = lowest_old >> 32;
+      const uint64_t second = lowest_old & UINT32_MAX;
+      uint64_t lowest_new;
+      if (loop < first) {
+        lowest_new = (loop << 32) | first;
+      }
+      else if (loop < second) {
+        lowest_new = (first << 32) | loop;
+      }
+      else {
+        break;
+      }
+      const uint64_t lowest_prev = atomic_cas_uint64(lowest, lowest_old, lowest_new);
+      if (lowest_prev == lowest_old) {
+        break;
+      }
+      lowest_old = lowest_prev;
+    }
+  }
+}
 
-  for (mp = mpolys, mp_index = 0; mp_index < numPolys; mp++, mp_index++) {
-    const MLoop *ml_curr;
-    int *e2l;
-    int ml_curr_index = mp->loopstart;
-    const int ml_last_index = (ml_curr_index + mp->totloop) - 1;
+static void mesh_edges_sharp_tag_edges_cb(void *__restrict userdata,
+                                          const int me_index,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  EdgesSharpTagData *data = (EdgesSharpTagData *)userdata;
+  LoopSplitTaskDataCommon *common_data = data->common_data;
+  const MLoop *mloops = common_data->mloops;
+  const MPoly *mpolys = common_data->mpolys;
+  const int *loop_to_poly = common_data->loop_to_poly;
+  const float(*polynors)[3] = common_data->polynors;
+  MEdge *me = (MEdge *)&common_data->medges[me_index];
+  int *e2l = common_data->edge_to_loops[me_index];
 
-    ml_curr = &mloops[ml_curr_index];
+  const int loops_num = e2l[0];
+  if (loops_num == 0) {
+    /* Loose edge. */
+    return;
+  }
 
-    for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++) {
-      e2l = edge_to_loops[ml_curr->e];
+  const uint64_t lowest = data->edge_loops_lowest[me_index];
+  const int ml_first_index = (int)(lowest >> 32);
+  e2l[0] = ml_first_index;
+  /* We have to check this here too, else we might miss some flat faces!!! */
+  e2l[1] = (mpolys[loop_to_poly[ml_first_index]].flag & ME_SMOOTH) ? INDEX_UNSET : INDEX_INVALID;
 
-      loop_to_poly[ml_curr_index] = mp_index;
+  if (loops_num == 1 || e2l[1] == INDEX_INVALID) {
+    return;
+  }
 
-      /* Pre-populate all loop normals as if their verts were all-smooth,
-       * this way we don't have to compute those later!
-       */
-      if (loopnors) {
-        normal_short_to_float_v3(loopnors[ml_curr_index], mverts[ml_curr->v].no);
-      }
+  const int ml_second_index = (int)(lowest & UINT32_MAX);
+  const int mp_index = loop_to_poly[ml_second_index];
+  const MPoly *mp = &mpolys[mp_index];
+  const bool is_angle_sharp = (data->check_angle &&
+                               dot_v3v3(polynors[loop_to_poly[ml_first_index]],
+                                        polynors[mp_index]) < data->split_angle_cos);
 
-      /* Check whether current edge might be smooth or sharp */
-      if ((e2l[0] | e2l[1]) == 0) {
-        /* 'Empty' edge until now, set e2l[0] (and e2l[1] to INDEX_UNSET to tag it as unset). */
-        e2l[0] = ml_curr_index;
-        /* We have to check this here too, else we might miss some flat faces!!! */
-        e2l[1] = (mp->flag & ME_SMOOTH) ? INDEX_UNSET : INDEX_INVALID;
-      }
-      else if (e2l[1] == INDEX_UNSET) {
-        const bool is_angle_sharp = (check_angle &&
-                                     dot_v3v3(polynors[loop_to_poly[e2l[0]]], polynors[mp_index]) <
-                                         split_angle_cos);
-
-        /* Second loop using this edge, time to test its sharpness.
-         * An edge is sharp if it is tagged as such, or its face is not smooth,
-         * or both poly have opposed (flipped) normals, i.e. both loops on the same edge share the
-         * same vertex, or angle between both its polys' normals is above split_angle value.
-         */
-        if (!(mp->flag & ME_SMOOTH) || (medges[ml_curr->e].flag & ME_SHARP) ||
-            ml_curr->v == mloops[e2l[0]].v || is_angle_sharp) {
-          /* NOTE: we are sure that loop != 0 here ;). */
-          e2l[1] = INDEX_INVALID;
-
-          /* We want to avoid tagging edges as sharp when it is already defined as such by
-           * other causes than angle threshold... */
-          if (do_sharp_edges_tag && is_angle_sharp) {
-            BLI_BITMAP_SET(sharp_edges, ml_curr->e, true);
-          }
-        }
-        else {
-          e2l[1] = ml_curr_index;
-        }
-      }
-      else if (!IS_EDGE_SHARP(e2l)) {
-        /* More than two loops using this edge, tag as sharp if not yet done. */
-        e2l[1] = INDEX_INVALID;
-
-        /* We want to avoid tagging edges as sharp when it is already defined as such by
-         * other causes than angle threshold... */
-        if (do_sharp_edges_tag) {
-          BLI_BITMAP_SET(sharp_edges, ml_curr->e, false);
-        }
-      }
-      /* Else, edge is already 'disqualified' (i.e. sharp)! */
+  /* Second loop using this edge, time to test its sharpness.
+   * An edge is sharp if it is tagged as such, or its face is not smooth,
+   * or both poly have opposed (flipped) normals, i.e. both loops on the same edge share the
+   * same vertex, or angle between both its polys' normals is above split_angle value.
+   */
+  if (!(mp->flag & ME_SMOOTH) || (me->flag & ME_SHARP) ||
+      mloops[ml_second_index].v == mloops[ml_first_index].v || is_angle_sharp) {
+    e2l[1] = INDEX_INVALID;
+
+    /* We want to avoid tagging edges as sharp when it is already defined as such by
+     * other causes than angle threshold... */
+    if (data->do_sharp_edges_tag && is_angle_sharp) {
+      me->flag |= ME_SHARP;
     }
   }
+  else if (loops_num > 2) {
+    /* More than two loops using this edge, tag as sharp. */
+    e2l[1] = INDEX_INVALID;
+  }
+  else {
+    e2l[1] = ml_second_index;
+  }
+}
 
-  /* If requested, do actual tagging of edges as sharp in another loop. */
-  if (do_sharp_edges_tag) {
-    MEdge *me;
-    int me_index;
-    for (me = (MEdge *)medges, me_index = 0; me_index < numEdges; me++, me_index++) {
-      if (BLI_BITMAP_TEST(sharp_edges, me_index)) {
-        me->flag |= ME_SHARP;
-      }
-    }
+/**
+ * Fill the edge to loops mapping and find out which edges are sharp, see
+ * #BKE_mesh_normals_loop_split for the meaning of its values.
+ *
+ * The first pass counts the loops of every edge and keeps track of the two lowest loop indices
+ * atomically, the second pass decides about sharpness for every edge on its own. The result is
+ * the same as when walking over all polygons in order.
+ */
+static void mesh_edges_sharp_tag(LoopSplitTaskDataCommon *data,
+                                 const bool check_angle,
+                                 const float split_angle,
+                                 const bool do_sharp_edges_tag)
+{
+  EdgesSharpTagData tag_data;
+  tag_data.common_data = data;
+  tag_data.edge_loops_lowest = (uint64_t *)MEM_malloc_arrayN(
+      (size_t)data->numEdges, sizeof(*tag_data.edge_loops_lowest), __func__);
+  tag_data.split_angle_cos = check_angle ? cosf(split_angle) : -1.0f;
+  tag_data.check_angle = check_angle;
+  tag_data.do_sharp_edges_tag = do_sharp_edges_tag;
 
-    MEM_freeN(sharp_edges);
+  for (int i = 0; i < data->numEdges; i++) {
+    tag_data.edge_loops_lowest[i] = EDGE_LOOPS_EMPTY;
   }
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = LOOP_SPLIT_TASK_BLOCK_SIZE;
+
+  BLI_task_parallel_range(0, data->numPolys, &tag_data, mesh_edges_sharp_tag_loops_cb, &settings);
+  BLI_task_parallel_range(0, data->numEdges, &tag_data, mesh_edges_sharp_tag_edges_cb, &settings);
+
+  MEM_freeN(tag_data.edge_loops_lowest);
 }
 
+#undef EDGE_LOOPS_EMPTY
+
 /**
  * Define sharp edges as needed to mimic 'autosmooth' from angle threshold.
  *
@@ -988,8 +1274,10 @@ void BKE_edges_sharp_from_angle_set(const struct MVert *mverts,
   common_data.mpolys = mpolys;
   common_data.edge_to_loops = edge_to_loops;
   common_data.loop_to_poly = loop_to_poly;
+  common_data.loopnors = nullptr;
   common_data.polynors = polynors;
   common_data.numEdges = numEdges;
+  common_data.numLoops = numLoops;
   common_data.numPolys = numPolys;
 
   mesh_edges_sharp_tag(&common_data, true, split_angle, true);
@@ -1337,54 +1625,30 @@ static void loop_split_worker_do(LoopSplitTaskDataCommon *common_data,
   }
 }
 
-static void loop_split_worker(TaskPool *__restrict pool, void *taskdata)
-{
-  LoopSplitTaskDataCommon *common_data = (LoopSplitTaskDataCommon *)BLI_task_pool_user_data(pool);
-  LoopSplitTaskData *data = (LoopSplitTaskData *)taskdata;
-
-  /* Temp edge vectors stack, only used when computing lnor spacearr. */
-  BLI_Stack *edge_vectors = common_data->lnors_spacearr ?
-                                BLI_stack_new(sizeof(float[3]), __func__) :
-                                nullptr;
-
-#ifdef DEBUG_TIME
-  TIMEIT_START_AVERAGED(loop_split_worker);
-#endif
-
-  for (int i = 0; i < LOOP_SPLIT_TASK_BLOCK_SIZE; i++, data++) {
-    /* A nullptr ml_curr is used to tag ended data! */
-    if (data->ml_curr == nullptr) {
-      break;
-    }
-
-    loop_split_worker_do(common_data, data, edge_vectors);
-  }
-
-  if (edge_vectors) {
-    BLI_stack_free(edge_vectors);
-  }
-
-#ifdef DEBUG_TIME
-  TIMEIT_END_AVERAGED(loop_split_worker);
-#endif
-}
-
 /**
- * Check whether given loop is part of an unknown-so-far cyclic smooth fan, or not.
+ * Check whether given loop is part of a cyclic smooth fan which has not been computed yet, and
+ * claim that fan for the calling thread if so.
  * Needed because cyclic smooth fans have no obvious 'entry point',
  * and yet we need to walk them once, and only once.
+ *
+ * The loop with the lowest index of the fan is used as entry point (returned in \a r_start_index),
+ * so the result does not depend on which thread claims the fan. Walked loops are tagged in
+ * \a loops_done once the fan is known to be handled, other loops of the same fan are skipped or
+ * stop walking as soon as they reach a tagged loop, so every fan is only walked about once.
  */
-static bool loop_split_generator_check_cyclic_smooth_fan(const MLoop *mloops,
-                                                         const MPoly *mpolys,
-                                                         const int (*edge_to_loops)[2],
-                                                         const int *loop_to_poly,
-                                                         const int *e2l_prev,
-                                                         BLI_bitmap *skip_loops,
-                                                         const MLoop *ml_curr,
-                                                         const MLoop *ml_prev,
-                                                         const int ml_curr_index,
-                                                         const int ml_prev_index,
-                                                         const int mp_curr_index)
+static bool loop_split_cyclic_smooth_fan_claim(const MLoop *mloops,
+                                               const MPoly *mpolys,
+                                               const int (*edge_to_loops)[2],
+                                               const int *loop_to_poly,
+                                               uint8_t *loops_done,
+                                               const int *e2l_prev,
+                                               const MLoop *ml_curr,
+                                               const MLoop *ml_prev,
+                                               const int ml_curr_index,
+                                               const int ml_prev_index,
+                                               const int mp_curr_index,
+                                               const int numLoops,
+                                               int *r_start_index)
 {
   const uint mv_pivot_index = ml_curr->v; /* The vertex we are "fanning" around! */
   const int *e2lfan_curr;
@@ -1392,6 +1656,11 @@ static bool loop_split_generator_check_cyclic_smooth_fan(const MLoop *mloops,
   /* mlfan_vert_index: the loop of our current edge might not be the loop of our current vertex! */
   int mlfan_curr_index, mlfan_vert_index, mpfan_curr_index;
 
+  if (loops_done[ml_curr_index]) {
+    /* Already walked from another loop of this fan. */
+    return false;
+  }
+
   e2lfan_curr = e2l_prev;
   if (IS_EDGE_SHARP(e2lfan_curr)) {
     /* Sharp loop, so not a cyclic smooth fan... */
@@ -1407,10 +1676,13 @@ static bool loop_split_generator_check_cyclic_smooth_fan(const MLoop *mloops,
   BLI_assert(mlfan_vert_index >= 0);
   BLI_assert(mpfan_curr_index >= 0);
 
-  BLI_assert(!BLI_BITMAP_TEST(skip_loops, mlfan_vert_index));
-  BLI_BITMAP_ENABLE(skip_loops, mlfan_vert_index);
+  blender::Vector<int, 16> fan_loops;
+  fan_loops.append(ml_curr_index);
+  int start_index = ml_curr_index;
+  bool is_cyclic = false;
 
-  while (true) {
+  /* Protects against endless walks on invalid geometry, a fan never has more loops than this. */
+  for (int i = 0; i < numLoops; i++) {
     /* Find next loop of the smooth fan. */
     BKE_mesh_loop_manifold_fan_around_vert_next(mloops,
                                                 mpolys,
@@ -1426,199 +1698,195 @@ static bool loop_split_generator_check_cyclic_smooth_fan(const MLoop *mloops,
 
     if (IS_EDGE_SHARP(e2lfan_curr)) {
       /* Sharp loop/edge, so not a cyclic smooth fan... */
-      return false;
+      break;
     }
-    /* Smooth loop/edge... */
-    if (BLI_BITMAP_TEST(skip_loops, mlfan_vert_index)) {
-      if (mlfan_vert_index == ml_curr_index) {
-        /* We walked around a whole cyclic smooth fan without finding any already-processed loop,
-         * means we can use initial ml_curr/ml_prev edge as start for this smooth fan. */
-        return true;
-      }
-      /* ... already checked in some previous looping, we can abort. */
-      return false;
+    if (mlfan_vert_index == ml_curr_index) {
+      /* We walked around a whole cyclic smooth fan. */
+      is_cyclic = true;
+      break;
+    }
+    if (loops_done[mlfan_vert_index]) {
+      /* ... the fan is already handled from another loop. */
+      break;
     }
+    fan_loops.append(mlfan_vert_index);
+    start_index = min_ii(start_index, mlfan_vert_index);
+  }
 
-    /* ... we can skip it in future, and keep checking the smooth fan. */
-    BLI_BITMAP_ENABLE(skip_loops, mlfan_vert_index);
+  /* Only one thread claims the fan, tagging its entry point first. */
+  const bool is_claimed = is_cyclic &&
+                          (atomic_fetch_and_or_uint8(&loops_done[start_index], 1) == 0);
+  for (const int loop_index : fan_loops) {
+    loops_done[loop_index] = 1;
   }
+  *r_start_index = start_index;
+  return is_claimed;
 }
 
-static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common_data)
-{
-  MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
-  float(*loopnors)[3] = common_data->loopnors;
-
-  const MLoop *mloops = common_data->mloops;
-  const MPoly *mpolys = common_data->mpolys;
-  const int *loop_to_poly = common_data->loop_to_poly;
-  const int(*edge_to_loops)[2] = common_data->edge_to_loops;
-  const int numLoops = common_data->numLoops;
-  const int numPolys = common_data->numPolys;
-
-  const MPoly *mp;
-  int mp_index;
-
-  const MLoop *ml_curr;
-  const MLoop *ml_prev;
-  int ml_curr_index;
-  int ml_prev_index;
-
-  BLI_bitmap *skip_loops = BLI_BITMAP_NEW(numLoops, __func__);
-
-  LoopSplitTaskData *data_buff = nullptr;
-  int data_idx = 0;
-
-  /* Temp edge vectors stack, only used when computing lnor spacearr
-   * (and we are not multi-threading). */
-  BLI_Stack *edge_vectors = nullptr;
+struct LoopSplitTaskTLS {
+  /** Temp edge vectors stack, only used when computing lnor spacearr. */
+  BLI_Stack *edge_vectors;
+  /**
+   * Shares its loop arrays with #LoopSplitTaskDataCommon.lnors_spacearr, but has its own memory
+   * arena to create the spaces in. Created lazily, the arenas are merged once all loops are done.
+   */
+  MLoopNorSpaceArray lnors_spacearr;
+};
 
-#ifdef DEBUG_TIME
-  TIMEIT_START_AVERAGED(loop_split_generator);
-#endif
+static MLoopNorSpaceArray *loop_split_tls_lnors_spacearr_ensure(
+    const LoopSplitTaskDataCommon *common_data, LoopSplitTaskTLS *tls_data)
+{
+  if (tls_data->lnors_spacearr.mem == nullptr) {
+    BKE_lnor_spacearr_tls_init(common_data->lnors_spacearr, &tls_data->lnors_spacearr);
+    tls_data->lnors_spacearr.num_spaces = 0;
+  }
+  /* Not tied to the arena, which may be moved to another chunk by #loop_split_poly_reduce_fn
+   * while this chunk is still used. */
+  if (tls_data->edge_vectors == nullptr) {
+    tls_data->edge_vectors = BLI_stack_new(sizeof(float[3]), __func__);
+  }
+  return &tls_data->lnors_spacearr;
+}
 
-  if (!pool) {
-    if (lnors_spacearr) {
-      edge_vectors = BLI_stack_new(sizeof(float[3]), __func__);
-    }
+static void loop_split_poly_reduce_fn(const void *__restrict UNUSED(userdata),
+                                      void *__restrict chunk_join,
+                                      void *__restrict chunk)
+{
+  LoopSplitTaskTLS *tls_join = (LoopSplitTaskTLS *)chunk_join;
+  LoopSplitTaskTLS *tls_data = (LoopSplitTaskTLS *)chunk;
+  if (tls_data->lnors_spacearr.mem == nullptr) {
+    return;
+  }
+  if (tls_join->lnors_spacearr.mem == nullptr) {
+    tls_join->lnors_spacearr = tls_data->lnors_spacearr;
+    tls_data->lnors_spacearr.mem = nullptr;
+  }
+  else {
+    BKE_lnor_spacearr_tls_join(&tls_join->lnors_spacearr, &tls_data->lnors_spacearr);
   }
+}
 
-  /* We now know edges that can be smoothed (with their vector, and their two loops),
-   * and edges that will be hard! Now, time to generate the normals.
-   */
-  for (mp = mpolys, mp_index = 0; mp_index < numPolys; mp++, mp_index++) {
-    float(*lnors)[3];
-    const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
-    ml_curr_index = mp->loopstart;
-    ml_prev_index = ml_last_index;
+static void loop_split_poly_free_fn(const void *__restrict UNUSED(userdata),
+                                    void *__restrict chunk)
+{
+  LoopSplitTaskTLS *tls_data = (LoopSplitTaskTLS *)chunk;
+  if (tls_data->edge_vectors) {
+    BLI_stack_free(tls_data->edge_vectors);
+    tls_data->edge_vectors = nullptr;
+  }
+}
 
-    ml_curr = &mloops[ml_curr_index];
-    ml_prev = &mloops[ml_prev_index];
-    lnors = &loopnors[ml_curr_index];
+/**
+ * Compute the normals of the fan starting at the given loop, which is either a sharp loop or the
+ * entry point of a cyclic smooth fan.
+ */
+static void loop_split_fan_do(LoopSplitTaskDataCommon *common_data,
+                              LoopSplitTaskTLS *tls_data,
+                              const int mp_index,
+                              const int ml_curr_index,
+                              const int ml_prev_index)
+{
+  const MLoop *mloops = common_data->mloops;
+  const int(*edge_to_loops)[2] = common_data->edge_to_loops;
 
-    for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++, lnors++) {
-      const int *e2l_curr = edge_to_loops[ml_curr->e];
-      const int *e2l_prev = edge_to_loops[ml_prev->e];
+  const MLoop *ml_curr = &mloops[ml_curr_index];
+  const MLoop *ml_prev = &mloops[ml_prev_index];
+  const int *e2l_curr = edge_to_loops[ml_curr->e];
+  const int *e2l_prev = edge_to_loops[ml_prev->e];
+
+  LoopSplitTaskData data = {nullptr};
+
+  if (IS_EDGE_SHARP(e2l_curr) && IS_EDGE_SHARP(e2l_prev)) {
+    data.lnor = &common_data->loopnors[ml_curr_index];
+    data.e2l_prev = nullptr; /* Tag as 'single' task. */
+  }
+  /* We *do not need* to check/tag loops as already computed!
+   * Due to the fact a loop only links to one of its two edges,
+   * a same fan *will never be walked more than once!*
+   * Since we consider edges having neighbor polys with inverted
+   * (flipped) normals as sharp, we are sure that no fan will be skipped,
+   * even only considering the case (sharp curr_edge, smooth prev_edge),
+   * and not the alternative (smooth curr_edge, sharp prev_edge).
+   * All this due/thanks to link between normals and loop ordering (i.e. winding).
+   */
+  else {
+    data.e2l_prev = e2l_prev; /* Also tag as 'fan' task. */
+  }
+  data.ml_curr = ml_curr;
+  data.ml_prev = ml_prev;
+  data.ml_curr_index = ml_curr_index;
+  data.ml_prev_index = ml_prev_index;
+  data.mp_index = mp_index;
+  if (common_data->lnors_spacearr) {
+    /* #MemArena is not thread-safe, create the space in the thread local one. */
+    data.lnor_space = BKE_lnor_space_create(
+        loop_split_tls_lnors_spacearr_ensure(common_data, tls_data));
+  }
 
-#if 0
-      printf("Checking loop %d / edge %u / vert %u (sharp edge: %d, skiploop: %d)...",
-             ml_curr_index,
-             ml_curr->e,
-             ml_curr->v,
-             IS_EDGE_SHARP(e2l_curr),
-             BLI_BITMAP_TEST_BOOL(skip_loops, ml_curr_index));
-#endif
+  loop_split_worker_do(common_data, &data, tls_data->edge_vectors);
+}
 
-      /* A smooth edge, we have to check for cyclic smooth fan case.
-       * If we find a new, never-processed cyclic smooth fan, we can do it now using that loop/edge
-       * as 'entry point', otherwise we can skip it. */
-
-      /* NOTE: In theory, we could make #loop_split_generator_check_cyclic_smooth_fan() store
-       * mlfan_vert_index'es and edge indexes in two stacks, to avoid having to fan again around
-       * the vert during actual computation of `clnor` & `clnorspace`.
-       * However, this would complicate the code, add more memory usage, and despite its logical
-       * complexity, #loop_manifold_fan_around_vert_next() is quite cheap in term of CPU cycles,
-       * so really think it's not worth it. */
-      if (!IS_EDGE_SHARP(e2l_curr) && (BLI_BITMAP_TEST(skip_loops, ml_curr_index) ||
-                                       !loop_split_generator_check_cyclic_smooth_fan(mloops,
-                                                                                     mpolys,
-                                                                                     edge_to_loops,
-                                                                                     loop_to_poly,
-                                                                                     e2l_prev,
-                                                                                     skip_loops,
-                                                                                     ml_curr,
-                                                                                     ml_prev,
-                                                                                     ml_curr_index,
-                                                                                     ml_prev_index,
-                                                                                     mp_index))) {
-        //              printf("SKIPPING!\n");
-      }
-      else {
-        LoopSplitTaskData *data, data_local;
+/**
+ * Compute the normals of all fans starting at the loops of the given polygon.
+ *
+ * Every fan is computed from exactly one of its loops (its first loop after a sharp edge, or its
+ * lowest loop index for cyclic smooth fans), so polygons can be processed in parallel and every
+ * loop normal is written by one thread only.
+ */
+static void loop_split_poly_fn(void *__restrict userdata,
+                               const int mp_index,
+                               const TaskParallelTLS *__restrict tls)
+{
+  LoopSplitTaskDataCommon *common_data = (LoopSplitTaskDataCommon *)userdata;
+  LoopSplitTaskTLS *tls_data = (LoopSplitTaskTLS *)tls->userdata_chunk;
 
-        //              printf("PROCESSING!\n");
+  const MLoop *mloops = common_data->mloops;
+  const MPoly *mpolys = common_data->mpolys;
+  const int(*edge_to_loops)[2] = common_data->edge_to_loops;
 
-        if (pool) {
-          if (data_idx == 0) {
-            data_buff = (LoopSplitTaskData *)MEM_calloc_arrayN(
-                LOOP_SPLIT_TASK_BLOCK_SIZE, sizeof(*data_buff), __func__);
-          }
-          data = &data_buff[data_idx];
-        }
-        else {
-          data = &data_local;
-          memset(data, 0, sizeof(*data));
-        }
+  const MPoly *mp = &mpolys[mp_index];
+  const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
+  int ml_curr_index = mp->loopstart;
+  int ml_prev_index = ml_last_index;
 
-        if (IS_EDGE_SHARP(e2l_curr) && IS_EDGE_SHARP(e2l_prev)) {
-          data->lnor = lnors;
-          data->ml_curr = ml_curr;
-          data->ml_prev = ml_prev;
-          data->ml_curr_index = ml_curr_index;
-#if 0 /* Not needed for 'single' loop. */
-          data->ml_prev_index = ml_prev_index;
-          data->e2l_prev = nullptr; /* Tag as 'single' task. */
-#endif
-          data->mp_index = mp_index;
-          if (lnors_spacearr) {
-            data->lnor_space = BKE_lnor_space_create(lnors_spacearr);
-          }
-        }
-        /* We *do not need* to check/tag loops as already computed!
-         * Due to the fact a loop only links to one of its two edges,
-         * a same fan *will never be walked more than once!*
-         * Since we consider edges having neighbor polys with inverted
-         * (flipped) normals as sharp, we are sure that no fan will be skipped,
-         * even only considering the case (sharp curr_edge, smooth prev_edge),
-         * and not the alternative (smooth curr_edge, sharp prev_edge).
-         * All this due/thanks to link between normals and loop ordering (i.e. winding).
-         */
-        else {
-#if 0 /* Not needed for 'fan' loops. */
-          data->lnor = lnors;
-#endif
-          data->ml_curr = ml_curr;
-          data->ml_prev = ml_prev;
-          data->ml_curr_index = ml_curr_index;
-          data->ml_prev_index = ml_prev_index;
-          data->e2l_prev = e2l_prev; /* Also tag as 'fan' task. */
-          data->mp_index = mp_index;
-          if (lnors_spacearr) {
-            data->lnor_space = BKE_lnor_space_create(lnors_spacearr);
-          }
-        }
+  const MLoop *ml_curr = &mloops[ml_curr_index];
+  const MLoop *ml_prev = &mloops[ml_prev_index];
 
-        if (pool) {
-          data_idx++;
-          if (data_idx == LOOP_SPLIT_TASK_BLOCK_SIZE) {
-            BLI_task_pool_push(pool, loop_split_worker, data_buff, true, nullptr);
-            data_idx = 0;
-          }
-        }
-        else {
-          loop_split_worker_do(common_data, data, edge_vectors);
-        }
-      }
+  for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++) {
+    const int *e2l_curr = edge_to_loops[ml_curr->e];
+    const int *e2l_prev = edge_to_loops[ml_prev->e];
+    int start_index;
 
-      ml_prev = ml_curr;
-      ml_prev_index = ml_curr_index;
+    if (IS_EDGE_SHARP(e2l_curr)) {
+      loop_split_fan_do(common_data, tls_data, mp_index, ml_curr_index, ml_prev_index);
+    }
+    /* A smooth edge, we have to check for cyclic smooth fan case.
+     * If this loop is part of a cyclic smooth fan which was not computed yet, we can do it now
+     * from the entry point of that fan, otherwise we can skip it. */
+    else if (loop_split_cyclic_smooth_fan_claim(mloops,
+                                                mpolys,
+                                                edge_to_loops,
+                                                common_data->loop_to_poly,
+                                                common_data->loops_done,
+                                                e2l_prev,
+                                                ml_curr,
+                                                ml_prev,
+                                                ml_curr_index,
+                                                ml_prev_index,
+                                                mp_index,
+                                                common_data->numLoops,
+                                                &start_index)) {
+      const int start_mp_index = common_data->loop_to_poly[start_index];
+      const MPoly *start_mp = &mpolys[start_mp_index];
+      const int start_prev_index = (start_index == start_mp->loopstart) ?
+                                       (start_mp->loopstart + start_mp->totloop - 1) :
+                                       (start_index - 1);
+      loop_split_fan_do(common_data, tls_data, start_mp_index, start_index, start_prev_index);
     }
-  }
-
-  /* Last block of data... Since it is calloc'ed and we use first nullptr item as stopper,
-   * everything is fine. */
-  if (pool && data_idx) {
-    BLI_task_pool_push(pool, loop_split_worker, data_buff, true, nullptr);
-  }
 
-  if (edge_vectors) {
-    BLI_stack_free(edge_vectors);
+    ml_prev = ml_curr;
+    ml_prev_index = ml_curr_index;
   }
-  MEM_freeN(skip_loops);
-
-#ifdef DEBUG_TIME
-  TIMEIT_END_AVERAGED(loop_split_generator);
-#endif
 }
 
 /**
@@ -1735,20 +2003,30 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
   /* This first loop check which edges are actually smooth, and compute edge vectors. */
   mesh_edges_sharp_tag(&common_data, check_angle, split_angle, false);
 
-  if (numLoops < LOOP_SPLIT_TASK_BLOCK_SIZE * 8) {
-    /* Not enough loops to be worth the whole threading overhead... */
-    loop_split_generator(nullptr, &common_data);
-  }
-  else {
-    TaskPool *task_pool = BLI_task_pool_create(&common_data, TASK_PRIORITY_HIGH);
+  /* We now know edges that can be smoothed (with their vector, and their two loops),
+   * and edges that will be hard! Now, time to generate the normals.
+   */
+  LoopSplitTaskTLS tls = {nullptr};
+  common_data.loops_done = (uint8_t *)MEM_calloc_arrayN(
+      (size_t)numLoops, sizeof(*common_data.loops_done), __func__);
 
-    loop_split_generator(task_pool, &common_data);
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  /* Not enough loops to be worth the whole threading overhead... */
+  settings.use_threading = (numLoops >= LOOP_SPLIT_TASK_BLOCK_SIZE * 8);
+  settings.min_iter_per_thread = LOOP_SPLIT_TASK_BLOCK_SIZE / 4;
+  settings.userdata_chunk = &tls;
+  settings.userdata_chunk_size = sizeof(tls);
+  settings.func_reduce = loop_split_poly_reduce_fn;
+  settings.func_free = loop_split_poly_free_fn;
 
-    BLI_task_pool_work_and_wait(task_pool);
+  BLI_task_parallel_range(0, numPolys, &common_data, loop_split_poly_fn, &settings);
 
-    BLI_task_pool_free(task_pool);
+  if (tls.lnors_spacearr.mem) {
+    BKE_lnor_spacearr_tls_join(r_lnors_spacearr, &tls.lnors_spacearr);
   }
 
+  MEM_freeN(common_data.loops_done);
   MEM_freeN(edge_to_loops);
   if (!r_loop_to_poly) {
     MEM_freeN(loop_to_poly);
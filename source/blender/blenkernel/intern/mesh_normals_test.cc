@@ -0,0 +1,359 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2021 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_array.hh"
+#include "BLI_map.hh"
+#include "BLI_math.h"
+#include "BLI_rand.hh"
+#include "BLI_vector.hh"
+
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+namespace blender::bke::tests {
+
+#define INDEX_UNSET INT_MIN
+#define INDEX_INVALID -1
+#define IS_EDGE_SHARP(_e2l) (ELEM((_e2l)[1], INDEX_UNSET, INDEX_INVALID))
+
+/**
+ * The previous, serial implementation of #BKE_mesh_normals_loop_split (without custom normals):
+ * edges are tagged in one walk over the polygons, fans are computed in polygon order and cyclic
+ * smooth fans are entered from their first loop found in that order.
+ * Fills the fan entry loop of every loop in \a r_loop_fans.
+ */
+static void loop_split_normals_reference(const Mesh *mesh,
+                                         const float (*polynors)[3],
+                                         const float split_angle,
+                                         MutableSpan<float3> r_loopnors,
+                                         MutableSpan<int> r_loop_fans)
+{
+  const MVert *mverts = mesh->mvert;
+  const MEdge *medges = mesh->medge;
+  const MLoop *mloops = mesh->mloop;
+  const MPoly *mpolys = mesh->mpoly;
+  const float split_angle_cos = cosf(split_angle);
+
+  /* Two loop indices per edge, see #BKE_mesh_normals_loop_split. */
+  Array<int> edge_to_loops(mesh->totedge * 2, 0);
+  Array<int> loop_to_poly(mesh->totloop);
+
+  for (const int mp_index : IndexRange(mesh->totpoly)) {
+    const MPoly *mp = &mpolys[mp_index];
+    for (const int ml_index : IndexRange(mp->loopstart, mp->totloop)) {
+      const MLoop *ml = &mloops[ml_index];
+      int *e2l = &edge_to_loops[ml->e * 2];
+      loop_to_poly[ml_index] = mp_index;
+      normal_short_to_float_v3(r_loopnors[ml_index], mverts[ml->v].no);
+
+      if ((e2l[0] | e2l[1]) == 0) {
+        e2l[0] = ml_index;
+        e2l[1] = (mp->flag & ME_SMOOTH) ? INDEX_UNSET : INDEX_INVALID;
+      }
+      else if (e2l[1] == INDEX_UNSET) {
+        const bool is_angle_sharp = dot_v3v3(polynors[loop_to_poly[e2l[0]]],
+                                             polynors[mp_index]) < split_angle_cos;
+        if (!(mp->flag & ME_SMOOTH) || (medges[ml->e].flag & ME_SHARP) ||
+            ml->v == mloops[e2l[0]].v || is_angle_sharp) {
+          e2l[1] = INDEX_INVALID;
+        }
+        else {
+          e2l[1] = ml_index;
+        }
+      }
+      else if (!IS_EDGE_SHARP(e2l)) {
+        e2l[1] = INDEX_INVALID;
+      }
+    }
+  }
+
+  Array<bool> skip_loops(mesh->totloop, false);
+  r_loop_fans.fill(-1);
+
+  for (const int mp_index : IndexRange(mesh->totpoly)) {
+    const MPoly *mp = &mpolys[mp_index];
+    int ml_prev_index = mp->loopstart + mp->totloop - 1;
+    for (const int ml_curr_index : IndexRange(mp->loopstart, mp->totloop)) {
+      const MLoop *ml_curr = &mloops[ml_curr_index];
+      const MLoop *ml_prev = &mloops[ml_prev_index];
+      const int *e2l_curr = &edge_to_loops[ml_curr->e * 2];
+      const int *e2l_prev = &edge_to_loops[ml_prev->e * 2];
+      const uint mv_pivot_index = ml_curr->v;
+
+      bool is_fan_start = IS_EDGE_SHARP(e2l_curr);
+      if (!is_fan_start && !skip_loops[ml_curr_index] && !IS_EDGE_SHARP(e2l_prev)) {
+        /* Check for a cyclic smooth fan, tagging its loops to skip them later. */
+        const int *e2lfan_curr = e2l_prev;
+        const MLoop *mlfan_curr = ml_prev;
+        int mlfan_curr_index = ml_prev_index;
+        int mlfan_vert_index = ml_curr_index;
+        int mpfan_curr_index = mp_index;
+        skip_loops[ml_curr_index] = true;
+        while (true) {
+          BKE_mesh_loop_manifold_fan_around_vert_next(mloops,
+                                                      mpolys,
+                                                      loop_to_poly.data(),
+                                                      e2lfan_curr,
+                                                      mv_pivot_index,
+                                                      &mlfan_curr,
+                                                      &mlfan_curr_index,
+                                                      &mlfan_vert_index,
+                                                      &mpfan_curr_index);
+          e2lfan_curr = &edge_to_loops[mlfan_curr->e * 2];
+          if (IS_EDGE_SHARP(e2lfan_curr)) {
+            break;
+          }
+          if (skip_loops[mlfan_vert_index]) {
+            is_fan_start = (mlfan_vert_index == ml_curr_index);
+            break;
+          }
+          skip_loops[mlfan_vert_index] = true;
+        }
+      }
+
+      if (!is_fan_start) {
+        ml_prev_index = ml_curr_index;
+        continue;
+      }
+
+      if (IS_EDGE_SHARP(e2l_prev)) {
+        if (IS_EDGE_SHARP(e2l_curr)) {
+          /* Single loop, it takes its poly normal. */
+          copy_v3_v3(r_loopnors[ml_curr_index], polynors[mp_index]);
+          r_loop_fans[ml_curr_index] = ml_curr_index;
+          ml_prev_index = ml_curr_index;
+          continue;
+        }
+      }
+
+      /* Fan around the vertex until the next sharp edge, accumulating the poly normals. */
+      const MVert *mv_pivot = &mverts[mv_pivot_index];
+      const MEdge *me_org = &medges[ml_curr->e];
+      float vec_curr[3], vec_prev[3];
+      float lnor[3] = {0.0f, 0.0f, 0.0f};
+      const int *e2lfan_curr = e2l_prev;
+      const MLoop *mlfan_curr = ml_prev;
+      int mlfan_curr_index = ml_prev_index;
+      int mlfan_vert_index = ml_curr_index;
+      int mpfan_curr_index = mp_index;
+      Vector<int> fan_loops;
+
+      const MVert *mv_org = &mverts[(me_org->v1 == mv_pivot_index) ? me_org->v2 : me_org->v1];
+      sub_v3_v3v3(vec_prev, mv_org->co, mv_pivot->co);
+      normalize_v3(vec_prev);
+
+      while (true) {
+        const MEdge *me_curr = &medges[mlfan_curr->e];
+        const MVert *mv_2 = &mverts[(me_curr->v1 == mv_pivot_index) ? me_curr->v2 : me_curr->v1];
+        sub_v3_v3v3(vec_curr, mv_2->co, mv_pivot->co);
+        normalize_v3(vec_curr);
+
+        const float fac = saacos(dot_v3v3(vec_curr, vec_prev));
+        madd_v3_v3fl(lnor, polynors[mpfan_curr_index], fac);
+        fan_loops.append(mlfan_vert_index);
+
+        if (IS_EDGE_SHARP(e2lfan_curr) || (me_curr == me_org)) {
+          break;
+        }
+        copy_v3_v3(vec_prev, vec_curr);
+        BKE_mesh_loop_manifold_fan_around_vert_next(mloops,
+                                                    mpolys,
+                                                    loop_to_poly.data(),
+                                                    e2lfan_curr,
+                                                    mv_pivot_index,
+                                                    &mlfan_curr,
+                                                    &mlfan_curr_index,
+                                                    &mlfan_vert_index,
+                                                    &mpfan_curr_index);
+        e2lfan_curr = &edge_to_loops[mlfan_curr->e * 2];
+      }
+
+      const bool is_valid = normalize_v3(lnor) != 0.0f;
+      for (const int loop_index : fan_loops) {
+        if (is_valid) {
+          copy_v3_v3(r_loopnors[loop_index], lnor);
+        }
+        r_loop_fans[loop_index] = ml_curr_index;
+      }
+      ml_prev_index = ml_curr_index;
+    }
+  }
+}
+
+#undef INDEX_UNSET
+#undef INDEX_INVALID
+#undef IS_EDGE_SHARP
+
+/**
+ * A UV sphere, so that the poles are high valence fans. The polygons are stored in a shuffled
+ * order, with shuffled first loops. \a sharp_factor is the share of flat polygons and sharp edges.
+ */
+static Mesh *create_sphere_mesh(const int segments,
+                                const int rings,
+                                const float sharp_factor,
+                                RandomNumberGenerator &rng)
+{
+  BKE_idtype_init();
+  const int verts_num = segments * (rings - 1) + 2;
+  const int pole_south = verts_num - 1;
+  auto ring_vert = [&](const int ring, const int segment) {
+    return 1 + (ring - 1) * segments + (segment % segments);
+  };
+
+  Vector<Vector<int>> polys;
+  for (const int i : IndexRange(segments)) {
+    polys.append({0, ring_vert(1, i), ring_vert(1, i + 1)});
+    polys.append({pole_south, ring_vert(rings - 1, i + 1), ring_vert(rings - 1, i)});
+    for (int ring = 1; ring < rings - 1; ring++) {
+      polys.append({ring_vert(ring, i),
+                    ring_vert(ring + 1, i),
+                    ring_vert(ring + 1, i + 1),
+                    ring_vert(ring, i + 1)});
+    }
+  }
+  int loops_num = 0;
+  for (const int i : polys.index_range()) {
+    std::swap(polys[i], polys[rng.get_int32(polys.size())]);
+  }
+  for (const Span<int> poly : polys) {
+    loops_num += poly.size();
+  }
+
+  Mesh *mesh = BKE_mesh_new_nomain(verts_num, 0, 0, loops_num, polys.size());
+  copy_v3_fl3(mesh->mvert[0].co, 0.0f, 0.0f, 1.0f);
+  copy_v3_fl3(mesh->mvert[pole_south].co, 0.0f, 0.0f, -1.0f);
+  for (int ring = 1; ring < rings; ring++) {
+    const float theta = (float)M_PI * ring / rings;
+    for (const int i : IndexRange(segments)) {
+      const float phi = 2.0f * (float)M_PI * i / segments;
+      /* Some noise, so that split angles give irregular sharp edges. */
+      const float radius = 1.0f + rng.get_float() * 0.1f;
+      copy_v3_fl3(mesh->mvert[ring_vert(ring, i)].co,
+                  radius * sinf(theta) * cosf(phi),
+                  radius * sinf(theta) * sinf(phi),
+                  radius * cosf(theta));
+    }
+  }
+
+  int loop_index = 0;
+  for (const int i : polys.index_range()) {
+    MPoly *mp = &mesh->mpoly[i];
+    mp->loopstart = loop_index;
+    mp->totloop = polys[i].size();
+    mp->flag = (rng.get_float() < sharp_factor) ? 0 : ME_SMOOTH;
+    const int first = rng.get_int32(mp->totloop);
+    for (const int j : IndexRange(mp->totloop)) {
+      mesh->mloop[loop_index++].v = polys[i][(first + j) % mp->totloop];
+    }
+  }
+  BKE_mesh_calc_edges(mesh, false, false);
+  for (const int i : IndexRange(mesh->totedge)) {
+    if (rng.get_float() < sharp_factor * 0.5f) {
+      mesh->medge[i].flag |= ME_SHARP;
+    }
+  }
+  return mesh;
+}
+
+static void test_loop_split_matches_reference(const int segments,
+                                              const int rings,
+                                              const float sharp_factor,
+                                              const float split_angle,
+                                              const uint32_t seed)
+{
+  RandomNumberGenerator rng(seed);
+  Mesh *mesh = create_sphere_mesh(segments, rings, sharp_factor, rng);
+  Array<float3> polynors(mesh->totpoly);
+  BKE_mesh_calc_normals_poly(mesh->mvert,
+                             nullptr,
+                             mesh->totvert,
+                             mesh->mloop,
+                             mesh->mpoly,
+                             mesh->totloop,
+                             mesh->totpoly,
+                             (float(*)[3])polynors.data(),
+                             false);
+
+  Array<float3> expected_loopnors(mesh->totloop);
+  Array<int> expected_loop_fans(mesh->totloop);
+  loop_split_normals_reference(mesh,
+                               (const float(*)[3])polynors.data(),
+                               split_angle,
+                               expected_loopnors,
+                               expected_loop_fans);
+
+  Array<float3> loopnors(mesh->totloop);
+  MLoopNorSpaceArray lnors_spacearr = {nullptr};
+  BKE_mesh_normals_loop_split(mesh->mvert,
+                              mesh->totvert,
+                              mesh->medge,
+                              mesh->totedge,
+                              mesh->mloop,
+                              (float(*)[3])loopnors.data(),
+                              mesh->totloop,
+                              mesh->mpoly,
+                              (const float(*)[3])polynors.data(),
+                              mesh->totpoly,
+                              true,
+                              split_angle,
+                              &lnors_spacearr,
+                              nullptr,
+                              nullptr);
+
+  /* Loops share a normal space if and only if they are in the same fan. */
+  Map<const MLoopNorSpace *, int> fan_by_space;
+  Map<int, const MLoopNorSpace *> space_by_fan;
+  for (const int i : IndexRange(mesh->totloop)) {
+    EXPECT_EQ(loopnors[i], expected_loopnors[i]);
+    const MLoopNorSpace *space = lnors_spacearr.lspacearr[i];
+    ASSERT_NE(space, nullptr);
+    if (space->ref_alpha != 0.0f) {
+      /* Spaces too much aligned with their edges are tagged invalid and left empty. */
+      EXPECT_EQ(float3(space->vec_lnor), expected_loopnors[i]);
+    }
+    EXPECT_EQ(fan_by_space.lookup_or_add(space, expected_loop_fans[i]), expected_loop_fans[i]);
+    EXPECT_EQ(space_by_fan.lookup_or_add(expected_loop_fans[i], space), space);
+  }
+  EXPECT_EQ(lnors_spacearr.num_spaces, space_by_fan.size());
+
+  BKE_lnor_spacearr_free(&lnors_spacearr);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST(mesh_normals_loop_split, MatchesSerialImplementation)
+{
+  test_loop_split_matches_reference(24, 12, 0.1f, DEG2RADF(30.0f), 0);
+  test_loop_split_matches_reference(24, 12, 0.1f, (float)M_PI, 1);
+}
+
+TEST(mesh_normals_loop_split, HighValenceFans)
+{
+  /* Enough loops to be computed in parallel, the poles are cyclic smooth fans. */
+  test_loop_split_matches_reference(256, 12, 0.0f, (float)M_PI, 2);
+  test_loop_split_matches_reference(256, 12, 0.1f, DEG2RADF(60.0f), 3);
+  test_loop_split_matches_reference(256, 12, 0.1f, (float)M_PI, 4);
+}
+
+}  // namespace blender::bke::tests
@@ -415,7 +415,8 @@ void BKE_remesh_reproject_vertex_paint(Mesh *target, Mesh *source)
     CustomData_add_layer_named(
         &target->vdata, CD_PROP_COLOR, CD_CALLOC, NULL, target->totvert, layer_name);
 
-    MPropCol *target_color = CustomData_get_layer_n(&target->vdata, CD_PROP_COLOR, layer_n);
+    MPropCol *target_color = CustomData_duplicate_referenced_layer_n(
+        &target->vdata, CD_PROP_COLOR, layer_n, target->totvert);
     MVert *target_verts = CustomData_get_layer(&target->vdata, CD_MVERT);
     MPropCol *source_color = CustomData_get_layer_n(&source->vdata, CD_PROP_COLOR, layer_n);
     for (int i = 0; i < target->totvert; i++) {
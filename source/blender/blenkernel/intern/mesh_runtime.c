@@ -34,6 +34,7 @@
 #include "BLI_threads.h"
 
 #include "BKE_bvhutils.h"
+#include "BKE_deform.h"
 #include "BKE_lib_id.h"
 #include "BKE_mesh.h"
 #include "BKE_mesh_runtime.h"
@@ -47,9 +48,18 @@
 /**
  * Default values defined at read time.
  */
+/** Source of #Mesh_Runtime.content_version, zero is never used. */
+static uint64_t mesh_content_version_last = 0;
+
+static uint64_t mesh_content_version_new(void)
+{
+  return atomic_add_and_fetch_uint64(&mesh_content_version_last, 1);
+}
+
 void BKE_mesh_runtime_reset(Mesh *mesh)
 {
   memset(&mesh->runtime, 0, sizeof(mesh->runtime));
+  mesh->runtime.content_version = mesh_content_version_new();
   mesh->runtime.eval_mutex = MEM_mallocN(sizeof(ThreadMutex), "mesh runtime eval_mutex");
   BLI_mutex_init(mesh->runtime.eval_mutex);
 }
@@ -57,22 +67,57 @@ void BKE_mesh_runtime_reset(Mesh *mesh)
 /* Clear all pointers which we don't want to be shared on copying the datablock.
  * However, keep all the flags which defines what the mesh is (for example, that
  * it's deformed only, or that its custom data layers are out of date.) */
-void BKE_mesh_runtime_reset_on_copy(Mesh *mesh, const int UNUSED(flag))
+void BKE_mesh_runtime_reset_on_copy(Mesh *mesh, const int flag)
 {
   Mesh_Runtime *runtime = &mesh->runtime;
 
+  if ((flag & LIB_ID_COPY_CD_REFERENCE) == 0) {
+    runtime->content_version = mesh_content_version_new();
+  }
+
   runtime->mesh_eval = NULL;
   runtime->edit_data = NULL;
   runtime->batch_cache = NULL;
   runtime->subdiv_ccg = NULL;
+  runtime->deform_weights = NULL;
   memset(&runtime->looptris, 0, sizeof(runtime->looptris));
   runtime->bvh_cache = NULL;
   runtime->shrinkwrap_data = NULL;
+  if (runtime->normals_dirty_verts) {
+    /* Not worth copying, fall back to a full update. */
+    runtime->normals_dirty_verts = NULL;
+    runtime->cd_dirty_vert |= CD_MASK_NORMAL;
+    runtime->vert_normals_known_valid = false;
+  }
 
   mesh->runtime.eval_mutex = MEM_mallocN(sizeof(ThreadMutex), "mesh runtime eval_mutex");
   BLI_mutex_init(mesh->runtime.eval_mutex);
 }
 
+static bool mesh_custom_data_is_referenced(const CustomData *data)
+{
+  for (int i = 0; i < data->totlayer; i++) {
+    const CustomDataLayer *layer = &data->layers[i];
+    if (layer->data != NULL && (layer->flag & CD_FLAG_NOFREE) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+uint64_t BKE_mesh_runtime_content_version(const Mesh *mesh)
+{
+  /* Writing to a referenced layer copies it first (see #CustomData_duplicate_referenced_layer),
+   * which clears the flag. Layers that have been added to the copy are owned by it as well. */
+  if (!mesh_custom_data_is_referenced(&mesh->vdata) ||
+      !mesh_custom_data_is_referenced(&mesh->edata) ||
+      !mesh_custom_data_is_referenced(&mesh->ldata) ||
+      !mesh_custom_data_is_referenced(&mesh->pdata)) {
+    return 0;
+  }
+  return mesh->runtime.content_version;
+}
+
 void BKE_mesh_runtime_clear_cache(Mesh *mesh)
 {
   if (mesh->runtime.eval_mutex != NULL) {
@@ -184,6 +229,40 @@ const MLoopTri *BKE_mesh_runtime_looptri_ensure(const Mesh *mesh)
   return looptri;
 }
 
+/**
+ * Vertex group weights of the mesh in compressed sparse row layout, or NULL when the mesh has no
+ * vertex group weights. The cache is discarded with the other geometry caches, changes to the
+ * weights are expected to go through a copy-on-write update which creates a new runtime.
+ *
+ * \note This function only fills a cache, and therefore the mesh argument can
+ * be considered logically const. Concurrent access is protected by a mutex.
+ */
+const DeformWeightsCSR *BKE_mesh_runtime_deform_weights_ensure(const Mesh *mesh)
+{
+  if (mesh->dvert == NULL) {
+    return NULL;
+  }
+
+  ThreadMutex *mesh_eval_mutex = (ThreadMutex *)mesh->runtime.eval_mutex;
+  BLI_mutex_lock(mesh_eval_mutex);
+
+  DeformWeightsCSR *deform_weights = mesh->runtime.deform_weights;
+
+  if (deform_weights != NULL && deform_weights->verts_num != mesh->totvert) {
+    BKE_defvert_weights_csr_free(deform_weights);
+    deform_weights = NULL;
+  }
+  if (deform_weights == NULL) {
+    deform_weights = BKE_defvert_weights_csr_create(mesh->dvert, mesh->totvert);
+    /* Casting away const is fine, this is a runtime cache. */
+    ((Mesh *)mesh)->runtime.deform_weights = deform_weights;
+  }
+
+  BLI_mutex_unlock(mesh_eval_mutex);
+
+  return deform_weights;
+}
+
 /* This is a copy of DM_verttri_from_looptri(). */
 void BKE_mesh_runtime_verttri_from_looptri(MVertTri *r_verttri,
                                            const MLoop *mloop,
@@ -248,6 +327,11 @@ void BKE_mesh_runtime_clear_geometry(Mesh *mesh)
     mesh->runtime.subdiv_ccg = NULL;
   }
   BKE_shrinkwrap_discard_boundary_data(mesh);
+  BKE_defvert_weights_csr_free(mesh->runtime.deform_weights);
+  mesh->runtime.deform_weights = NULL;
+  if (mesh->runtime.normals_dirty_verts) {
+    BKE_mesh_normals_tag_dirty(mesh);
+  }
 }
 
 /** \} */
@@ -0,0 +1,261 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2021 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include "BKE_attribute.h"
+#include "BKE_customdata.h"
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "MEM_guardedalloc.h"
+
+namespace blender::bke::tests {
+
+static Mesh *create_mesh_with_layers()
+{
+  BKE_idtype_init();
+  Mesh *mesh = BKE_mesh_new_nomain(3, 3, 0, 3, 1);
+  CustomData_add_layer(&mesh->vdata, CD_MDEFORMVERT, CD_CALLOC, nullptr, mesh->totvert);
+  float *attribute = (float *)CustomData_add_layer_named(
+      &mesh->vdata, CD_PROP_FLOAT, CD_CALLOC, nullptr, mesh->totvert, "a");
+  attribute[0] = 1.0f;
+  CustomData_add_layer(&mesh->ldata, CD_MLOOPUV, CD_CALLOC, nullptr, mesh->totloop);
+  CustomData_add_layer(&mesh->ldata, CD_MLOOPCOL, CD_CALLOC, nullptr, mesh->totloop);
+  CustomData_add_layer(&mesh->ldata, CD_MDISPS, CD_CALLOC, nullptr, mesh->totloop);
+  BKE_mesh_update_customdata_pointers(mesh, false);
+  return mesh;
+}
+
+static Mesh *copy_mesh_sharing_geometry(Mesh *mesh)
+{
+  BKE_mesh_share_custom_data(mesh, LIB_ID_COPY_CD_SHARE_GEOMETRY);
+  return (Mesh *)BKE_id_copy_ex(
+      nullptr, &mesh->id, nullptr, LIB_ID_COPY_LOCALIZE | LIB_ID_COPY_CD_SHARE_GEOMETRY);
+}
+
+TEST(mesh_copy, ShareGeometryLayers)
+{
+  Mesh *mesh = create_mesh_with_layers();
+  Mesh *copy = copy_mesh_sharing_geometry(mesh);
+
+  EXPECT_EQ(copy->mvert, mesh->mvert);
+  EXPECT_EQ(copy->medge, mesh->medge);
+  EXPECT_EQ(copy->mpoly, mesh->mpoly);
+  EXPECT_EQ(copy->mloop, mesh->mloop);
+  EXPECT_EQ(copy->dvert, mesh->dvert);
+  EXPECT_EQ(copy->mloopcol, mesh->mloopcol);
+  EXPECT_EQ(copy->mloopuv, mesh->mloopuv);
+  EXPECT_EQ(CustomData_get_layer_named(&copy->vdata, CD_PROP_FLOAT, "a"),
+            CustomData_get_layer_named(&mesh->vdata, CD_PROP_FLOAT, "a"));
+
+  /* Multi-resolution data is copied. */
+  EXPECT_NE(CustomData_get_layer(&copy->ldata, CD_MDISPS),
+            CustomData_get_layer(&mesh->ldata, CD_MDISPS));
+
+  BKE_id_free(nullptr, copy);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST(mesh_copy, CopyUnpreparedGeometryLayers)
+{
+  Mesh *mesh = create_mesh_with_layers();
+  Mesh *copy = (Mesh *)BKE_id_copy_ex(
+      nullptr, &mesh->id, nullptr, LIB_ID_COPY_LOCALIZE | LIB_ID_COPY_CD_SHARE_GEOMETRY);
+
+  /* The source is not modified by copying, so nothing can be shared. */
+  EXPECT_NE(copy->mvert, mesh->mvert);
+  EXPECT_NE(copy->mloopuv, mesh->mloopuv);
+  EXPECT_FALSE(CustomData_has_referenced(&mesh->vdata));
+  EXPECT_FALSE(CustomData_has_referenced(&mesh->ldata));
+
+  BKE_id_free(nullptr, copy);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST(mesh_copy, UnshareVerticesBeforeWrite)
+{
+  Mesh *mesh = create_mesh_with_layers();
+  mesh->mvert[1].co[0] = 1.0f;
+  Mesh *copy = copy_mesh_sharing_geometry(mesh);
+
+  /* Freeing the original keeps the data alive for the copy. */
+  BKE_id_free(nullptr, mesh);
+  EXPECT_EQ(copy->mvert[1].co[0], 1.0f);
+
+  /* The copy is the only user now, so it takes over the data without copying it. */
+  const MVert *mvert = copy->mvert;
+  EXPECT_EQ(CustomData_duplicate_referenced_layer(&copy->vdata, CD_MVERT, copy->totvert), mvert);
+
+  BKE_id_free(nullptr, copy);
+}
+
+TEST(mesh_copy, UnshareAttributeBeforeWrite)
+{
+  Mesh *mesh = create_mesh_with_layers();
+  BKE_mesh_share_custom_data(mesh, LIB_ID_COPY_CD_SHARE_GEOMETRY);
+  Mesh *copy = (Mesh *)BKE_id_copy_ex(
+      nullptr, &mesh->id, nullptr, LIB_ID_COPY_LOCALIZE | LIB_ID_COPY_CD_SHARE_GEOMETRY);
+
+  const int layer_index = CustomData_get_named_layer_index(&mesh->vdata, CD_PROP_FLOAT, "a");
+  CustomDataLayer *layer = &mesh->vdata.layers[layer_index];
+  BKE_id_attribute_ensure_unshared(&mesh->id, layer);
+  float *attribute = (float *)layer->data;
+  attribute[0] = 2.0f;
+  const float *copy_attribute = (const float *)CustomData_get_layer_named(
+      &copy->vdata, CD_PROP_FLOAT, "a");
+  EXPECT_NE(attribute, copy_attribute);
+  EXPECT_EQ(copy_attribute[0], 1.0f);
+
+  const int uv_index = CustomData_get_layer_index(&mesh->ldata, CD_MLOOPUV);
+  BKE_id_attribute_ensure_unshared(&mesh->id, &mesh->ldata.layers[uv_index]);
+  EXPECT_NE(mesh->mloopuv, copy->mloopuv);
+  EXPECT_EQ(mesh->mloopuv, mesh->ldata.layers[uv_index].data);
+
+  /* The copy is the only user of its data now, so it can take it over without copying. */
+  const float *data_before = copy_attribute;
+  EXPECT_EQ(CustomData_duplicate_referenced_layer_named(
+                &copy->vdata, CD_PROP_FLOAT, "a", copy->totvert),
+            data_before);
+
+  BKE_id_free(nullptr, copy);
+  BKE_id_free(nullptr, mesh);
+}
+
+/* A grid of quads in the XY plane with a bump, so that vertex normals differ. */
+static Mesh *create_grid_mesh(const int size)
+{
+  BKE_idtype_init();
+  const int polys_num = (size - 1) * (size - 1);
+  Mesh *mesh = BKE_mesh_new_nomain(size * size, 0, 0, polys_num * 4, polys_num);
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      float *co = mesh->mvert[y * size + x].co;
+      co[0] = (float)x;
+      co[1] = (float)y;
+      co[2] = (float)((x * 7 + y * 3) % 5) * 0.1f;
+    }
+  }
+  int poly_index = 0;
+  for (int y = 0; y < size - 1; y++) {
+    for (int x = 0; x < size - 1; x++, poly_index++) {
+      MPoly *mp = &mesh->mpoly[poly_index];
+      mp->loopstart = poly_index * 4;
+      mp->totloop = 4;
+      MLoop *ml = &mesh->mloop[mp->loopstart];
+      ml[0].v = y * size + x;
+      ml[1].v = y * size + x + 1;
+      ml[2].v = (y + 1) * size + x + 1;
+      ml[3].v = (y + 1) * size + x;
+    }
+  }
+  return mesh;
+}
+
+static void expect_vert_normals_eq(const Mesh *a, const Mesh *b)
+{
+  ASSERT_EQ(a->totvert, b->totvert);
+  for (int i = 0; i < a->totvert; i++) {
+    EXPECT_EQ(a->mvert[i].no[0], b->mvert[i].no[0]);
+    EXPECT_EQ(a->mvert[i].no[1], b->mvert[i].no[1]);
+    EXPECT_EQ(a->mvert[i].no[2], b->mvert[i].no[2]);
+  }
+}
+
+/* Move a few vertices and apply the positions to both meshes, recomputing all normals of the
+ * reference mesh. */
+static void apply_moved_coords(Mesh *mesh, Mesh *reference)
+{
+  float(*coords)[3] = BKE_mesh_vert_coords_alloc(mesh, nullptr);
+  coords[7][2] += 0.5f;
+  coords[20][0] -= 0.3f;
+  coords[21][2] -= 0.25f;
+  BKE_mesh_vert_coords_apply(mesh, coords);
+  BKE_mesh_vert_coords_apply(reference, coords);
+  BKE_mesh_normals_tag_dirty(reference);
+  MEM_freeN(coords);
+}
+
+TEST(mesh_normals, PartialUpdateMatchesFull)
+{
+  Mesh *mesh = create_grid_mesh(8);
+  BKE_mesh_calc_normals(mesh);
+  Mesh *reference = (Mesh *)BKE_id_copy_ex(nullptr, &mesh->id, nullptr, LIB_ID_COPY_LOCALIZE);
+
+  apply_moved_coords(mesh, reference);
+  /* Only the moved vertices are tagged. */
+  EXPECT_NE(mesh->runtime.normals_dirty_verts, nullptr);
+  EXPECT_FALSE(mesh->runtime.cd_dirty_vert & CD_MASK_NORMAL);
+
+  BKE_mesh_ensure_normals(mesh);
+  BKE_mesh_ensure_normals(reference);
+  expect_vert_normals_eq(mesh, reference);
+
+  BKE_id_free(nullptr, reference);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST(mesh_normals, PartialUpdateForDisplayMatchesFull)
+{
+  Mesh *mesh = create_grid_mesh(8);
+  BKE_mesh_normals_tag_dirty(mesh);
+  BKE_mesh_ensure_normals_for_display(mesh);
+  Mesh *reference = (Mesh *)BKE_id_copy_ex(nullptr, &mesh->id, nullptr, LIB_ID_COPY_LOCALIZE);
+
+  apply_moved_coords(mesh, reference);
+  EXPECT_NE(mesh->runtime.normals_dirty_verts, nullptr);
+  reference->runtime.cd_dirty_poly |= CD_MASK_NORMAL;
+
+  BKE_mesh_ensure_normals_for_display(mesh);
+  BKE_mesh_ensure_normals_for_display(reference);
+  expect_vert_normals_eq(mesh, reference);
+  const float(*poly_nors)[3] = (const float(*)[3])CustomData_get_layer(&mesh->pdata, CD_NORMAL);
+  const float(*reference_poly_nors)[3] = (const float(*)[3])CustomData_get_layer(
+      &reference->pdata, CD_NORMAL);
+  for (int i = 0; i < mesh->totpoly; i++) {
+    EXPECT_EQ(poly_nors[i][0], reference_poly_nors[i][0]);
+    EXPECT_EQ(poly_nors[i][1], reference_poly_nors[i][1]);
+    EXPECT_EQ(poly_nors[i][2], reference_poly_nors[i][2]);
+  }
+
+  BKE_id_free(nullptr, reference);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST(mesh_normals, UnknownNormalsAreRecomputed)
+{
+  /* The normals of a new mesh were never computed, so they can't be partially updated. */
+  Mesh *mesh = create_grid_mesh(8);
+  Mesh *reference = (Mesh *)BKE_id_copy_ex(nullptr, &mesh->id, nullptr, LIB_ID_COPY_LOCALIZE);
+
+  apply_moved_coords(mesh, reference);
+  EXPECT_EQ(mesh->runtime.normals_dirty_verts, nullptr);
+  EXPECT_TRUE(mesh->runtime.cd_dirty_vert & CD_MASK_NORMAL);
+
+  BKE_mesh_ensure_normals(mesh);
+  BKE_mesh_ensure_normals(reference);
+  expect_vert_normals_eq(mesh, reference);
+
+  BKE_id_free(nullptr, reference);
+  BKE_id_free(nullptr, mesh);
+}
+
+}  // namespace blender::bke::tests
@@ -27,7 +27,9 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_linklist.h"
 #include "BLI_listbase.h"
+#include "BLI_mempool.h"
 #include "BLI_string_utf8.h"
 
 #include "BLI_array.hh"
@@ -36,6 +38,7 @@
 #include "BLI_math.h"
 #include "BLI_rand.h"
 #include "BLI_span.hh"
+#include "BLI_task.hh"
 #include "BLI_vector.hh"
 
 #include "DNA_anim_types.h"
@@ -73,6 +76,7 @@
 using blender::Array;
 using blender::float3;
 using blender::float4x4;
+using blender::IndexRange;
 using blender::Span;
 using blender::Vector;
 
@@ -80,6 +84,18 @@ using blender::Vector;
 /** \name Internal Duplicate Context
  * \{ */
 
+/**
+ * The list returned by #object_duplilist. The list base is the first member, so that callers can
+ * use it as a regular #ListBase of #DupliObject. The dupli-objects are allocated from a memory
+ * pool, because allocating them one by one is slow when there are millions of instances.
+ */
+struct DupliList {
+  ListBase list;
+  BLI_mempool *pool;
+  /** Arrays of dupli-objects created at once, see #make_duplis_instances_component_bulk. */
+  LinkNode *blocks;
+};
+
 struct DupliContext {
   Depsgraph *depsgraph;
   /** XXX child objects are selected from this group if set, could be nicer. */
@@ -105,7 +121,7 @@ struct DupliContext {
   const struct DupliGenerator *gen;
 
   /** Result containers. */
-  ListBase *duplilist; /* Legacy doubly-linked list. */
+  DupliList *duplilist; /* Legacy doubly-linked list. */
 };
 
 struct DupliGenerator {
@@ -171,28 +187,38 @@ static void copy_dupli_context(
   r_ctx->gen = get_dupli_generator(r_ctx);
 }
 
+static uint dupli_object_name_hash(const Object *ob)
+{
+  return BLI_hash_string(ob->id.name + 2);
+}
+
 /**
- * Generate a dupli instance.
+ * Hash of the instancer that is mixed into the random id of duplis of other objects.
+ */
+static uint dupli_instancer_hash(const DupliContext *ctx, const Object *ob)
+{
+  return (ctx->object != ob) ? BLI_hash_int(dupli_object_name_hash(ctx->object)) : 0;
+}
+
+/**
+ * Initialize a zeroed dupli instance, with the hashes used for the random id computed by the
+ * caller, see #dupli_object_name_hash and #dupli_instancer_hash. This avoids hashing the same
+ * names for every instance when there are many.
+ *
+ * Only reads the context, so duplis can be initialized from multiple threads.
  *
  * \param mat: is transform of the object relative to current context (including #Object.obmat).
  */
-static DupliObject *make_dupli(const DupliContext *ctx,
-                               Object *ob,
-                               const float mat[4][4],
-                               int index)
+static void dupli_object_init(const DupliContext *ctx,
+                              DupliObject *dob,
+                              Object *ob,
+                              const float mat[4][4],
+                              int index,
+                              const uint name_hash,
+                              const uint instancer_hash)
 {
-  DupliObject *dob;
   int i;
 
-  /* Add a #DupliObject instance to the result container. */
-  if (ctx->duplilist) {
-    dob = (DupliObject *)MEM_callocN(sizeof(DupliObject), "dupli object");
-    BLI_addtail(ctx->duplilist, dob);
-  }
-  else {
-    return nullptr;
-  }
-
   dob->ob = ob;
   mul_m4_m4m4(dob->mat, (float(*)[4])ctx->space_mat, mat);
   dob->type = ctx->gen->type;
@@ -219,7 +245,7 @@ static DupliObject *make_dupli(const DupliContext *ctx,
 
   /* Random number.
    * The logic here is designed to match Cycles. */
-  dob->random_id = BLI_hash_string(dob->ob->id.name + 2);
+  dob->random_id = name_hash;
 
   if (dob->persistent_id[0] != INT_MAX) {
     for (i = 0; i < MAX_DUPLI_RECUR; i++) {
@@ -230,13 +256,49 @@ static DupliObject *make_dupli(const DupliContext *ctx,
     dob->random_id = BLI_hash_int_2d(dob->random_id, 0);
   }
 
-  if (ctx->object != ob) {
-    dob->random_id ^= BLI_hash_int(BLI_hash_string(ctx->object->id.name + 2));
+  dob->random_id ^= instancer_hash;
+}
+
+/**
+ * Generate a dupli instance, see #dupli_object_init.
+ */
+static DupliObject *make_dupli_ex(const DupliContext *ctx,
+                                  Object *ob,
+                                  const float mat[4][4],
+                                  int index,
+                                  const uint name_hash,
+                                  const uint instancer_hash)
+{
+  DupliObject *dob;
+
+  /* Add a #DupliObject instance to the result container. */
+  if (ctx->duplilist) {
+    dob = (DupliObject *)BLI_mempool_calloc(ctx->duplilist->pool);
+    BLI_addtail(&ctx->duplilist->list, dob);
   }
+  else {
+    return nullptr;
+  }
+
+  dupli_object_init(ctx, dob, ob, mat, index, name_hash, instancer_hash);
 
   return dob;
 }
 
+/**
+ * Generate a dupli instance.
+ *
+ * \param mat: is transform of the object relative to current context (including #Object.obmat).
+ */
+static DupliObject *make_dupli(const DupliContext *ctx,
+                               Object *ob,
+                               const float mat[4][4],
+                               int index)
+{
+  return make_dupli_ex(
+      ctx, ob, mat, index, dupli_object_name_hash(ob), dupli_instancer_hash(ctx, ob));
+}
+
 /**
  * Recursive dupli-objects.
  *
@@ -832,13 +894,166 @@ static const DupliGenerator gen_dupli_verts_pointcloud = {
 
 /* -------------------------------------------------------------------- */
 /** \name Instances Geometry Component Implementation
+ *
+ * The draw manager and Cycles still receive every instance as a separate #DupliObject, there is
+ * no bulk path that passes the instance transforms to them directly yet.
  * \{ */
 
+/**
+ * Data that only depends on the instance reference, which is computed once for all instances.
+ */
+struct InstanceReferenceDupliData {
+  /** The instanced objects, for collection references all visible objects in the collection. */
+  Vector<Object *> objects;
+  Vector<uint> name_hashes;
+  Vector<uint> instancer_hashes;
+  /** Whether each object can generate duplis itself, otherwise the recursion can be skipped. */
+  Vector<bool> has_recursive_duplis;
+};
+
+static InstanceReferenceDupliData get_instance_reference_dupli_data(
+    const DupliContext *ctx, const InstanceReference &reference)
+{
+  InstanceReferenceDupliData data;
+  switch (reference.type()) {
+    case InstanceReference::Type::Object: {
+      data.objects.append(&reference.object());
+      break;
+    }
+    case InstanceReference::Type::Collection: {
+      eEvaluationMode mode = DEG_get_mode(ctx->depsgraph);
+      FOREACH_COLLECTION_VISIBLE_OBJECT_RECURSIVE_BEGIN (&reference.collection(), object, mode) {
+        if (object == ctx->object) {
+          continue;
+        }
+        data.objects.append(object);
+      }
+      FOREACH_COLLECTION_VISIBLE_OBJECT_RECURSIVE_END;
+      break;
+    }
+    case InstanceReference::Type::None: {
+      break;
+    }
+  }
+
+  for (Object *object : data.objects) {
+    data.name_hashes.append(dupli_object_name_hash(object));
+    data.instancer_hashes.append(dupli_instancer_hash(ctx, object));
+
+    DupliContext rctx;
+    copy_dupli_context(&rctx, ctx, object, nullptr, 0);
+    /* Objects in the instance stack are passed on, so that the recursion warning is reported. */
+    data.has_recursive_duplis.append(rctx.gen != nullptr ||
+                                     ctx->instance_stack->contains(object));
+  }
+  return data;
+}
+
+/**
+ * Transform of the objects in an instanced collection, relative to the collection objects.
+ */
+static void instance_collection_matrix(const DupliContext *ctx,
+                                       const Collection &collection,
+                                       const float4x4 &instance_offset_matrix,
+                                       float r_collection_matrix[4][4])
+{
+  unit_m4(r_collection_matrix);
+  sub_v3_v3(r_collection_matrix[3], collection.instance_offset);
+  mul_m4_m4_pre(r_collection_matrix, instance_offset_matrix.values);
+  mul_m4_m4_pre(r_collection_matrix, ctx->object->obmat);
+}
+
+/**
+ * Create the duplis of all instances in a single allocation and fill them in parallel.
+ *
+ * Only possible when none of the instanced objects generates duplis itself, so that the number
+ * of duplis of every instance is known beforehand. The duplis are in the same order as the ones
+ * created by #make_duplis_instances_component one by one.
+ */
+static void make_duplis_instances_component_bulk(
+    const DupliContext *ctx,
+    const InstancesComponent &component,
+    Span<InstanceReferenceDupliData> references_data)
+{
+  Span<float4x4> instance_offset_matrices = component.instance_transforms();
+  Span<int> instance_reference_handles = component.instance_reference_handles();
+  Span<int> almost_unique_ids = component.almost_unique_ids();
+  Span<InstanceReference> references = component.references();
+
+  /* Index of the first dupli of every instance. */
+  Array<int64_t> dupli_offsets(instance_offset_matrices.size());
+  int64_t totdupli = 0;
+  for (const int64_t i : instance_offset_matrices.index_range()) {
+    dupli_offsets[i] = totdupli;
+    totdupli += references_data[instance_reference_handles[i]].objects.size();
+  }
+  if (totdupli == 0) {
+    return;
+  }
+
+  DupliObject *duplis = (DupliObject *)MEM_calloc_arrayN(
+      (size_t)totdupli, sizeof(DupliObject), __func__);
+  BLI_linklist_prepend(&ctx->duplilist->blocks, duplis);
+
+  blender::threading::parallel_for(
+      instance_offset_matrices.index_range(), 1024, [&](IndexRange range) {
+        for (const int64_t i : range) {
+          const int handle = instance_reference_handles[i];
+          const InstanceReference &reference = references[handle];
+          const InstanceReferenceDupliData &reference_data = references_data[handle];
+          const int id = almost_unique_ids[i];
+
+          float collection_matrix[4][4];
+          if (reference.type() == InstanceReference::Type::Collection) {
+            instance_collection_matrix(
+                ctx, reference.collection(), instance_offset_matrices[i], collection_matrix);
+          }
+
+          for (const int64_t object_index : reference_data.objects.index_range()) {
+            Object *object = reference_data.objects[object_index];
+            const int64_t dupli_index = dupli_offsets[i] + object_index;
+            DupliObject *dob = &duplis[dupli_index];
+
+            float matrix[4][4];
+            if (reference.type() == InstanceReference::Type::Collection) {
+              mul_m4_m4m4(matrix, collection_matrix, object->obmat);
+            }
+            else {
+              mul_m4_m4m4(matrix, ctx->object->obmat, instance_offset_matrices[i].values);
+            }
+            dupli_object_init(ctx,
+                              dob,
+                              object,
+                              matrix,
+                              id,
+                              reference_data.name_hashes[object_index],
+                              reference_data.instancer_hashes[object_index]);
+
+            /* The first and last dupli are linked to the list below. */
+            dob->prev = (dupli_index > 0) ? dob - 1 : nullptr;
+            dob->next = (dupli_index < totdupli - 1) ? dob + 1 : nullptr;
+          }
+        }
+      });
+
+  ListBase *list = &ctx->duplilist->list;
+  DupliObject *dob_first = &duplis[0];
+  DupliObject *dob_last = &duplis[totdupli - 1];
+  dob_first->prev = (DupliObject *)list->last;
+  if (list->last) {
+    ((DupliObject *)list->last)->next = dob_first;
+  }
+  else {
+    list->first = dob_first;
+  }
+  list->last = dob_last;
+}
+
 static void make_duplis_instances_component(const DupliContext *ctx)
 {
   const InstancesComponent *component =
       ctx->object->runtime.geometry_set_eval->get_component_for_read<InstancesComponent>();
-  if (component == nullptr) {
+  if (component == nullptr || ctx->duplilist == nullptr) {
     return;
   }
 
@@ -847,8 +1062,23 @@ static void make_duplis_instances_component(const DupliContext *ctx)
   Span<int> almost_unique_ids = component->almost_unique_ids();
   Span<InstanceReference> references = component->references();
 
+  /* There are usually a lot more instances than references. */
+  Array<InstanceReferenceDupliData> references_data(references.size());
+  bool has_recursive_duplis = false;
+  for (const int64_t i : references.index_range()) {
+    references_data[i] = get_instance_reference_dupli_data(ctx, references[i]);
+    has_recursive_duplis |= references_data[i].has_recursive_duplis.as_span().contains(true);
+  }
+
+  if (!has_recursive_duplis) {
+    make_duplis_instances_component_bulk(ctx, *component, references_data);
+    return;
+  }
+
   for (int64_t i : instance_offset_matrices.index_range()) {
-    const InstanceReference &reference = references[instance_reference_handles[i]];
+    const int handle = instance_reference_handles[i];
+    const InstanceReference &reference = references[handle];
+    const InstanceReferenceDupliData &reference_data = references_data[handle];
     const int id = almost_unique_ids[i];
 
     switch (reference.type()) {
@@ -856,35 +1086,41 @@ static void make_duplis_instances_component(const DupliContext *ctx)
         Object &object = reference.object();
         float matrix[4][4];
         mul_m4_m4m4(matrix, ctx->object->obmat, instance_offset_matrices[i].values);
-        make_dupli(ctx, &object, matrix, id);
-
-        float space_matrix[4][4];
-        mul_m4_m4m4(space_matrix, instance_offset_matrices[i].values, object.imat);
-        mul_m4_m4_pre(space_matrix, ctx->object->obmat);
-        make_recursive_duplis(ctx, &object, space_matrix, id);
+        make_dupli_ex(ctx,
+                      &object,
+                      matrix,
+                      id,
+                      reference_data.name_hashes[0],
+                      reference_data.instancer_hashes[0]);
+
+        if (reference_data.has_recursive_duplis[0]) {
+          float space_matrix[4][4];
+          mul_m4_m4m4(space_matrix, instance_offset_matrices[i].values, object.imat);
+          mul_m4_m4_pre(space_matrix, ctx->object->obmat);
+          make_recursive_duplis(ctx, &object, space_matrix, id);
+        }
         break;
       }
       case InstanceReference::Type::Collection: {
-        Collection &collection = reference.collection();
         float collection_matrix[4][4];
-        unit_m4(collection_matrix);
-        sub_v3_v3(collection_matrix[3], collection.instance_offset);
-        mul_m4_m4_pre(collection_matrix, instance_offset_matrices[i].values);
-        mul_m4_m4_pre(collection_matrix, ctx->object->obmat);
-
-        eEvaluationMode mode = DEG_get_mode(ctx->depsgraph);
-        FOREACH_COLLECTION_VISIBLE_OBJECT_RECURSIVE_BEGIN (&collection, object, mode) {
-          if (object == ctx->object) {
-            continue;
-          }
+        instance_collection_matrix(
+            ctx, reference.collection(), instance_offset_matrices[i], collection_matrix);
 
+        for (const int64_t object_index : reference_data.objects.index_range()) {
+          Object *object = reference_data.objects[object_index];
           float instance_matrix[4][4];
           mul_m4_m4m4(instance_matrix, collection_matrix, object->obmat);
 
-          make_dupli(ctx, object, instance_matrix, id);
-          make_recursive_duplis(ctx, object, collection_matrix, id);
+          make_dupli_ex(ctx,
+                        object,
+                        instance_matrix,
+                        id,
+                        reference_data.name_hashes[object_index],
+                        reference_data.instancer_hashes[object_index]);
+          if (reference_data.has_recursive_duplis[object_index]) {
+            make_recursive_duplis(ctx, object, collection_matrix, id);
+          }
         }
-        FOREACH_COLLECTION_VISIBLE_OBJECT_RECURSIVE_END;
         break;
       }
       case InstanceReference::Type::None: {
@@ -1609,7 +1845,8 @@ static const DupliGenerator *get_dupli_generator(const DupliContext *ctx)
  */
 ListBase *object_duplilist(Depsgraph *depsgraph, Scene *sce, Object *ob)
 {
-  ListBase *duplilist = (ListBase *)MEM_callocN(sizeof(ListBase), "duplilist");
+  DupliList *duplilist = (DupliList *)MEM_callocN(sizeof(DupliList), "duplilist");
+  duplilist->pool = BLI_mempool_create(sizeof(DupliObject), 0, 512, BLI_MEMPOOL_NOP);
   DupliContext ctx;
   Vector<Object *> instance_stack;
   instance_stack.append(ob);
@@ -1619,13 +1856,15 @@ ListBase *object_duplilist(Depsgraph *depsgraph, Scene *sce, Object *ob)
     ctx.gen->make_duplis(&ctx);
   }
 
-  return duplilist;
+  return &duplilist->list;
 }
 
 void free_object_duplilist(ListBase *lb)
 {
-  BLI_freelistN(lb);
-  MEM_freeN(lb);
+  DupliList *duplilist = (DupliList *)lb;
+  BLI_mempool_destroy(duplilist->pool);
+  BLI_linklist_free(duplilist->blocks, MEM_freeN);
+  MEM_freeN(duplilist);
 }
 
 /** \} */
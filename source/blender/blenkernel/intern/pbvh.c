@@ -250,17 +250,21 @@ void pbvh_grow_nodes(PBVH *pbvh, int totnode)
 }
 
 /* Add a vertex to the map, with a positive value for unique vertices and
- * a negative value for additional vertices */
-static int map_insert_vert(
-    PBVH *pbvh, GHash *map, unsigned int *face_verts, unsigned int *uniq_verts, int vertex)
+ * a negative value for additional vertices. A vertex is unique to the leaf which is the first
+ * one in the build order to use it, see #pbvh_build_vert_owners_task_cb. */
+static int map_insert_vert(GHash *map,
+                           unsigned int *face_verts,
+                           unsigned int *uniq_verts,
+                           const int *vert_owner_leaf,
+                           int leaf_index,
+                           int vertex)
 {
   void *key, **value_p;
 
   key = POINTER_FROM_INT(vertex);
   if (!BLI_ghash_ensure_p(map, key, &value_p)) {
     int value_i;
-    if (BLI_BITMAP_TEST(pbvh->vert_bitmap, vertex) == 0) {
-      BLI_BITMAP_ENABLE(pbvh->vert_bitmap, vertex);
+    if (vert_owner_leaf[vertex] == leaf_index) {
       value_i = *uniq_verts;
       (*uniq_verts)++;
     }
@@ -276,7 +280,10 @@ static int map_insert_vert(
 }
 
 /* Find vertices used by the faces in this node and update the draw buffers */
-static void build_mesh_leaf_node(PBVH *pbvh, PBVHNode *node)
+static void build_mesh_leaf_node(PBVH *pbvh,
+                                 PBVHNode *node,
+                                 const int *vert_owner_leaf,
+                                 int leaf_index)
 {
   bool has_visible = false;
 
@@ -297,8 +304,12 @@ static void build_mesh_leaf_node(PBVH *pbvh, PBVHNode *node)
   for (int i = 0; i < totface; i++) {
     const MLoopTri *lt = &pbvh->looptri[node->prim_indices[i]];
     for (int j = 0; j < 3; j++) {
-      face_vert_indices[i][j] = map_insert_vert(
-          pbvh, map, &node->face_verts, &node->uniq_verts, pbvh->mloop[lt->tri[j]].v);
+      face_vert_indices[i][j] = map_insert_vert(map,
+                                                &node->face_verts,
+                                                &node->uniq_verts,
+                                                vert_owner_leaf,
+                                                leaf_index,
+                                                pbvh->mloop[lt->tri[j]].v);
     }
 
     if (has_visible == false) {
@@ -412,24 +423,6 @@ static void build_grid_leaf_node(PBVH *pbvh, PBVHNode *node)
   BKE_pbvh_node_mark_rebuild_draw(node);
 }
 
-static void build_leaf(PBVH *pbvh, int node_index, BBC *prim_bbc, int offset, int count)
-{
-  pbvh->nodes[node_index].flag |= PBVH_Leaf;
-
-  pbvh->nodes[node_index].prim_indices = pbvh->prim_indices + offset;
-  pbvh->nodes[node_index].totprim = count;
-
-  /* Still need vb for searches */
-  update_vb(pbvh, &pbvh->nodes[node_index], prim_bbc, offset, count);
-
-  if (pbvh->looptri) {
-    build_mesh_leaf_node(pbvh, pbvh->nodes + node_index);
-  }
-  else {
-    build_grid_leaf_node(pbvh, pbvh->nodes + node_index);
-  }
-}
-
 /* Return zero if all primitives in the node can be drawn with the
  * same material (including flat/smooth shading), non-zero otherwise */
 static bool leaf_needs_material_split(PBVH *pbvh, int offset, int count)
@@ -464,70 +457,411 @@ static bool leaf_needs_material_split(PBVH *pbvh, int offset, int count)
   return false;
 }
 
-/* Recursively build a node in the tree
+/* -------------------------------------------------------------------- */
+/** \name Tree Build
  *
- * vb is the voxel box around all of the primitives contained in
- * this node.
+ * The tree is built top-down in two passes. The first pass partitions the primitive indices into
+ * a temporary tree, where sub-trees are built by independent tasks. Large nodes are split using a
+ * binned surface area heuristic along the widest axis of the primitive centroids. The second pass
+ * flattens the temporary tree into the node array in depth-first order, and the leaves are then
+ * filled in parallel.
+ * \{ */
+
+/* Split large nodes with the surface area heuristic. Without it, nodes are split at the middle of
+ * the widest axis of the primitive centroids, which gives the same tree as the serial build. */
+#define USE_PBVH_BUILD_SAH
+
+#ifdef USE_PBVH_BUILD_SAH
+/* Number of bins used to evaluate the surface area heuristic. */
+#  define PBVH_BUILD_SAH_BINS 16
+/* Ranges with more primitives than this are binned in parallel. */
+#  define PBVH_BUILD_PARALLEL_BIN_MIN_PRIMS 65536
+#endif
+
+/* Nodes with more primitives than this are split in a separate task. */
+#define PBVH_BUILD_TASK_MIN_PRIMS 4096
+
+typedef struct PBVHBuildNode {
+  /* Both are NULL for leaves. */
+  struct PBVHBuildNode *children[2];
+  /* Bounding box of the primitives, only set for non-leaf nodes. */
+  BB vb;
+  int offset, count;
+} PBVHBuildNode;
+
+typedef struct PBVHBuildContext {
+  PBVH *pbvh;
+  BBC *prim_bbc;
+  int totleaf;
+} PBVHBuildContext;
+
+typedef struct PBVHBuildTask {
+  PBVHBuildNode *node;
+  BB cb;
+  bool has_cb;
+} PBVHBuildTask;
+
+#ifdef USE_PBVH_BUILD_SAH
+typedef struct PBVHBuildBins {
+  int count[PBVH_BUILD_SAH_BINS];
+  /* Bounding box of the primitives. */
+  BB bb[PBVH_BUILD_SAH_BINS];
+  /* Bounding box of the primitive centroids. */
+  BB cb[PBVH_BUILD_SAH_BINS];
+} PBVHBuildBins;
+
+typedef struct PBVHBuildBinData {
+  const PBVH *pbvh;
+  const BBC *prim_bbc;
+  int offset;
+  int axis;
+  float axis_min;
+  float axis_scale;
+} PBVHBuildBinData;
+
+static void build_bins_reset(PBVHBuildBins *bins)
+{
+  for (int i = 0; i < PBVH_BUILD_SAH_BINS; i++) {
+    bins->count[i] = 0;
+    BB_reset(&bins->bb[i]);
+    BB_reset(&bins->cb[i]);
+  }
+}
+
+BLI_INLINE int build_bin_index(const PBVHBuildBinData *data, const float centroid[3])
+{
+  const int bin = (int)((centroid[data->axis] - data->axis_min) * data->axis_scale);
+  return CLAMPIS(bin, 0, PBVH_BUILD_SAH_BINS - 1);
+}
+
+static void build_bins_task_cb(void *__restrict userdata,
+                               const int i,
+                               const TaskParallelTLS *__restrict tls)
+{
+  const PBVHBuildBinData *data = userdata;
+  PBVHBuildBins *bins = tls->userdata_chunk;
+  const BBC *bbc = &data->prim_bbc[data->pbvh->prim_indices[data->offset + i]];
+  const int bin = build_bin_index(data, bbc->bcentroid);
+  bins->count[bin]++;
+  BB_expand_with_bb(&bins->bb[bin], (BB *)bbc);
+  BB_expand(&bins->cb[bin], bbc->bcentroid);
+}
+
+static void build_bins_reduce(const void *__restrict UNUSED(userdata),
+                              void *__restrict chunk_join,
+                              void *__restrict chunk)
+{
+  PBVHBuildBins *join = chunk_join;
+  PBVHBuildBins *bins = chunk;
+  for (int i = 0; i < PBVH_BUILD_SAH_BINS; i++) {
+    join->count[i] += bins->count[i];
+    BB_expand_with_bb(&join->bb[i], &bins->bb[i]);
+    BB_expand_with_bb(&join->cb[i], &bins->cb[i]);
+  }
+}
+
+static float BB_half_area(const BB *bb)
+{
+  float size[3];
+  sub_v3_v3v3(size, bb->bmax, bb->bmin);
+  return size[0] * size[1] + size[1] * size[2] + size[2] * size[0];
+}
+
+/* Find the split with the lowest surface area heuristic cost between the bins.
+ * Returns the index of the last bin on the left side, or -1 if the primitives can't be split. */
+static int build_bins_find_split(const PBVHBuildBins *bins)
+{
+  BB right_bb[PBVH_BUILD_SAH_BINS];
+  int right_count[PBVH_BUILD_SAH_BINS];
+  BB bb;
+  BB_reset(&bb);
+  int count = 0;
+  for (int i = PBVH_BUILD_SAH_BINS - 1; i > 0; i--) {
+    BB_expand_with_bb(&bb, (BB *)&bins->bb[i]);
+    count += bins->count[i];
+    right_bb[i] = bb;
+    right_count[i] = count;
+  }
+
+  int best_split = -1;
+  float best_cost = FLT_MAX;
+  BB_reset(&bb);
+  count = 0;
+  for (int i = 0; i < PBVH_BUILD_SAH_BINS - 1; i++) {
+    BB_expand_with_bb(&bb, (BB *)&bins->bb[i]);
+    count += bins->count[i];
+    if (count == 0 || right_count[i + 1] == 0) {
+      continue;
+    }
+    const float cost = BB_half_area(&bb) * (float)count +
+                       BB_half_area(&right_bb[i + 1]) * (float)right_count[i + 1];
+    if (cost < best_cost) {
+      best_cost = cost;
+      best_split = i;
+    }
+  }
+  return best_split;
+}
+
+/* Returns the index of the first element on the right of the partition */
+static int partition_indices_bins(int *prim_indices,
+                                  int lo,
+                                  int hi,
+                                  const PBVHBuildBinData *data,
+                                  int split_bin)
+{
+  const BBC *prim_bbc = data->prim_bbc;
+  int i = lo, j = hi;
+  for (;;) {
+    while (i <= j && build_bin_index(data, prim_bbc[prim_indices[i]].bcentroid) <= split_bin) {
+      i++;
+    }
+    while (i <= j && build_bin_index(data, prim_bbc[prim_indices[j]].bcentroid) > split_bin) {
+      j--;
+    }
+    if (!(i < j)) {
+      return i;
+    }
+    SWAP(int, prim_indices[i], prim_indices[j]);
+    i++;
+    j--;
+  }
+}
+
+/* Split the node using the surface area heuristic.
+ * Returns the index of the first primitive of the right child, or -1 if the primitives can't be
+ * separated this way. */
+static int build_split_sah(PBVH *pbvh,
+                           PBVHBuildNode *node,
+                           const BB *cb,
+                           BBC *prim_bbc,
+                           BB r_child_cb[2])
+{
+  const int axis = BB_widest_axis(cb);
+  const float extent = cb->bmax[axis] - cb->bmin[axis];
+  if (!(extent > 0.0f)) {
+    return -1;
+  }
+
+  PBVHBuildBinData data = {
+      .pbvh = pbvh,
+      .prim_bbc = prim_bbc,
+      .offset = node->offset,
+      .axis = axis,
+      .axis_min = cb->bmin[axis],
+      .axis_scale = (float)PBVH_BUILD_SAH_BINS / extent,
+  };
+
+  PBVHBuildBins bins;
+  build_bins_reset(&bins);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = node->count > PBVH_BUILD_PARALLEL_BIN_MIN_PRIMS;
+  settings.min_iter_per_thread = PBVH_BUILD_PARALLEL_BIN_MIN_PRIMS / 4;
+  settings.userdata_chunk = &bins;
+  settings.userdata_chunk_size = sizeof(bins);
+  settings.func_reduce = build_bins_reduce;
+  BLI_task_parallel_range(0, node->count, &data, build_bins_task_cb, &settings);
+
+  const int split_bin = build_bins_find_split(&bins);
+  if (split_bin == -1) {
+    return -1;
+  }
+
+  BB_reset(&node->vb);
+  BB_reset(&r_child_cb[0]);
+  BB_reset(&r_child_cb[1]);
+  for (int i = 0; i < PBVH_BUILD_SAH_BINS; i++) {
+    BB_expand_with_bb(&node->vb, &bins.bb[i]);
+    BB_expand_with_bb(&r_child_cb[i <= split_bin ? 0 : 1], &bins.cb[i]);
+  }
+
+  return partition_indices_bins(
+      pbvh->prim_indices, node->offset, node->offset + node->count - 1, &data, split_bin);
+}
+#endif /* USE_PBVH_BUILD_SAH */
+
+static void build_sub(PBVHBuildContext *ctx, TaskPool *pool, PBVHBuildNode *node, const BB *cb);
+
+static void build_sub_task_cb(TaskPool *__restrict pool, void *taskdata)
+{
+  PBVHBuildContext *ctx = BLI_task_pool_user_data(pool);
+  PBVHBuildTask *task = taskdata;
+  build_sub(ctx, pool, task->node, task->has_cb ? &task->cb : NULL);
+}
+
+/* Recursively build a node in the tree
  *
  * cb is the bounding box around all the centroids of the primitives
- * contained in this node
+ * contained in this node, NULL when it is not known yet.
  *
- * offset and start indicate a range in the array of primitive indices
+ * Large children are built by new tasks in the pool, small ones are built directly.
  */
-
-static void build_sub(PBVH *pbvh, int node_index, BB *cb, BBC *prim_bbc, int offset, int count)
+static void build_sub(PBVHBuildContext *ctx, TaskPool *pool, PBVHBuildNode *node, const BB *cb)
 {
-  int end;
+  PBVH *pbvh = ctx->pbvh;
+  BBC *prim_bbc = ctx->prim_bbc;
+  const int offset = node->offset;
+  const int count = node->count;
+  int end = -1;
   BB cb_backing;
+  BB child_cb[2];
+  bool has_child_cb = false;
 
   /* Decide whether this is a leaf or not */
   const bool below_leaf_limit = count <= pbvh->leaf_limit;
   if (below_leaf_limit) {
     if (!leaf_needs_material_split(pbvh, offset, count)) {
-      build_leaf(pbvh, node_index, prim_bbc, offset, count);
+      node->children[0] = node->children[1] = NULL;
+      atomic_add_and_fetch_int32(&ctx->totleaf, 1);
       return;
     }
   }
 
-  /* Add two child nodes */
-  pbvh->nodes[node_index].children_offset = pbvh->totnode;
-  pbvh_grow_nodes(pbvh, pbvh->totnode + 2);
-
-  /* Update parent node bounding box */
-  update_vb(pbvh, &pbvh->nodes[node_index], prim_bbc, offset, count);
-
   if (!below_leaf_limit) {
-    /* Find axis with widest range of primitive centroids */
     if (!cb) {
       cb = &cb_backing;
-      BB_reset(cb);
+      BB_reset(&cb_backing);
       for (int i = offset + count - 1; i >= offset; i--) {
-        BB_expand(cb, prim_bbc[pbvh->prim_indices[i]].bcentroid);
+        BB_expand(&cb_backing, prim_bbc[pbvh->prim_indices[i]].bcentroid);
       }
     }
-    const int axis = BB_widest_axis(cb);
-
-    /* Partition primitives along that axis */
-    end = partition_indices(pbvh->prim_indices,
-                            offset,
-                            offset + count - 1,
-                            axis,
-                            (cb->bmax[axis] + cb->bmin[axis]) * 0.5f,
-                            prim_bbc);
+#ifdef USE_PBVH_BUILD_SAH
+    end = build_split_sah(pbvh, node, cb, prim_bbc, child_cb);
+    has_child_cb = (end != -1);
+#endif
   }
-  else {
-    /* Partition primitives by material */
-    end = partition_indices_material(pbvh, offset, offset + count - 1);
+
+  if (end == -1) {
+    /* Update node bounding box */
+    BB_reset(&node->vb);
+    for (int i = offset + count - 1; i >= offset; i--) {
+      BB_expand_with_bb(&node->vb, (BB *)(&prim_bbc[pbvh->prim_indices[i]]));
+    }
+
+    if (!below_leaf_limit) {
+      /* Without the surface area heuristic, or when all centroids are at the same place on the
+       * widest axis, split at the median of the centroid bounds. */
+      const int axis = BB_widest_axis(cb);
+      end = partition_indices(pbvh->prim_indices,
+                              offset,
+                              offset + count - 1,
+                              axis,
+                              (cb->bmax[axis] + cb->bmin[axis]) * 0.5f,
+                              prim_bbc);
+    }
+    else {
+      /* Partition primitives by material */
+      end = partition_indices_material(pbvh, offset, offset + count - 1);
+    }
   }
 
   /* Build children */
-  build_sub(pbvh, pbvh->nodes[node_index].children_offset, NULL, prim_bbc, offset, end - offset);
-  build_sub(pbvh,
-            pbvh->nodes[node_index].children_offset + 1,
-            NULL,
-            prim_bbc,
-            end,
-            offset + count - end);
+  for (int i = 0; i < 2; i++) {
+    PBVHBuildNode *child = MEM_mallocN(sizeof(*child), __func__);
+    child->offset = (i == 0) ? offset : end;
+    child->count = (i == 0) ? end - offset : offset + count - end;
+    node->children[i] = child;
+
+    if (child->count > PBVH_BUILD_TASK_MIN_PRIMS) {
+      PBVHBuildTask *task = MEM_mallocN(sizeof(*task), __func__);
+      task->node = child;
+      task->has_cb = has_child_cb;
+      if (has_child_cb) {
+        task->cb = child_cb[i];
+      }
+      BLI_task_pool_push(pool, build_sub_task_cb, task, true, NULL);
+    }
+    else {
+      build_sub(ctx, pool, child, has_child_cb ? &child_cb[i] : NULL);
+    }
+  }
+}
+
+/* Move the temporary tree into the node array, allocating the children of a node right when it
+ * is visited, and collect the leaves in depth-first order. */
+static void build_flatten(
+    PBVH *pbvh, const PBVHBuildNode *build_node, int node_index, int *r_leaves, int *r_totleaf)
+{
+  if (build_node->children[0] == NULL) {
+    PBVHNode *node = &pbvh->nodes[node_index];
+    node->flag |= PBVH_Leaf;
+    node->prim_indices = pbvh->prim_indices + build_node->offset;
+    node->totprim = build_node->count;
+    r_leaves[(*r_totleaf)++] = node_index;
+    return;
+  }
+
+  const int children_offset = pbvh->totnode;
+  pbvh_grow_nodes(pbvh, pbvh->totnode + 2);
+
+  PBVHNode *node = &pbvh->nodes[node_index];
+  node->children_offset = children_offset;
+  node->vb = build_node->vb;
+  node->orig_vb = build_node->vb;
+
+  for (int i = 0; i < 2; i++) {
+    build_flatten(pbvh, build_node->children[i], children_offset + i, r_leaves, r_totleaf);
+    MEM_freeN(build_node->children[i]);
+  }
+}
+
+typedef struct PBVHBuildLeavesData {
+  PBVH *pbvh;
+  BBC *prim_bbc;
+  const int *leaves;
+  int *vert_owner_leaf;
+} PBVHBuildLeavesData;
+
+BLI_INLINE void atomic_min_int32(int32_t *p, int32_t x)
+{
+  int32_t value = *p;
+  while (x < value) {
+    const int32_t prev_value = atomic_cas_int32(p, value, x);
+    if (prev_value == value) {
+      break;
+    }
+    value = prev_value;
+  }
+}
+
+/* Vertices are unique to the first leaf in the depth-first order which uses them, which is the
+ * order in which leaves used to be built one after another. */
+static void pbvh_build_vert_owners_task_cb(void *__restrict userdata,
+                                           const int n,
+                                           const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  PBVHBuildLeavesData *data = userdata;
+  const PBVH *pbvh = data->pbvh;
+  const PBVHNode *node = &pbvh->nodes[data->leaves[n]];
+
+  for (int i = 0; i < node->totprim; i++) {
+    const MLoopTri *lt = &pbvh->looptri[node->prim_indices[i]];
+    for (int j = 0; j < 3; j++) {
+      atomic_min_int32(&data->vert_owner_leaf[pbvh->mloop[lt->tri[j]].v], n);
+    }
+  }
+}
+
+static void pbvh_build_leaves_task_cb(void *__restrict userdata,
+                                      const int n,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  PBVHBuildLeavesData *data = userdata;
+  PBVH *pbvh = data->pbvh;
+  PBVHNode *node = &pbvh->nodes[data->leaves[n]];
+  const int offset = (int)(node->prim_indices - pbvh->prim_indices);
+
+  /* Still need vb for searches */
+  update_vb(pbvh, node, data->prim_bbc, offset, node->totprim);
+
+  if (pbvh->looptri) {
+    build_mesh_leaf_node(pbvh, node, data->vert_owner_leaf, n);
+  }
+  else {
+    build_grid_leaf_node(pbvh, node);
+  }
 }
 
 static void pbvh_build(PBVH *pbvh, BB *cb, BBC *prim_bbc, int totprim)
@@ -551,8 +885,124 @@ static void pbvh_build(PBVH *pbvh, BB *cb, BBC *prim_bbc, int totprim)
     }
   }
 
+  /* Partition the primitives. */
+  PBVHBuildContext ctx = {
+      .pbvh = pbvh,
+      .prim_bbc = prim_bbc,
+      .totleaf = 0,
+  };
+  PBVHBuildNode root = {.offset = 0, .count = totprim};
+  TaskPool *pool = BLI_task_pool_create(&ctx, TASK_PRIORITY_HIGH);
+  build_sub(&ctx, pool, &root, cb);
+  BLI_task_pool_work_and_wait(pool);
+  BLI_task_pool_free(pool);
+
+  /* Create the nodes. */
+  int *leaves = MEM_malloc_arrayN(ctx.totleaf, sizeof(int), "bvh build leaves");
+  int totleaf = 0;
   pbvh->totnode = 1;
-  build_sub(pbvh, 0, cb, prim_bbc, 0, totprim);
+  build_flatten(pbvh, &root, 0, leaves, &totleaf);
+  BLI_assert(totleaf == ctx.totleaf);
+
+  /* Fill the leaves. */
+  PBVHBuildLeavesData data = {
+      .pbvh = pbvh,
+      .prim_bbc = prim_bbc,
+      .leaves = leaves,
+      .vert_owner_leaf = NULL,
+  };
+
+  TaskParallelSettings settings;
+  BKE_pbvh_parallel_range_settings(&settings, true, ctx.totleaf);
+
+  if (pbvh->looptri) {
+    data.vert_owner_leaf = MEM_malloc_arrayN(pbvh->totvert, sizeof(int), "bvh vert owner leaf");
+    copy_vn_i(data.vert_owner_leaf, pbvh->totvert, INT_MAX);
+    BLI_task_parallel_range(0, ctx.totleaf, &data, pbvh_build_vert_owners_task_cb, &settings);
+  }
+
+  BLI_task_parallel_range(0, ctx.totleaf, &data, pbvh_build_leaves_task_cb, &settings);
+
+  MEM_SAFE_FREE(data.vert_owner_leaf);
+  MEM_freeN(leaves);
+}
+
+/** \} */
+
+typedef struct PBVHBuildPrimBBData {
+  const PBVH *pbvh;
+  BBC *prim_bbc;
+} PBVHBuildPrimBBData;
+
+/* For each face, store the AABB and the AABB centroid */
+static void pbvh_build_looptri_bbc_task_cb(void *__restrict userdata,
+                                           const int i,
+                                           const TaskParallelTLS *__restrict tls)
+{
+  PBVHBuildPrimBBData *data = userdata;
+  const PBVH *pbvh = data->pbvh;
+  const MLoopTri *lt = &pbvh->looptri[i];
+  const int sides = 3;
+  BBC *bbc = data->prim_bbc + i;
+
+  BB_reset((BB *)bbc);
+
+  for (int j = 0; j < sides; j++) {
+    BB_expand((BB *)bbc, pbvh->verts[pbvh->mloop[lt->tri[j]].v].co);
+  }
+
+  BBC_update_centroid(bbc);
+
+  BB_expand(tls->userdata_chunk, bbc->bcentroid);
+}
+
+/* For each grid, store the AABB and the AABB centroid */
+static void pbvh_build_grid_bbc_task_cb(void *__restrict userdata,
+                                        const int i,
+                                        const TaskParallelTLS *__restrict tls)
+{
+  PBVHBuildPrimBBData *data = userdata;
+  const PBVH *pbvh = data->pbvh;
+  const CCGKey *key = &pbvh->gridkey;
+  CCGElem *grid = pbvh->grids[i];
+  BBC *bbc = data->prim_bbc + i;
+
+  BB_reset((BB *)bbc);
+
+  for (int j = 0; j < key->grid_area; j++) {
+    BB_expand((BB *)bbc, CCG_elem_offset_co(key, grid, j));
+  }
+
+  BBC_update_centroid(bbc);
+
+  BB_expand(tls->userdata_chunk, bbc->bcentroid);
+}
+
+static void pbvh_build_bbc_reduce(const void *__restrict UNUSED(userdata),
+                                  void *__restrict chunk_join,
+                                  void *__restrict chunk)
+{
+  BB_expand_with_bb(chunk_join, chunk);
+}
+
+static BBC *pbvh_build_prim_bbc(PBVH *pbvh, int totprim, TaskParallelRangeFunc func, BB *r_cb)
+{
+  PBVHBuildPrimBBData data = {
+      .pbvh = pbvh,
+      .prim_bbc = MEM_mallocN(sizeof(BBC) * totprim, "prim_bbc"),
+  };
+
+  BB_reset(r_cb);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+  settings.userdata_chunk = r_cb;
+  settings.userdata_chunk_size = sizeof(*r_cb);
+  settings.func_reduce = pbvh_build_bbc_reduce;
+  BLI_task_parallel_range(0, totprim, &data, func, &settings);
+
+  return data.prim_bbc;
 }
 
 /**
@@ -573,7 +1023,6 @@ void BKE_pbvh_build_mesh(PBVH *pbvh,
                          const MLoopTri *looptri,
                          int looptri_num)
 {
-  BBC *prim_bbc = NULL;
   BB cb;
 
   pbvh->mesh = mesh;
@@ -582,7 +1031,6 @@ void BKE_pbvh_build_mesh(PBVH *pbvh,
   pbvh->mloop = mloop;
   pbvh->looptri = looptri;
   pbvh->verts = verts;
-  pbvh->vert_bitmap = BLI_BITMAP_NEW(totvert, "bvh->vert_bitmap");
   pbvh->totvert = totvert;
   pbvh->leaf_limit = LEAF_LIMIT;
   pbvh->vdata = vdata;
@@ -592,33 +1040,13 @@ void BKE_pbvh_build_mesh(PBVH *pbvh,
   pbvh->face_sets_color_seed = mesh->face_sets_color_seed;
   pbvh->face_sets_color_default = mesh->face_sets_color_default;
 
-  BB_reset(&cb);
-
-  /* For each face, store the AABB and the AABB centroid */
-  prim_bbc = MEM_mallocN(sizeof(BBC) * looptri_num, "prim_bbc");
-
-  for (int i = 0; i < looptri_num; i++) {
-    const MLoopTri *lt = &looptri[i];
-    const int sides = 3;
-    BBC *bbc = prim_bbc + i;
-
-    BB_reset((BB *)bbc);
-
-    for (int j = 0; j < sides; j++) {
-      BB_expand((BB *)bbc, verts[pbvh->mloop[lt->tri[j]].v].co);
-    }
-
-    BBC_update_centroid(bbc);
-
-    BB_expand(&cb, bbc->bcentroid);
-  }
+  BBC *prim_bbc = pbvh_build_prim_bbc(pbvh, looptri_num, pbvh_build_looptri_bbc_task_cb, &cb);
 
   if (looptri_num) {
     pbvh_build(pbvh, &cb, prim_bbc, looptri_num);
   }
 
   MEM_freeN(prim_bbc);
-  MEM_freeN(pbvh->vert_bitmap);
 }
 
 /* Do a full rebuild with on Grids data structure */
@@ -642,25 +1070,7 @@ void BKE_pbvh_build_grids(PBVH *pbvh,
   pbvh->leaf_limit = max_ii(LEAF_LIMIT / (gridsize * gridsize), 1);
 
   BB cb;
-  BB_reset(&cb);
-
-  /* For each grid, store the AABB and the AABB centroid */
-  BBC *prim_bbc = MEM_mallocN(sizeof(BBC) * totgrid, "prim_bbc");
-
-  for (int i = 0; i < totgrid; i++) {
-    CCGElem *grid = grids[i];
-    BBC *bbc = prim_bbc + i;
-
-    BB_reset((BB *)bbc);
-
-    for (int j = 0; j < gridsize * gridsize; j++) {
-      BB_expand((BB *)bbc, CCG_elem_offset_co(key, grid, j));
-    }
-
-    BBC_update_centroid(bbc);
-
-    BB_expand(&cb, bbc->bcentroid);
-  }
+  BBC *prim_bbc = pbvh_build_prim_bbc(pbvh, totgrid, pbvh_build_grid_bbc_task_cb, &cb);
 
   if (totgrid) {
     pbvh_build(pbvh, &cb, prim_bbc, totgrid);
@@ -25,6 +25,7 @@
 #include "BLI_heap_simple.h"
 #include "BLI_math.h"
 #include "BLI_memarena.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_DerivedMesh.h"
@@ -57,6 +58,16 @@
 #  endif
 #endif
 
+/**
+ * Build the edge queues of many nodes in parallel, see #edge_queue_create_from_nodes.
+ * Strokes updating fewer nodes check them on a single thread, where collecting the edges
+ * of each node first would only add overhead.
+ */
+#define USE_EDGEQUEUE_PARALLEL
+#ifdef USE_EDGEQUEUE_PARALLEL
+#  define EDGEQUEUE_PARALLEL_MIN_NODES 16
+#endif
+
 // #define USE_VERIFY
 
 #ifdef USE_VERIFY
@@ -746,6 +757,11 @@ typedef struct EdgeQueue {
 #endif
 } EdgeQueue;
 
+typedef struct EdgeQueueCandidate {
+  BMEdge *e;
+  float priority;
+} EdgeQueueCandidate;
+
 typedef struct {
   EdgeQueue *q;
   BLI_mempool *pool;
@@ -753,6 +769,9 @@ typedef struct {
   int cd_vert_mask_offset;
   int cd_vert_node_offset;
   int cd_face_node_offset;
+  /* When set, edges are collected here instead of being inserted into the heap,
+   * see #edge_queue_create_from_nodes. */
+  BLI_Buffer *candidates;
 } EdgeQueueContext;
 
 /* only tag'd edges are in the queue */
@@ -833,6 +852,18 @@ static bool check_mask(EdgeQueueContext *eq_ctx, BMVert *v)
   return BM_ELEM_CD_GET_FLOAT(v, eq_ctx->cd_vert_mask_offset) < 1.0f;
 }
 
+static void edge_queue_heap_insert(EdgeQueueContext *eq_ctx, BMEdge *e, float priority)
+{
+  BMVert **pair = BLI_mempool_alloc(eq_ctx->pool);
+  pair[0] = e->v1;
+  pair[1] = e->v2;
+  BLI_heapsimple_insert(eq_ctx->q->heap, priority, pair);
+#ifdef USE_EDGEQUEUE_TAG
+  BLI_assert(EDGE_QUEUE_TEST(e) == false);
+  EDGE_QUEUE_ENABLE(e);
+#endif
+}
+
 static void edge_queue_insert(EdgeQueueContext *eq_ctx, BMEdge *e, float priority)
 {
   /* Don't let topology update affect fully masked vertices. This used to
@@ -845,14 +876,13 @@ static void edge_queue_insert(EdgeQueueContext *eq_ctx, BMEdge *e, float priorit
        (check_mask(eq_ctx, e->v1) || check_mask(eq_ctx, e->v2))) &&
       !(BM_elem_flag_test_bool(e->v1, BM_ELEM_HIDDEN) ||
         BM_elem_flag_test_bool(e->v2, BM_ELEM_HIDDEN))) {
-    BMVert **pair = BLI_mempool_alloc(eq_ctx->pool);
-    pair[0] = e->v1;
-    pair[1] = e->v2;
-    BLI_heapsimple_insert(eq_ctx->q->heap, priority, pair);
-#ifdef USE_EDGEQUEUE_TAG
-    BLI_assert(EDGE_QUEUE_TEST(e) == false);
-    EDGE_QUEUE_ENABLE(e);
-#endif
+    if (eq_ctx->candidates != NULL) {
+      EdgeQueueCandidate candidate = {e, priority};
+      BLI_buffer_append(eq_ctx->candidates, EdgeQueueCandidate, candidate);
+    }
+    else {
+      edge_queue_heap_insert(eq_ctx, e, priority);
+    }
   }
 }
 
@@ -990,6 +1020,106 @@ static void short_edge_queue_face_add(EdgeQueueContext *eq_ctx, BMFace *f)
   }
 }
 
+#ifdef USE_EDGEQUEUE_PARALLEL
+typedef struct EdgeQueueCreateData {
+  const EdgeQueueContext *eq_ctx;
+  PBVHNode **nodes;
+  BLI_Buffer *candidates;
+  void (*face_add)(EdgeQueueContext *eq_ctx, BMFace *f);
+} EdgeQueueCreateData;
+
+static void edge_queue_create_task_cb(void *__restrict userdata,
+                                      const int n,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  EdgeQueueCreateData *data = userdata;
+  EdgeQueueContext eq_ctx = *data->eq_ctx;
+  eq_ctx.candidates = &data->candidates[n];
+
+  GSetIterator gs_iter;
+  GSET_ITER (gs_iter, data->nodes[n]->bm_faces) {
+    BMFace *f = BLI_gsetIterator_getKey(&gs_iter);
+
+    data->face_add(&eq_ctx, f);
+  }
+}
+#endif
+
+/* Check the faces of leaf nodes marked for topology update.
+ *
+ * With #USE_EDGEQUEUE_PARALLEL and enough nodes, nodes are checked in parallel, each collecting
+ * its own list of candidate edges without touching the heap or the edge tags. Edges on the
+ * boundary of nodes are found by all the nodes using them, they are de-duplicated by the serial
+ * pass which fills the heap in node order, so the queue is the same as the one created on a
+ * single thread. */
+static void edge_queue_create_from_nodes(EdgeQueueContext *eq_ctx,
+                                         PBVH *pbvh,
+                                         void (*face_add)(EdgeQueueContext *eq_ctx, BMFace *f))
+{
+  PBVHNode **nodes = MEM_malloc_arrayN(pbvh->totnode, sizeof(*nodes), __func__);
+  int totnode = 0;
+  for (int n = 0; n < pbvh->totnode; n++) {
+    PBVHNode *node = &pbvh->nodes[n];
+
+    if ((node->flag & PBVH_Leaf) && (node->flag & PBVH_UpdateTopology) &&
+        !(node->flag & PBVH_FullyHidden)) {
+      nodes[totnode++] = node;
+    }
+  }
+
+#ifdef USE_EDGEQUEUE_PARALLEL
+  if (totnode < EDGEQUEUE_PARALLEL_MIN_NODES)
+#endif
+  {
+    for (int i = 0; i < totnode; i++) {
+      GSetIterator gs_iter;
+
+      /* Check each face */
+      GSET_ITER (gs_iter, nodes[i]->bm_faces) {
+        BMFace *f = BLI_gsetIterator_getKey(&gs_iter);
+
+        face_add(eq_ctx, f);
+      }
+    }
+    MEM_freeN(nodes);
+    return;
+  }
+
+#ifdef USE_EDGEQUEUE_PARALLEL
+  BLI_Buffer *candidates = MEM_malloc_arrayN(totnode, sizeof(*candidates), __func__);
+  for (int i = 0; i < totnode; i++) {
+    BLI_buffer_field_init(&candidates[i], EdgeQueueCandidate);
+  }
+
+  EdgeQueueCreateData data = {
+      .eq_ctx = eq_ctx,
+      .nodes = nodes,
+      .candidates = candidates,
+      .face_add = face_add,
+  };
+
+  TaskParallelSettings settings;
+  BKE_pbvh_parallel_range_settings(&settings, true, totnode);
+  BLI_task_parallel_range(0, totnode, &data, edge_queue_create_task_cb, &settings);
+
+  for (int i = 0; i < totnode; i++) {
+    const EdgeQueueCandidate *candidate = candidates[i].data;
+    for (size_t j = 0; j < candidates[i].count; j++, candidate++) {
+#ifdef USE_EDGEQUEUE_TAG
+      if (EDGE_QUEUE_TEST(candidate->e)) {
+        continue;
+      }
+#endif
+      edge_queue_heap_insert(eq_ctx, candidate->e, candidate->priority);
+    }
+    BLI_buffer_field_free(&candidates[i]);
+  }
+
+  MEM_freeN(candidates);
+  MEM_freeN(nodes);
+#endif
+}
+
 /* Create a priority queue containing vertex pairs connected by a long
  * edge as defined by PBVH.bm_max_edge_len.
  *
@@ -1035,22 +1165,7 @@ static void long_edge_queue_create(EdgeQueueContext *eq_ctx,
   pbvh_bmesh_edge_tag_verify(pbvh);
 #endif
 
-  for (int n = 0; n < pbvh->totnode; n++) {
-    PBVHNode *node = &pbvh->nodes[n];
-
-    /* Check leaf nodes marked for topology update */
-    if ((node->flag & PBVH_Leaf) && (node->flag & PBVH_UpdateTopology) &&
-        !(node->flag & PBVH_FullyHidden)) {
-      GSetIterator gs_iter;
-
-      /* Check each face */
-      GSET_ITER (gs_iter, node->bm_faces) {
-        BMFace *f = BLI_gsetIterator_getKey(&gs_iter);
-
-        long_edge_queue_face_add(eq_ctx, f);
-      }
-    }
-  }
+  edge_queue_create_from_nodes(eq_ctx, pbvh, long_edge_queue_face_add);
 }
 
 /* Create a priority queue containing vertex pairs connected by a
@@ -1094,22 +1209,7 @@ static void short_edge_queue_create(EdgeQueueContext *eq_ctx,
     eq_ctx->q->edge_queue_tri_in_range = edge_queue_tri_in_sphere;
   }
 
-  for (int n = 0; n < pbvh->totnode; n++) {
-    PBVHNode *node = &pbvh->nodes[n];
-
-    /* Check leaf nodes marked for topology update */
-    if ((node->flag & PBVH_Leaf) && (node->flag & PBVH_UpdateTopology) &&
-        !(node->flag & PBVH_FullyHidden)) {
-      GSetIterator gs_iter;
-
-      /* Check each face */
-      GSET_ITER (gs_iter, node->bm_faces) {
-        BMFace *f = BLI_gsetIterator_getKey(&gs_iter);
-
-        short_edge_queue_face_add(eq_ctx, f);
-      }
-    }
-  }
+  edge_queue_create_from_nodes(eq_ctx, pbvh, short_edge_queue_face_add);
 }
 
 /*************************** Topology update **************************/
@@ -0,0 +1,163 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2021 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_ghash.h"
+#include "BLI_math.h"
+#include "BLI_task.h"
+#include "BLI_vector.hh"
+
+#include "BKE_customdata.h"
+#include "BKE_pbvh.h"
+
+#include "bmesh.h"
+
+namespace blender::bke::tests {
+
+/* A dynamic topology sculpt session on a triangulated grid, set up like
+ * #SCULPT_dynamic_topology_enable_ex does. */
+struct DyntopoGrid {
+  BMesh *bm;
+  BMLog *log;
+  PBVH *pbvh;
+
+  DyntopoGrid(const int resolution)
+  {
+    BMeshCreateParams bm_params = {};
+    bm = BM_mesh_create(&bm_mesh_allocsize_default, &bm_params);
+
+    Vector<BMVert *> verts;
+    for (int y = 0; y <= resolution; y++) {
+      for (int x = 0; x <= resolution; x++) {
+        /* Uneven edge lengths, so the queues are not full of equal priorities. */
+        const float co[3] = {x + 0.3f * (y % 3), y * 0.7f, (x % 7 == 0) ? 0.5f : 0.0f};
+        verts.append(BM_vert_create(bm, co, nullptr, BM_CREATE_NOP));
+      }
+    }
+    for (int y = 0; y < resolution; y++) {
+      for (int x = 0; x < resolution; x++) {
+        BMVert *v0 = verts[y * (resolution + 1) + x];
+        BMVert *v1 = verts[y * (resolution + 1) + x + 1];
+        BMVert *v2 = verts[(y + 1) * (resolution + 1) + x + 1];
+        BMVert *v3 = verts[(y + 1) * (resolution + 1) + x];
+        BMVert *tri_a[3] = {v0, v1, v2};
+        BMVert *tri_b[3] = {v0, v2, v3};
+        BM_face_create_verts(bm, tri_a, 3, nullptr, BM_CREATE_NOP, true);
+        BM_face_create_verts(bm, tri_b, 3, nullptr, BM_CREATE_NOP, true);
+      }
+    }
+    BM_mesh_normals_update(bm);
+
+    BM_data_layer_add(bm, &bm->vdata, CD_PAINT_MASK);
+    BM_data_layer_add_named(bm, &bm->vdata, CD_PROP_INT32, "_dyntopo_node_id");
+    BM_data_layer_add_named(bm, &bm->pdata, CD_PROP_INT32, "_dyntopo_node_id");
+    const int cd_vert_node_offset = CustomData_get_offset(&bm->vdata, CD_PROP_INT32);
+    const int cd_face_node_offset = CustomData_get_offset(&bm->pdata, CD_PROP_INT32);
+
+    log = BM_log_create(bm);
+    BM_log_entry_add(log);
+
+    pbvh = BKE_pbvh_new();
+    BKE_pbvh_build_bmesh(pbvh, bm, false, log, cd_vert_node_offset, cd_face_node_offset);
+  }
+
+  ~DyntopoGrid()
+  {
+    BKE_pbvh_free(pbvh);
+    BM_log_free(log);
+    BM_mesh_free(bm);
+  }
+
+  /* Update the topology of all nodes, returns the number of nodes. */
+  int update_topology(const PBVHTopologyUpdateMode mode, const float detail_size)
+  {
+    PBVHNode **nodes;
+    int totnode;
+    BKE_pbvh_search_gather(pbvh, nullptr, nullptr, &nodes, &totnode);
+    for (int i = 0; i < totnode; i++) {
+      BKE_pbvh_node_mark_topology_update(nodes[i]);
+    }
+    MEM_SAFE_FREE(nodes);
+
+    /* A brush covering the whole grid. */
+    const float center[3] = {0.0f, 0.0f, 0.0f};
+    const float radius = 1000.0f;
+    BKE_pbvh_bmesh_detail_size_set(pbvh, detail_size);
+    BKE_pbvh_bmesh_update_topology(pbvh, mode, center, nullptr, radius, false, false);
+    return totnode;
+  }
+
+  /* Number of faces in leaf nodes, each face is expected to be in exactly one of them. */
+  int node_face_count() const
+  {
+    PBVHNode **nodes;
+    int totnode;
+    BKE_pbvh_search_gather(pbvh, nullptr, nullptr, &nodes, &totnode);
+    int totface = 0;
+    for (int i = 0; i < totnode; i++) {
+      totface += BLI_gset_len(BKE_pbvh_bmesh_node_faces(nodes[i]));
+    }
+    MEM_SAFE_FREE(nodes);
+    return totface;
+  }
+
+  float max_edge_length() const
+  {
+    float max_len_sq = 0.0f;
+    BMIter iter;
+    BMEdge *e;
+    BM_ITER_MESH (e, &iter, bm, BM_EDGES_OF_MESH) {
+      max_len_sq = max_ff(max_len_sq, BM_edge_calc_length_squared(e));
+    }
+    return sqrtf(max_len_sq);
+  }
+};
+
+/* Enough nodes are updated for the edge queues to be built in parallel. */
+TEST(pbvh_bmesh, SubdivideLongEdges)
+{
+  BLI_task_scheduler_init();
+  {
+    DyntopoGrid grid(48);
+    EXPECT_GE(grid.update_topology(PBVH_Subdivide, 0.4f), 16);
+
+    EXPECT_GT(grid.bm->totface, 48 * 48 * 2);
+    EXPECT_EQ(grid.node_face_count(), grid.bm->totface);
+    EXPECT_LE(grid.max_edge_length(), 0.4f);
+  }
+  BLI_task_scheduler_exit();
+}
+
+TEST(pbvh_bmesh, CollapseShortEdges)
+{
+  BLI_task_scheduler_init();
+  {
+    DyntopoGrid grid(48);
+    grid.update_topology(PBVH_Subdivide, 0.4f);
+    const int totface_subdivided = grid.bm->totface;
+    EXPECT_GE(grid.update_topology(PBVH_Collapse, 1.5f), 16);
+
+    EXPECT_LT(grid.bm->totface, totface_subdivided);
+    EXPECT_EQ(grid.node_face_count(), grid.bm->totface);
+  }
+  BLI_task_scheduler_exit();
+}
+
+}  // namespace blender::bke::tests
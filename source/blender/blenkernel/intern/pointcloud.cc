@@ -29,9 +29,11 @@
 #include "BLI_math.h"
 #include "BLI_rand.h"
 #include "BLI_string.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_anim_data.h"
+#include "BKE_bvhutils.h"
 #include "BKE_customdata.h"
 #include "BKE_geometry_set.hh"
 #include "BKE_global.h"
@@ -58,12 +60,33 @@ static void pointcloud_random(PointCloud *pointcloud);
 const char *POINTCLOUD_ATTR_POSITION = "position";
 const char *POINTCLOUD_ATTR_RADIUS = "radius";
 
+static void pointcloud_runtime_reset(PointCloud *pointcloud)
+{
+  memset(&pointcloud->runtime, 0, sizeof(pointcloud->runtime));
+  pointcloud->runtime.eval_mutex = MEM_mallocN(sizeof(ThreadMutex), "pointcloud eval_mutex");
+  BLI_mutex_init(static_cast<ThreadMutex *>(pointcloud->runtime.eval_mutex));
+}
+
+static void pointcloud_runtime_free(PointCloud *pointcloud)
+{
+  if (pointcloud->runtime.bvh_cache) {
+    bvhcache_free(pointcloud->runtime.bvh_cache);
+    pointcloud->runtime.bvh_cache = nullptr;
+  }
+  if (pointcloud->runtime.eval_mutex) {
+    BLI_mutex_end(static_cast<ThreadMutex *>(pointcloud->runtime.eval_mutex));
+    MEM_freeN(pointcloud->runtime.eval_mutex);
+    pointcloud->runtime.eval_mutex = nullptr;
+  }
+}
+
 static void pointcloud_init_data(ID *id)
 {
   PointCloud *pointcloud = (PointCloud *)id;
   BLI_assert(MEMCMP_STRUCT_AFTER_IS_ZERO(pointcloud, id));
 
   MEMCPY_STRUCT_AFTER(pointcloud, DNA_struct_default_get(PointCloud), id);
+  pointcloud_runtime_reset(pointcloud);
 
   CustomData_reset(&pointcloud->pdata);
   CustomData_add_layer_named(&pointcloud->pdata,
@@ -75,13 +98,36 @@ static void pointcloud_init_data(ID *id)
   BKE_pointcloud_update_customdata_pointers(pointcloud);
 }
 
+void BKE_pointcloud_share_custom_data(PointCloud *pointcloud)
+{
+  CustomData_share_layers(&pointcloud->pdata, CD_MASK_ALL, pointcloud->totpoint);
+  /* Positions and radii are often written to directly, also through RNA, so they are never
+   * shared. The point cloud is their only user, so taking them back does not copy them. */
+  const std::pair<int, const char *> unshared_layers[] = {
+      {CD_PROP_FLOAT3, POINTCLOUD_ATTR_POSITION}, {CD_PROP_FLOAT, POINTCLOUD_ATTR_RADIUS}};
+  for (const std::pair<int, const char *> &item : unshared_layers) {
+    const int index = CustomData_get_named_layer_index(&pointcloud->pdata, item.first, item.second);
+    if (index != -1 && pointcloud->pdata.layers[index].shared != nullptr) {
+      CustomData_duplicate_referenced_layer_named(
+          &pointcloud->pdata, item.first, item.second, pointcloud->totpoint);
+    }
+  }
+  BKE_pointcloud_update_customdata_pointers(pointcloud);
+}
+
 static void pointcloud_copy_data(Main *UNUSED(bmain), ID *id_dst, const ID *id_src, const int flag)
 {
   PointCloud *pointcloud_dst = (PointCloud *)id_dst;
   const PointCloud *pointcloud_src = (const PointCloud *)id_src;
   pointcloud_dst->mat = static_cast<Material **>(MEM_dupallocN(pointcloud_dst->mat));
 
-  const eCDAllocType alloc_type = (flag & LIB_ID_COPY_CD_REFERENCE) ? CD_REFERENCE : CD_DUPLICATE;
+  eCDAllocType alloc_type = CD_DUPLICATE;
+  if (flag & LIB_ID_COPY_CD_REFERENCE) {
+    alloc_type = CD_REFERENCE;
+  }
+  else if (flag & (LIB_ID_COPY_CD_SHARE_ATTRIBUTES | LIB_ID_COPY_CD_SHARE_GEOMETRY)) {
+    alloc_type = CD_SHARE;
+  }
   CustomData_copy(&pointcloud_src->pdata,
                   &pointcloud_dst->pdata,
                   CD_MASK_ALL,
@@ -90,6 +136,7 @@ static void pointcloud_copy_data(Main *UNUSED(bmain), ID *id_dst, const ID *id_s
   BKE_pointcloud_update_customdata_pointers(pointcloud_dst);
 
   pointcloud_dst->batch_cache = nullptr;
+  pointcloud_runtime_reset(pointcloud_dst);
 }
 
 static void pointcloud_free_data(ID *id)
@@ -97,6 +144,7 @@ static void pointcloud_free_data(ID *id)
   PointCloud *pointcloud = (PointCloud *)id;
   BKE_animdata_free(&pointcloud->id, false);
   BKE_pointcloud_batch_cache_free(pointcloud);
+  pointcloud_runtime_free(pointcloud);
   CustomData_free(&pointcloud->pdata, pointcloud->totpoint);
   MEM_SAFE_FREE(pointcloud->mat);
 }
@@ -114,6 +162,10 @@ static void pointcloud_blend_write(BlendWriter *writer, ID *id, const void *id_a
   PointCloud *pointcloud = (PointCloud *)id;
   if (pointcloud->id.us > 0 || BLO_write_is_undo(writer)) {
     CustomDataLayer *players = nullptr, players_buff[CD_TEMP_CHUNK_SIZE];
+
+    /* Cache only, don't write. */
+    memset(&pointcloud->runtime, 0, sizeof(pointcloud->runtime));
+
     CustomData_blend_write_prepare(
         &pointcloud->pdata, &players, players_buff, ARRAY_SIZE(players_buff));
 
@@ -149,6 +201,8 @@ static void pointcloud_blend_read_data(BlendDataReader *reader, ID *id)
 
   /* Materials */
   BLO_read_pointer_array(reader, (void **)&pointcloud->mat);
+
+  pointcloud_runtime_reset(pointcloud);
 }
 
 static void pointcloud_blend_read_lib(BlendLibReader *reader, ID *id)
@@ -308,6 +362,18 @@ void BKE_pointcloud_update_customdata_pointers(PointCloud *pointcloud)
       CustomData_get_layer_named(&pointcloud->pdata, CD_PROP_FLOAT, POINTCLOUD_ATTR_RADIUS));
 }
 
+/**
+ * Free data derived from the point positions, like the cached BVH tree.
+ * Has to be called when the positions are changed.
+ */
+void BKE_pointcloud_tag_positions_changed(PointCloud *pointcloud)
+{
+  if (pointcloud->runtime.bvh_cache) {
+    bvhcache_free(pointcloud->runtime.bvh_cache);
+    pointcloud->runtime.bvh_cache = nullptr;
+  }
+}
+
 bool BKE_pointcloud_customdata_required(PointCloud *UNUSED(pointcloud), CustomDataLayer *layer)
 {
   return layer->type == CD_PROP_FLOAT3 && STREQ(layer->name, POINTCLOUD_ATTR_POSITION);
@@ -2804,6 +2804,212 @@ void BKE_scene_view_layer_graph_evaluated_ensure(Main *bmain, Scene *scene, View
   BKE_scene_graph_update_tagged(depsgraph, bmain);
 }
 
+/**
+ * Whether the evaluated state of a frame does not depend on evaluation of previous frames, so
+ * that frames can be evaluated in any order. This is not the case for simulations, which step
+ * from the state of the previous frame.
+ */
+bool BKE_scene_frames_are_independent(Scene *scene)
+{
+  if (scene->rigidbody_world != NULL) {
+    return false;
+  }
+  bool is_independent = true;
+  FOREACH_SCENE_OBJECT_BEGIN (scene, ob) {
+    if (BKE_ptcache_object_has(scene, ob, 0)) {
+      is_independent = false;
+      break;
+    }
+  }
+  FOREACH_SCENE_OBJECT_END;
+  return is_independent;
+}
+
+/* Frame change handlers run on the original scene, which is shared by all dependency graphs. */
+static bool scene_frames_evaluate_in_parallel(Scene *scene)
+{
+  if (BKE_callback_has_handlers(BKE_CB_EVT_FRAME_CHANGE_PRE) ||
+      BKE_callback_has_handlers(BKE_CB_EVT_FRAME_CHANGE_POST)) {
+    return false;
+  }
+  return BKE_scene_frames_are_independent(scene);
+}
+
+static Depsgraph *scene_frames_depsgraph_new(Main *bmain,
+                                             Scene *scene,
+                                             ViewLayer *view_layer,
+                                             ID **ids,
+                                             const int num_ids,
+                                             const bool for_render)
+{
+  Depsgraph *depsgraph = DEG_graph_new(
+      bmain, scene, view_layer, for_render ? DAG_EVAL_RENDER : DAG_EVAL_VIEWPORT);
+  DEG_debug_name_set(depsgraph, "FRAMES_EVALUATION");
+  if (ids != NULL) {
+    DEG_graph_build_from_ids(depsgraph, ids, num_ids);
+  }
+  else {
+    DEG_graph_build_from_view_layer(depsgraph);
+  }
+  return depsgraph;
+}
+
+/* Same as a frame change of the original scene with #BKE_scene_graph_update_for_newframe. */
+static void scene_graph_evaluate_frames_serial(Main *bmain,
+                                               Scene *scene,
+                                               ViewLayer *view_layer,
+                                               ID **ids,
+                                               const int num_ids,
+                                               const bool for_render,
+                                               const float *frames,
+                                               const int frames_num,
+                                               SceneFrameEvaluatedFn callback,
+                                               void *user_data)
+{
+  Depsgraph *depsgraph = scene_frames_depsgraph_new(
+      bmain, scene, view_layer, ids, num_ids, for_render);
+
+  const int orig_frame = scene->r.cfra;
+  const float orig_subframe = scene->r.subframe;
+
+  for (int i = 0; i < frames_num; i++) {
+    BKE_scene_frame_set(scene, frames[i]);
+    BKE_scene_camera_switch_update(scene);
+    BKE_scene_graph_update_for_newframe(depsgraph);
+    callback(depsgraph, frames[i], user_data);
+  }
+
+  scene->r.cfra = orig_frame;
+  scene->r.subframe = orig_subframe;
+  BKE_scene_camera_switch_update(scene);
+
+  DEG_graph_free(depsgraph);
+}
+
+typedef struct SceneFramesEvaluationData {
+  Depsgraph **depsgraphs;
+  const float *frames;
+} SceneFramesEvaluationData;
+
+static void scene_graph_evaluate_initial_cb(void *__restrict userdata,
+                                            const int index,
+                                            const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SceneFramesEvaluationData *data = (SceneFramesEvaluationData *)userdata;
+  Depsgraph *depsgraph = data->depsgraphs[index];
+  DEG_evaluate_on_refresh(depsgraph);
+  /* Remaining copy-on-write tags would copy the frame of the original scene again. */
+  const bool backup = false;
+  DEG_ids_clear_recalc(depsgraph, backup);
+}
+
+static void scene_graph_evaluate_frame_cb(void *__restrict userdata,
+                                          const int index,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SceneFramesEvaluationData *data = (SceneFramesEvaluationData *)userdata;
+  Depsgraph *depsgraph = data->depsgraphs[index];
+  const float frame = data->frames[index];
+
+  /* The original scene is shared by all dependency graphs, so the frame and the camera of the
+   * markers are only changed on the evaluated scene, before evaluating anything that uses them. */
+  Scene *scene_eval = DEG_get_evaluated_scene(depsgraph);
+  BKE_scene_frame_set(scene_eval, frame);
+#ifdef DURIAN_CAMERA_SWITCH
+  Object *camera = BKE_scene_camera_switch_find(scene_eval);
+  if (camera != NULL) {
+    scene_eval->camera = camera;
+  }
+#endif
+
+  DEG_evaluate_on_framechange(depsgraph, frame);
+}
+
+/**
+ * Evaluate the given frames of the view layer, using up to \a num_depsgraphs independent
+ * dependency graphs which evaluate different frames in parallel. When \a num_depsgraphs is zero
+ * or less the number of system threads is used. When \a ids is not NULL the dependency graphs
+ * only contain these IDs and their dependencies, like #DEG_graph_build_from_ids.
+ *
+ * The \a callback is called for every frame in the order of the \a frames array, from the calling
+ * thread. The evaluated scene has the frame and the camera of the markers at that frame, as
+ * after #BKE_scene_graph_update_for_newframe. The current frame of the original scene is the
+ * same after the call.
+ *
+ * Frames are only evaluated in parallel when they are independent of each other (see
+ * #BKE_scene_frames_are_independent) and no frame change handlers are registered. Otherwise a
+ * single dependency graph evaluates the frames by changing the frame of the original scene.
+ */
+void BKE_scene_graph_evaluate_frames(Main *bmain,
+                                     Scene *scene,
+                                     ViewLayer *view_layer,
+                                     ID **ids,
+                                     const int num_ids,
+                                     const bool for_render,
+                                     const float *frames,
+                                     const int frames_num,
+                                     int num_depsgraphs,
+                                     SceneFrameEvaluatedFn callback,
+                                     void *user_data)
+{
+  if (frames_num <= 0) {
+    return;
+  }
+  if (num_depsgraphs <= 0) {
+    num_depsgraphs = BLI_system_thread_count();
+  }
+  num_depsgraphs = min_ii(num_depsgraphs, frames_num);
+  if (num_depsgraphs == 1 || !scene_frames_evaluate_in_parallel(scene)) {
+    scene_graph_evaluate_frames_serial(bmain,
+                                       scene,
+                                       view_layer,
+                                       ids,
+                                       num_ids,
+                                       for_render,
+                                       frames,
+                                       frames_num,
+                                       callback,
+                                       user_data);
+    return;
+  }
+
+  /* Building happens serially, it accesses the original data-base. */
+  Depsgraph **depsgraphs = MEM_malloc_arrayN(num_depsgraphs, sizeof(Depsgraph *), __func__);
+  for (int i = 0; i < num_depsgraphs; i++) {
+    depsgraphs[i] = scene_frames_depsgraph_new(
+        bmain, scene, view_layer, ids, num_ids, for_render);
+  }
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+
+  SceneFramesEvaluationData data;
+  data.depsgraphs = depsgraphs;
+
+  /* Create the evaluated copies, so that the frame and camera of the evaluated scene can be set
+   * before the evaluation of every frame. */
+  BLI_task_parallel_range(0, num_depsgraphs, &data, scene_graph_evaluate_initial_cb, &settings);
+
+  /* Every dependency graph evaluates one frame of the batch, the batch is then reported in order
+   * before the next one is evaluated. */
+  for (int batch_start = 0; batch_start < frames_num; batch_start += num_depsgraphs) {
+    const int batch_size = min_ii(num_depsgraphs, frames_num - batch_start);
+    data.frames = frames + batch_start;
+    BLI_task_parallel_range(0, batch_size, &data, scene_graph_evaluate_frame_cb, &settings);
+    for (int i = 0; i < batch_size; i++) {
+      callback(depsgraphs[i], frames[batch_start + i], user_data);
+      const bool backup = false;
+      DEG_ids_clear_recalc(depsgraphs[i], backup);
+    }
+  }
+
+  for (int i = 0; i < num_depsgraphs; i++) {
+    DEG_graph_free(depsgraphs[i]);
+  }
+  MEM_freeN(depsgraphs);
+}
+
 /* return default view */
 SceneRenderView *BKE_scene_add_render_view(Scene *sce, const char *name)
 {
@@ -0,0 +1,233 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_array.hh"
+#include "BLI_listbase.h"
+#include "BLI_string.h"
+#include "BLI_vector.hh"
+
+#include "BKE_action.h"
+#include "BKE_anim_data.h"
+#include "BKE_collection.h"
+#include "BKE_fcurve.h"
+#include "BKE_global.h"
+#include "BKE_idtype.h"
+#include "BKE_layer.h"
+#include "BKE_lib_id.h"
+#include "BKE_main.h"
+#include "BKE_object.h"
+#include "BKE_scene.h"
+
+#include "DNA_anim_types.h"
+#include "DNA_collection_types.h"
+#include "DNA_object_types.h"
+#include "DNA_rigidbody_types.h"
+#include "DNA_scene_types.h"
+#include "DNA_windowmanager_types.h"
+
+#include "DEG_depsgraph.h"
+#include "DEG_depsgraph_build.h"
+#include "DEG_depsgraph_query.h"
+
+#include "RNA_define.h"
+
+namespace blender::bke::tests {
+
+struct FrameResult {
+  float frame;
+  int cfra;
+  float subframe;
+  float location_x;
+  const Object *camera;
+};
+
+class SceneFramesEvaluationTest : public testing::Test {
+ protected:
+  Main *bmain;
+  Scene *scene;
+  ViewLayer *view_layer;
+  Object *ob_animated;
+  Object *camera_a;
+  Object *camera_b;
+
+  static void SetUpTestSuite()
+  {
+    BKE_idtype_init();
+    RNA_init();
+    DEG_register_node_types();
+  }
+
+  static void TearDownTestSuite()
+  {
+    DEG_free_node_types();
+    RNA_exit();
+  }
+
+  void SetUp() override
+  {
+    bmain = BKE_main_new();
+    /* Used for tagging by the camera switching of markers. */
+    G_MAIN = bmain;
+    /* Frame changes update image editors of the window manager. */
+    bmain->wm.first = MEM_callocN(sizeof(wmWindowManager), __func__);
+    scene = static_cast<Scene *>(BKE_libblock_alloc(bmain, ID_SCE, "Scene", 0));
+    scene->master_collection = BKE_collection_master_add();
+    scene->r.cfra = 1;
+    scene->r.framelen = 1.0f;
+    view_layer = BKE_view_layer_add(scene, "ViewLayer", nullptr, VIEWLAYER_ADD_NEW);
+
+    ob_animated = add_object("Animated");
+    camera_a = add_object("CameraA");
+    camera_b = add_object("CameraB");
+    add_marker(1, camera_a);
+    add_marker(5, camera_b);
+
+    /* Linear animation of the X location from 0 at frame 1 to 9 at frame 10. */
+    bAction *action = static_cast<bAction *>(BKE_id_new(bmain, ID_AC, "Action"));
+    AnimData *adt = BKE_animdata_ensure_id(&ob_animated->id);
+    adt->action = action;
+    id_us_plus(&action->id);
+    FCurve *fcu = BKE_fcurve_create();
+    fcu->rna_path = BLI_strdup("location");
+    fcu->array_index = 0;
+    fcu->bezt = static_cast<BezTriple *>(MEM_callocN(2 * sizeof(BezTriple), __func__));
+    fcu->totvert = 2;
+    for (int i = 0; i < 2; i++) {
+      fcu->bezt[i].vec[1][0] = (i == 0) ? 1.0f : 10.0f;
+      fcu->bezt[i].vec[1][1] = (i == 0) ? 0.0f : 9.0f;
+      fcu->bezt[i].ipo = BEZT_IPO_LIN;
+    }
+    calchandles_fcurve(fcu);
+    BLI_addtail(&action->curves, fcu);
+  }
+
+  void TearDown() override
+  {
+    MEM_freeN(bmain->wm.first);
+    bmain->wm.first = nullptr;
+    BKE_main_free(bmain);
+    G_MAIN = nullptr;
+  }
+
+  Object *add_object(const char *name)
+  {
+    Object *ob = BKE_object_add_only_object(bmain, OB_EMPTY, name);
+    BKE_collection_object_add(bmain, scene->master_collection, ob);
+    return ob;
+  }
+
+  void add_marker(const int frame, Object *camera)
+  {
+    TimeMarker *marker = static_cast<TimeMarker *>(MEM_callocN(sizeof(TimeMarker), __func__));
+    marker->frame = frame;
+    marker->camera = camera;
+    BLI_addtail(&scene->markers, marker);
+  }
+
+  static FrameResult frame_result(Depsgraph *depsgraph, const Object *ob, const float frame)
+  {
+    const Scene *scene_eval = DEG_get_evaluated_scene(depsgraph);
+    const Object *ob_eval = DEG_get_evaluated_object(depsgraph, const_cast<Object *>(ob));
+    return {frame,
+            scene_eval->r.cfra,
+            scene_eval->r.subframe,
+            ob_eval->obmat[3][0],
+            DEG_get_original_object(scene_eval->camera)};
+  }
+
+  /* Reference: a frame change of the original scene, as done by exporters and bake loops. */
+  Vector<FrameResult> evaluate_serial(Span<float> frames)
+  {
+    Depsgraph *depsgraph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_VIEWPORT);
+    DEG_graph_build_from_view_layer(depsgraph);
+    Vector<FrameResult> results;
+    for (const float frame : frames) {
+      BKE_scene_frame_set(scene, frame);
+      BKE_scene_camera_switch_update(scene);
+      BKE_scene_graph_update_for_newframe(depsgraph);
+      results.append(frame_result(depsgraph, ob_animated, frame));
+    }
+    DEG_graph_free(depsgraph);
+    scene->r.cfra = 1;
+    scene->r.subframe = 0.0f;
+    BKE_scene_camera_switch_update(scene);
+    return results;
+  }
+
+  struct CallbackData {
+    Object *ob;
+    Vector<FrameResult> results;
+  };
+
+  static void frame_evaluated(Depsgraph *depsgraph, float frame, void *user_data)
+  {
+    CallbackData *data = static_cast<CallbackData *>(user_data);
+    data->results.append(frame_result(depsgraph, data->ob, frame));
+  }
+};
+
+TEST_F(SceneFramesEvaluationTest, matches_serial_evaluation)
+{
+  const Array<float> frames = {1.0f, 2.5f, 4.0f, 5.0f, 7.0f, 9.5f, 10.0f, 3.0f};
+  const Vector<FrameResult> expected = evaluate_serial(frames);
+  EXPECT_EQ(expected[1].location_x, 1.5f);
+  EXPECT_EQ(expected[3].camera, camera_b);
+  EXPECT_EQ(expected[7].camera, camera_a);
+
+  for (const int num_depsgraphs : {1, 3}) {
+    CallbackData data;
+    data.ob = ob_animated;
+    BKE_scene_graph_evaluate_frames(bmain,
+                                    scene,
+                                    view_layer,
+                                    nullptr,
+                                    0,
+                                    false,
+                                    frames.data(),
+                                    frames.size(),
+                                    num_depsgraphs,
+                                    frame_evaluated,
+                                    &data);
+
+    ASSERT_EQ(data.results.size(), expected.size());
+    for (const int i : expected.index_range()) {
+      EXPECT_EQ(data.results[i].frame, expected[i].frame);
+      EXPECT_EQ(data.results[i].cfra, expected[i].cfra);
+      EXPECT_FLOAT_EQ(data.results[i].subframe, expected[i].subframe);
+      EXPECT_FLOAT_EQ(data.results[i].location_x, expected[i].location_x);
+      EXPECT_EQ(data.results[i].camera, expected[i].camera);
+    }
+    /* The original scene is back at its frame. */
+    EXPECT_EQ(scene->r.cfra, 1);
+    EXPECT_EQ(scene->r.subframe, 0.0f);
+    EXPECT_EQ(scene->camera, camera_a);
+  }
+}
+
+TEST_F(SceneFramesEvaluationTest, simulations_are_not_independent)
+{
+  EXPECT_TRUE(BKE_scene_frames_are_independent(scene));
+  scene->rigidbody_world = static_cast<RigidBodyWorld *>(
+      MEM_callocN(sizeof(RigidBodyWorld), __func__));
+  EXPECT_FALSE(BKE_scene_frames_are_independent(scene));
+  MEM_freeN(scene->rigidbody_world);
+  scene->rigidbody_world = nullptr;
+}
+
+}  // namespace blender::bke::tests
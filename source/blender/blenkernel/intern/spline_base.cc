@@ -178,12 +178,26 @@ Span<float> Spline::evaluated_lengths() const
   evaluated_lengths_cache_.resize(total);
 
   Span<float3> positions = this->evaluated_positions();
-  accumulate_lengths(positions, is_cyclic_, evaluated_lengths_cache_);
+  this->calculate_evaluated_lengths(positions, evaluated_lengths_cache_);
 
   length_cache_dirty_ = false;
   return evaluated_lengths_cache_;
 }
 
+/**
+ * Like #evaluated_lengths, but the result is written to \a r_lengths, which must have the size
+ * of #evaluated_edges_size, instead of the cache.
+ */
+void Spline::calculate_evaluated_lengths(Span<float3> evaluated_positions,
+                                         MutableSpan<float> r_lengths) const
+{
+  BLI_assert(r_lengths.size() == this->evaluated_edges_size());
+  if (r_lengths.is_empty()) {
+    return;
+  }
+  accumulate_lengths(evaluated_positions, is_cyclic_, r_lengths);
+}
+
 static float3 direction_bisect(const float3 &prev, const float3 &middle, const float3 &next)
 {
   const float3 dir_prev = (middle - prev).normalized();
@@ -236,17 +250,30 @@ Span<float3> Spline::evaluated_tangents() const
   evaluated_tangents_cache_.resize(eval_size);
 
   Span<float3> positions = this->evaluated_positions();
+  this->calculate_evaluated_tangents(positions, evaluated_tangents_cache_);
 
-  if (eval_size == 1) {
-    evaluated_tangents_cache_.first() = float3(1.0f, 0.0f, 0.0f);
+  tangent_cache_dirty_ = false;
+  return evaluated_tangents_cache_;
+}
+
+/**
+ * Like #evaluated_tangents, but the result is written to \a r_tangents instead of the cache.
+ */
+void Spline::calculate_evaluated_tangents(Span<float3> evaluated_positions,
+                                          MutableSpan<float3> r_tangents) const
+{
+  BLI_assert(r_tangents.size() == evaluated_positions.size());
+  if (r_tangents.is_empty()) {
+    return;
+  }
+
+  if (r_tangents.size() == 1) {
+    r_tangents.first() = float3(1.0f, 0.0f, 0.0f);
   }
   else {
-    calculate_tangents(positions, is_cyclic_, evaluated_tangents_cache_);
-    this->correct_end_tangents();
+    calculate_tangents(evaluated_positions, is_cyclic_, r_tangents);
+    this->correct_end_tangents(r_tangents);
   }
-
-  tangent_cache_dirty_ = false;
-  return evaluated_tangents_cache_;
 }
 
 static float3 rotate_direction_around_axis(const float3 &direction,
@@ -365,7 +392,20 @@ Span<float3> Spline::evaluated_normals() const
   evaluated_normals_cache_.resize(eval_size);
 
   Span<float3> tangents = this->evaluated_tangents();
-  MutableSpan<float3> normals = evaluated_normals_cache_;
+  this->calculate_evaluated_normals(tangents, evaluated_normals_cache_);
+
+  normal_cache_dirty_ = false;
+  return evaluated_normals_cache_;
+}
+
+/**
+ * Like #evaluated_normals, but the result is written to \a r_normals instead of the cache.
+ */
+void Spline::calculate_evaluated_normals(Span<float3> evaluated_tangents,
+                                         MutableSpan<float3> r_normals) const
+{
+  Span<float3> tangents = evaluated_tangents;
+  MutableSpan<float3> normals = r_normals;
 
   /* Only Z up normals are supported at the moment. */
   switch (this->normal_mode) {
@@ -389,9 +429,6 @@ Span<float3> Spline::evaluated_normals() const
   for (const int i : normals.index_range()) {
     normals[i] = rotate_direction_around_axis(normals[i], tangents[i], tilts[i]);
   }
-
-  normal_cache_dirty_ = false;
-  return evaluated_normals_cache_;
 }
 
 Spline::LookupResult Spline::lookup_evaluated_factor(const float factor) const
@@ -425,8 +462,17 @@ Spline::LookupResult Spline::lookup_evaluated_length(const float length) const
  */
 Array<float> Spline::sample_uniform_index_factors(const int samples_size) const
 {
-  const Span<float> lengths = this->evaluated_lengths();
+  return this->sample_uniform_index_factors(this->evaluated_lengths(), samples_size);
+}
 
+/**
+ * Like #sample_uniform_index_factors, but using lengths that were calculated without the cache,
+ * see #calculate_evaluated_lengths.
+ */
+Array<float> Spline::sample_uniform_index_factors(Span<float> lengths,
+                                                  const int samples_size) const
+{
+  BLI_assert(lengths.size() == this->evaluated_edges_size());
   BLI_assert(samples_size > 0);
   Array<float> samples(samples_size);
 
@@ -435,7 +481,7 @@ Array<float> Spline::sample_uniform_index_factors(const int samples_size) const
     return samples;
   }
 
-  const float total_length = this->length();
+  const float total_length = lengths.is_empty() ? 0.0f : lengths.last();
   const float sample_length = total_length / (samples_size - (is_cyclic_ ? 0 : 1));
 
   /* Store the length at the previous evaluated point in a variable so it can
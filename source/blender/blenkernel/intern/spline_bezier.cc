@@ -317,19 +317,20 @@ int BezierSpline::evaluated_points_size() const
  * that the handles define a zero direction, fallback to using the direction defined by the
  * first and last evaluated segments already calculated in #Spline::evaluated_tangents().
  */
-void BezierSpline::correct_end_tangents() const
+void BezierSpline::correct_end_tangents(MutableSpan<float3> tangents) const
 {
   if (is_cyclic_) {
     return;
   }
 
-  MutableSpan<float3> tangents(evaluated_tangents_cache_);
+  Span<float3> handles_left = this->handle_positions_left();
+  Span<float3> handles_right = this->handle_positions_right();
 
-  if (handle_positions_right_.first() != positions_.first()) {
-    tangents.first() = (handle_positions_right_.first() - positions_.first()).normalized();
+  if (handles_right.first() != positions_.first()) {
+    tangents.first() = (handles_right.first() - positions_.first()).normalized();
   }
-  if (handle_positions_left_.last() != positions_.last()) {
-    tangents.last() = (positions_.last() - handle_positions_left_.last()).normalized();
+  if (handles_left.last() != positions_.last()) {
+    tangents.last() = (positions_.last() - handles_left.last()).normalized();
   }
 }
 
@@ -159,7 +159,7 @@ int NURBSpline::evaluated_points_size() const
   return resolution_ * this->segments_size();
 }
 
-void NURBSpline::correct_end_tangents() const
+void NURBSpline::correct_end_tangents(MutableSpan<float3> UNUSED(tangents)) const
 {
 }
 
@@ -103,7 +103,7 @@ int PolySpline::evaluated_points_size() const
   return this->size();
 }
 
-void PolySpline::correct_end_tangents() const
+void PolySpline::correct_end_tangents(MutableSpan<float3> UNUSED(tangents)) const
 {
 }
 
@@ -27,6 +27,8 @@
 #include "DNA_meshdata_types.h"
 #include "DNA_modifier_types.h"
 
+#include "BLI_listbase.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
 #include "MEM_guardedalloc.h"
@@ -47,6 +49,7 @@ void BKE_subdiv_init()
 
 void BKE_subdiv_exit()
 {
+  BKE_subdiv_cache_clear();
   openSubdiv_cleanup();
 }
 
@@ -96,6 +99,255 @@ bool BKE_subdiv_settings_equal(const SubdivSettings *settings_a, const SubdivSet
           settings_a->fvar_linear_interpolation == settings_b->fvar_linear_interpolation);
 }
 
+/* ============================= TOPOLOGY CACHE ============================= */
+
+/* Topology refiners are shared by all descriptors which are created for the same settings and
+ * topology, so that multiple objects using the same mesh only store and refine the topology once.
+ * Shared topology refiners are refined before they are published, after that they are never
+ * modified, which allows evaluators to be created from them from multiple threads.
+ *
+ * Descriptors which are released by their users are kept in the cache as well, so that an
+ * identical topology which is requested later on (next frame of a geometry nodes evaluation which
+ * creates the descriptor from scratch, a topology change which is undone) re-uses the evaluator,
+ * and only needs to update coarse positions.
+ *
+ * Idle descriptors are kept in the least recently released order, and the oldest ones are freed
+ * once the estimated memory used by them goes over the budget.
+ *
+ * NOTE: The memory used by OpenSubdiv is not measured, it is estimated from the sizes of the
+ * stencil and patch tables and of the topology levels. So the budget is approximate, and the
+ * actual memory used by idle descriptors can be somewhat above it. */
+
+/* Approximate budget of the idle descriptors, in bytes. */
+#define SUBDIV_CACHE_MAX_MEMORY (256 * 1024 * 1024)
+
+typedef struct SubdivSharedTopologyRefiner {
+  struct SubdivSharedTopologyRefiner *next, *prev;
+  OpenSubdiv_TopologyRefiner *topology_refiner;
+  /* Settings and base topology element counts, used to quickly skip refiners which can not
+   * possibly match the converter, without iterating over its topology. */
+  SubdivSettings settings;
+  int num_vertices;
+  int num_edges;
+  int num_faces;
+  /* Number of descriptors (live and idle ones) using this refiner, and of pending lookups. */
+  int users;
+} SubdivSharedTopologyRefiner;
+
+typedef struct SubdivCacheEntry {
+  struct SubdivCacheEntry *next, *prev;
+  Subdiv *subdiv;
+  size_t memory_usage;
+} SubdivCacheEntry;
+
+static struct {
+  ListBase shared_topology_refiners;
+  ListBase entries;
+  size_t memory_usage;
+} subdiv_cache = {{NULL, NULL}, {NULL, NULL}, 0};
+
+static ThreadMutex subdiv_cache_mutex = BLI_MUTEX_INITIALIZER;
+
+/* Returns true if the topology refiner is to be deleted.
+ * Is to be called with the cache mutex locked. */
+static bool subdiv_shared_topology_refiner_user_remove_locked(SubdivSharedTopologyRefiner *shared)
+{
+  BLI_assert(shared->users > 0);
+  shared->users--;
+  if (shared->users != 0) {
+    return false;
+  }
+  BLI_remlink(&subdiv_cache.shared_topology_refiners, shared);
+  return true;
+}
+
+static void subdiv_shared_topology_refiner_delete(SubdivSharedTopologyRefiner *shared)
+{
+  openSubdiv_deleteTopologyRefiner(shared->topology_refiner);
+  MEM_freeN(shared);
+}
+
+static void subdiv_shared_topology_refiner_user_remove(SubdivSharedTopologyRefiner *shared)
+{
+  BLI_mutex_lock(&subdiv_cache_mutex);
+  const bool do_delete = subdiv_shared_topology_refiner_user_remove_locked(shared);
+  BLI_mutex_unlock(&subdiv_cache_mutex);
+  if (do_delete) {
+    subdiv_shared_topology_refiner_delete(shared);
+  }
+}
+
+static void subdiv_free_data(Subdiv *subdiv)
+{
+  if (subdiv->evaluator != NULL) {
+    openSubdiv_deleteEvaluator(subdiv->evaluator);
+  }
+  if (subdiv->shared_topology_refiner != NULL) {
+    subdiv_shared_topology_refiner_user_remove(subdiv->shared_topology_refiner);
+  }
+  else if (subdiv->topology_refiner != NULL) {
+    openSubdiv_deleteTopologyRefiner(subdiv->topology_refiner);
+  }
+  BKE_subdiv_displacement_detach(subdiv);
+  if (subdiv->cache_.face_ptex_offset != NULL) {
+    MEM_freeN(subdiv->cache_.face_ptex_offset);
+  }
+  MEM_freeN(subdiv);
+}
+
+static bool subdiv_shared_topology_refiner_key_matches(const SubdivSharedTopologyRefiner *shared,
+                                                       const SubdivSettings *settings,
+                                                       const OpenSubdiv_Converter *converter)
+{
+  return BKE_subdiv_settings_equal(&shared->settings, settings) &&
+         shared->num_vertices == converter->getNumVertices(converter) &&
+         shared->num_edges == converter->getNumEdges(converter) &&
+         shared->num_faces == converter->getNumFaces(converter);
+}
+
+/* Find the shared topology refiner created for the given settings and topology, and an idle
+ * descriptor which uses it.
+ *
+ * Returns NULL if there is no such refiner. Otherwise the caller owns one user of the returned
+ * refiner. If an idle descriptor is found, it is taken out of the cache and given to the caller
+ * as well, with the user of the refiner it owns. */
+static SubdivSharedTopologyRefiner *subdiv_cache_acquire(const SubdivSettings *settings,
+                                                         OpenSubdiv_Converter *converter,
+                                                         Subdiv **r_subdiv)
+{
+  SubdivSharedTopologyRefiner *found_shared = NULL;
+  ListBase unused_shared = {NULL, NULL};
+  *r_subdiv = NULL;
+
+  BLI_mutex_lock(&subdiv_cache_mutex);
+  /* Most recently created refiners are more likely to be requested again. */
+  SubdivSharedTopologyRefiner *shared = subdiv_cache.shared_topology_refiners.last;
+  while (shared != NULL) {
+    if (!subdiv_shared_topology_refiner_key_matches(shared, settings, converter)) {
+      shared = shared->prev;
+      continue;
+    }
+    /* Compare the full topology outside of the lock. The added user keeps the refiner alive. */
+    shared->users++;
+    BLI_mutex_unlock(&subdiv_cache_mutex);
+    const bool is_equal = openSubdiv_topologyRefinerCompareWithConverter(shared->topology_refiner,
+                                                                         converter);
+    BLI_mutex_lock(&subdiv_cache_mutex);
+    if (is_equal) {
+      found_shared = shared;
+      break;
+    }
+    SubdivSharedTopologyRefiner *prev_shared = shared->prev;
+    if (subdiv_shared_topology_refiner_user_remove_locked(shared)) {
+      BLI_addtail(&unused_shared, shared);
+    }
+    shared = prev_shared;
+  }
+  if (found_shared != NULL) {
+    LISTBASE_FOREACH_BACKWARD (SubdivCacheEntry *, entry, &subdiv_cache.entries) {
+      if (entry->subdiv->shared_topology_refiner != found_shared) {
+        continue;
+      }
+      *r_subdiv = entry->subdiv;
+      subdiv_cache.memory_usage -= entry->memory_usage;
+      BLI_freelinkN(&subdiv_cache.entries, entry);
+      break;
+    }
+  }
+  BLI_mutex_unlock(&subdiv_cache_mutex);
+
+  LISTBASE_FOREACH_MUTABLE (SubdivSharedTopologyRefiner *, unused, &unused_shared) {
+    subdiv_shared_topology_refiner_delete(unused);
+  }
+  return found_shared;
+}
+
+/* Refine the topology refiner and make it available to other descriptors. The returned shared
+ * refiner has one user, owned by the caller. */
+static SubdivSharedTopologyRefiner *subdiv_shared_topology_refiner_add(
+    const SubdivSettings *settings,
+    const OpenSubdiv_Converter *converter,
+    OpenSubdiv_TopologyRefiner *topology_refiner)
+{
+  /* The refinement modifies the refiner, so it is to be done before other threads can see it.
+   * It marks the refiner as refined, so that creating evaluators from it does not refine it again.
+   * Adding the refiner to the cache under the lock makes both visible to other threads. */
+  openSubdiv_topologyRefinerRefine(topology_refiner);
+
+  SubdivSharedTopologyRefiner *shared = MEM_callocN(sizeof(SubdivSharedTopologyRefiner),
+                                                    __func__);
+  shared->topology_refiner = topology_refiner;
+  shared->settings = *settings;
+  shared->num_vertices = converter->getNumVertices(converter);
+  shared->num_edges = converter->getNumEdges(converter);
+  shared->num_faces = converter->getNumFaces(converter);
+  shared->users = 1;
+
+  BLI_mutex_lock(&subdiv_cache_mutex);
+  BLI_addtail(&subdiv_cache.shared_topology_refiners, shared);
+  BLI_mutex_unlock(&subdiv_cache_mutex);
+  return shared;
+}
+
+/* Estimated memory which is freed when the idle descriptor is evicted. The topology refiner is
+ * counted even if it is still used by other descriptors, which over-estimates the memory. */
+static size_t subdiv_cache_entry_memory_usage(const Subdiv *subdiv)
+{
+  OpenSubdiv_TopologyRefiner *topology_refiner = subdiv->topology_refiner;
+  size_t memory_usage = sizeof(Subdiv) + topology_refiner->getMemoryUsage(topology_refiner);
+  if (subdiv->evaluator != NULL) {
+    memory_usage += subdiv->evaluator->getMemoryUsage(subdiv->evaluator);
+  }
+  if (subdiv->cache_.face_ptex_offset != NULL) {
+    memory_usage += sizeof(int) * (size_t)topology_refiner->getNumFaces(topology_refiner);
+  }
+  return memory_usage;
+}
+
+static void subdiv_cache_release(Subdiv *subdiv)
+{
+  SubdivCacheEntry *entry = MEM_callocN(sizeof(SubdivCacheEntry), __func__);
+  entry->subdiv = subdiv;
+  entry->memory_usage = subdiv_cache_entry_memory_usage(subdiv);
+  if (entry->memory_usage > SUBDIV_CACHE_MAX_MEMORY) {
+    /* Would evict everything else from the cache. */
+    MEM_freeN(entry);
+    subdiv_free_data(subdiv);
+    return;
+  }
+
+  ListBase evicted_entries = {NULL, NULL};
+  BLI_mutex_lock(&subdiv_cache_mutex);
+  BLI_addtail(&subdiv_cache.entries, entry);
+  subdiv_cache.memory_usage += entry->memory_usage;
+  while (subdiv_cache.memory_usage > SUBDIV_CACHE_MAX_MEMORY) {
+    SubdivCacheEntry *oldest_entry = BLI_pophead(&subdiv_cache.entries);
+    subdiv_cache.memory_usage -= oldest_entry->memory_usage;
+    BLI_addtail(&evicted_entries, oldest_entry);
+  }
+  BLI_mutex_unlock(&subdiv_cache_mutex);
+
+  /* Free outside of the lock, deleting evaluators is not cheap. */
+  LISTBASE_FOREACH_MUTABLE (SubdivCacheEntry *, evicted_entry, &evicted_entries) {
+    subdiv_free_data(evicted_entry->subdiv);
+    MEM_freeN(evicted_entry);
+  }
+}
+
+void BKE_subdiv_cache_clear(void)
+{
+  BLI_mutex_lock(&subdiv_cache_mutex);
+  ListBase entries = subdiv_cache.entries;
+  BLI_listbase_clear(&subdiv_cache.entries);
+  subdiv_cache.memory_usage = 0;
+  BLI_mutex_unlock(&subdiv_cache_mutex);
+
+  LISTBASE_FOREACH_MUTABLE (SubdivCacheEntry *, entry, &entries) {
+    subdiv_free_data(entry->subdiv);
+    MEM_freeN(entry);
+  }
+}
+
 /* ============================== CONSTRUCTION ============================== */
 
 /* Creation from scratch. */
@@ -106,13 +358,28 @@ Subdiv *BKE_subdiv_new_from_converter(const SubdivSettings *settings,
   SubdivStats stats;
   BKE_subdiv_stats_init(&stats);
   BKE_subdiv_stats_begin(&stats, SUBDIV_STATS_TOPOLOGY_REFINER_CREATION_TIME);
-  OpenSubdiv_TopologyRefinerSettings topology_refiner_settings;
-  topology_refiner_settings.level = settings->level;
-  topology_refiner_settings.is_adaptive = settings->is_adaptive;
-  struct OpenSubdiv_TopologyRefiner *osd_topology_refiner = NULL;
+  SubdivSharedTopologyRefiner *shared_topology_refiner = NULL;
   if (converter->getNumVertices(converter) != 0) {
-    osd_topology_refiner = openSubdiv_createTopologyRefinerFromConverter(
-        converter, &topology_refiner_settings);
+    Subdiv *cached_subdiv;
+    shared_topology_refiner = subdiv_cache_acquire(settings, converter, &cached_subdiv);
+    if (cached_subdiv != NULL) {
+      /* The idle descriptor owns its own user of the refiner. */
+      subdiv_shared_topology_refiner_user_remove(shared_topology_refiner);
+      BKE_subdiv_stats_end(&stats, SUBDIV_STATS_TOPOLOGY_REFINER_CREATION_TIME);
+      cached_subdiv->stats = stats;
+      return cached_subdiv;
+    }
+    if (shared_topology_refiner == NULL) {
+      OpenSubdiv_TopologyRefinerSettings topology_refiner_settings;
+      topology_refiner_settings.level = settings->level;
+      topology_refiner_settings.is_adaptive = settings->is_adaptive;
+      struct OpenSubdiv_TopologyRefiner *osd_topology_refiner =
+          openSubdiv_createTopologyRefinerFromConverter(converter, &topology_refiner_settings);
+      if (osd_topology_refiner != NULL) {
+        shared_topology_refiner = subdiv_shared_topology_refiner_add(
+            settings, converter, osd_topology_refiner);
+      }
+    }
   }
   else {
     /* TODO(sergey): Check whether original geometry had any vertices.
@@ -121,9 +388,12 @@ Subdiv *BKE_subdiv_new_from_converter(const SubdivSettings *settings,
   }
   Subdiv *subdiv = MEM_callocN(sizeof(Subdiv), "subdiv from converetr");
   subdiv->settings = *settings;
-  subdiv->topology_refiner = osd_topology_refiner;
+  subdiv->topology_refiner = (shared_topology_refiner != NULL) ?
+                                 shared_topology_refiner->topology_refiner :
+                                 NULL;
   subdiv->evaluator = NULL;
   subdiv->displacement_evaluator = NULL;
+  subdiv->shared_topology_refiner = shared_topology_refiner;
   BKE_subdiv_stats_end(&stats, SUBDIV_STATS_TOPOLOGY_REFINER_CREATION_TIME);
   subdiv->stats = stats;
   return subdiv;
@@ -188,17 +458,13 @@ Subdiv *BKE_subdiv_update_from_mesh(Subdiv *subdiv,
 
 void BKE_subdiv_free(Subdiv *subdiv)
 {
-  if (subdiv->evaluator != NULL) {
-    openSubdiv_deleteEvaluator(subdiv->evaluator);
-  }
-  if (subdiv->topology_refiner != NULL) {
-    openSubdiv_deleteTopologyRefiner(subdiv->topology_refiner);
+  if (subdiv->shared_topology_refiner == NULL) {
+    subdiv_free_data(subdiv);
+    return;
   }
+  /* Displacement is specific to the user of the descriptor. */
   BKE_subdiv_displacement_detach(subdiv);
-  if (subdiv->cache_.face_ptex_offset != NULL) {
-    MEM_freeN(subdiv->cache_.face_ptex_offset);
-  }
-  MEM_freeN(subdiv);
+  subdiv_cache_release(subdiv);
 }
 
 /* =========================== PTEX FACES AND GRIDS ========================= */
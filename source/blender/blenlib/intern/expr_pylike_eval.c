@@ -29,14 +29,17 @@
  *  - Literals:
  *      floating point and decimal integer.
  *  - Constants:
- *      pi, True, False
+ *      pi, e, tau, True, False
  *  - Operators:
- *      +, -, *, /, ==, !=, <, <=, >, >=, and, or, not, ternary if
+ *      +, -, *, /, //, %, **, ==, !=, <, <=, >, >=, and, or, not, ternary if
  *  - Functions:
- *      min, max, radians, degrees,
- *      abs, fabs, floor, ceil, trunc, int,
- *      sin, cos, tan, asin, acos, atan, atan2,
- *      exp, log, sqrt, pow, fmod
+ *      min, max (also of a single tuple or list), radians, degrees,
+ *      abs, fabs, floor, ceil, trunc, int, float, bool, round,
+ *      sin, cos, tan, asin, acos, atan, atan2, sinh, cosh, tanh, asinh, acosh, atanh,
+ *      exp, expm1, log, log1p, log2, log10, sqrt, pow, fmod, hypot, copysign,
+ *      clamp, lerp, smoothstep
+ *  - Attributes of numbers:
+ *      real, imag, conjugate(), is_integer()
  *
  * The implementation has no global state and can be used multi-threaded.
  */
@@ -325,6 +328,63 @@ static double op_sub(double a, double b)
   return a - b;
 }
 
+/* Python floor division, consistent with the modulo operator below. */
+static double op_floordiv(double a, double b)
+{
+  if (b == 0.0) {
+    return a / b;
+  }
+  const double mod = fmod(a, b);
+  double div = (a - mod) / b;
+  if (mod != 0.0 && ((b < 0.0) != (mod < 0.0))) {
+    div -= 1.0;
+  }
+  if (div == 0.0) {
+    return copysign(0.0, a / b);
+  }
+  /* Snap to the nearest integer to compensate for rounding errors of the division. */
+  double result = floor(div);
+  if (div - result > 0.5) {
+    result += 1.0;
+  }
+  return result;
+}
+
+/* Python modulo, the result has the sign of the divisor. */
+static double op_mod(double a, double b)
+{
+  double result = fmod(a, b);
+  if (result != 0.0) {
+    if ((b < 0.0) != (result < 0.0)) {
+      result += b;
+    }
+  }
+  else {
+    result = copysign(0.0, b);
+  }
+  return result;
+}
+
+static double op_identity(double arg)
+{
+  return arg;
+}
+
+static double op_zero(double UNUSED(arg))
+{
+  return 0.0;
+}
+
+static double op_bool(double arg)
+{
+  return arg ? 1.0 : 0.0;
+}
+
+static double op_is_integer(double arg)
+{
+  return (isfinite(arg) && arg == trunc(arg)) ? 1.0 : 0.0;
+}
+
 static double op_radians(double arg)
 {
   return arg * M_PI / 180.0;
@@ -351,6 +411,12 @@ static double op_clamp(double arg)
   return arg;
 }
 
+static double op_clamp2(double arg, double minv)
+{
+  CLAMP(arg, minv, 1.0);
+  return arg;
+}
+
 static double op_clamp3(double arg, double minv, double maxv)
 {
   CLAMP(arg, minv, maxv);
@@ -405,7 +471,7 @@ typedef struct BuiltinConstDef {
 } BuiltinConstDef;
 
 static BuiltinConstDef builtin_consts[] = {
-    {"pi", M_PI}, {"True", 1.0}, {"False", 0.0}, {NULL, 0.0}};
+    {"pi", M_PI}, {"e", M_E}, {"tau", 2.0 * M_PI}, {"True", 1.0}, {"False", 0.0}, {NULL, 0.0}};
 
 typedef struct BuiltinOpDef {
   const char *name;
@@ -430,6 +496,8 @@ static BuiltinOpDef builtin_ops[] = {
     {"trunc", OPCODE_FUNC1, trunc},
     {"round", OPCODE_FUNC1, round},
     {"int", OPCODE_FUNC1, trunc},
+    {"float", OPCODE_FUNC1, op_identity},
+    {"bool", OPCODE_FUNC1, op_bool},
     {"sin", OPCODE_FUNC1, sin},
     {"cos", OPCODE_FUNC1, cos},
     {"tan", OPCODE_FUNC1, tan},
@@ -437,14 +505,27 @@ static BuiltinOpDef builtin_ops[] = {
     {"acos", OPCODE_FUNC1, acos},
     {"atan", OPCODE_FUNC1, atan},
     {"atan2", OPCODE_FUNC2, atan2},
+    {"sinh", OPCODE_FUNC1, sinh},
+    {"cosh", OPCODE_FUNC1, cosh},
+    {"tanh", OPCODE_FUNC1, tanh},
+    {"asinh", OPCODE_FUNC1, asinh},
+    {"acosh", OPCODE_FUNC1, acosh},
+    {"atanh", OPCODE_FUNC1, atanh},
     {"exp", OPCODE_FUNC1, exp},
+    {"expm1", OPCODE_FUNC1, expm1},
     {"log", OPCODE_FUNC1, log},
     {"log", OPCODE_FUNC2, op_log2},
+    {"log1p", OPCODE_FUNC1, log1p},
+    {"log2", OPCODE_FUNC1, log2},
+    {"log10", OPCODE_FUNC1, log10},
     {"sqrt", OPCODE_FUNC1, sqrt},
     {"pow", OPCODE_FUNC2, pow},
     {"fmod", OPCODE_FUNC2, fmod},
+    {"hypot", OPCODE_FUNC2, hypot},
+    {"copysign", OPCODE_FUNC2, copysign},
     {"lerp", OPCODE_FUNC3, op_lerp},
     {"clamp", OPCODE_FUNC1, op_clamp},
+    {"clamp", OPCODE_FUNC2, op_clamp2},
     {"clamp", OPCODE_FUNC3, op_clamp3},
     {"smoothstep", OPCODE_FUNC3, op_smoothstep},
     {NULL, OPCODE_CONST, NULL},
@@ -472,6 +553,8 @@ static BuiltinOpDef builtin_ops[] = {
 #define TOKEN_LE MAKE_CHAR2('<', '=')
 #define TOKEN_NE MAKE_CHAR2('!', '=')
 #define TOKEN_EQ MAKE_CHAR2('=', '=')
+#define TOKEN_POW MAKE_CHAR2('*', '*')
+#define TOKEN_FLOORDIV MAKE_CHAR2('/', '/')
 #define TOKEN_AND MAKE_CHAR2('A', 'N')
 #define TOKEN_OR MAKE_CHAR2('O', 'R')
 #define TOKEN_NOT MAKE_CHAR2('N', 'O')
@@ -720,6 +803,13 @@ static bool parse_next_token(ExprParseState *state)
     return true;
   }
 
+  /* ** and // tokens */
+  if (ELEM(state->cur[0], '*', '/') && state->cur[1] == state->cur[0]) {
+    state->token = MAKE_CHAR2(state->cur[0], state->cur[1]);
+    state->cur += 2;
+    return true;
+  }
+
   /* Special characters (single character tokens) */
   if (strchr(token_characters, *state->cur)) {
     state->token = *state->cur++;
@@ -758,12 +848,10 @@ static bool parse_next_token(ExprParseState *state)
 
 static bool parse_expr(ExprParseState *state);
 
-static int parse_function_args(ExprParseState *state)
+/* Parse comma separated expressions up to the closing token, which is consumed.
+ * Returns the number of expressions or -1 on error. */
+static int parse_expr_list(ExprParseState *state, short close_token)
 {
-  if (!parse_next_token(state) || state->token != '(' || !parse_next_token(state)) {
-    return -1;
-  }
-
   int arg_count = 0;
 
   for (;;) {
@@ -773,38 +861,136 @@ static int parse_function_args(ExprParseState *state)
 
     arg_count++;
 
-    switch (state->token) {
-      case ',':
-        if (!parse_next_token(state)) {
-          return -1;
-        }
-        break;
+    if (state->token == ',') {
+      if (!parse_next_token(state)) {
+        return -1;
+      }
+      /* Trailing comma. */
+      if (state->token != close_token) {
+        continue;
+      }
+    }
 
-      case ')':
-        if (!parse_next_token(state)) {
-          return -1;
-        }
-        return arg_count;
+    if (state->token != close_token || !parse_next_token(state)) {
+      return -1;
+    }
 
-      default:
-        return -1;
+    return arg_count;
+  }
+}
+
+static int parse_function_args(ExprParseState *state)
+{
+  if (!parse_next_token(state) || state->token != '(' || !parse_next_token(state)) {
+    return -1;
+  }
+
+  return parse_expr_list(state, ')');
+}
+
+/* Check if the parentheses starting right before the given position enclose a tuple which is
+ * the only argument of a function call, i.e. `min((a, b))` as opposed to `min((a + b) * 2, c)`. */
+static bool parse_is_single_tuple_arg(const char *cur)
+{
+  bool has_comma = false;
+  int depth = 0;
+
+  for (; *cur; cur++) {
+    if (ELEM(*cur, '(', '[')) {
+      depth++;
     }
+    else if (ELEM(*cur, ')', ']')) {
+      if (depth-- == 0) {
+        break;
+      }
+    }
+    else if (*cur == ',' && depth == 0) {
+      has_comma = true;
+    }
+  }
+
+  if (*cur == 0) {
+    return false;
   }
+
+  for (cur++; isspace(*cur); cur++) {
+    /* Pass. */
+  }
+
+  return has_comma && *cur == ')';
 }
 
-static bool parse_unary(ExprParseState *state)
+/* Parse arguments of min and max: either multiple values, or a single tuple or list of them. */
+static int parse_min_max_args(ExprParseState *state)
 {
-  int i;
+  if (!parse_next_token(state) || state->token != '(' || !parse_next_token(state)) {
+    return -1;
+  }
 
-  switch (state->token) {
-    case '+':
-      return parse_next_token(state) && parse_unary(state);
+  short close_token;
 
-    case '-':
-      CHECK_ERROR(parse_next_token(state) && parse_unary(state));
-      parse_add_func(state, OPCODE_FUNC1, 1, op_negate);
-      return true;
+  if (state->token == '[') {
+    close_token = ']';
+  }
+  else if (state->token == '(' && parse_is_single_tuple_arg(state->cur)) {
+    close_token = ')';
+  }
+  else {
+    return parse_expr_list(state, ')');
+  }
 
+  if (!parse_next_token(state)) {
+    return -1;
+  }
+
+  int count = parse_expr_list(state, close_token);
+
+  if (count < 0 || state->token != ')' || !parse_next_token(state)) {
+    return -1;
+  }
+
+  return count;
+}
+
+/* Parse attribute access on a number, which is treated like a Python float. */
+static bool parse_attribute(ExprParseState *state)
+{
+  CHECK_ERROR(parse_next_token(state) && state->token == TOKEN_ID);
+
+  if (STREQ(state->tokenbuf, "real")) {
+    return parse_next_token(state);
+  }
+
+  if (STREQ(state->tokenbuf, "imag")) {
+    CHECK_ERROR(parse_next_token(state));
+    return parse_add_func(state, OPCODE_FUNC1, 1, op_zero);
+  }
+
+  /* Methods without arguments. */
+  UnaryOpFunc func = NULL;
+
+  if (STREQ(state->tokenbuf, "conjugate")) {
+    func = op_identity;
+  }
+  else if (STREQ(state->tokenbuf, "is_integer")) {
+    func = op_is_integer;
+  }
+
+  CHECK_ERROR(func != NULL);
+  CHECK_ERROR(parse_next_token(state) && state->token == '(');
+  CHECK_ERROR(parse_next_token(state) && state->token == ')');
+  CHECK_ERROR(parse_next_token(state));
+
+  return parse_add_func(state, OPCODE_FUNC1, 1, func);
+}
+
+static bool parse_unary(ExprParseState *state);
+
+static bool parse_atom(ExprParseState *state)
+{
+  int i;
+
+  switch (state->token) {
     case '(':
       return parse_next_token(state) && parse_expr(state) && state->token == ')' &&
              parse_next_token(state);
@@ -853,7 +1039,7 @@ static bool parse_unary(ExprParseState *state)
 
       /* Specially supported functions. */
       if (STREQ(state->tokenbuf, "min")) {
-        int cnt = parse_function_args(state);
+        int cnt = parse_min_max_args(state);
         CHECK_ERROR(cnt > 0);
 
         parse_add_op(state, OPCODE_MIN, 1 - cnt)->arg.ival = cnt;
@@ -861,7 +1047,7 @@ static bool parse_unary(ExprParseState *state)
       }
 
       if (STREQ(state->tokenbuf, "max")) {
-        int cnt = parse_function_args(state);
+        int cnt = parse_min_max_args(state);
         CHECK_ERROR(cnt > 0);
 
         parse_add_op(state, OPCODE_MAX, 1 - cnt)->arg.ival = cnt;
@@ -875,6 +1061,46 @@ static bool parse_unary(ExprParseState *state)
   }
 }
 
+static bool parse_primary(ExprParseState *state)
+{
+  CHECK_ERROR(parse_atom(state));
+
+  while (state->token == '.') {
+    CHECK_ERROR(parse_attribute(state));
+  }
+
+  return true;
+}
+
+static bool parse_power(ExprParseState *state)
+{
+  CHECK_ERROR(parse_primary(state));
+
+  /* Right associative, and binds tighter than a unary operator on the left: -a**b == -(a**b). */
+  if (state->token == TOKEN_POW) {
+    CHECK_ERROR(parse_next_token(state) && parse_unary(state));
+    parse_add_func(state, OPCODE_FUNC2, 2, pow);
+  }
+
+  return true;
+}
+
+static bool parse_unary(ExprParseState *state)
+{
+  switch (state->token) {
+    case '+':
+      return parse_next_token(state) && parse_unary(state);
+
+    case '-':
+      CHECK_ERROR(parse_next_token(state) && parse_unary(state));
+      parse_add_func(state, OPCODE_FUNC1, 1, op_negate);
+      return true;
+
+    default:
+      return parse_power(state);
+  }
+}
+
 static bool parse_mul(ExprParseState *state)
 {
   CHECK_ERROR(parse_unary(state));
@@ -891,6 +1117,16 @@ static bool parse_mul(ExprParseState *state)
         parse_add_func(state, OPCODE_FUNC2, 2, op_div);
         break;
 
+      case TOKEN_FLOORDIV:
+        CHECK_ERROR(parse_next_token(state) && parse_unary(state));
+        parse_add_func(state, OPCODE_FUNC2, 2, op_floordiv);
+        break;
+
+      case '%':
+        CHECK_ERROR(parse_next_token(state) && parse_unary(state));
+        parse_add_func(state, OPCODE_FUNC2, 2, op_mod);
+        break;
+
       default:
         return true;
     }
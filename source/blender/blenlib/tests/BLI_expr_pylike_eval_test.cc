@@ -111,6 +111,15 @@ TEST_PARSE_FAIL(Truncated7, "1 and")
 TEST_PARSE_FAIL(Truncated8, "1 or")
 TEST_PARSE_FAIL(Truncated9, "sqrt(1")
 TEST_PARSE_FAIL(Truncated10, "fmod(1,")
+TEST_PARSE_FAIL(Truncated11, "1 **")
+TEST_PARSE_FAIL(Truncated12, "max([1, 2]")
+
+TEST_PARSE_FAIL(Tuple, "(1, 2)")
+TEST_PARSE_FAIL(TupleArgs, "max((1, 2), 3)")
+TEST_PARSE_FAIL(EmptyList, "max([])")
+TEST_PARSE_FAIL(BadAttribute1, "pi.x")
+TEST_PARSE_FAIL(BadAttribute2, "pi.real()")
+TEST_PARSE_FAIL(BadAttribute3, "pi.conjugate")
 
 /* Constant expression with working constant folding */
 #define TEST_CONST(name, str, value) \
@@ -145,6 +154,8 @@ TEST_CONST(Half, ".5", 0.5)
 TEST_CONST(Pi, "pi", M_PI)
 TEST_CONST(True, "True", TRUE_VAL)
 TEST_CONST(False, "False", FALSE_VAL)
+TEST_CONST(E, "e", M_E)
+TEST_CONST(Tau, "tau", 2.0 * M_PI)
 
 TEST_CONST(Sqrt, "sqrt(4)", 2.0)
 TEST_EVAL(Sqrt, "sqrt(x)", 4.0, 2.0)
@@ -156,6 +167,15 @@ TEST_CONST(Pow, "pow(4, 0.5)", 2.0)
 TEST_EVAL(Pow, "pow(4, x)", 0.5, 2.0)
 
 TEST_CONST(Log2_1, "log(4, 2)", 2.0)
+TEST_CONST(Log2_2, "log2(8)", 3.0)
+TEST_CONST(Log10, "log10(100)", 2.0)
+
+TEST_CONST(Hypot, "hypot(3, 4)", 5.0)
+TEST_CONST(CopySign, "copysign(2, -1)", -2.0)
+
+TEST_CONST(Float, "float(2)", 2.0)
+TEST_CONST(Bool1, "bool(2)", TRUE_VAL)
+TEST_CONST(Bool2, "bool(0)", FALSE_VAL)
 
 TEST_CONST(Round1, "round(-0.5)", -1.0)
 TEST_CONST(Round2, "round(-0.4)", 0.0)
@@ -167,6 +187,9 @@ TEST_CONST(Clamp2, "clamp(0.5)", 0.5)
 TEST_CONST(Clamp3, "clamp(1.5)", 1.0)
 TEST_CONST(Clamp4, "clamp(0.5, 0.2, 0.3)", 0.3)
 TEST_CONST(Clamp5, "clamp(0.0, 0.2, 0.3)", 0.2)
+TEST_CONST(Clamp6, "clamp(0.1, 0.2)", 0.2)
+TEST_CONST(Clamp7, "clamp(1.5, 0.2)", 1.0)
+TEST_EVAL(Clamp1, "clamp(x, -1, 1)", 2.0, 1.0)
 
 TEST_CONST(Lerp1, "lerp(-10,10,-1)", -30.0)
 TEST_CONST(Lerp2, "lerp(-10,10,0.25)", -5.0)
@@ -187,6 +210,13 @@ TEST_RESULT(Min2, "min(1,2,3)", 1.0)
 TEST_RESULT(Max2, "max(1,2,3)", 3.0)
 TEST_RESULT(Min3, "min(2,3,1)", 1.0)
 TEST_RESULT(Max3, "max(2,3,1)", 3.0)
+TEST_RESULT(Min4, "min((2, 3, 1))", 1.0)
+TEST_RESULT(Max4, "max([2, 3, 1])", 3.0)
+TEST_RESULT(Max5, "max((2, 3, 1,))", 3.0)
+TEST_RESULT(Max6, "max(2, 3, 1,)", 3.0)
+TEST_RESULT(Max7, "max((1 + 1) * 2, 3)", 4.0)
+TEST_EVAL(Max1, "max(x, 2, 3, 4, 5, 6, 7, 8, 9, 10)", 11.0, 11.0)
+TEST_EVAL(Min1, "min([x, 2, max(x, 3)])", 1.0, 1.0)
 
 TEST_CONST(UnaryPlus, "+1", 1.0)
 
@@ -205,6 +235,23 @@ TEST_EVAL(BinaryMul, "x*3", 2, 6.0)
 TEST_CONST(BinaryDiv, "3/2", 1.5)
 TEST_EVAL(BinaryDiv, "3/x", 2, 1.5)
 
+TEST_CONST(FloorDiv1, "7 // 2", 3.0)
+TEST_CONST(FloorDiv2, "-7 // 2", -4.0)
+TEST_CONST(FloorDiv3, "1 // 0.1", 9.0)
+TEST_EVAL(FloorDiv, "x // 2", 7.5, 3.0)
+
+TEST_CONST(Mod1, "7 % 3", 1.0)
+TEST_CONST(Mod2, "-7 % 3", 2.0)
+TEST_CONST(Mod3, "7 % -3", -2.0)
+TEST_EVAL(Mod, "x % 2", 3.5, 1.5)
+
+TEST_CONST(Power1, "2 ** 3", 8.0)
+TEST_CONST(Power2, "2 ** 3 ** 2", 512.0)
+TEST_CONST(Power3, "-2 ** 2", -4.0)
+TEST_CONST(Power4, "2 ** -1", 0.5)
+TEST_CONST(Power5, "2 * 3 ** 2", 18.0)
+TEST_EVAL(Power, "x ** 2", 3.0, 9.0)
+
 TEST_CONST(Arith1, "1 + -2 * 3", -5.0)
 TEST_CONST(Arith2, "(1 + -2) * 3", -3.0)
 TEST_CONST(Arith3, "-1 + 2 * 3", 5.0)
@@ -273,6 +320,14 @@ TEST_RESULT(Or2, "0 or 3", 3.0)
 TEST_RESULT(Bool1, "2 or 3 and 4", 2.0)
 TEST_RESULT(Bool2, "not 2 or 3 and 4", 4.0)
 
+TEST_CONST(AttrReal, "pi.real", M_PI)
+TEST_CONST(AttrImag, "pi.imag", 0.0)
+TEST_CONST(AttrConjugate, "(1 + 1).conjugate()", 2.0)
+TEST_CONST(AttrIsInteger1, "(2.0).is_integer()", TRUE_VAL)
+TEST_CONST(AttrIsInteger2, "(2.5).is_integer()", FALSE_VAL)
+TEST_EVAL(AttrReal, "x.real * 2", 1.5, 3.0)
+TEST_EVAL(AttrIsInteger, "1 if x.is_integer() else 2", 1.5, 2.0)
+
 TEST(expr_pylike, Eval_Ternary1)
 {
   ExprPyLike_Parsed *expr = parse_for_eval("x / 2 if x < 4 else x - 2 if x < 8 else x*2 - 12",
@@ -342,6 +397,10 @@ TEST_ERROR(Mixed1, "sqrt(x) + 1 / max(0, x)", -1.0, EXPR_PYLIKE_MATH_ERROR)
 TEST_ERROR(Mixed2, "sqrt(x) + 1 / max(0, x)", 0.0, EXPR_PYLIKE_DIV_BY_ZERO)
 TEST_ERROR(Mixed3, "sqrt(x) + 1 / max(0, x)", 1.0, EXPR_PYLIKE_SUCCESS)
 
+TEST_ERROR(FloorDivZero, "1 // x", 0.0, EXPR_PYLIKE_DIV_BY_ZERO)
+TEST_ERROR(ModZero, "1 % x", 0.0, EXPR_PYLIKE_MATH_ERROR)
+TEST_ERROR(PowerDomain, "x ** 0.5", -1.0, EXPR_PYLIKE_MATH_ERROR)
+
 TEST(expr_pylike, Error_Invalid)
 {
   ExprPyLike_Parsed *expr = BLI_expr_pylike_parse("", nullptr, 0);
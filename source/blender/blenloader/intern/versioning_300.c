@@ -665,6 +665,21 @@ void blo_do_versions_300(FileData *fd, Library *UNUSED(lib), Main *bmain)
     }
   }
 
+  if (!MAIN_VERSION_ATLEAST(bmain, 300, 14)) {
+    /* Keep the points of existing Point Distribute nodes, the close points used to be eliminated
+     * in their original order. */
+    FOREACH_NODETREE_BEGIN (bmain, ntree, id) {
+      if (ntree->type == NTREE_GEOMETRY) {
+        LISTBASE_FOREACH (bNode *, node, &ntree->nodes) {
+          if (node->type == GEO_NODE_POINT_DISTRIBUTE) {
+            node->custom2 |= GEO_NODE_POINT_DISTRIBUTE_LEGACY_ORDER;
+          }
+        }
+      }
+    }
+    FOREACH_NODETREE_END;
+  }
+
   /**
    * Versioning code until next subversion bump goes here.
    *
@@ -62,6 +62,26 @@ void DEG_debug_stats_gnuplot(const struct Depsgraph *graph,
                              const char *label,
                              const char *output_filename);
 
+/* ************************************************ */
+/* Evaluation Timeline */
+
+/* Record start and end time, thread and owner ID of every operation evaluated by any dependency
+ * graph. Recording stops after the given number of graph evaluations, or when stopped explicitly
+ * if the number is 0. Starting the recording discards previously recorded timeline. */
+void DEG_debug_trace_start(int num_evaluations);
+void DEG_debug_trace_stop(void);
+bool DEG_debug_trace_is_recording(void);
+
+/* Write the recorded timeline. Files with ".csv" extension are written as comma separated values,
+ * all others as Chrome trace event JSON (chrome://tracing, Perfetto). */
+bool DEG_debug_trace_write(const char *filepath);
+
+/* Automatically write the timeline to the given file once the recording stops. */
+void DEG_debug_trace_output_set(const char *filepath);
+
+/* Stop recording, write pending output and free all memory. Is called on exit. */
+void DEG_debug_trace_exit(void);
+
 /* ************************************************ */
 
 /* Compare two dependency graphs. */
@@ -25,11 +25,16 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "DNA_ID.h"
 #include "DNA_anim_types.h"
+#include "DNA_collection_types.h"
+#include "DNA_scene_types.h"
 
 #include "BLI_utildefines.h"
 
 #include "BKE_animsys.h"
+#include "BKE_main.h"
+#include "BKE_node.h"
 
 namespace blender::deg {
 
@@ -105,6 +110,7 @@ void animated_property_cb(ID * /*id*/, FCurve *fcurve, void *data_v)
   if (pointer_rna.owner_id != data->pointer_rna.owner_id) {
     animated_property_storage = data->builder_cache->ensureAnimatedPropertyStorage(
         pointer_rna.owner_id);
+    data->builder_cache->linkIDs(data->pointer_rna.owner_id, pointer_rna.owner_id);
   }
   /* Set the property as animated. */
   animated_property_storage->tagPropertyAsAnimated(&pointer_rna, property_rna);
@@ -112,7 +118,8 @@ void animated_property_cb(ID * /*id*/, FCurve *fcurve, void *data_v)
 
 }  // namespace
 
-AnimatedPropertyStorage::AnimatedPropertyStorage() : is_fully_initialized(false)
+AnimatedPropertyStorage::AnimatedPropertyStorage(const ID *id)
+    : is_fully_initialized(false), id_session_uuid(id->session_uuid)
 {
 }
 
@@ -157,10 +164,97 @@ DepsgraphBuilderCache::~DepsgraphBuilderCache()
   }
 }
 
+void DepsgraphBuilderCache::beginBuild(Main *bmain)
+{
+  if (animated_property_storage_map_.is_empty()) {
+    return;
+  }
+  /* Keys of the storage map might point to datablocks which were freed since the previous build,
+   * so only dereference pointers which are known to be alive. */
+  Set<ID *> alive_ids;
+  ListBase *lbarray[INDEX_ID_MAX];
+  const int num_lists = set_listbasepointers(bmain, lbarray);
+  for (int i = 0; i < num_lists; i++) {
+    LISTBASE_FOREACH (ID *, id, lbarray[i]) {
+      alive_ids.add(id);
+      /* Embedded IDs are not in any list of Main, but builders access their storages too. */
+      bNodeTree *ntree = ntreeFromID(id);
+      if (ntree != nullptr) {
+        alive_ids.add(&ntree->id);
+      }
+      if (GS(id->name) == ID_SCE) {
+        Scene *scene = (Scene *)id;
+        if (scene->master_collection != nullptr) {
+          alive_ids.add(&scene->master_collection->id);
+        }
+      }
+    }
+  }
+
+  Vector<ID *> ids_to_invalidate;
+  for (auto item : animated_property_storage_map_.items()) {
+    ID *storage_id = item.key;
+    if (!alive_ids.contains(storage_id)) {
+      ids_to_invalidate.append(storage_id);
+      continue;
+    }
+    /* Recalc flags of the original ID are also set when the datablock is restored by undo. */
+    if (storage_id->session_uuid != item.value->id_session_uuid ||
+        (storage_id->recalc & ID_RECALC_ALL) != 0) {
+      ids_to_invalidate.append(storage_id);
+    }
+  }
+  for (ID *id_to_invalidate : ids_to_invalidate) {
+    invalidateLinkedStorages(id_to_invalidate);
+  }
+}
+
+void DepsgraphBuilderCache::invalidateID(ID *id)
+{
+  if (animated_property_storage_map_.is_empty()) {
+    return;
+  }
+  /* Actions can be shared by any number of IDs, so changes to them invalidate everything. */
+  if (GS(id->name) == ID_AC) {
+    for (AnimatedPropertyStorage *animated_property_storage :
+         animated_property_storage_map_.values()) {
+      delete animated_property_storage;
+    }
+    animated_property_storage_map_.clear();
+    linked_ids_map_.clear();
+    return;
+  }
+  invalidateLinkedStorages(id);
+}
+
+void DepsgraphBuilderCache::invalidateLinkedStorages(ID *id)
+{
+  /* NOTE: IDs are never dereferenced here, they might be freed already. */
+  Vector<ID *> queue;
+  queue.append(id);
+  while (!queue.is_empty()) {
+    ID *current_id = queue.pop_last();
+    delete animated_property_storage_map_.pop_default(current_id, nullptr);
+    optional<Set<ID *>> linked_ids = linked_ids_map_.pop_try(current_id);
+    if (!linked_ids.has_value()) {
+      continue;
+    }
+    for (ID *linked_id : *linked_ids) {
+      queue.append(linked_id);
+    }
+  }
+}
+
+void DepsgraphBuilderCache::linkIDs(ID *id_a, ID *id_b)
+{
+  linked_ids_map_.lookup_or_add_default(id_a).add(id_b);
+  linked_ids_map_.lookup_or_add_default(id_b).add(id_a);
+}
+
 AnimatedPropertyStorage *DepsgraphBuilderCache::ensureAnimatedPropertyStorage(ID *id)
 {
   return animated_property_storage_map_.lookup_or_add_cb(
-      id, []() { return new AnimatedPropertyStorage(); });
+      id, [id]() { return new AnimatedPropertyStorage(id); });
 }
 
 AnimatedPropertyStorage *DepsgraphBuilderCache::ensureInitializedAnimatedPropertyStorage(ID *id)
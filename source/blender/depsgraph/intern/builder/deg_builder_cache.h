@@ -30,6 +30,7 @@
 #include "RNA_access.h"
 
 struct ID;
+struct Main;
 struct PointerRNA;
 struct PropertyRNA;
 
@@ -59,7 +60,7 @@ class AnimatedPropertyID {
 
 class AnimatedPropertyStorage {
  public:
-  AnimatedPropertyStorage();
+  AnimatedPropertyStorage(const ID *id);
 
   void initializeFromID(DepsgraphBuilderCache *builder_cache, ID *id);
 
@@ -72,17 +73,37 @@ class AnimatedPropertyStorage {
   /* The storage is fully initialized from all F-Curves from corresponding ID. */
   bool is_fully_initialized;
 
+  /* Session UUID of the ID at the time the storage was created. Used to detect the ID pointer
+   * being re-used by another datablock. */
+  unsigned int id_session_uuid;
+
   /* indexed by PointerRNA.data. */
   Set<AnimatedPropertyID> animated_properties_set;
 
   MEM_CXX_CLASS_ALLOC_FUNCS("AnimatedPropertyStorage");
 };
 
-/* Cached data which can be re-used by multiple builders. */
+/* Cached data which can be re-used by multiple builders.
+ *
+ * The cache is owned by the dependency graph and is kept across relations updates, so that only
+ * storages of IDs which were changed since the previous build are re-initialized. The nodes and
+ * relations of the graph are still built from scratch on every relations update. */
 class DepsgraphBuilderCache {
  public:
   ~DepsgraphBuilderCache();
 
+  /* Discard storages of IDs which were removed or modified since the previous build. Is to be
+   * called before any storage is accessed by builders. */
+  void beginBuild(Main *bmain);
+
+  /* Discard storage of the given ID, and of all IDs whose storages were initialized together
+   * with it. Is not to be called while the graph is being built. */
+  void invalidateID(ID *id);
+
+  /* Mark storages of both IDs as depending on each other, so that they are invalidated together.
+   * Happens when F-Curves of one ID animate properties of another one. */
+  void linkIDs(ID *id_a, ID *id_b);
+
   /* Makes sure storage for animated properties exists and initialized for the given ID. */
   AnimatedPropertyStorage *ensureAnimatedPropertyStorage(ID *id);
   AnimatedPropertyStorage *ensureInitializedAnimatedPropertyStorage(ID *id);
@@ -103,6 +124,10 @@ class DepsgraphBuilderCache {
   }
 
   Map<ID *, AnimatedPropertyStorage *> animated_property_storage_map_;
+  Map<ID *, Set<ID *>> linked_ids_map_;
+
+ protected:
+  void invalidateLinkedStorages(ID *id);
 
   MEM_CXX_CLASS_ALLOC_FUNCS("DepsgraphBuilderCache");
 };
@@ -0,0 +1,96 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2021 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#include "intern/builder/deg_builder_cache.h"
+
+#include "testing/testing.h"
+
+#include "DNA_ID.h"
+#include "DNA_collection_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "BKE_collection.h"
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_main.h"
+#include "BKE_object.h"
+
+namespace blender::deg::tests {
+
+class DepsgraphBuilderCacheTest : public testing::Test {
+ protected:
+  Main *bmain;
+
+  void SetUp() override
+  {
+    BKE_idtype_init();
+    bmain = BKE_main_new();
+  }
+
+  void TearDown() override
+  {
+    BKE_main_free(bmain);
+  }
+};
+
+TEST_F(DepsgraphBuilderCacheTest, embedded_ids_are_kept)
+{
+  Scene *scene = static_cast<Scene *>(BKE_libblock_alloc(bmain, ID_SCE, "Scene", 0));
+  scene->master_collection = BKE_collection_master_add();
+
+  DepsgraphBuilderCache cache;
+  cache.ensureAnimatedPropertyStorage(&scene->id);
+  cache.ensureAnimatedPropertyStorage(&scene->master_collection->id);
+  cache.beginBuild(bmain);
+  EXPECT_TRUE(cache.animated_property_storage_map_.contains(&scene->id));
+  EXPECT_TRUE(cache.animated_property_storage_map_.contains(&scene->master_collection->id));
+}
+
+TEST_F(DepsgraphBuilderCacheTest, changed_ids_are_invalidated)
+{
+  Object *object_a = BKE_object_add_only_object(bmain, OB_EMPTY, "A");
+  Object *object_b = BKE_object_add_only_object(bmain, OB_EMPTY, "B");
+  Object *object_c = BKE_object_add_only_object(bmain, OB_EMPTY, "C");
+  /* Not part of Main, like a data-block which has been freed. */
+  ID removed_id = {nullptr};
+
+  DepsgraphBuilderCache cache;
+  cache.ensureAnimatedPropertyStorage(&object_a->id);
+  cache.ensureAnimatedPropertyStorage(&object_b->id);
+  cache.ensureAnimatedPropertyStorage(&object_c->id);
+  cache.ensureAnimatedPropertyStorage(&removed_id);
+  cache.linkIDs(&object_a->id, &object_b->id);
+
+  object_a->id.recalc |= ID_RECALC_TRANSFORM;
+  cache.beginBuild(bmain);
+  EXPECT_FALSE(cache.animated_property_storage_map_.contains(&object_a->id));
+  EXPECT_FALSE(cache.animated_property_storage_map_.contains(&object_b->id));
+  EXPECT_TRUE(cache.animated_property_storage_map_.contains(&object_c->id));
+  EXPECT_FALSE(cache.animated_property_storage_map_.contains(&removed_id));
+
+  cache.invalidateID(&object_c->id);
+  EXPECT_TRUE(cache.animated_property_storage_map_.is_empty());
+}
+
+}  // namespace blender::deg::tests
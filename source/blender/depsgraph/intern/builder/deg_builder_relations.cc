@@ -31,7 +31,9 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_array.hh"
 #include "BLI_blenlib.h"
+#include "BLI_task.hh"
 #include "BLI_utildefines.h"
 
 #include "DNA_action_types.h"
@@ -366,6 +368,13 @@ Relation *DepsgraphRelationBuilder::add_time_relation(TimeSourceNode *timesrc,
   return nullptr;
 }
 
+void DepsgraphRelationBuilder::add_pending_relations(Span<PendingRelation> relations)
+{
+  for (const PendingRelation &relation : relations) {
+    add_operation_relation(relation.from, relation.to, relation.description, relation.flags);
+  }
+}
+
 Relation *DepsgraphRelationBuilder::add_operation_relation(OperationNode *node_from,
                                                            OperationNode *node_to,
                                                            const char *description,
@@ -2834,10 +2843,27 @@ void DepsgraphRelationBuilder::build_scene_speakers(Scene * /*scene*/, ViewLayer
   }
 }
 
+/* NOTE: Only this pass gathers relations in parallel, the per-ID relations built by the recursive
+ * `build_*()` functions are still built on a single thread. Doing those in parallel would need:
+ * - A thread-safe built map, since an ID is built by whichever `build_*()` function reaches it
+ *   first.
+ * - Thread-safe caches, which are filled on demand while building (RNA node query, physics
+ *   relations and the builder cache).
+ * - Gathering relations into per-ID buffers like below. `add_relation()` writes to the inlinks
+ *   and outlinks of nodes of other IDs, and some builders inspect those links. */
 void DepsgraphRelationBuilder::build_copy_on_write_relations()
 {
-  for (IDNode *id_node : graph_->id_nodes) {
-    build_copy_on_write_relations(id_node);
+  const int64_t num_id_nodes = graph_->id_nodes.size();
+  /* Every ID gathers its relations into its own buffer, so the order in which relations are added
+   * to the graph does not depend on how the work got scheduled. */
+  Array<Vector<PendingRelation>> id_relations(num_id_nodes);
+  threading::parallel_for(IndexRange(num_id_nodes), 32, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      collect_copy_on_write_relations(graph_->id_nodes[i], id_relations[i]);
+    }
+  });
+  for (Span<PendingRelation> relations : id_relations) {
+    add_pending_relations(relations);
   }
 }
 
@@ -2871,6 +2897,14 @@ void DepsgraphRelationBuilder::build_nested_shapekey(ID *owner, Key *key)
 }
 
 void DepsgraphRelationBuilder::build_copy_on_write_relations(IDNode *id_node)
+{
+  Vector<PendingRelation> relations;
+  collect_copy_on_write_relations(id_node, relations);
+  add_pending_relations(relations);
+}
+
+void DepsgraphRelationBuilder::collect_copy_on_write_relations(
+    IDNode *id_node, Vector<PendingRelation> &r_relations) const
 {
   ID *id_orig = id_node->id_orig;
 
@@ -2927,8 +2961,7 @@ void DepsgraphRelationBuilder::build_copy_on_write_relations(IDNode *id_node)
      * copy of ID. */
     OperationNode *op_entry = comp_node->get_entry_operation();
     if (op_entry != nullptr) {
-      Relation *rel = graph_->add_new_relation(op_cow, op_entry, "CoW Dependency");
-      rel->flag |= rel_flag;
+      r_relations.append({op_cow, op_entry, "CoW Dependency", rel_flag});
     }
     /* All dangling operations should also be executed after copy-on-write. */
     for (OperationNode *op_node : comp_node->operations_map->values()) {
@@ -2936,8 +2969,7 @@ void DepsgraphRelationBuilder::build_copy_on_write_relations(IDNode *id_node)
         continue;
       }
       if (op_node->inlinks.is_empty()) {
-        Relation *rel = graph_->add_new_relation(op_cow, op_node, "CoW Dependency");
-        rel->flag |= rel_flag;
+        r_relations.append({op_cow, op_node, "CoW Dependency", rel_flag});
       }
       else {
         bool has_same_comp_dependency = false;
@@ -2952,8 +2984,7 @@ void DepsgraphRelationBuilder::build_copy_on_write_relations(IDNode *id_node)
           }
         }
         if (!has_same_comp_dependency) {
-          Relation *rel = graph_->add_new_relation(op_cow, op_node, "CoW Dependency");
-          rel->flag |= rel_flag;
+          r_relations.append({op_cow, op_node, "CoW Dependency", rel_flag});
         }
       }
     }
@@ -2963,7 +2994,10 @@ void DepsgraphRelationBuilder::build_copy_on_write_relations(IDNode *id_node)
      * component of its Mesh. This is because pointers are all known
      * already so remapping will happen all correct. And then If some object
      * evaluation step needs geometry, it will have transitive dependency
-     * to Mesh copy-on-write already. */
+     * to Mesh copy-on-write already.
+     *
+     * NOTE: The inlinks checked above are never modified by copy-on-write relations of other
+     * IDs, which is what allows to gather relations of different IDs in parallel. */
   }
   /* TODO(sergey): This solves crash for now, but causes too many
    * updates potentially. */
@@ -2974,8 +3008,17 @@ void DepsgraphRelationBuilder::build_copy_on_write_relations(IDNode *id_node)
       if (deg_copy_on_write_is_needed(object_data_id)) {
         OperationKey data_copy_on_write_key(
             object_data_id, NodeType::COPY_ON_WRITE, OperationCode::COPY_ON_WRITE);
-        add_relation(
-            data_copy_on_write_key, copy_on_write_key, "Eval Order", RELATION_FLAG_GODMODE);
+        OperationNode *op_data_cow = find_node(data_copy_on_write_key);
+        if (op_data_cow != nullptr) {
+          r_relations.append({op_data_cow, op_cow, "Eval Order", RELATION_FLAG_GODMODE});
+        }
+        else {
+          /* Same report as #add_relation gives for a missing node. */
+          fprintf(stderr,
+                  "add_relation(%s) - Could not find op_from (%s)\n",
+                  "Eval Order",
+                  data_copy_on_write_key.identifier().c_str());
+        }
       }
     }
     else {
@@ -313,6 +313,8 @@ class DepsgraphRelationBuilder : public DepsgraphBuilder {
                                          bool add_absorption,
                                          const char *name);
 
+  /* Copy-on-write relations of different IDs do not depend on each other, so they are gathered in
+   * parallel and added to the graph afterwards in the order of ID nodes. */
   virtual void build_copy_on_write_relations();
   virtual void build_copy_on_write_relations(IDNode *id_node);
   virtual void build_driver_relations();
@@ -323,6 +325,15 @@ class DepsgraphRelationBuilder : public DepsgraphBuilder {
   Depsgraph *getGraph();
 
  protected:
+  /* Relation between resolved operation nodes which is not yet added to the graph. Allows to
+   * gather relations from multiple threads while only reading the graph. */
+  struct PendingRelation {
+    OperationNode *from;
+    OperationNode *to;
+    const char *description;
+    int flags;
+  };
+
   TimeSourceNode *get_node(const TimeSourceKey &key) const;
   ComponentNode *get_node(const ComponentKey &key) const;
   OperationNode *get_node(const OperationKey &key) const;
@@ -339,6 +350,12 @@ class DepsgraphRelationBuilder : public DepsgraphBuilder {
                                    OperationNode *node_to,
                                    const char *description,
                                    int flags = 0);
+  void add_pending_relations(Span<PendingRelation> relations);
+
+  /* Gather relations from copy-on-write operation of the ID to all its components. Does not
+   * modify the graph, so it is safe to be called for different IDs from multiple threads. */
+  void collect_copy_on_write_relations(IDNode *id_node,
+                                       Vector<PendingRelation> &r_relations) const;
 
   template<typename KeyType>
   DepsNodeHandle create_node_handle(const KeyType &key, const char *default_name = "");
@@ -36,7 +36,8 @@ AbstractBuilderPipeline::AbstractBuilderPipeline(::Depsgraph *graph)
     : deg_graph_(reinterpret_cast<Depsgraph *>(graph)),
       bmain_(deg_graph_->bmain),
       scene_(deg_graph_->scene),
-      view_layer_(deg_graph_->view_layer)
+      view_layer_(deg_graph_->view_layer),
+      builder_cache_(*deg_graph_->builder_cache)
 {
 }
 
@@ -48,6 +49,7 @@ void AbstractBuilderPipeline::build()
   }
 
   build_step_sanity_check();
+  builder_cache_.beginBuild(bmain_);
   build_step_nodes();
   build_step_relations();
   build_step_finalize();
@@ -0,0 +1,306 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#include "intern/debug/deg_debug_trace.h"
+
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+
+#include "PIL_time.h"
+
+#include "BLI_fileops.h"
+#include "BLI_math_base.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_ID.h"
+
+#include "DEG_depsgraph_debug.h"
+
+#include "intern/depsgraph.h"
+#include "intern/node/deg_node_component.h"
+#include "intern/node/deg_node_id.h"
+#include "intern/node/deg_node_operation.h"
+
+namespace deg = blender::deg;
+
+namespace blender::deg {
+namespace {
+
+struct TraceEvent {
+  int evaluation_index;
+  float frame;
+  int thread_index;
+  /* In seconds, relative to the beginning of the recording. */
+  double start_time;
+  double end_time;
+  string depsgraph_name;
+  string id_name;
+  string operation_name;
+};
+
+struct EvaluationTrace {
+  std::mutex mutex;
+
+  bool is_recording = false;
+  /* Number of graph evaluations to record, 0 means record until stopped. */
+  int num_evaluations_to_record = 0;
+  int num_started_evaluations = 0;
+  int num_evaluations_in_progress = 0;
+  double start_time = 0.0;
+
+  /* When not empty, the trace is written to this file once the recording stops. */
+  string output_filepath;
+
+  Vector<TraceEvent> events;
+};
+
+EvaluationTrace &get_trace()
+{
+  static EvaluationTrace trace;
+  return trace;
+}
+
+/* Small index which identifies the calling thread in the trace. */
+int get_thread_index()
+{
+  static std::atomic<int> num_threads = 0;
+  static thread_local int thread_index = num_threads++;
+  return thread_index;
+}
+
+string json_escape(StringRef str)
+{
+  string result;
+  result.reserve(str.size());
+  for (const char c : str) {
+    if (ELEM(c, '"', '\\')) {
+      result += '\\';
+      result += c;
+    }
+    else if (static_cast<unsigned char>(c) < 0x20) {
+      char buffer[8];
+      BLI_snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+      result += buffer;
+    }
+    else {
+      result += c;
+    }
+  }
+  return result;
+}
+
+string csv_escape(StringRef str)
+{
+  string result = "\"";
+  for (const char c : str) {
+    if (c == '"') {
+      result += '"';
+    }
+    result += c;
+  }
+  result += '"';
+  return result;
+}
+
+/* Chrome trace event format, can be opened in chrome://tracing or Perfetto. */
+void write_trace_json(FILE *file, Span<TraceEvent> events)
+{
+  fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+  for (const int64_t i : events.index_range()) {
+    const TraceEvent &event = events[i];
+    fprintf(file,
+            "{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, "
+            "\"ts\": %.3f, \"dur\": %.3f, "
+            "\"args\": {\"depsgraph\": \"%s\", \"evaluation\": %d, \"frame\": %f}}%s\n",
+            json_escape(event.operation_name).c_str(),
+            json_escape(event.id_name).c_str(),
+            event.thread_index,
+            event.start_time * 1e6,
+            (event.end_time - event.start_time) * 1e6,
+            json_escape(event.depsgraph_name).c_str(),
+            event.evaluation_index,
+            event.frame,
+            (i == events.size() - 1) ? "" : ",");
+  }
+  fprintf(file, "]}\n");
+}
+
+void write_trace_csv(FILE *file, Span<TraceEvent> events)
+{
+  fprintf(file, "evaluation,frame,depsgraph,id,operation,thread,start,end\n");
+  for (const TraceEvent &event : events) {
+    fprintf(file,
+            "%d,%f,%s,%s,%s,%d,%.9f,%.9f\n",
+            event.evaluation_index,
+            event.frame,
+            csv_escape(event.depsgraph_name).c_str(),
+            csv_escape(event.id_name).c_str(),
+            csv_escape(event.operation_name).c_str(),
+            event.thread_index,
+            event.start_time,
+            event.end_time);
+  }
+}
+
+/* Is to be called with the trace mutex locked. */
+bool write_trace(const EvaluationTrace &trace, const char *filepath)
+{
+  FILE *file = BLI_fopen(filepath, "w");
+  if (file == nullptr) {
+    fprintf(stderr, "Could not open file %s for writing depsgraph trace\n", filepath);
+    return false;
+  }
+  if (BLI_path_extension_check(filepath, ".csv")) {
+    write_trace_csv(file, trace.events);
+  }
+  else {
+    write_trace_json(file, trace.events);
+  }
+  fclose(file);
+  return true;
+}
+
+/* Is to be called with the trace mutex locked. */
+void write_trace_output_if_finished(EvaluationTrace &trace)
+{
+  if (trace.is_recording || trace.num_evaluations_in_progress != 0) {
+    return;
+  }
+  if (trace.output_filepath.empty()) {
+    return;
+  }
+  if (write_trace(trace, trace.output_filepath.c_str())) {
+    printf("Depsgraph evaluation trace of %d evaluations written to %s\n",
+           trace.num_started_evaluations,
+           trace.output_filepath.c_str());
+  }
+  trace.output_filepath.clear();
+}
+
+}  // namespace
+
+int deg_debug_trace_begin_evaluation(const Depsgraph * /*graph*/)
+{
+  EvaluationTrace &trace = get_trace();
+  std::lock_guard lock{trace.mutex};
+  if (!trace.is_recording) {
+    return -1;
+  }
+  const int evaluation_index = trace.num_started_evaluations++;
+  if (trace.num_started_evaluations == trace.num_evaluations_to_record) {
+    trace.is_recording = false;
+  }
+  trace.num_evaluations_in_progress++;
+  return evaluation_index;
+}
+
+void deg_debug_trace_end_evaluation(const int evaluation_index)
+{
+  BLI_assert(evaluation_index >= 0);
+  UNUSED_VARS_NDEBUG(evaluation_index);
+  EvaluationTrace &trace = get_trace();
+  std::lock_guard lock{trace.mutex};
+  trace.num_evaluations_in_progress--;
+  write_trace_output_if_finished(trace);
+}
+
+void deg_debug_trace_add_operation(const Depsgraph *graph,
+                                   const int evaluation_index,
+                                   const OperationNode *operation_node,
+                                   const double start_time,
+                                   const double end_time)
+{
+  const ComponentNode *component_node = operation_node->owner;
+  const IDNode *id_node = component_node->owner;
+
+  TraceEvent event;
+  event.evaluation_index = evaluation_index;
+  event.frame = graph->frame;
+  event.thread_index = get_thread_index();
+  event.depsgraph_name = graph->debug.name;
+  event.id_name = id_node->id_orig->name + 2;
+  event.operation_name = nodeTypeAsString(component_node->type);
+  if (!component_node->name.empty()) {
+    event.operation_name += "[" + component_node->name + "]";
+  }
+  event.operation_name += "/" + operation_node->identifier();
+
+  EvaluationTrace &trace = get_trace();
+  std::lock_guard lock{trace.mutex};
+  event.start_time = start_time - trace.start_time;
+  event.end_time = end_time - trace.start_time;
+  trace.events.append(std::move(event));
+}
+
+}  // namespace blender::deg
+
+void DEG_debug_trace_start(const int num_evaluations)
+{
+  deg::EvaluationTrace &trace = deg::get_trace();
+  std::lock_guard lock{trace.mutex};
+  trace.events.clear();
+  trace.is_recording = true;
+  trace.num_evaluations_to_record = max_ii(num_evaluations, 0);
+  trace.num_started_evaluations = 0;
+  trace.start_time = PIL_check_seconds_timer();
+}
+
+void DEG_debug_trace_stop(void)
+{
+  deg::EvaluationTrace &trace = deg::get_trace();
+  std::lock_guard lock{trace.mutex};
+  trace.is_recording = false;
+  deg::write_trace_output_if_finished(trace);
+}
+
+bool DEG_debug_trace_is_recording(void)
+{
+  deg::EvaluationTrace &trace = deg::get_trace();
+  std::lock_guard lock{trace.mutex};
+  return trace.is_recording;
+}
+
+bool DEG_debug_trace_write(const char *filepath)
+{
+  deg::EvaluationTrace &trace = deg::get_trace();
+  std::lock_guard lock{trace.mutex};
+  return deg::write_trace(trace, filepath);
+}
+
+void DEG_debug_trace_output_set(const char *filepath)
+{
+  deg::EvaluationTrace &trace = deg::get_trace();
+  std::lock_guard lock{trace.mutex};
+  trace.output_filepath = (filepath != nullptr) ? filepath : "";
+}
+
+void DEG_debug_trace_exit(void)
+{
+  deg::EvaluationTrace &trace = deg::get_trace();
+  std::lock_guard lock{trace.mutex};
+  trace.is_recording = false;
+  trace.num_evaluations_in_progress = 0;
+  deg::write_trace_output_if_finished(trace);
+  /* Free memory explicitly, so it is not reported as leaked. */
+  trace.events.clear_and_make_inline();
+}
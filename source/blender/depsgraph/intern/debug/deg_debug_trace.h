@@ -0,0 +1,45 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ *
+ * Recording of the evaluation timeline: start and end time of every evaluated operation.
+ */
+
+#pragma once
+
+namespace blender {
+namespace deg {
+
+struct Depsgraph;
+struct OperationNode;
+
+/* Is to be called when graph evaluation begins. Returns index of the evaluation in the trace,
+ * or -1 when the evaluation is not to be recorded. */
+int deg_debug_trace_begin_evaluation(const Depsgraph *graph);
+/* Is to be called for every evaluation for which begin function returned non-negative index. */
+void deg_debug_trace_end_evaluation(int evaluation_index);
+
+/* Record evaluation of a single operation. Is safe to be called from multiple threads. */
+void deg_debug_trace_add_operation(const Depsgraph *graph,
+                                   int evaluation_index,
+                                   const OperationNode *operation_node,
+                                   double start_time,
+                                   double end_time);
+
+}  // namespace deg
+}  // namespace blender
@@ -50,6 +50,7 @@ struct ViewLayer;
 namespace blender {
 namespace deg {
 
+class DepsgraphBuilderCache;
 struct IDNode;
 struct Node;
 struct OperationNode;
@@ -175,6 +176,10 @@ struct Depsgraph {
    * created along with relations, for fast lookup during evaluation. */
   Map<const ID *, ListBase *> *physics_relations[DEG_PHYSICS_RELATIONS_NUM];
 
+  /* Data gathered by builders which is kept across relations updates. Only parts which belong
+   * to IDs which were changed since the previous build are gathered again. */
+  DepsgraphBuilderCache *builder_cache;
+
   MEM_CXX_CLASS_ALLOC_FUNCS("Depsgraph");
 };
 
@@ -83,6 +83,8 @@ void DEG_evaluate_on_framechange(Depsgraph *graph, float frame)
 
   deg_graph->tag_time_source();
   deg_graph->frame = frame;
-  deg_graph->ctime = BKE_scene_frame_to_ctime(scene, frame);
+  /* The frame includes the sub-frame, the one of the input scene does not necessarily match when
+   * multiple graphs evaluate different frames of it, see #BKE_scene_graph_evaluate_frames. */
+  deg_graph->ctime = frame * scene->r.framelen;
   deg_flush_updates_and_refresh(deg_graph);
 }
@@ -56,6 +56,7 @@
 #include "DEG_depsgraph_query.h"
 
 #include "intern/builder/deg_builder.h"
+#include "intern/builder/deg_builder_cache.h"
 #include "intern/depsgraph.h"
 #include "intern/depsgraph_registry.h"
 #include "intern/depsgraph_update.h"
@@ -661,6 +662,11 @@ void graph_id_tag_update(
   IDNode *id_node = (graph != nullptr) ? graph->find_id_node(id) : nullptr;
   if (graph != nullptr) {
     DEG_graph_id_type_tag(reinterpret_cast<::Depsgraph *>(graph), GS(id->name));
+    /* Data gathered by the builder for this ID is to be gathered again on next relations update.
+     * Tags coming from the graph itself do not correspond to changes in the datablock. */
+    if (update_source == DEG_UPDATE_SOURCE_USER_EDIT) {
+      graph->builder_cache->invalidateID(id);
+    }
   }
   if (flag == 0) {
     deg_graph_node_tag_zero(bmain, graph, id_node, update_source);
@@ -29,7 +29,9 @@
 
 #include "BLI_compiler_attrs.h"
 #include "BLI_gsqueue.h"
+#include "BLI_heap.h"
 #include "BLI_task.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_global.h"
@@ -43,6 +45,7 @@
 
 #include "atomic_ops.h"
 
+#include "intern/debug/deg_debug_trace.h"
 #include "intern/depsgraph.h"
 #include "intern/depsgraph_relation.h"
 #include "intern/depsgraph_tag.h"
@@ -69,10 +72,7 @@ void schedule_children(DepsgraphEvalState *state,
                        ScheduleFunction *schedule_function,
                        ScheduleFunctionArgs... schedule_function_args);
 
-void schedule_node_to_pool(OperationNode *node, const int UNUSED(thread_id), TaskPool *pool)
-{
-  BLI_task_pool_push(pool, deg_task_run_func, node, false, nullptr);
-}
+void schedule_node_to_pool(OperationNode *node, const int thread_id, TaskPool *pool);
 
 /* Denotes which part of dependency graph is being evaluated. */
 enum class EvaluationStage {
@@ -96,6 +96,16 @@ struct DepsgraphEvalState {
   bool do_stats;
   EvaluationStage stage;
   bool need_single_thread_pass;
+  /* Index of this evaluation in the evaluation timeline trace, -1 if it is not recorded. */
+  int trace_evaluation_index;
+
+  /* Operations which are ready for evaluation, ordered by their priority.
+   *
+   * Tasks pushed to the pool do not carry an operation, instead every task picks the operation
+   * with the highest priority at the time it starts. This way long chains of operations get
+   * started as early as possible, instead of in the order operations became ready. */
+  Heap *ready_operations;
+  ThreadMutex ready_operations_mutex;
 };
 
 void evaluate_node(const DepsgraphEvalState *state, OperationNode *operation_node)
@@ -104,24 +114,43 @@ void evaluate_node(const DepsgraphEvalState *state, OperationNode *operation_nod
 
   /* Sanity checks. */
   BLI_assert_msg(!operation_node->is_noop(), "NOOP nodes should not actually be scheduled");
-  /* Perform operation. */
+  /* Perform operation. The time is always measured, it is used for scheduling priorities. */
+  const double start_time = PIL_check_seconds_timer();
+  operation_node->evaluate(depsgraph);
+  const double end_time = PIL_check_seconds_timer();
+  const double evaluation_time = end_time - start_time;
+  operation_node->stats.add_evaluation_time(evaluation_time);
   if (state->do_stats) {
-    const double start_time = PIL_check_seconds_timer();
-    operation_node->evaluate(depsgraph);
-    operation_node->stats.current_time += PIL_check_seconds_timer() - start_time;
+    operation_node->stats.current_time += evaluation_time;
   }
-  else {
-    operation_node->evaluate(depsgraph);
+  if (state->trace_evaluation_index != -1) {
+    deg_debug_trace_add_operation(
+        state->graph, state->trace_evaluation_index, operation_node, start_time, end_time);
   }
 }
 
-void deg_task_run_func(TaskPool *pool, void *taskdata)
+void schedule_node_to_pool(OperationNode *node, const int UNUSED(thread_id), TaskPool *pool)
+{
+  DepsgraphEvalState *state = (DepsgraphEvalState *)BLI_task_pool_user_data(pool);
+  BLI_mutex_lock(&state->ready_operations_mutex);
+  /* The heap pops the smallest value first. */
+  BLI_heap_insert(state->ready_operations, (float)-node->priority, node);
+  BLI_mutex_unlock(&state->ready_operations_mutex);
+  BLI_task_pool_push(pool, deg_task_run_func, nullptr, false, nullptr);
+}
+
+void deg_task_run_func(TaskPool *pool, void *UNUSED(taskdata))
 {
   void *userdata_v = BLI_task_pool_user_data(pool);
   DepsgraphEvalState *state = (DepsgraphEvalState *)userdata_v;
 
+  /* Every task is pushed after an operation has been added to the heap, so there is always at
+   * least one operation to pick. */
+  BLI_mutex_lock(&state->ready_operations_mutex);
+  OperationNode *operation_node = (OperationNode *)BLI_heap_pop_min(state->ready_operations);
+  BLI_mutex_unlock(&state->ready_operations_mutex);
+
   /* Evaluate node. */
-  OperationNode *operation_node = reinterpret_cast<OperationNode *>(taskdata);
   evaluate_node(state, operation_node);
 
   /* Schedule children. */
@@ -182,6 +211,7 @@ void initialize_execution(DepsgraphEvalState *state, Depsgraph *graph)
 {
   const bool do_stats = state->do_stats;
   calculate_pending_parents(graph);
+  deg_eval_stats_calculate_priorities(graph);
   /* Clear tags and other things which needs to be clear. */
   for (OperationNode *node : graph->operations) {
     if (do_stats) {
@@ -382,6 +412,9 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
   state.graph = graph;
   state.do_stats = graph->debug.do_time_debug();
   state.need_single_thread_pass = false;
+  state.trace_evaluation_index = deg_debug_trace_begin_evaluation(graph);
+  state.ready_operations = BLI_heap_new();
+  BLI_mutex_init(&state.ready_operations_mutex);
   /* Prepare all nodes for evaluation. */
   initialize_execution(&state, graph);
 
@@ -405,12 +438,19 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
     evaluate_graph_single_threaded(&state);
   }
 
+  BLI_assert(BLI_heap_is_empty(state.ready_operations));
+  BLI_heap_free(state.ready_operations, nullptr);
+  BLI_mutex_end(&state.ready_operations_mutex);
+
   /* Finalize statistics gathering. This is because we only gather single
    * operation timing here, without aggregating anything to avoid any extra
    * synchronization. */
   if (state.do_stats) {
     deg_eval_stats_aggregate(graph);
   }
+  if (state.trace_evaluation_index != -1) {
+    deg_debug_trace_end_evaluation(state.trace_evaluation_index);
+  }
   /* Clear any uncleared tags - just in case. */
   deg_graph_clear_tags(graph);
   graph->is_evaluating = false;
@@ -46,6 +46,8 @@
 #include "BKE_idprop.h"
 #include "BKE_layer.h"
 #include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_pointcloud.h"
 #include "BKE_scene.h"
 
 #include "DEG_depsgraph.h"
@@ -283,8 +285,8 @@ struct ValidateData {
 };
 
 /* Similar to generic BKE_id_copy() but does not require main and assumes pointer
- * is already allocated. */
-bool id_copy_inplace_no_main(const ID *id, ID *newid)
+ * is already allocated. The extra flags are passed to the copy callback of the ID type. */
+bool id_copy_inplace_no_main(const ID *id, ID *newid, const int extra_flag = 0)
 {
   const ID *id_for_copy = id;
 
@@ -305,7 +307,7 @@ bool id_copy_inplace_no_main(const ID *id, ID *newid)
                                 (ID *)id_for_copy,
                                 &newid,
                                 (LIB_ID_COPY_LOCALIZE | LIB_ID_CREATE_NO_ALLOCATE |
-                                 LIB_ID_COPY_SET_COPIED_ON_WRITE)) != nullptr);
+                                 LIB_ID_COPY_SET_COPIED_ON_WRITE | extra_flag)) != nullptr);
 
 #ifdef NESTED_ID_NASTY_WORKAROUND
   if (result) {
@@ -863,8 +865,6 @@ ID *deg_expand_copy_on_write_datablock(const Depsgraph *depsgraph,
   }
   // BLI_assert(check_datablock_expanded(id_cow) == false);
   /* Copy data from original ID to a copied version. */
-  /* TODO(sergey): Avoid doing full ID copy somehow, make Mesh to reference
-   * original geometry arrays for until those are modified. */
   /* TODO(sergey): We do some trickery with temp bmain and extra ID pointer
    * just to be able to use existing API. Ideally we need to replace this with
    * in-place copy from existing datablock to a prepared memory.
@@ -887,9 +887,24 @@ ID *deg_expand_copy_on_write_datablock(const Depsgraph *depsgraph,
       }
       break;
     }
-    case ID_ME: {
-      /* TODO(sergey): Ideally we want to handle meshes in a special
-       * manner here to avoid initial copy of all the geometry arrays. */
+    case ID_ME:
+    case ID_PT: {
+      /* Avoid initial copy of the geometry arrays: they are shared with the original datablock
+       * and are only copied when the evaluation modifies them. The original prepares its layers
+       * for sharing, the copy only adds users to them.
+       *
+       * Render engines evaluate their dependency graph from a job thread while the original
+       * datablock can be edited from the interface. So layers are only shared for the
+       * interactive evaluation, which never runs at the same time as the tools. */
+      if (depsgraph->mode == DAG_EVAL_VIEWPORT) {
+        if (id_type == ID_ME) {
+          BKE_mesh_share_custom_data((Mesh *)id_node->id_orig, LIB_ID_COPY_CD_SHARE_GEOMETRY);
+        }
+        else {
+          BKE_pointcloud_share_custom_data((PointCloud *)id_node->id_orig);
+        }
+        done = id_copy_inplace_no_main(id_orig, id_cow, LIB_ID_COPY_CD_SHARE_GEOMETRY);
+      }
       break;
     }
     default:
@@ -26,6 +26,7 @@
 #include "BLI_utildefines.h"
 
 #include "intern/depsgraph.h"
+#include "intern/depsgraph_relation.h"
 
 #include "intern/node/deg_node.h"
 #include "intern/node/deg_node_component.h"
@@ -54,4 +55,51 @@ void deg_eval_stats_aggregate(Depsgraph *graph)
   }
 }
 
+static bool is_priority_relation(const Relation *rel)
+{
+  return rel->from->type == NodeType::OPERATION && rel->to->type == NodeType::OPERATION &&
+         (rel->flag & RELATION_FLAG_CYCLIC) == 0;
+}
+
+void deg_eval_stats_calculate_priorities(Depsgraph *graph)
+{
+  /* Traverse operations from the leaves of the graph towards its roots, so that priorities of all
+   * children are known by the time the priority of an operation is calculated. Custom flags are
+   * used to count children which are not handled yet. */
+  Vector<OperationNode *> queue;
+  for (OperationNode *op_node : graph->operations) {
+    op_node->custom_flags = 0;
+    for (Relation *rel : op_node->outlinks) {
+      if (is_priority_relation(rel)) {
+        op_node->custom_flags++;
+      }
+    }
+    if (op_node->custom_flags == 0) {
+      queue.append(op_node);
+    }
+  }
+  while (!queue.is_empty()) {
+    OperationNode *op_node = queue.pop_last();
+    double children_priority = 0.0;
+    for (Relation *rel : op_node->outlinks) {
+      if (is_priority_relation(rel)) {
+        children_priority = max(children_priority, ((OperationNode *)rel->to)->priority);
+      }
+    }
+    /* Operations which are not tagged for update are not evaluated, so they do not contribute
+     * to the length of the chain. */
+    const bool need_update = (op_node->flag & DEPSOP_FLAG_NEEDS_UPDATE) != 0;
+    op_node->priority = (need_update ? op_node->stats.average_time : 0.0) + children_priority;
+    for (Relation *rel : op_node->inlinks) {
+      if (!is_priority_relation(rel)) {
+        continue;
+      }
+      OperationNode *parent = (OperationNode *)rel->from;
+      if (--parent->custom_flags == 0) {
+        queue.append(parent);
+      }
+    }
+  }
+}
+
 }  // namespace blender::deg
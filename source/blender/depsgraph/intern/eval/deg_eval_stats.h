@@ -31,5 +31,10 @@ struct Depsgraph;
 /* Aggregate operation timings to overall component and ID nodes timing. */
 void deg_eval_stats_aggregate(Depsgraph *graph);
 
+/* Calculate evaluation priorities of operations from their average evaluation time, so that
+ * operations at the beginning of the longest chain of tagged operations are evaluated first.
+ * Cyclic relations are ignored. */
+void deg_eval_stats_calculate_priorities(Depsgraph *graph);
+
 }  // namespace deg
 }  // namespace blender
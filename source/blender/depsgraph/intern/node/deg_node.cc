@@ -278,6 +278,7 @@ Node::Stats::Stats()
 void Node::Stats::reset()
 {
   current_time = 0.0;
+  average_time = 0.0;
 }
 
 void Node::Stats::reset_current()
@@ -285,6 +286,17 @@ void Node::Stats::reset_current()
   current_time = 0.0;
 }
 
+void Node::Stats::add_evaluation_time(const double time)
+{
+  if (average_time == 0.0) {
+    average_time = time;
+  }
+  else {
+    /* Favor recent evaluations, so that the average follows changes in the scene quickly. */
+    average_time = average_time * 0.75 + time * 0.25;
+  }
+}
+
 /*******************************************************************************
  * Node itself.
  */
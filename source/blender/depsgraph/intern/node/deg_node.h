@@ -161,8 +161,13 @@ struct Node {
     /* Reset counters needed for the current graph evaluation, does not
      * touch averaging accumulators. */
     void reset_current();
+    /* Accumulate time spent on a single evaluation of this node into the average. */
+    void add_evaluation_time(double time);
     /* Time spend on this node during current graph evaluation. */
     double current_time;
+    /* Exponential moving average of the time spent on evaluation of this node in previous graph
+     * evaluations. Is gathered regardless of whether time debugging is enabled. */
+    double average_time;
   };
   /* Relationships between nodes
    * The reason why all depsgraph nodes are descended from this type (apart
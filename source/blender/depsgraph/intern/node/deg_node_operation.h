@@ -265,6 +265,11 @@ struct OperationNode : public Node {
   uint32_t num_links_pending;
   bool scheduled;
 
+  /* Estimated time needed to evaluate this operation and the longest chain of operations which
+   * depend on it. Operations with higher priority are evaluated first when multiple of them are
+   * ready for evaluation. */
+  double priority;
+
   /* Identifier for the operation being performed. */
   OperationCode opcode;
   int name_tag;
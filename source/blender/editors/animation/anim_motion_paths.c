@@ -25,6 +25,7 @@
 #include "BLI_dlrbTree.h"
 #include "BLI_listbase.h"
 #include "BLI_math.h"
+#include "BLI_threads.h"
 
 #include "DNA_anim_types.h"
 #include "DNA_armature_types.h"
@@ -74,6 +75,19 @@ static void motionpaths_calc_update_scene(struct Depsgraph *depsgraph)
   BKE_scene_graph_update_for_newframe(depsgraph);
 }
 
+/* Flat array of the target objects, for the DEG API. */
+static ID **motionpaths_targets_ids(ListBase *targets, int *r_num_ids)
+{
+  const int num_ids = BLI_listbase_count(targets);
+  ID **ids = MEM_malloc_arrayN(sizeof(ID *), num_ids, "animviz IDS");
+  int current_id_index = 0;
+  for (MPathTarget *mpt = targets->first; mpt != NULL; mpt = mpt->next) {
+    ids[current_id_index++] = &mpt->ob->id;
+  }
+  *r_num_ids = num_ids;
+  return ids;
+}
+
 Depsgraph *animviz_depsgraph_build(Main *bmain,
                                    Scene *scene,
                                    ViewLayer *view_layer,
@@ -83,12 +97,8 @@ Depsgraph *animviz_depsgraph_build(Main *bmain,
   Depsgraph *depsgraph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_VIEWPORT);
 
   /* Make a flat array of IDs for the DEG API. */
-  const int num_ids = BLI_listbase_count(targets);
-  ID **ids = MEM_malloc_arrayN(sizeof(ID *), num_ids, "animviz IDS");
-  int current_id_index = 0;
-  for (MPathTarget *mpt = targets->first; mpt != NULL; mpt = mpt->next) {
-    ids[current_id_index++] = &mpt->ob->id;
-  }
+  int num_ids;
+  ID **ids = motionpaths_targets_ids(targets, &num_ids);
 
   /* Build graph from all requested IDs. */
   DEG_graph_build_from_ids(depsgraph, ids, num_ids);
@@ -138,8 +148,13 @@ void animviz_get_object_motionpaths(Object *ob, ListBase *targets)
 
 /* ........ */
 
-/* perform baking for the targets on the current frame */
-static void motionpaths_calc_bake_targets(ListBase *targets, int cframe)
+/* perform baking for the targets on the current frame
+ * - frame_depsgraph: dependency graph which is evaluated at the frame, which is not necessarily
+ *   the one of the #MPathTarget.ob_eval objects
+ */
+static void motionpaths_calc_bake_targets(ListBase *targets,
+                                          int cframe,
+                                          Depsgraph *frame_depsgraph)
 {
   MPathTarget *mpt;
 
@@ -157,7 +172,7 @@ static void motionpaths_calc_bake_targets(ListBase *targets, int cframe)
     /* get the relevant cache vert to write to */
     bMotionPathVert *mpv = mpath->points + (cframe - mpath->start_frame);
 
-    Object *ob_eval = mpt->ob_eval;
+    Object *ob_eval = DEG_get_evaluated_object(frame_depsgraph, mpt->ob);
 
     /* Lookup evaluated pose channel, here because the depsgraph
      * evaluation can change them so they are not cached in mpt. */
@@ -198,10 +213,12 @@ static void motionpaths_calc_bake_targets(ListBase *targets, int cframe)
      * while dragging in transform. */
     bMotionPath *mpath_eval = NULL;
     if (mpt->pchan) {
-      mpath_eval = (pchan_eval) ? pchan_eval->mpath : NULL;
+      bPoseChannel *pchan_target_eval = BKE_pose_channel_find_name(mpt->ob_eval->pose,
+                                                                   mpt->pchan->name);
+      mpath_eval = (pchan_target_eval) ? pchan_target_eval->mpath : NULL;
     }
     else {
-      mpath_eval = ob_eval->mpath;
+      mpath_eval = mpt->ob_eval->mpath;
     }
 
     if (mpath_eval && mpath_eval->length == mpath->length) {
@@ -215,6 +232,70 @@ static void motionpaths_calc_bake_targets(ListBase *targets, int cframe)
   }
 }
 
+static void motionpaths_calc_frame_evaluated(Depsgraph *depsgraph, float frame, void *user_data)
+{
+  ListBase *targets = user_data;
+  motionpaths_calc_bake_targets(targets, (int)frame, depsgraph);
+}
+
+/* Minimum number of frames evaluated by every dependency graph. Every additional graph is built
+ * and creates its own copy-on-write data, which only pays off over long ranges. */
+#define MOTIONPATH_FRAMES_PER_DEPSGRAPH_MIN 64
+
+/* Evaluate and bake the targets over the given range.
+ *
+ * Ranges recalculated after editing keyframes are evaluated with the given dependency graph. Full
+ * ranges which are long enough are evaluated by multiple temporary dependency graphs in parallel
+ * (when the frames are independent), containing only the targets like the one from
+ * #animviz_depsgraph_build. */
+static void motionpaths_calc_frames(Depsgraph *depsgraph,
+                                    ListBase *targets,
+                                    const eAnimvizCalcRange range,
+                                    const int sfra,
+                                    const int efra)
+{
+  Scene *scene = DEG_get_input_scene(depsgraph);
+  const int frames_num = efra - sfra + 1;
+  const int num_depsgraphs = (range == ANIMVIZ_CALC_RANGE_FULL) ?
+                                 min_ii(BLI_system_thread_count(),
+                                        frames_num / MOTIONPATH_FRAMES_PER_DEPSGRAPH_MIN) :
+                                 1;
+
+  if (num_depsgraphs <= 1) {
+    for (CFRA = sfra; CFRA <= efra; CFRA++) {
+      /* Update relevant data for new frame. */
+      motionpaths_calc_update_scene(depsgraph);
+
+      /* perform baking for targets */
+      motionpaths_calc_bake_targets(targets, CFRA, depsgraph);
+    }
+    return;
+  }
+
+  int num_ids;
+  ID **ids = motionpaths_targets_ids(targets, &num_ids);
+
+  float *frames = MEM_malloc_arrayN(frames_num, sizeof(float), __func__);
+  for (int i = 0; i < frames_num; i++) {
+    frames[i] = (float)(sfra + i);
+  }
+
+  BKE_scene_graph_evaluate_frames(DEG_get_bmain(depsgraph),
+                                  scene,
+                                  DEG_get_input_view_layer(depsgraph),
+                                  ids,
+                                  num_ids,
+                                  false,
+                                  frames,
+                                  frames_num,
+                                  num_depsgraphs,
+                                  motionpaths_calc_frame_evaluated,
+                                  targets);
+
+  MEM_freeN(frames);
+  MEM_freeN(ids);
+}
+
 /* Get pointer to animviz settings for the given target. */
 static bAnimVizSettings *animviz_target_settings_get(MPathTarget *mpt)
 {
@@ -464,18 +545,13 @@ void animviz_calc_motionpaths(Depsgraph *depsgraph,
             sfra,
             efra,
             efra - sfra + 1);
-  for (CFRA = sfra; CFRA <= efra; CFRA++) {
-    if (range == ANIMVIZ_CALC_RANGE_CURRENT_FRAME) {
-      /* For current frame, only update tagged. */
-      BKE_scene_graph_update_tagged(depsgraph, bmain);
-    }
-    else {
-      /* Update relevant data for new frame. */
-      motionpaths_calc_update_scene(depsgraph);
-    }
-
-    /* perform baking for targets */
-    motionpaths_calc_bake_targets(targets, CFRA);
+  if (range == ANIMVIZ_CALC_RANGE_CURRENT_FRAME) {
+    /* For current frame, only update tagged. */
+    BKE_scene_graph_update_tagged(depsgraph, bmain);
+    motionpaths_calc_bake_targets(targets, CFRA, depsgraph);
+  }
+  else {
+    motionpaths_calc_frames(depsgraph, targets, range, sfra, efra);
   }
 
   /* reset original environment */
@@ -233,7 +233,9 @@ void ED_mesh_uv_loop_reset_ex(struct Mesh *me, const int layernum)
   else {
     /* Collect Mesh UVs */
     BLI_assert(CustomData_has_layer(&me->ldata, CD_MLOOPUV));
-    MLoopUV *mloopuv = CustomData_get_layer_n(&me->ldata, CD_MLOOPUV, layernum);
+    MLoopUV *mloopuv = CustomData_duplicate_referenced_layer_n(
+        &me->ldata, CD_MLOOPUV, layernum, me->totloop);
+    BKE_mesh_update_customdata_pointers(me, false);
 
     for (int i = 0; i < me->totpoly; i++) {
       mesh_uv_reset_mface(&me->mpoly[i], mloopuv);
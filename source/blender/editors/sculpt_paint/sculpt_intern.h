@@ -672,6 +672,19 @@ typedef struct SculptUndoNode {
   /* Sculpt Face Sets */
   int *face_sets;
 
+  /* Compressed copy of the co, orig_co, col and mask arrays. While it is set, those arrays are
+   * NULL. Is only used for nodes of finished undo steps, see `sculpt_undo_node_pack()`. */
+  struct {
+    void *data;
+    size_t size;
+    /* Size of the uncompressed arrays. */
+    size_t raw_size;
+    int allvert;
+    int layers;
+    /* The undo step size has been updated for the compressed size. */
+    bool is_accounted;
+  } packed;
+
   size_t undo_size;
 } SculptUndoNode;
 
@@ -23,6 +23,7 @@
  */
 
 #include <stddef.h>
+#include <zlib.h>
 
 #include "MEM_guardedalloc.h"
 
@@ -107,7 +108,11 @@
  * does modifications on it.
  *
  * End of dynamic topology and symmetrize in this mode are handled in a special
- * manner as well. */
+ * manner as well.
+ *
+ * Once an undo step is finished, the coordinates, mask and color arrays of its nodes are
+ * compressed by background tasks. They are decompressed right before the step is restored, and
+ * compressed again afterwards. */
 
 typedef struct UndoSculpt {
   ListBase nodes;
@@ -116,6 +121,7 @@ typedef struct UndoSculpt {
 } UndoSculpt;
 
 static UndoSculpt *sculpt_undo_get_nodes(void);
+static void sculpt_undo_pack_finish(void);
 
 static void update_cb(PBVHNode *node, void *rebuild)
 {
@@ -885,6 +891,12 @@ static void sculpt_undo_free_list(ListBase *lb)
     if (unode->mask) {
       MEM_freeN(unode->mask);
     }
+    if (unode->col) {
+      MEM_freeN(unode->col);
+    }
+    if (unode->packed.data) {
+      MEM_freeN(unode->packed.data);
+    }
 
     if (unode->bm_entry) {
       BM_log_entry_drop(unode->bm_entry);
@@ -1414,6 +1426,9 @@ void SCULPT_undo_push_end_ex(const bool use_nested_undo)
     }
   }
 
+  /* Have the size of the previously compressed steps up to date for the memory limit. */
+  sculpt_undo_pack_finish();
+
   /* We could remove this and enforce all callers run in an operator using 'OPTYPE_UNDO'. */
   wmWindowManager *wm = G_MAIN->wm.first;
   if (wm->op_undo_depth == 0 || use_nested_undo) {
@@ -1436,6 +1451,274 @@ typedef struct SculptUndoStep {
   UndoSculpt data;
 } SculptUndoStep;
 
+/* -------------------------------------------------------------------- */
+/** \name Undo Node Compression
+ *
+ * The float arrays are transformed before compression: every 32 bit word is stored as a
+ * difference to the same component of the previous element, and the result is split into byte
+ * planes. Neighboring vertices of a PBVH node have close values, so this leaves long runs of
+ * similar high bytes which compress well.
+ * \{ */
+
+enum {
+  SCULPT_UNDO_PACKED_CO = (1 << 0),
+  SCULPT_UNDO_PACKED_ORIG_CO = (1 << 1),
+  SCULPT_UNDO_PACKED_COL = (1 << 2),
+  SCULPT_UNDO_PACKED_MASK = (1 << 3),
+};
+
+typedef struct SculptUndoPackedLayer {
+  int flag;
+  /* Number of floats per element. */
+  int elem_words;
+} SculptUndoPackedLayer;
+
+static const SculptUndoPackedLayer sculpt_undo_packed_layers[] = {
+    {SCULPT_UNDO_PACKED_CO, 3},
+    {SCULPT_UNDO_PACKED_ORIG_CO, 3},
+    {SCULPT_UNDO_PACKED_COL, 4},
+    {SCULPT_UNDO_PACKED_MASK, 1},
+};
+
+static float **sculpt_undo_packed_layer_ptr(SculptUndoNode *unode, int flag)
+{
+  switch (flag) {
+    case SCULPT_UNDO_PACKED_CO:
+      return (float **)&unode->co;
+    case SCULPT_UNDO_PACKED_ORIG_CO:
+      return (float **)&unode->orig_co;
+    case SCULPT_UNDO_PACKED_COL:
+      return (float **)&unode->col;
+    case SCULPT_UNDO_PACKED_MASK:
+      return &unode->mask;
+  }
+  BLI_assert_unreachable();
+  return NULL;
+}
+
+static void sculpt_undo_pack_transform(const uint32_t *src,
+                                       const size_t totword,
+                                       const int elem_words,
+                                       uchar *dst)
+{
+  for (size_t i = 0; i < totword; i++) {
+    const uint32_t word = (i < (size_t)elem_words) ? src[i] : src[i] - src[i - elem_words];
+    dst[i] = (uchar)word;
+    dst[totword + i] = (uchar)(word >> 8);
+    dst[totword * 2 + i] = (uchar)(word >> 16);
+    dst[totword * 3 + i] = (uchar)(word >> 24);
+  }
+}
+
+static void sculpt_undo_unpack_transform(const uchar *src,
+                                         const size_t totword,
+                                         const int elem_words,
+                                         uint32_t *dst)
+{
+  for (size_t i = 0; i < totword; i++) {
+    const uint32_t word = (uint32_t)src[i] | ((uint32_t)src[totword + i] << 8) |
+                          ((uint32_t)src[totword * 2 + i] << 16) |
+                          ((uint32_t)src[totword * 3 + i] << 24);
+    dst[i] = (i < (size_t)elem_words) ? word : word + dst[i - elem_words];
+  }
+}
+
+/* Compress the float arrays of the node. Does not touch the undo step, so it can run in a
+ * background task. */
+static void sculpt_undo_node_pack(SculptUndoNode *unode)
+{
+  BLI_assert(unode->packed.data == NULL);
+  if (!ELEM(unode->type, SCULPT_UNDO_COORDS, SCULPT_UNDO_MASK, SCULPT_UNDO_COLOR)) {
+    return;
+  }
+
+  const int allvert = unode->maxgrid ? unode->totgrid * unode->gridsize * unode->gridsize :
+                                       (unode->index ? (int)(MEM_allocN_len(unode->index) /
+                                                             sizeof(*unode->index)) :
+                                                       0);
+  int layers = 0;
+  size_t raw_size = 0;
+  for (int i = 0; i < ARRAY_SIZE(sculpt_undo_packed_layers); i++) {
+    const SculptUndoPackedLayer *layer = &sculpt_undo_packed_layers[i];
+    const float *data = *sculpt_undo_packed_layer_ptr(unode, layer->flag);
+    if (data != NULL) {
+      BLI_assert(MEM_allocN_len(data) == sizeof(float) * layer->elem_words * (size_t)allvert);
+      layers |= layer->flag;
+      raw_size += sizeof(float) * layer->elem_words * (size_t)allvert;
+    }
+  }
+  if (raw_size == 0) {
+    return;
+  }
+
+  uchar *raw = MEM_mallocN(raw_size, __func__);
+  size_t offset = 0;
+  for (int i = 0; i < ARRAY_SIZE(sculpt_undo_packed_layers); i++) {
+    const SculptUndoPackedLayer *layer = &sculpt_undo_packed_layers[i];
+    if (layers & layer->flag) {
+      const size_t totword = (size_t)layer->elem_words * (size_t)allvert;
+      const float *data = *sculpt_undo_packed_layer_ptr(unode, layer->flag);
+      sculpt_undo_pack_transform((const uint32_t *)data, totword, layer->elem_words, raw + offset);
+      offset += sizeof(float) * totword;
+    }
+  }
+
+  uLongf packed_size = compressBound((uLong)raw_size);
+  void *packed = MEM_mallocN(packed_size, "SculptUndoNode.packed");
+  if (compress2(packed, &packed_size, raw, (uLong)raw_size, Z_BEST_SPEED) != Z_OK ||
+      packed_size >= raw_size) {
+    /* Not worth it, keep the data as it is. */
+    MEM_freeN(packed);
+    MEM_freeN(raw);
+    return;
+  }
+  MEM_freeN(raw);
+
+  for (int i = 0; i < ARRAY_SIZE(sculpt_undo_packed_layers); i++) {
+    float **data_p = sculpt_undo_packed_layer_ptr(unode, sculpt_undo_packed_layers[i].flag);
+    MEM_SAFE_FREE(*data_p);
+  }
+
+  unode->packed.data = MEM_reallocN(packed, packed_size);
+  unode->packed.size = packed_size;
+  unode->packed.raw_size = raw_size;
+  unode->packed.allvert = allvert;
+  unode->packed.layers = layers;
+  unode->packed.is_accounted = false;
+}
+
+static void sculpt_undo_node_unpack(SculptUndoNode *unode)
+{
+  if (unode->packed.data == NULL) {
+    return;
+  }
+
+  uchar *raw = MEM_mallocN(unode->packed.raw_size, __func__);
+  uLongf raw_size = (uLongf)unode->packed.raw_size;
+  const int result = uncompress(raw, &raw_size, unode->packed.data, (uLong)unode->packed.size);
+  BLI_assert(result == Z_OK && raw_size == unode->packed.raw_size);
+  UNUSED_VARS_NDEBUG(result);
+
+  size_t offset = 0;
+  for (int i = 0; i < ARRAY_SIZE(sculpt_undo_packed_layers); i++) {
+    const SculptUndoPackedLayer *layer = &sculpt_undo_packed_layers[i];
+    if (unode->packed.layers & layer->flag) {
+      const size_t totword = (size_t)layer->elem_words * (size_t)unode->packed.allvert;
+      float *data = MEM_mallocN(sizeof(float) * totword, __func__);
+      sculpt_undo_unpack_transform(raw + offset, totword, layer->elem_words, (uint32_t *)data);
+      *sculpt_undo_packed_layer_ptr(unode, layer->flag) = data;
+      offset += sizeof(float) * totword;
+    }
+  }
+  MEM_freeN(raw);
+
+  MEM_freeN(unode->packed.data);
+  unode->packed.data = NULL;
+}
+
+/* Steps which have their nodes compressed by the background tasks. */
+static struct {
+  TaskPool *task_pool;
+  ListBase steps;
+} sculpt_undo_pack = {NULL, {NULL, NULL}};
+
+static void sculpt_undo_node_pack_task(TaskPool *__restrict UNUSED(pool), void *taskdata)
+{
+  sculpt_undo_node_pack(taskdata);
+}
+
+/* Start compressing the nodes of the step in the background. */
+static void sculpt_undo_pack_step(SculptUndoStep *us)
+{
+  BLI_assert(BLI_thread_is_main());
+  bool has_packed_nodes = false;
+  LISTBASE_FOREACH (SculptUndoNode *, unode, &us->data.nodes) {
+    if (unode->packed.data != NULL ||
+        !ELEM(unode->type, SCULPT_UNDO_COORDS, SCULPT_UNDO_MASK, SCULPT_UNDO_COLOR)) {
+      continue;
+    }
+    if (sculpt_undo_pack.task_pool == NULL) {
+      sculpt_undo_pack.task_pool = BLI_task_pool_create_background(NULL, TASK_PRIORITY_LOW);
+    }
+    BLI_task_pool_push(sculpt_undo_pack.task_pool, sculpt_undo_node_pack_task, unode, false, NULL);
+    has_packed_nodes = true;
+  }
+  if (has_packed_nodes) {
+    BLI_addtail(&sculpt_undo_pack.steps, BLI_genericNodeN(us));
+  }
+}
+
+static bool sculpt_undo_pack_is_pending(const SculptUndoStep *us)
+{
+  return BLI_findptr(&sculpt_undo_pack.steps, us, offsetof(LinkData, data)) != NULL;
+}
+
+/* Wait for the background compression to finish, and update the size of the compressed steps.
+ * Is to be called before accessing nodes of a finished step. */
+static void sculpt_undo_pack_finish(void)
+{
+  if (sculpt_undo_pack.task_pool == NULL) {
+    return;
+  }
+  BLI_assert(BLI_thread_is_main());
+  BLI_task_pool_work_and_wait(sculpt_undo_pack.task_pool);
+  BLI_task_pool_free(sculpt_undo_pack.task_pool);
+  sculpt_undo_pack.task_pool = NULL;
+
+  LISTBASE_FOREACH (LinkData *, link, &sculpt_undo_pack.steps) {
+    SculptUndoStep *us = link->data;
+    LISTBASE_FOREACH (SculptUndoNode *, unode, &us->data.nodes) {
+      if (unode->packed.data != NULL && !unode->packed.is_accounted) {
+        us->data.undo_size -= unode->packed.raw_size - unode->packed.size;
+        unode->packed.is_accounted = true;
+      }
+    }
+    us->step.data_size = us->data.undo_size;
+  }
+  BLI_freelistN(&sculpt_undo_pack.steps);
+}
+
+typedef struct SculptUndoUnpackData {
+  SculptUndoNode **nodes;
+} SculptUndoUnpackData;
+
+static void sculpt_undo_unpack_task_cb(void *__restrict userdata,
+                                       const int i,
+                                       const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SculptUndoUnpackData *data = userdata;
+  sculpt_undo_node_unpack(data->nodes[i]);
+}
+
+/* Decompress all nodes of the step, so it can be restored. */
+static void sculpt_undo_unpack_step(SculptUndoStep *us)
+{
+  if (sculpt_undo_pack_is_pending(us)) {
+    sculpt_undo_pack_finish();
+  }
+
+  const int totnode = BLI_listbase_count(&us->data.nodes);
+  SculptUndoUnpackData data = {
+      .nodes = MEM_malloc_arrayN(totnode, sizeof(SculptUndoNode *), __func__),
+  };
+  int totpacked = 0;
+  LISTBASE_FOREACH (SculptUndoNode *, unode, &us->data.nodes) {
+    if (unode->packed.data != NULL) {
+      data.nodes[totpacked++] = unode;
+      us->data.undo_size += unode->packed.raw_size - unode->packed.size;
+    }
+  }
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  BLI_task_parallel_range(0, totpacked, &data, sculpt_undo_unpack_task_cb, &settings);
+
+  MEM_freeN(data.nodes);
+  us->step.data_size = us->data.undo_size;
+}
+
+/** \} */
+
 static void sculpt_undosys_step_encode_init(struct bContext *UNUSED(C), UndoStep *us_p)
 {
   SculptUndoStep *us = (SculptUndoStep *)us_p;
@@ -1452,6 +1735,8 @@ static bool sculpt_undosys_step_encode(struct bContext *UNUSED(C),
   SculptUndoStep *us = (SculptUndoStep *)us_p;
   us->step.data_size = us->data.undo_size;
 
+  sculpt_undo_pack_step(us);
+
   SculptUndoNode *unode = us->data.nodes.last;
   if (unode && unode->type == SCULPT_UNDO_DYNTOPO_END) {
     us->step.use_memfile_step = true;
@@ -1470,7 +1755,9 @@ static void sculpt_undosys_step_decode_undo_impl(struct bContext *C,
                                                  SculptUndoStep *us)
 {
   BLI_assert(us->step.is_applied == true);
+  sculpt_undo_unpack_step(us);
   sculpt_undo_restore_list(C, depsgraph, &us->data.nodes);
+  sculpt_undo_pack_step(us);
   us->step.is_applied = false;
 }
 
@@ -1479,7 +1766,9 @@ static void sculpt_undosys_step_decode_redo_impl(struct bContext *C,
                                                  SculptUndoStep *us)
 {
   BLI_assert(us->step.is_applied == false);
+  sculpt_undo_unpack_step(us);
   sculpt_undo_restore_list(C, depsgraph, &us->data.nodes);
+  sculpt_undo_pack_step(us);
   us->step.is_applied = true;
 }
 
@@ -1583,6 +1872,9 @@ static void sculpt_undosys_step_decode(
 static void sculpt_undosys_step_free(UndoStep *us_p)
 {
   SculptUndoStep *us = (SculptUndoStep *)us_p;
+  if (sculpt_undo_pack_is_pending(us)) {
+    sculpt_undo_pack_finish();
+  }
   sculpt_undo_free_list(&us->data.nodes);
 }
 
@@ -1629,6 +1921,10 @@ static UndoSculpt *sculpt_undo_get_nodes(void)
 {
   UndoStack *ustack = ED_undo_stack_get();
   UndoStep *us = BKE_undosys_stack_init_or_active_with_type(ustack, BKE_UNDOSYS_TYPE_SCULPT);
+  if (us != NULL && us != ustack->step_init && BLI_thread_is_main()) {
+    /* Nodes of a finished step are accessed, make sure they are not compressed. */
+    sculpt_undo_unpack_step((SculptUndoStep *)us);
+  }
   return sculpt_undosys_step_get_nodes(us);
 }
 
@@ -1494,6 +1494,62 @@ static void node_add_error_message_button(
   UI_block_emboss_set(node.block, UI_EMBOSS);
 }
 
+static std::optional<std::chrono::microseconds> node_get_execution_time(const SpaceNode &snode,
+                                                                       const bNode &node)
+{
+  const geo_log::TreeLog *tree_log = geo_log::ModifierLog::find_tree_by_node_editor_context(snode);
+  if (tree_log == nullptr) {
+    return std::nullopt;
+  }
+  if (node.type == NODE_GROUP) {
+    /* The time of a group node is the time of all the nodes inside of it. */
+    const geo_log::TreeLog *child_log = tree_log->lookup_child_log(node.name);
+    if (child_log == nullptr) {
+      return std::nullopt;
+    }
+    return child_log->execution_time();
+  }
+  const geo_log::NodeLog *node_log = tree_log->lookup_node_log(node);
+  if (node_log == nullptr || node_log->execution_count() == 0) {
+    return std::nullopt;
+  }
+  return node_log->execution_time();
+}
+
+static void node_draw_execution_time(const SpaceNode &snode, bNode &node, const rctf &rect)
+{
+  if ((snode.flag & SNODE_SHOW_TIMINGS) == 0) {
+    return;
+  }
+  const std::optional<std::chrono::microseconds> exec_time = node_get_execution_time(snode, node);
+  if (!exec_time.has_value()) {
+    return;
+  }
+
+  char label[32];
+  if (exec_time->count() < 100) {
+    BLI_strncpy(label, "< 0.1 ms", sizeof(label));
+  }
+  else {
+    BLI_snprintf(label, sizeof(label), "%.1f ms", exec_time->count() / 1000.0);
+  }
+
+  uiDefBut(node.block,
+           UI_BTYPE_LABEL,
+           0,
+           label,
+           rect.xmin,
+           rect.ymax,
+           BLI_rctf_size_x(&rect),
+           UI_UNIT_Y,
+           nullptr,
+           0,
+           0,
+           0,
+           0,
+           nullptr);
+}
+
 static void node_draw_basis(const bContext *C,
                             const View2D *v2d,
                             const SpaceNode *snode,
@@ -1747,6 +1803,8 @@ static void node_draw_basis(const bContext *C,
     }
   }
 
+  node_draw_execution_time(*snode, *node, *rct);
+
   UI_block_end(C, node->block);
   UI_block_draw(C, node->block);
   node->block = nullptr;
@@ -1899,6 +1957,8 @@ static void node_draw_hidden(const bContext *C,
 
   node_draw_sockets(v2d, C, ntree, node, true, false);
 
+  node_draw_execution_time(*snode, *node, *rct);
+
   UI_block_end(C, node->block);
   UI_block_draw(C, node->block);
   node->block = nullptr;
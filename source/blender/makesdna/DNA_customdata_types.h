@@ -53,6 +53,12 @@ typedef struct CustomDataLayer {
   char name[64];
   /** Layer data. */
   void *data;
+  /**
+   * Run-time owner of #data when it is shared with layers of other custom data (see #CD_SHARE).
+   * Shared layers are flagged with #CD_FLAG_NOFREE as well. Not written to files, it is cleared
+   * when writing and reading.
+   */
+  struct CustomDataSharedLayer *shared;
 } CustomDataLayer;
 
 #define MAX_CUSTOMDATA_LAYER_NAME 64
@@ -86,7 +86,8 @@ typedef struct Mesh_Runtime {
   void *batch_cache;
 
   struct SubdivCCG *subdiv_ccg;
-  void *_pad1;
+  /** Vertex group weights in a compact layout, see #BKE_mesh_runtime_deform_weights_ensure. */
+  struct DeformWeightsCSR *deform_weights;
   int subdiv_ccg_tot_level;
   char _pad2[4];
 
@@ -103,6 +104,13 @@ typedef struct Mesh_Runtime {
   /** Non-manifold boundary data for Shrinkwrap Target Project. */
   struct ShrinkwrapBoundaryData *shrinkwrap_data;
 
+  /**
+   * Bitmap of vertices whose normals are outdated while the other normals are still valid.
+   * Only used when `cd_dirty_vert` doesn't contain #CD_MASK_NORMAL,
+   * see #BKE_mesh_vert_normal_tag_dirty.
+   */
+  unsigned int *normals_dirty_verts;
+
   /** Set by modifier stack if only deformed from original. */
   char deformed_only;
   /**
@@ -122,11 +130,23 @@ typedef struct Mesh_Runtime {
    */
   char wrapper_type_finalize;
 
-  char _pad[4];
+  /**
+   * Vertex normals were computed for the current positions, so that moved vertices can be
+   * updated partially (see #BKE_mesh_vert_coords_apply). This is not the case for new meshes
+   * which never had their normals computed, even when `cd_dirty_vert` is clear.
+   */
+  char vert_normals_known_valid;
+
+  char _pad[3];
 
   /** Needed in case we need to lazily initialize the mesh. */
   CustomData_MeshMasks cd_mask_extra;
 
+  /**
+   * Identifies the content of the mesh, see #BKE_mesh_runtime_content_version. Copies that only
+   * reference the layers of the source keep its version, all other meshes get a new one.
+   */
+  uint64_t content_version;
 } Mesh_Runtime;
 
 typedef struct Mesh {
@@ -2259,6 +2259,9 @@ typedef struct NodesModifierData {
   /* Contains logged information from the last evaluation. This can be used to help the user to
    * debug a node tree. */
   void *runtime_eval_log;
+  /* Outputs of nodes from previous evaluations that can be reused when their inputs did not
+   * change. Only used on the original modifier. */
+  void *runtime_output_cache;
 } NodesModifierData;
 
 typedef struct MeshToVolumeModifierData {
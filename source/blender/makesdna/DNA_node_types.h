@@ -1880,6 +1880,12 @@ typedef enum GeometryNodePointDistributeMode {
   GEO_NODE_POINT_DISTRIBUTE_POISSON = 1,
 } GeometryNodePointDistributeMode;
 
+/* Point Distribute node custom2. */
+typedef enum GeometryNodePointDistributeFlag {
+  /** Eliminate close points in the order they were generated, like before 3.0. */
+  GEO_NODE_POINT_DISTRIBUTE_LEGACY_ORDER = (1 << 0),
+} GeometryNodePointDistributeFlag;
+
 typedef enum GeometryNodeRotatePointsType {
   GEO_NODE_POINT_ROTATE_TYPE_EULER = 0,
   GEO_NODE_POINT_ROTATE_TYPE_AXIS_ANGLE = 1,
@@ -27,6 +27,13 @@
 extern "C" {
 #endif
 
+typedef struct PointCloud_Runtime {
+  /** Cache of BVH trees built from the points, see #BKE_bvhtree_from_pointcloud_get. */
+  struct BVHCache *bvh_cache;
+  /** Protects lazy creation of the BVH cache, #ThreadMutex. */
+  void *eval_mutex;
+} PointCloud_Runtime;
+
 typedef struct PointCloud {
   ID id;
   struct AnimData *adt; /* animation data (must be immediately after id) */
@@ -52,6 +59,9 @@ typedef struct PointCloud {
 
   /* Draw Cache */
   void *batch_cache;
+
+  /** Runtime data, not written to files. */
+  PointCloud_Runtime runtime;
 } PointCloud;
 
 /* PointCloud.flag */
@@ -209,6 +209,9 @@ static void rna_Attribute_data_begin(CollectionPropertyIterator *iter, PointerRN
   ID *id = ptr->owner_id;
   CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
 
+  /* The data can be modified through the iterator. */
+  BKE_id_attribute_ensure_unshared(id, layer);
+
   int length = BKE_id_attribute_data_length(id, layer);
   size_t struct_size;
 
@@ -252,6 +252,21 @@ static void rna_Depsgraph_debug_stats_gnuplot(Depsgraph *depsgraph,
   fclose(f);
 }
 
+static void rna_Depsgraph_debug_trace_start(int num_evaluations)
+{
+  DEG_debug_trace_start(num_evaluations);
+}
+
+static void rna_Depsgraph_debug_trace_stop(void)
+{
+  DEG_debug_trace_stop();
+}
+
+static bool rna_Depsgraph_debug_trace_write(const char *filepath)
+{
+  return DEG_debug_trace_write(filepath);
+}
+
 static void rna_Depsgraph_debug_tag_update(Depsgraph *depsgraph)
 {
   DEG_graph_tag_relations_update(depsgraph);
@@ -665,6 +680,37 @@ static void rna_def_depsgraph(BlenderRNA *brna)
                                   "File name where gnuplot script will save the result");
   RNA_def_parameter_flags(parm, 0, PARM_REQUIRED);
 
+  func = RNA_def_function(srna, "debug_trace_start", "rna_Depsgraph_debug_trace_start");
+  RNA_def_function_ui_description(func,
+                                  "Start recording timeline of operations evaluated by all "
+                                  "dependency graphs, discarding previously recorded timeline");
+  RNA_def_function_flag(func, FUNC_NO_SELF);
+  RNA_def_int(func,
+              "num_evaluations",
+              0,
+              0,
+              INT_MAX,
+              "Number of Evaluations",
+              "Stop recording after this number of graph evaluations, 0 to record until stopped",
+              0,
+              INT_MAX);
+
+  func = RNA_def_function(srna, "debug_trace_stop", "rna_Depsgraph_debug_trace_stop");
+  RNA_def_function_ui_description(func, "Stop recording evaluation timeline");
+  RNA_def_function_flag(func, FUNC_NO_SELF);
+
+  func = RNA_def_function(srna, "debug_trace_write", "rna_Depsgraph_debug_trace_write");
+  RNA_def_function_ui_description(func,
+                                  "Write recorded evaluation timeline, as comma separated values "
+                                  "for files with '.csv' extension, and as Chrome trace JSON "
+                                  "otherwise");
+  RNA_def_function_flag(func, FUNC_NO_SELF);
+  parm = RNA_def_string_file_path(
+      func, "filepath", NULL, FILE_MAX, "File Path", "Output path for the timeline");
+  RNA_def_parameter_flags(parm, 0, PARM_REQUIRED);
+  parm = RNA_def_boolean(func, "result", false, "Result", "True if the file was written");
+  RNA_def_function_return(func, parm);
+
   func = RNA_def_function(srna, "debug_tag_update", "rna_Depsgraph_debug_tag_update");
 
   func = RNA_def_function(srna, "debug_stats", "rna_Depsgraph_debug_stats");
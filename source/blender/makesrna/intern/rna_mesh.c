@@ -67,6 +67,7 @@ static const EnumPropertyItem rna_enum_mesh_remesh_mode_items[] = {
 
 #  include "BLI_math.h"
 
+#  include "BKE_attribute.h"
 #  include "BKE_customdata.h"
 #  include "BKE_main.h"
 #  include "BKE_mesh.h"
@@ -716,6 +717,10 @@ static void rna_MeshUVLoopLayer_data_begin(CollectionPropertyIterator *iter, Poi
 {
   Mesh *me = rna_mesh(ptr);
   CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+  if (me->edit_mesh == NULL) {
+    /* The data can be modified through the iterator. */
+    BKE_id_attribute_ensure_unshared(&me->id, layer);
+  }
   rna_iterator_array_begin(
       iter, layer->data, sizeof(MLoopUV), (me->edit_mesh) ? 0 : me->totloop, 0, NULL);
 }
@@ -1621,6 +1621,11 @@ static void rna_NodesModifier_node_group_update(Main *bmain, Scene *scene, Point
   MOD_nodes_update_interface(object, nmd);
 }
 
+static float rna_NodesModifier_node_execution_time(NodesModifierData *nmd, const char *node_path)
+{
+  return MOD_nodes_node_execution_time(nmd, node_path);
+}
+
 static IDProperty **rna_NodesModifier_properties(PointerRNA *ptr)
 {
   NodesModifierData *nmd = ptr->data;
@@ -6993,6 +6998,8 @@ static void rna_def_modifier_nodes(BlenderRNA *brna)
 {
   StructRNA *srna;
   PropertyRNA *prop;
+  FunctionRNA *func;
+  PropertyRNA *parm;
 
   srna = RNA_def_struct(brna, "NodesModifier", "Modifier");
   RNA_def_struct_ui_text(srna, "Nodes Modifier", "");
@@ -7009,6 +7016,19 @@ static void rna_def_modifier_nodes(BlenderRNA *brna)
   RNA_def_property_update(prop, 0, "rna_NodesModifier_node_group_update");
 
   RNA_define_lib_overridable(false);
+
+  func = RNA_def_function(srna, "node_execution_time", "rna_NodesModifier_node_execution_time");
+  RNA_def_function_ui_description(
+      func, "Time in seconds that a node took to execute in the last evaluation of the modifier");
+  parm = RNA_def_string(func,
+                        "node_path",
+                        NULL,
+                        0,
+                        "Node Path",
+                        "Name of the node, nodes in nested groups are separated by a slash");
+  RNA_def_parameter_flags(parm, 0, PARM_REQUIRED);
+  parm = RNA_def_float(func, "time", 0.0f, 0.0f, FLT_MAX, "", "Execution time", 0.0f, FLT_MAX);
+  RNA_def_function_return(func, parm);
 }
 
 static void rna_def_modifier_mesh_to_volume(BlenderRNA *brna)
@@ -28,6 +28,13 @@ void MOD_nodes_update_interface(struct Object *object, struct NodesModifierData
 
 void MOD_nodes_init(struct Main *bmain, struct NodesModifierData *nmd);
 
+/**
+ * Time in seconds that the node at the given path took to execute in the last evaluation. Nodes
+ * in nested groups are referenced with a path like "Group/Node". For group nodes, the time of all
+ * nodes inside of the group is returned.
+ */
+float MOD_nodes_node_execution_time(const struct NodesModifierData *nmd, const char *node_path);
+
 #ifdef __cplusplus
 }
 #endif
@@ -278,7 +278,7 @@ static Mesh *modifyMesh(ModifierData *md, const ModifierEvalContext *ctx, struct
   MEM_freeN(edgeMap);
   MEM_freeN(faceMap);
 
-  if (mesh->runtime.cd_dirty_vert & CD_MASK_NORMAL) {
+  if (BKE_mesh_vert_normals_are_dirty(mesh)) {
     result->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
   }
 
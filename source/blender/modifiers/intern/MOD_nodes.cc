@@ -98,6 +98,7 @@ using blender::StringRefNull;
 using blender::Vector;
 using blender::fn::GMutablePointer;
 using blender::fn::GPointer;
+using blender::modifiers::geometry_nodes::NodeOutputCache;
 using blender::nodes::GeoNodeExecParams;
 using blender::threading::EnumerableThreadSpecific;
 using namespace blender::fn::multi_function_types;
@@ -710,6 +711,38 @@ void MOD_nodes_init(Main *bmain, NodesModifierData *nmd)
   ntreeUpdateTree(bmain, ntree);
 }
 
+float MOD_nodes_node_execution_time(const NodesModifierData *nmd, const char *node_path)
+{
+  if (nmd->runtime_eval_log == nullptr) {
+    return 0.0f;
+  }
+  const geo_log::ModifierLog &log = *static_cast<geo_log::ModifierLog *>(nmd->runtime_eval_log);
+  const geo_log::TreeLog *tree_log = &log.root_tree();
+
+  /* Nodes in nested groups are referenced with a path like "Group/Node". */
+  StringRef remaining_path = node_path;
+  while (true) {
+    const int64_t separator = remaining_path.find('/');
+    if (separator == StringRef::not_found) {
+      break;
+    }
+    tree_log = tree_log->lookup_child_log(remaining_path.substr(0, separator));
+    if (tree_log == nullptr) {
+      return 0.0f;
+    }
+    remaining_path = remaining_path.drop_prefix(separator + 1);
+  }
+
+  std::chrono::microseconds exec_time{0};
+  if (const geo_log::TreeLog *child_log = tree_log->lookup_child_log(remaining_path)) {
+    exec_time = child_log->execution_time();
+  }
+  else if (const geo_log::NodeLog *node_log = tree_log->lookup_node_log(remaining_path)) {
+    exec_time = node_log->execution_time();
+  }
+  return std::chrono::duration<float>(exec_time).count();
+}
+
 static void initialize_group_input(NodesModifierData &nmd,
                                    const bNodeSocket &socket,
                                    const CPPType &cpp_type,
@@ -844,6 +877,34 @@ static void clear_runtime_data(NodesModifierData *nmd)
   }
 }
 
+static void clear_output_cache(NodesModifierData *nmd)
+{
+  if (nmd->runtime_output_cache != nullptr) {
+    delete (NodeOutputCache *)nmd->runtime_output_cache;
+    nmd->runtime_output_cache = nullptr;
+  }
+}
+
+/**
+ * Node outputs are only cached for the active depsgraph, because that is where interactive
+ * changes are made. Other evaluations (e.g. for rendering) would only increase memory usage.
+ */
+static NodeOutputCache *ensure_output_cache(NodesModifierData *nmd,
+                                            const ModifierEvalContext *ctx)
+{
+  if (!DEG_is_active(ctx->depsgraph)) {
+    return nullptr;
+  }
+  if ((ctx->flag & MOD_APPLY_ORCO) != 0) {
+    return nullptr;
+  }
+  NodesModifierData *nmd_orig = (NodesModifierData *)BKE_modifier_get_original(&nmd->modifier);
+  if (nmd_orig->runtime_output_cache == nullptr) {
+    nmd_orig->runtime_output_cache = new NodeOutputCache();
+  }
+  return (NodeOutputCache *)nmd_orig->runtime_output_cache;
+}
+
 /**
  * Evaluate a node group to compute the output geometry.
  * Currently, this uses a fairly basic and inefficient algorithm that might compute things more
@@ -860,6 +921,8 @@ static GeometrySet compute_geometry(const DerivedNodeTree &tree,
   blender::LinearAllocator<> &allocator = scope.linear_allocator();
   blender::nodes::MultiFunctionByNode mf_by_node = get_multi_function_per_node(tree, scope);
 
+  NodeOutputCache *output_cache = ensure_output_cache(nmd, ctx);
+
   Map<DOutputSocket, GMutablePointer> group_inputs;
 
   const DTreeContext *root_context = &tree.root_context();
@@ -914,6 +977,7 @@ static GeometrySet compute_geometry(const DerivedNodeTree &tree,
   eval_params.depsgraph = ctx->depsgraph;
   eval_params.self_object = ctx->object;
   eval_params.geo_logger = geo_logger.has_value() ? &*geo_logger : nullptr;
+  eval_params.output_cache = output_cache;
   blender::modifiers::geometry_nodes::evaluate_geometry_nodes(eval_params);
 
   if (geo_logger.has_value()) {
@@ -1169,6 +1233,7 @@ static void blendRead(BlendDataReader *reader, ModifierData *md)
   BLO_read_data_address(reader, &nmd->settings.properties);
   IDP_BlendDataRead(reader, &nmd->settings.properties);
   nmd->runtime_eval_log = nullptr;
+  nmd->runtime_output_cache = nullptr;
 }
 
 static void copyData(const ModifierData *md, ModifierData *target, const int flag)
@@ -1179,6 +1244,7 @@ static void copyData(const ModifierData *md, ModifierData *target, const int fla
   BKE_modifier_copydata_generic(md, target, flag);
 
   tnmd->runtime_eval_log = nullptr;
+  tnmd->runtime_output_cache = nullptr;
 
   if (nmd->settings.properties != nullptr) {
     tnmd->settings.properties = IDP_CopyProperty_ex(nmd->settings.properties, flag);
@@ -1194,6 +1260,7 @@ static void freeData(ModifierData *md)
   }
 
   clear_runtime_data(nmd);
+  clear_output_cache(nmd);
 }
 
 static void requiredDataMask(Object *UNUSED(ob),
@@ -21,6 +21,11 @@
 
 #include "DEG_depsgraph_query.h"
 
+#include "BKE_attribute_access.hh"
+#include "BKE_mesh_runtime.h"
+
+#include "MEM_guardedalloc.h"
+
 #include "FN_generic_value_map.hh"
 #include "FN_multi_function.hh"
 
@@ -28,6 +33,7 @@
 #include "BLI_stack.hh"
 #include "BLI_task.h"
 #include "BLI_task.hh"
+#include "BLI_timeit.hh"
 #include "BLI_vector_set.hh"
 
 namespace blender::modifiers::geometry_nodes {
@@ -149,6 +155,14 @@ struct OutputState {
    * the output is not needed anymore.
    */
   int potential_users = 0;
+
+  /**
+   * Identifies the geometry computed for this output across evaluations when a #NodeOutputCache
+   * is used. Zero means that the geometry has not been computed by a node and is empty. This is
+   * set before the value is forwarded, so nodes that received the value can read it without a
+   * lock.
+   */
+  uint64_t geometry_stamp = 0;
 };
 
 enum class NodeScheduleState {
@@ -315,6 +329,115 @@ static bool node_supports_laziness(const DNode node)
   return node->typeinfo()->geometry_node_execute_supports_laziness;
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Node Output Cache
+ * \{ */
+
+/**
+ * Nodes that depend on data that is not passed in as an input value can't be cached, because
+ * changes of that data would not be detected.
+ */
+static bool node_outputs_are_cacheable(const DNode node)
+{
+  if (node_supports_laziness(node)) {
+    return false;
+  }
+  /* These nodes depend on the depsgraph, e.g. to load volume grids from files. */
+  if (ELEM(node->bnode()->type,
+           GEO_NODE_IS_VIEWPORT,
+           GEO_NODE_TRANSFORM,
+           GEO_NODE_VOLUME_TO_MESH)) {
+    return false;
+  }
+  for (const InputSocketRef *socket : node->inputs()) {
+    if (!socket->is_available()) {
+      continue;
+    }
+    /* Only the pointers are compared, changes to the referenced data are not detected. */
+    if (ELEM(socket->bsocket()->type, SOCK_OBJECT, SOCK_COLLECTION, SOCK_TEXTURE)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/** The key has to stay the same when the derived node tree is rebuilt. */
+static NodeCacheKey node_cache_key(const DNode node)
+{
+  NodeCacheKey key;
+  for (const DTreeContext *context = node.context(); !context->is_root();
+       context = context->parent_context()) {
+    key.node_names.append(context->parent_node()->name());
+  }
+  std::reverse(key.node_names.begin(), key.node_names.end());
+  key.node_names.append(node->name());
+  return key;
+}
+
+/**
+ * Cached geometries must not reference data that might be freed before the next evaluation
+ * (e.g. the evaluated mesh of another object).
+ */
+static bool value_can_be_cached(const GPointer value)
+{
+  const CPPType &type = *value.type();
+  if (type.is<GeometrySet>()) {
+    for (const GeometryComponent *component : value.get<GeometrySet>()->get_components_for_read()) {
+      if (!component->owns_direct_data()) {
+        return false;
+      }
+    }
+    return true;
+  }
+  return type.is_equality_comparable();
+}
+
+/**
+ * This only has to be a rough estimate. Components that are shared between multiple cached values
+ * are counted multiple times.
+ */
+static int64_t estimate_value_memory(const GPointer value)
+{
+  const CPPType &type = *value.type();
+  if (!type.is<GeometrySet>()) {
+    return type.size();
+  }
+  int64_t memory = sizeof(GeometrySet);
+  for (const GeometryComponent *component : value.get<GeometrySet>()->get_components_for_read()) {
+    component->attribute_foreach(
+        [&](const StringRefNull UNUSED(name), const AttributeMetaData &meta_data) {
+          const CPPType *attribute_type = bke::custom_data_type_to_cpp_type(meta_data.data_type);
+          if (attribute_type != nullptr) {
+            memory += attribute_type->size() * component->attribute_domain_size(meta_data.domain);
+          }
+          return true;
+        });
+    if (component->type() == GEO_COMPONENT_TYPE_INSTANCES) {
+      const InstancesComponent &instances = *static_cast<const InstancesComponent *>(component);
+      memory += instances.instances_amount() * sizeof(float4x4);
+    }
+  }
+  return memory;
+}
+
+static int64_t estimate_entry_memory(const NodeOutputCache::Entry &entry)
+{
+  int64_t memory = sizeof(NodeOutputCache::Entry) + entry.settings.storage.size();
+  for (const CachedValue &value : entry.input_values) {
+    memory += estimate_value_memory(value.get());
+  }
+  memory += entry.input_geometry_stamps.size() * sizeof(uint64_t);
+  for (const std::optional<CachedValue> &value : entry.outputs) {
+    if (value.has_value()) {
+      memory += estimate_value_memory(value->get());
+    }
+  }
+  memory += entry.output_geometry_stamps.size() * sizeof(uint64_t);
+  return memory;
+}
+
+/** \} */
+
 /** Implements the callbacks that might be called when a node is executed. */
 class NodeParamsProvider : public nodes::GeoNodeExecParamsProvider {
  private:
@@ -322,6 +445,12 @@ class NodeParamsProvider : public nodes::GeoNodeExecParamsProvider {
   NodeState &node_state_;
 
  public:
+  /**
+   * When not null, a copy of every output value is stored here before it is forwarded, so that
+   * it can be added to the #NodeOutputCache.
+   */
+  NodeOutputCache::Entry *cache_entry = nullptr;
+
   NodeParamsProvider(GeometryNodesEvaluator &evaluator, DNode dnode, NodeState &node_state);
 
   bool can_get_input(StringRef identifier) const override;
@@ -566,6 +695,12 @@ class GeometryNodesEvaluator {
         value.destruct();
         continue;
       }
+      if (params_.output_cache != nullptr && value.type()->is<GeometrySet>()) {
+        NodeState &node_state = this->get_node_state(node);
+        node_state.outputs[socket->index()].geometry_stamp =
+            params_.output_cache->stamp_input_geometry(socket->index(),
+                                                       *value.get<GeometrySet>());
+      }
       this->forward_output(socket, value);
     }
   }
@@ -646,7 +781,9 @@ class GeometryNodesEvaluator {
     /* Only execute the node if all prerequisites are met. There has to be an output that is
      * required and all required inputs have to be provided already. */
     if (do_execute_node) {
+      const timeit::TimePoint start_time = timeit::Clock::now();
       this->execute_node(node, node_state);
+      this->log_execution_time(node, timeit::Clock::now() - start_time);
     }
 
     this->node_task_postprocessing(node, node_state);
@@ -839,9 +976,157 @@ class GeometryNodesEvaluator {
   {
     const bNode &bnode = *node->bnode();
 
+    if (params_.output_cache != nullptr && node_outputs_are_cacheable(node)) {
+      this->execute_geometry_node_with_cache(node, node_state, *params_.output_cache);
+      return;
+    }
+
+    NodeParamsProvider params_provider{*this, node, node_state};
+    GeoNodeExecParams params{params_provider};
+    bnode.typeinfo->geometry_node_execute(params);
+  }
+
+  /**
+   * Forwards the outputs of a previous execution of the node if its inputs and settings did not
+   * change. Otherwise the node is executed and its outputs are added to the cache.
+   */
+  void execute_geometry_node_with_cache(const DNode node,
+                                        NodeState &node_state,
+                                        NodeOutputCache &cache)
+  {
+    const bNode &bnode = *node->bnode();
+    NodeCacheKey key = node_cache_key(node);
+
+    auto entry = std::make_unique<NodeOutputCache::Entry>(bnode);
+    this->gather_inputs_for_cache(node, node_state, *entry);
+
+    if (cache.lookup(key, *entry) && this->try_forward_cached_outputs(node, node_state, *entry)) {
+      return;
+    }
+    entry->outputs.clear();
+    entry->output_geometry_stamps.clear();
+
     NodeParamsProvider params_provider{*this, node, node_state};
+    params_provider.cache_entry = entry.get();
     GeoNodeExecParams params{params_provider};
     bnode.typeinfo->geometry_node_execute(params);
+
+    /* Warnings are only logged when the node is actually executed. */
+    if (params_provider.has_reported_warning) {
+      return;
+    }
+    for (const CachedValue &value : entry->input_values) {
+      if (!value_can_be_cached(value.get())) {
+        return;
+      }
+    }
+    for (const std::optional<CachedValue> &value : entry->outputs) {
+      if (value.has_value() && !value_can_be_cached(value->get())) {
+        return;
+      }
+    }
+    entry->memory = estimate_entry_memory(*entry);
+    cache.add(std::move(key), std::move(entry));
+  }
+
+  /**
+   * Non-geometry inputs are copied into the entry. For geometry inputs only the stamps are stored,
+   * see #OutputState::geometry_stamp.
+   */
+  void gather_inputs_for_cache(const DNode node,
+                               NodeState &node_state,
+                               NodeOutputCache::Entry &r_entry)
+  {
+    for (const int i : node->inputs().index_range()) {
+      InputState &input_state = node_state.inputs[i];
+      if (input_state.type == nullptr) {
+        continue;
+      }
+      BLI_assert(input_state.was_ready_for_execution);
+      const DInputSocket socket = node.input(i);
+      if (input_state.type->is<GeometrySet>()) {
+        /* Use the same order as #NodeParamsProvider::extract_multi_input. Unlinked geometry
+         * inputs are always empty. */
+        bool is_linked = false;
+        socket.foreach_origin_socket([&](DSocket origin) {
+          r_entry.input_geometry_stamps.append(this->get_geometry_stamp(origin));
+          is_linked = true;
+        });
+        if (!is_linked) {
+          r_entry.input_geometry_stamps.append(0);
+        }
+        continue;
+      }
+      if (!socket->is_multi_input_socket()) {
+        r_entry.input_values.append_as(*input_state.type, input_state.value.single->value);
+        continue;
+      }
+      MultiInputValue &multi_value = *input_state.value.multi;
+      Vector<const void *> values;
+      socket.foreach_origin_socket([&](DSocket origin) {
+        for (const MultiInputValueItem &item : multi_value.items) {
+          if (item.origin == origin && !values.contains(item.value)) {
+            values.append(item.value);
+            return;
+          }
+        }
+      });
+      if (values.is_empty()) {
+        values.append(multi_value.items[0].value);
+      }
+      for (const void *value : values) {
+        r_entry.input_values.append_as(*input_state.type, value);
+      }
+    }
+  }
+
+  /**
+   * The origin has computed and forwarded its geometry already, so the stamp can be read without a
+   * lock.
+   */
+  uint64_t get_geometry_stamp(const DSocket origin)
+  {
+    if (origin->is_input()) {
+      return 0;
+    }
+    const NodeState &origin_state = this->get_node_state(origin.node());
+    return origin_state.outputs[origin->index()].geometry_stamp;
+  }
+
+  bool try_forward_cached_outputs(const DNode node,
+                                  NodeState &node_state,
+                                  const NodeOutputCache::Entry &entry)
+  {
+    /* All outputs that might be used have to be in the cache. */
+    for (const int i : node->outputs().index_range()) {
+      const OutputState &output_state = node_state.outputs[i];
+      if (output_state.has_been_computed || !node->output(i).is_available()) {
+        continue;
+      }
+      if (output_state.output_usage_for_execution == ValueUsage::Unused) {
+        continue;
+      }
+      if (i >= entry.outputs.size() || !entry.outputs[i].has_value()) {
+        return false;
+      }
+    }
+
+    LinearAllocator<> &allocator = local_allocators_.local();
+    for (const int i : node->outputs().index_range()) {
+      OutputState &output_state = node_state.outputs[i];
+      if (output_state.has_been_computed || i >= entry.outputs.size() ||
+          !entry.outputs[i].has_value()) {
+        continue;
+      }
+      const GPointer cached_value = entry.outputs[i]->get();
+      const CPPType &type = *cached_value.type();
+      void *buffer = allocator.allocate(type.size(), type.alignment());
+      type.copy_construct(cached_value.get(), buffer);
+      output_state.geometry_stamp = entry.output_geometry_stamps[i];
+      this->forward_output(node.output(i), {type, buffer});
+      output_state.has_been_computed = true;
+    }
+    return true;
   }
 
   void execute_multi_function_node(const DNode node,
@@ -1412,6 +1697,15 @@ class GeometryNodesEvaluator {
     params_.geo_logger->local().log_value_for_sockets(sockets, value);
   }
 
+  void log_execution_time(const DNode node, const timeit::Nanoseconds exec_time)
+  {
+    if (params_.geo_logger == nullptr) {
+      return;
+    }
+    params_.geo_logger->local().log_execution_time(
+        node, std::chrono::duration_cast<std::chrono::microseconds>(exec_time));
+  }
+
   /* In most cases when `NodeState` is accessed, the node has to be locked first to avoid race
    * conditions. */
   template<typename Function>
@@ -1550,6 +1844,12 @@ void NodeParamsProvider::set_output(StringRef identifier, GMutablePointer value)
 
   OutputState &output_state = node_state_.outputs[socket->index()];
   BLI_assert(!output_state.has_been_computed);
+  if (evaluator_.params_.output_cache != nullptr && value.type()->is<GeometrySet>()) {
+    output_state.geometry_stamp = evaluator_.params_.output_cache->new_geometry_stamp();
+  }
+  if (cache_entry != nullptr) {
+    cache_entry->add_output(socket->index(), value, output_state.geometry_stamp);
+  }
   evaluator_.forward_output(socket, value);
   output_state.has_been_computed = true;
 }
@@ -1605,10 +1905,251 @@ bool NodeParamsProvider::lazy_output_is_required(StringRef identifier) const
   return output_state.output_usage_for_execution == ValueUsage::Required;
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Node Output Cache
+ * \{ */
+
+CachedValue::CachedValue(const CPPType &type, const void *value) : type_(&type)
+{
+  buffer_ = MEM_mallocN_aligned(type.size(), type.alignment(), __func__);
+  type.copy_construct(value, buffer_);
+}
+
+CachedValue::CachedValue(CachedValue &&other) noexcept
+    : type_(other.type_), buffer_(other.buffer_)
+{
+  other.buffer_ = nullptr;
+}
+
+CachedValue::~CachedValue()
+{
+  if (buffer_ != nullptr) {
+    type_->destruct(buffer_);
+    MEM_freeN(buffer_);
+  }
+}
+
+CachedNodeSettings::CachedNodeSettings(const bNode &bnode)
+    : typeinfo(bnode.typeinfo),
+      custom1(bnode.custom1),
+      custom2(bnode.custom2),
+      custom3(bnode.custom3),
+      custom4(bnode.custom4),
+      id(bnode.id)
+{
+  if (bnode.storage != nullptr) {
+    const char *storage_data = static_cast<const char *>(bnode.storage);
+    storage.extend(Span<char>(storage_data, MEM_allocN_len(bnode.storage)));
+  }
+}
+
+bool operator==(const CachedNodeSettings &a, const CachedNodeSettings &b)
+{
+  return a.typeinfo == b.typeinfo && a.custom1 == b.custom1 && a.custom2 == b.custom2 &&
+         a.custom3 == b.custom3 && a.custom4 == b.custom4 && a.id == b.id &&
+         a.storage.as_span() == b.storage.as_span();
+}
+
+uint64_t NodeCacheKey::hash() const
+{
+  uint64_t hash = 0;
+  for (const std::string &name : node_names) {
+    hash = hash * 33 ^ get_default_hash(name);
+  }
+  return hash;
+}
+
+bool NodeOutputCache::Entry::has_same_inputs(const Entry &other) const
+{
+  if (!(settings == other.settings)) {
+    return false;
+  }
+  if (input_geometry_stamps.as_span() != other.input_geometry_stamps.as_span()) {
+    return false;
+  }
+  if (input_values.size() != other.input_values.size()) {
+    return false;
+  }
+  for (const int i : input_values.index_range()) {
+    const GPointer a = input_values[i].get();
+    const GPointer b = other.input_values[i].get();
+    if (*a.type() != *b.type() || !a.type()->is_equal_or_false(a.get(), b.get())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void NodeOutputCache::Entry::add_output(const int index,
+                                        const GPointer value,
+                                        const uint64_t geometry_stamp)
+{
+  if (outputs.size() <= index) {
+    outputs.resize(index + 1);
+    output_geometry_stamps.resize(index + 1, 0);
+  }
+  outputs[index].emplace(*value.type(), value.get());
+  output_geometry_stamps[index] = geometry_stamp;
+}
+
+/**
+ * Returns a number that identifies the content of the geometry, or none when it is unknown. Only
+ * meshes are supported, because they are what is typically passed into the modifier.
+ */
+static std::optional<uint64_t> geometry_content_version(const GeometrySet &geometry_set)
+{
+  for (const GeometryComponentType type : {GEO_COMPONENT_TYPE_INSTANCES,
+                                           GEO_COMPONENT_TYPE_VOLUME,
+                                           GEO_COMPONENT_TYPE_CURVE,
+                                           GEO_COMPONENT_TYPE_POINT_CLOUD}) {
+    if (geometry_set.has(type)) {
+      return std::nullopt;
+    }
+  }
+  const Mesh *mesh = geometry_set.get_mesh_for_read();
+  if (mesh == nullptr) {
+    return 0;
+  }
+  const uint64_t version = BKE_mesh_runtime_content_version(mesh);
+  if (version == 0) {
+    return std::nullopt;
+  }
+  return version;
+}
+
+NodeOutputCache::NodeOutputCache() = default;
+NodeOutputCache::~NodeOutputCache() = default;
+
+uint64_t NodeOutputCache::new_geometry_stamp()
+{
+  return next_geometry_stamp_.fetch_add(1);
+}
+
+uint64_t NodeOutputCache::stamp_input_geometry(const int input_index,
+                                               const GeometrySet &geometry_set)
+{
+  /* A version is compared instead of keeping the geometry alive, because the evaluator would have
+   * to copy the geometry before modifying it otherwise. Comparing the content itself would be as
+   * slow as some of the nodes that are skipped. */
+  const std::optional<uint64_t> content_version = geometry_content_version(geometry_set);
+  if (!content_version) {
+    return this->new_geometry_stamp();
+  }
+  if (*content_version == 0) {
+    /* The geometry is empty, like the default geometry. */
+    return 0;
+  }
+  std::lock_guard lock{mutex_};
+  const std::pair<uint64_t, uint64_t> *previous = input_geometry_stamps_.lookup_ptr(input_index);
+  if (previous != nullptr && previous->first == *content_version) {
+    return previous->second;
+  }
+  const uint64_t stamp = this->new_geometry_stamp();
+  input_geometry_stamps_.add_overwrite(input_index, {*content_version, stamp});
+  return stamp;
+}
+
+void NodeOutputCache::begin_evaluation()
+{
+  std::lock_guard lock{mutex_};
+  evaluation_start_ = ++use_counter_;
+}
+
+void NodeOutputCache::end_evaluation()
+{
+  std::lock_guard lock{mutex_};
+  Vector<NodeCacheKey> keys_to_remove;
+  for (auto item : entries_.items()) {
+    if (item.value->last_used_stamp < evaluation_start_) {
+      keys_to_remove.append(item.key);
+    }
+  }
+  for (const NodeCacheKey &key : keys_to_remove) {
+    memory_usage_ -= entries_.lookup(key)->memory;
+    entries_.remove(key);
+  }
+}
+
+bool NodeOutputCache::lookup(const NodeCacheKey &key, Entry &entry)
+{
+  std::lock_guard lock{mutex_};
+  std::unique_ptr<Entry> *cached_entry = entries_.lookup_ptr(key);
+  if (cached_entry == nullptr) {
+    return false;
+  }
+  if (!(*cached_entry)->has_same_inputs(entry)) {
+    /* Free the outdated outputs before the node is executed again. */
+    memory_usage_ -= (*cached_entry)->memory;
+    entries_.remove(key);
+    return false;
+  }
+  (*cached_entry)->last_used_stamp = ++use_counter_;
+  /* Copy the values while the entry can't be removed by other threads. */
+  const Entry &found_entry = **cached_entry;
+  for (const int i : found_entry.outputs.index_range()) {
+    if (found_entry.outputs[i].has_value()) {
+      entry.add_output(i, found_entry.outputs[i]->get(), found_entry.output_geometry_stamps[i]);
+    }
+  }
+  return true;
+}
+
+void NodeOutputCache::add(NodeCacheKey key, std::unique_ptr<Entry> entry)
+{
+  std::lock_guard lock{mutex_};
+  /* The previous entry is outdated, because the node has been executed again. */
+  std::unique_ptr<Entry> *old_entry = entries_.lookup_ptr(key);
+  if (old_entry != nullptr) {
+    memory_usage_ -= (*old_entry)->memory;
+    entries_.remove(key);
+  }
+  if (entry->memory > memory_budget) {
+    return;
+  }
+  while (memory_usage_ + entry->memory > memory_budget) {
+    this->remove_least_recently_used();
+  }
+  entry->last_used_stamp = ++use_counter_;
+  memory_usage_ += entry->memory;
+  entries_.add_new(std::move(key), std::move(entry));
+}
+
+void NodeOutputCache::remove_least_recently_used()
+{
+  const NodeCacheKey *lru_key = nullptr;
+  uint64_t lru_stamp = UINT64_MAX;
+  for (auto item : entries_.items()) {
+    if (item.value->last_used_stamp < lru_stamp) {
+      lru_key = &item.key;
+      lru_stamp = item.value->last_used_stamp;
+    }
+  }
+  BLI_assert(lru_key != nullptr);
+  const NodeCacheKey key = *lru_key;
+  memory_usage_ -= entries_.lookup(key)->memory;
+  entries_.remove(key);
+}
+
+int64_t NodeOutputCache::memory_usage()
+{
+  std::lock_guard lock{mutex_};
+  return memory_usage_;
+}
+
+/** \} */
+
 void evaluate_geometry_nodes(GeometryNodesEvaluationParams &params)
 {
+  if (params.output_cache != nullptr) {
+    params.output_cache->begin_evaluation();
+  }
+
   GeometryNodesEvaluator evaluator{params};
   evaluator.execute();
+
+  if (params.output_cache != nullptr) {
+    params.output_cache->end_evaluation();
+  }
 }
 
 }  // namespace blender::modifiers::geometry_nodes
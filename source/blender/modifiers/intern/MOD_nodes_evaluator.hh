@@ -16,7 +16,13 @@
 
 #pragma once
 
+#include <atomic>
+#include <mutex>
+
 #include "BLI_map.hh"
+#include "BLI_utility_mixins.hh"
+
+#include "BKE_geometry_set.hh"
 
 #include "NOD_derived_node_tree.hh"
 #include "NOD_geometry_nodes_eval_log.hh"
@@ -31,9 +37,150 @@ namespace geo_log = blender::nodes::geometry_nodes_eval_log;
 namespace blender::modifiers::geometry_nodes {
 
 using namespace nodes::derived_node_tree_types;
+using fn::CPPType;
 using fn::GMutablePointer;
 using fn::GPointer;
 
+/**
+ * A value that is owned by the #NodeOutputCache. It lives longer than a single evaluation, so it
+ * can't be allocated with the linear allocators of the evaluator.
+ */
+class CachedValue : NonCopyable {
+ private:
+  const CPPType *type_ = nullptr;
+  void *buffer_ = nullptr;
+
+ public:
+  CachedValue(const CPPType &type, const void *value);
+  CachedValue(CachedValue &&other) noexcept;
+  ~CachedValue();
+
+  GPointer get() const
+  {
+    return {*type_, buffer_};
+  }
+};
+
+/**
+ * All the data of a node that might change its behavior, except for the input values. Unlinked
+ * inputs are not part of this, because their values are passed to the node like other inputs.
+ */
+struct CachedNodeSettings {
+  const bNodeType *typeinfo;
+  short custom1, custom2;
+  float custom3, custom4;
+  const ID *id;
+  Vector<char> storage;
+
+  CachedNodeSettings(const bNode &bnode);
+
+  friend bool operator==(const CachedNodeSettings &a, const CachedNodeSettings &b);
+};
+
+/**
+ * Identifies a node across evaluations, also when the derived node tree is rebuilt. Node names
+ * are only unique within a node tree, so the names of all the group nodes the node is nested in
+ * are part of the key as well.
+ */
+struct NodeCacheKey {
+  /** Names of the parent group nodes starting at the root tree, followed by the node name. */
+  Vector<std::string> node_names;
+
+  uint64_t hash() const;
+
+  friend bool operator==(const NodeCacheKey &a, const NodeCacheKey &b)
+  {
+    return a.node_names.as_span() == b.node_names.as_span();
+  }
+};
+
+/**
+ * Keeps the outputs of geometry node executions alive across evaluations of the same modifier.
+ * When a node is executed again with the same inputs and settings, the cached outputs are
+ * forwarded instead of running the node. That way only nodes that are affected by a change have
+ * to run again.
+ *
+ * Input geometries are not kept alive by the cache, because the evaluator would have to copy them
+ * before they can be modified. Instead, every geometry that is passed between nodes gets a stamp
+ * that identifies it across evaluations. A node that outputs cached geometry passes on the stamp
+ * of the cached geometry, every new geometry gets a new stamp. The geometry passed into the
+ * modifier gets the same stamp as in the previous evaluation if it has the same content version,
+ * see #BKE_mesh_runtime_content_version.
+ */
+class NodeOutputCache : NonCopyable, NonMovable {
+ public:
+  struct Entry {
+    CachedNodeSettings settings;
+    /** Values of all available non-geometry inputs in the order of the input sockets. */
+    Vector<CachedValue> input_values;
+    /** Stamps of the geometries passed to all available geometry inputs. */
+    Vector<uint64_t> input_geometry_stamps;
+    /** Computed output values, indexed by the output socket index. */
+    Vector<std::optional<CachedValue>> outputs;
+    /** Stamps of the geometry outputs, indexed like #outputs. */
+    Vector<uint64_t> output_geometry_stamps;
+    int64_t memory = 0;
+    /** Value of the use counter of the cache when the entry was added or found last. */
+    uint64_t last_used_stamp = 0;
+
+    Entry(const bNode &bnode) : settings(bnode)
+    {
+    }
+
+    bool has_same_inputs(const Entry &other) const;
+    void add_output(int index, GPointer value, uint64_t geometry_stamp);
+  };
+
+  /**
+   * When a new entry does not fit into this amount of memory, the least recently used entries are
+   * removed until it does. Entries that are larger than the budget on their own are not stored.
+   */
+  static constexpr int64_t memory_budget = 512 * 1024 * 1024;
+
+ private:
+  std::mutex mutex_;
+  Map<NodeCacheKey, std::unique_ptr<Entry>> entries_;
+  /** Content version of the geometry passed to a group input and its stamp, by socket index. */
+  Map<int, std::pair<uint64_t, uint64_t>> input_geometry_stamps_;
+  std::atomic<uint64_t> next_geometry_stamp_ = 1;
+  int64_t memory_usage_ = 0;
+  /** Incremented whenever an entry is added or found, to find the least recently used entries. */
+  uint64_t use_counter_ = 0;
+  /** Value of the use counter at the start of the current evaluation. */
+  uint64_t evaluation_start_ = 0;
+
+  /** Has to be called with the mutex locked. */
+  void remove_least_recently_used();
+
+ public:
+  NodeOutputCache();
+  ~NodeOutputCache();
+
+  /** Returns a stamp that has not been used before. Zero is used for the default geometry. */
+  uint64_t new_geometry_stamp();
+
+  /**
+   * Returns the stamp for the geometry passed into the group input with the given index. It is
+   * the same as in the previous evaluation, when the content version of the geometry is the same.
+   */
+  uint64_t stamp_input_geometry(int input_index, const GeometrySet &geometry_set);
+
+  /** Has to be called before every evaluation that uses the cache. */
+  void begin_evaluation();
+  /** Removes the entries that have not been used by the last evaluation. */
+  void end_evaluation();
+
+  /**
+   * If the node has been cached with the same settings and inputs as in the given entry, the
+   * cached outputs are copied into it and true is returned. Otherwise the outdated entry is
+   * removed, because the node will be executed again.
+   */
+  bool lookup(const NodeCacheKey &key, Entry &entry);
+  void add(NodeCacheKey key, std::unique_ptr<Entry> entry);
+
+  int64_t memory_usage();
+};
+
 struct GeometryNodesEvaluationParams {
   blender::LinearAllocator<> allocator;
 
@@ -50,6 +197,8 @@ struct GeometryNodesEvaluationParams {
   Depsgraph *depsgraph;
   Object *self_object;
   geo_log::GeoLogger *geo_logger;
+  /* Optional, used to skip the execution of nodes whose inputs did not change. */
+  NodeOutputCache *output_cache = nullptr;
 
   Vector<GMutablePointer> r_output_values;
 };
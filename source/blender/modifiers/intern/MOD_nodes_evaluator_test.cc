@@ -0,0 +1,216 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "testing/testing.h"
+
+#include "MOD_nodes_evaluator.hh"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "BKE_customdata.h"
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+
+namespace blender::modifiers::geometry_nodes::tests {
+
+static std::unique_ptr<NodeOutputCache::Entry> create_entry(const bNode &bnode,
+                                                            const float input,
+                                                            const uint64_t geometry_stamp)
+{
+  auto entry = std::make_unique<NodeOutputCache::Entry>(bnode);
+  entry->input_values.append_as(CPPType::get<float>(), &input);
+  entry->input_geometry_stamps.append(geometry_stamp);
+  return entry;
+}
+
+static NodeCacheKey create_key(Span<const char *> names)
+{
+  NodeCacheKey key;
+  for (const char *name : names) {
+    key.node_names.append(name);
+  }
+  return key;
+}
+
+TEST(node_output_cache, Hit)
+{
+  NodeOutputCache cache;
+  bNode bnode = {nullptr};
+  const NodeCacheKey key = create_key({"Node"});
+
+  cache.begin_evaluation();
+  std::unique_ptr<NodeOutputCache::Entry> entry = create_entry(bnode, 1.0f, 5);
+  const int output = 42;
+  entry->add_output(1, {CPPType::get<int>(), &output}, 0);
+  entry->memory = 100;
+  cache.add(key, std::move(entry));
+  cache.end_evaluation();
+  EXPECT_EQ(cache.memory_usage(), 100);
+
+  cache.begin_evaluation();
+  std::unique_ptr<NodeOutputCache::Entry> query = create_entry(bnode, 1.0f, 5);
+  EXPECT_TRUE(cache.lookup(key, *query));
+  cache.end_evaluation();
+
+  ASSERT_EQ(query->outputs.size(), 2);
+  EXPECT_FALSE(query->outputs[0].has_value());
+  ASSERT_TRUE(query->outputs[1].has_value());
+  EXPECT_EQ(*query->outputs[1]->get().get<int>(), 42);
+  EXPECT_EQ(cache.memory_usage(), 100);
+}
+
+TEST(node_output_cache, MissOnChangedInputs)
+{
+  NodeOutputCache cache;
+  bNode bnode = {nullptr};
+  const NodeCacheKey key = create_key({"Node"});
+
+  cache.begin_evaluation();
+  cache.add(key, create_entry(bnode, 1.0f, 5));
+  EXPECT_FALSE(cache.lookup(key, *create_entry(bnode, 1.0f, 6)));
+  /* The outdated entry has been removed. */
+  EXPECT_FALSE(cache.lookup(key, *create_entry(bnode, 1.0f, 5)));
+
+  cache.add(key, create_entry(bnode, 1.0f, 5));
+  EXPECT_FALSE(cache.lookup(key, *create_entry(bnode, 2.0f, 5)));
+
+  cache.add(key, create_entry(bnode, 1.0f, 5));
+  EXPECT_FALSE(cache.lookup(create_key({"Other Node"}), *create_entry(bnode, 1.0f, 5)));
+  EXPECT_TRUE(cache.lookup(key, *create_entry(bnode, 1.0f, 5)));
+  cache.end_evaluation();
+}
+
+TEST(node_output_cache, MissOnChangedSettings)
+{
+  NodeOutputCache cache;
+  bNode bnode = {nullptr};
+  const NodeCacheKey key = create_key({"Node"});
+
+  cache.begin_evaluation();
+  cache.add(key, create_entry(bnode, 1.0f, 5));
+  bnode.custom1 = 1;
+  EXPECT_FALSE(cache.lookup(key, *create_entry(bnode, 1.0f, 5)));
+  cache.end_evaluation();
+}
+
+TEST(node_output_cache, KeysOfNestedNodes)
+{
+  NodeOutputCache cache;
+  bNode bnode = {nullptr};
+
+  cache.begin_evaluation();
+  cache.add(create_key({"A", "B/C"}), create_entry(bnode, 1.0f, 5));
+  EXPECT_FALSE(cache.lookup(create_key({"A/B", "C"}), *create_entry(bnode, 1.0f, 5)));
+  EXPECT_TRUE(cache.lookup(create_key({"A", "B/C"}), *create_entry(bnode, 1.0f, 5)));
+  cache.end_evaluation();
+}
+
+TEST(node_output_cache, UnusedEntriesAreRemoved)
+{
+  NodeOutputCache cache;
+  bNode bnode = {nullptr};
+  const NodeCacheKey key = create_key({"Node"});
+
+  cache.begin_evaluation();
+  std::unique_ptr<NodeOutputCache::Entry> entry = create_entry(bnode, 1.0f, 5);
+  entry->memory = 100;
+  cache.add(key, std::move(entry));
+  cache.end_evaluation();
+
+  /* The node is not evaluated anymore, e.g. because it has been disconnected. */
+  cache.begin_evaluation();
+  cache.end_evaluation();
+  EXPECT_EQ(cache.memory_usage(), 0);
+
+  cache.begin_evaluation();
+  EXPECT_FALSE(cache.lookup(key, *create_entry(bnode, 1.0f, 5)));
+  cache.end_evaluation();
+}
+
+TEST(node_output_cache, LeastRecentlyUsedEntriesAreEvicted)
+{
+  NodeOutputCache cache;
+  bNode bnode = {nullptr};
+  const NodeCacheKey key_a = create_key({"A"});
+  const NodeCacheKey key_b = create_key({"B"});
+  const NodeCacheKey key_c = create_key({"C"});
+  const int64_t entry_memory = NodeOutputCache::memory_budget / 2;
+
+  cache.begin_evaluation();
+  for (const NodeCacheKey &key : {key_a, key_b}) {
+    std::unique_ptr<NodeOutputCache::Entry> entry = create_entry(bnode, 1.0f, 5);
+    entry->memory = entry_memory;
+    cache.add(key, std::move(entry));
+  }
+  EXPECT_EQ(cache.memory_usage(), NodeOutputCache::memory_budget);
+  EXPECT_TRUE(cache.lookup(key_a, *create_entry(bnode, 1.0f, 5)));
+
+  std::unique_ptr<NodeOutputCache::Entry> entry = create_entry(bnode, 1.0f, 5);
+  entry->memory = entry_memory;
+  cache.add(key_c, std::move(entry));
+  EXPECT_EQ(cache.memory_usage(), NodeOutputCache::memory_budget);
+  EXPECT_FALSE(cache.lookup(key_b, *create_entry(bnode, 1.0f, 5)));
+  EXPECT_TRUE(cache.lookup(key_a, *create_entry(bnode, 1.0f, 5)));
+  EXPECT_TRUE(cache.lookup(key_c, *create_entry(bnode, 1.0f, 5)));
+
+  /* An entry that does not fit on its own does not remove other entries. */
+  entry = create_entry(bnode, 1.0f, 5);
+  entry->memory = NodeOutputCache::memory_budget + 1;
+  cache.add(key_b, std::move(entry));
+  EXPECT_FALSE(cache.lookup(key_b, *create_entry(bnode, 1.0f, 5)));
+  EXPECT_EQ(cache.memory_usage(), NodeOutputCache::memory_budget);
+  cache.end_evaluation();
+}
+
+TEST(node_output_cache, InputGeometryStamp)
+{
+  BKE_idtype_init();
+  NodeOutputCache cache;
+  EXPECT_EQ(cache.stamp_input_geometry(0, GeometrySet()), 0);
+
+  Mesh *mesh = BKE_mesh_new_nomain(4, 0, 0, 0, 0);
+
+  /* Copies that reference the data of the same mesh get the same stamp. */
+  GeometrySet geometry = GeometrySet::create_with_mesh(BKE_mesh_copy_for_eval(mesh, true));
+  const uint64_t stamp = cache.stamp_input_geometry(0, geometry);
+  EXPECT_NE(stamp, 0);
+  GeometrySet geometry_copy = GeometrySet::create_with_mesh(BKE_mesh_copy_for_eval(mesh, true));
+  EXPECT_EQ(cache.stamp_input_geometry(0, geometry_copy), stamp);
+
+  /* Writing to a referenced layer copies it, which makes the content unknown. */
+  Mesh *mesh_copy = geometry_copy.get_mesh_for_write();
+  CustomData_duplicate_referenced_layer(&mesh_copy->vdata, CD_MVERT, mesh_copy->totvert);
+  const uint64_t changed_stamp = cache.stamp_input_geometry(0, geometry_copy);
+  EXPECT_NE(changed_stamp, stamp);
+  EXPECT_NE(cache.stamp_input_geometry(0, geometry_copy), changed_stamp);
+
+  /* A mesh that owns its data may have been modified in place. */
+  GeometrySet geometry_owned = GeometrySet::create_with_mesh(mesh);
+  EXPECT_NE(cache.stamp_input_geometry(0, geometry_owned),
+            cache.stamp_input_geometry(0, geometry_owned));
+
+  /* A full copy gets a new version, e.g. when the copy-on-write mesh is updated. */
+  Mesh *mesh_updated = BKE_mesh_copy_for_eval(mesh, false);
+  GeometrySet geometry_updated = GeometrySet::create_with_mesh(
+      BKE_mesh_copy_for_eval(mesh_updated, true));
+  EXPECT_NE(cache.stamp_input_geometry(0, geometry_updated), stamp);
+  geometry_updated.clear();
+  BKE_id_free(nullptr, mesh_updated);
+}
+
+}  // namespace blender::modifiers::geometry_nodes::tests
@@ -564,7 +564,7 @@ static Mesh *normalEditModifier_do(NormalEditModifierData *enmd,
                              num_loops,
                              num_polys,
                              polynors,
-                             (result->runtime.cd_dirty_vert & CD_MASK_NORMAL) ? false : true);
+                             !BKE_mesh_vert_normals_are_dirty(result));
 
   result->runtime.cd_dirty_vert &= ~CD_MASK_NORMAL;
 
@@ -65,6 +65,10 @@ class GeoNodeExecParamsProvider {
   const ModifierData *modifier = nullptr;
   Depsgraph *depsgraph = nullptr;
   geometry_nodes_eval_log::GeoLogger *logger = nullptr;
+  /**
+   * Set when the node reported a warning during its execution, even if the warning was not logged.
+   */
+  bool has_reported_warning = false;
 
   /**
    * Returns true when the node is allowed to get/extract the input value. The identifier is
@@ -30,6 +30,8 @@
  * necessary information.
  */
 
+#include <chrono>
+
 #include "BLI_enumerable_thread_specific.hh"
 #include "BLI_function_ref.hh"
 #include "BLI_linear_allocator.hh"
@@ -143,6 +145,11 @@ struct NodeWithWarning {
   NodeWarning warning;
 };
 
+struct NodeWithExecutionTime {
+  DNode node;
+  std::chrono::microseconds exec_time;
+};
+
 /** The same value can be referenced by multiple sockets when they are linked. */
 struct ValueOfSockets {
   Span<DSocket> sockets;
@@ -163,6 +170,7 @@ class LocalGeoLogger {
   std::unique_ptr<LinearAllocator<>> allocator_;
   Vector<ValueOfSockets> values_;
   Vector<NodeWithWarning> node_warnings_;
+  Vector<NodeWithExecutionTime> node_exec_times_;
 
   friend ModifierLog;
 
@@ -175,6 +183,7 @@ class LocalGeoLogger {
   void log_value_for_sockets(Span<DSocket> sockets, GPointer value);
   void log_multi_value_socket(DSocket socket, Span<GPointer> values);
   void log_node_warning(DNode node, NodeWarningType type, std::string message);
+  void log_execution_time(DNode node, std::chrono::microseconds exec_time);
 };
 
 /** The root logger class. */
@@ -231,6 +240,9 @@ class NodeLog {
   Vector<SocketLog> input_logs_;
   Vector<SocketLog> output_logs_;
   Vector<NodeWarning, 0> warnings_;
+  /* Accumulated over all executions of the node. Some nodes are executed more than once. */
+  std::chrono::microseconds exec_time_{0};
+  int exec_count_ = 0;
 
   friend ModifierLog;
 
@@ -253,6 +265,16 @@ class NodeLog {
     return warnings_;
   }
 
+  std::chrono::microseconds execution_time() const
+  {
+    return exec_time_;
+  }
+
+  int execution_count() const
+  {
+    return exec_count_;
+  }
+
   Vector<const GeometryAttributeInfo *> lookup_available_attributes() const;
 };
 
@@ -269,6 +291,9 @@ class TreeLog {
   const NodeLog *lookup_node_log(const bNode &node) const;
   const TreeLog *lookup_child_log(StringRef node_name) const;
   void foreach_node_log(FunctionRef<void(const NodeLog &)> fn) const;
+
+  /** Time spent in all the nodes of this tree, including nested node groups. */
+  std::chrono::microseconds execution_time() const;
 };
 
 /** Contains information about an entire geometry nodes evaluation. */
@@ -88,6 +88,19 @@ struct CurveToPointsResults {
 CurveToPointsResults curve_to_points_create_result_attributes(PointCloudComponent &points,
                                                               const CurveEval &curve);
 
+/**
+ * Mark the points that are closer than the minimum distance to a point that is kept in the
+ * elimination mask. The mask is a flat array for the points of all instances.
+ *
+ * \param use_legacy_order: Visit the points in the order they were generated, which is slower but
+ * keeps the result of files created before the grid based elimination.
+ */
+void point_distribute_eliminate_close_points(Span<Vector<float3>> positions_all,
+                                             Span<int> instance_start_offsets,
+                                             const float minimum_distance,
+                                             const bool use_legacy_order,
+                                             MutableSpan<bool> elimination_mask);
+
 void curve_create_default_rotation_attribute(Span<float3> tangents,
                                              Span<float3> normals,
                                              MutableSpan<float3> rotations);
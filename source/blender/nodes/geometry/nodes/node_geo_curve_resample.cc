@@ -76,7 +76,10 @@ struct SampleModeParam {
   std::optional<int> count;
 };
 
-static SplinePtr resample_spline(const Spline &input_spline, const int count)
+static SplinePtr resample_spline(const Spline &input_spline,
+                                 Span<float3> evaluated_positions,
+                                 Span<float> evaluated_lengths,
+                                 const int count)
 {
   std::unique_ptr<PolySpline> output_spline = std::make_unique<PolySpline>();
   output_spline->set_cyclic(input_spline.is_cyclic());
@@ -109,10 +112,11 @@ static SplinePtr resample_spline(const Spline &input_spline, const int count)
 
   output_spline->resize(count);
 
-  Array<float> uniform_samples = input_spline.sample_uniform_index_factors(count);
+  Array<float> uniform_samples = input_spline.sample_uniform_index_factors(evaluated_lengths,
+                                                                          count);
 
   input_spline.sample_with_index_factors<float3>(
-      input_spline.evaluated_positions(), uniform_samples, output_spline->positions());
+      evaluated_positions, uniform_samples, output_spline->positions());
 
   input_spline.sample_with_index_factors<float>(
       input_spline.interpolate_to_evaluated(input_spline.radii()),
@@ -161,20 +165,30 @@ static std::unique_ptr<CurveEval> resample_curve(const CurveEval &input_curve,
   output_curve->resize(input_splines.size());
   MutableSpan<SplinePtr> output_splines = output_curve->splines();
 
+  const CurveEvaluatedData evaluated = input_curve.evaluate(false);
+  auto resample_spline_index = [&](const int i, const int count) {
+    const Spline &input_spline = *input_splines[i];
+    const IndexRange points = evaluated.points_range(i);
+    return resample_spline(input_spline,
+                           evaluated.positions.as_span().slice(points.start(), points.size()),
+                           evaluated.spline_lengths(i, input_spline),
+                           count);
+  };
+
   if (mode_param.mode == GEO_NODE_CURVE_SAMPLE_COUNT) {
     threading::parallel_for(input_splines.index_range(), 128, [&](IndexRange range) {
       for (const int i : range) {
         BLI_assert(mode_param.count);
-        output_splines[i] = resample_spline(*input_splines[i], *mode_param.count);
+        output_splines[i] = resample_spline_index(i, *mode_param.count);
       }
     });
   }
   else if (mode_param.mode == GEO_NODE_CURVE_SAMPLE_LENGTH) {
     threading::parallel_for(input_splines.index_range(), 128, [&](IndexRange range) {
       for (const int i : range) {
-        const float length = input_splines[i]->length();
+        const float length = evaluated.spline_length(i, *input_splines[i]);
         const int count = std::max(int(length / *mode_param.length), 1);
-        output_splines[i] = resample_spline(*input_splines[i], count);
+        output_splines[i] = resample_spline_index(i, count);
       }
     });
   }
@@ -44,14 +44,13 @@ static bNodeSocketTemplate geo_node_curve_to_mesh_out[] = {
 namespace blender::nodes {
 
 static void vert_extrude_to_mesh_data(const Spline &spline,
+                                      Span<float3> positions,
                                       const float3 profile_vert,
                                       MutableSpan<MVert> r_verts,
                                       MutableSpan<MEdge> r_edges,
                                       const int vert_offset,
                                       const int edge_offset)
 {
-  Span<float3> positions = spline.evaluated_positions();
-
   for (const int i : IndexRange(positions.size() - 1)) {
     MEdge &edge = r_edges[edge_offset + i];
     edge.v1 = vert_offset + i;
@@ -79,7 +78,13 @@ static void mark_edges_sharp(MutableSpan<MEdge> edges)
   }
 }
 
+/**
+ * \param positions, tangents, normals: The evaluated data of the spline, see #CurveEval::evaluate.
+ */
 static void spline_extrude_to_mesh_data(const Spline &spline,
+                                        Span<float3> positions,
+                                        Span<float3> tangents,
+                                        Span<float3> normals,
                                         const Spline &profile_spline,
                                         const int vert_offset,
                                         const int edge_offset,
@@ -100,6 +105,7 @@ static void spline_extrude_to_mesh_data(const Spline &spline,
 
   if (profile_vert_len == 1) {
     vert_extrude_to_mesh_data(spline,
+                              positions,
                               profile_spline.evaluated_positions()[0],
                               r_verts,
                               r_edges,
@@ -182,9 +188,6 @@ static void spline_extrude_to_mesh_data(const Spline &spline,
   }
 
   /* Calculate the positions of each profile ring profile along the spline. */
-  Span<float3> positions = spline.evaluated_positions();
-  Span<float3> tangents = spline.evaluated_tangents();
-  Span<float3> normals = spline.evaluated_normals();
   Span<float3> profile_positions = profile_spline.evaluated_positions();
 
   GVArray_Typed<float> radii = spline.interpolate_to_evaluated(spline.radii());
@@ -301,13 +304,26 @@ static Mesh *curve_to_mesh_calculate(const CurveEval &curve, const CurveEval &pr
   mesh->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
   mesh->runtime.cd_dirty_poly |= CD_MASK_NORMAL;
 
+  /* Evaluate all curve splines at once, there are usually many more of them than profiles. */
+  const CurveEvaluatedData evaluated = curve.evaluate(true);
+
   threading::parallel_for(curves.index_range(), 128, [&](IndexRange curves_range) {
     for (const int i_spline : curves_range) {
       const int spline_start_index = i_spline * profiles.size();
+      const IndexRange points = evaluated.points_range(i_spline);
+      const Span<float3> positions = evaluated.positions.as_span().slice(points.start(),
+                                                                         points.size());
+      const Span<float3> tangents = evaluated.tangents.as_span().slice(points.start(),
+                                                                       points.size());
+      const Span<float3> normals = evaluated.normals.as_span().slice(points.start(),
+                                                                     points.size());
       threading::parallel_for(profiles.index_range(), 128, [&](IndexRange profiles_range) {
         for (const int i_profile : profiles_range) {
           const int i_mesh = spline_start_index + i_profile;
           spline_extrude_to_mesh_data(*curves[i_spline],
+                                      positions,
+                                      tangents,
+                                      normals,
                                       *profiles[i_profile],
                                       offsets.vert[i_mesh],
                                       offsets.edge[i_mesh],
@@ -66,24 +66,11 @@ static void geo_node_curve_to_points_update(bNodeTree *UNUSED(ntree), bNode *nod
 
 namespace blender::nodes {
 
-/**
- * Evaluate splines in parallel to speed up the rest of the node's execution.
- */
-static void evaluate_splines(Span<SplinePtr> splines)
-{
-  threading::parallel_for_each(splines, [](const SplinePtr &spline) {
-    /* These functions fill the corresponding caches on each spline. */
-    spline->evaluated_positions();
-    spline->evaluated_tangents();
-    spline->evaluated_normals();
-    spline->evaluated_lengths();
-  });
-}
-
 static Array<int> calculate_spline_point_offsets(GeoNodeExecParams &params,
                                                  const GeometryNodeCurveSampleMode mode,
                                                  const CurveEval &curve,
-                                                 const Span<SplinePtr> splines)
+                                                 const Span<SplinePtr> splines,
+                                                 const CurveEvaluatedData &evaluated)
 {
   const int size = curve.splines().size();
   switch (mode) {
@@ -105,13 +92,13 @@ static Array<int> calculate_spline_point_offsets(GeoNodeExecParams &params,
       int offset = 0;
       for (const int i : IndexRange(size)) {
         offsets[i] = offset;
-        offset += splines[i]->length() / resolution;
+        offset += evaluated.spline_length(i, *splines[i]) / resolution;
       }
       offsets.last() = offset;
       return offsets;
     }
     case GEO_NODE_CURVE_SAMPLE_EVALUATED: {
-      return curve.evaluated_point_offsets();
+      return evaluated.offsets;
     }
   }
   BLI_assert_unreachable();
@@ -171,6 +158,7 @@ CurveToPointsResults curve_to_points_create_result_attributes(PointCloudComponen
  */
 static void copy_evaluated_point_attributes(Span<SplinePtr> splines,
                                             Span<int> offsets,
+                                            const CurveEvaluatedData &evaluated,
                                             CurveToPointsResults &data)
 {
   threading::parallel_for(splines.index_range(), 64, [&](IndexRange range) {
@@ -179,7 +167,8 @@ static void copy_evaluated_point_attributes(Span<SplinePtr> splines,
       const int offset = offsets[i];
       const int size = offsets[i + 1] - offsets[i];
 
-      data.positions.slice(offset, size).copy_from(spline.evaluated_positions());
+      data.positions.slice(offset, size)
+          .copy_from(evaluated.positions.as_span().slice(offset, size));
       spline.interpolate_to_evaluated(spline.radii())->materialize(data.radii.slice(offset, size));
       spline.interpolate_to_evaluated(spline.tilts())->materialize(data.tilts.slice(offset, size));
 
@@ -194,14 +183,16 @@ static void copy_evaluated_point_attributes(Span<SplinePtr> splines,
             ->materialize(point_span.slice(offset, size).data());
       }
 
-      data.tangents.slice(offset, size).copy_from(spline.evaluated_tangents());
-      data.normals.slice(offset, size).copy_from(spline.evaluated_normals());
+      data.tangents.slice(offset, size)
+          .copy_from(evaluated.tangents.as_span().slice(offset, size));
+      data.normals.slice(offset, size).copy_from(evaluated.normals.as_span().slice(offset, size));
     }
   });
 }
 
 static void copy_uniform_sample_point_attributes(Span<SplinePtr> splines,
                                                  Span<int> offsets,
+                                                 const CurveEvaluatedData &evaluated,
                                                  CurveToPointsResults &data)
 {
   threading::parallel_for(splines.index_range(), 64, [&](IndexRange range) {
@@ -213,10 +204,14 @@ static void copy_uniform_sample_point_attributes(Span<SplinePtr> splines,
         continue;
       }
 
-      const Array<float> uniform_samples = spline.sample_uniform_index_factors(size);
+      const IndexRange evaluated_points = evaluated.points_range(i);
+      const Array<float> uniform_samples = spline.sample_uniform_index_factors(
+          evaluated.spline_lengths(i, spline), size);
 
       spline.sample_with_index_factors<float3>(
-          spline.evaluated_positions(), uniform_samples, data.positions.slice(offset, size));
+          evaluated.positions.as_span().slice(evaluated_points.start(), evaluated_points.size()),
+          uniform_samples,
+          data.positions.slice(offset, size));
 
       spline.sample_with_index_factors<float>(spline.interpolate_to_evaluated(spline.radii()),
                                               uniform_samples,
@@ -239,14 +234,18 @@ static void copy_uniform_sample_point_attributes(Span<SplinePtr> splines,
       }
 
       spline.sample_with_index_factors<float3>(
-          spline.evaluated_tangents(), uniform_samples, data.tangents.slice(offset, size));
-      for (float3 &tangent : data.tangents) {
+          evaluated.tangents.as_span().slice(evaluated_points.start(), evaluated_points.size()),
+          uniform_samples,
+          data.tangents.slice(offset, size));
+      for (float3 &tangent : data.tangents.slice(offset, size)) {
         tangent.normalize();
       }
 
       spline.sample_with_index_factors<float3>(
-          spline.evaluated_normals(), uniform_samples, data.normals.slice(offset, size));
-      for (float3 &normals : data.normals) {
+          evaluated.normals.as_span().slice(evaluated_points.start(), evaluated_points.size()),
+          uniform_samples,
+          data.normals.slice(offset, size));
+      for (float3 &normals : data.normals.slice(offset, size)) {
         normals.normalize();
       }
     }
@@ -318,9 +317,10 @@ static void geo_node_curve_to_points_exec(GeoNodeExecParams params)
   const Span<SplinePtr> splines = curve.splines();
   curve.assert_valid_point_attributes();
 
-  evaluate_splines(splines);
+  const CurveEvaluatedData evaluated = curve.evaluate(true);
 
-  const Array<int> offsets = calculate_spline_point_offsets(params, mode, curve, splines);
+  const Array<int> offsets = calculate_spline_point_offsets(
+      params, mode, curve, splines, evaluated);
   const int total_size = offsets.last();
   if (total_size == 0) {
     params.set_output("Geometry", GeometrySet());
@@ -335,10 +335,10 @@ static void geo_node_curve_to_points_exec(GeoNodeExecParams params)
   switch (mode) {
     case GEO_NODE_CURVE_SAMPLE_COUNT:
     case GEO_NODE_CURVE_SAMPLE_LENGTH:
-      copy_uniform_sample_point_attributes(splines, offsets, new_attributes);
+      copy_uniform_sample_point_attributes(splines, offsets, evaluated, new_attributes);
       break;
     case GEO_NODE_CURVE_SAMPLE_EVALUATED:
-      copy_evaluated_point_attributes(splines, offsets, new_attributes);
+      copy_evaluated_point_attributes(splines, offsets, evaluated, new_attributes);
       break;
   }
 
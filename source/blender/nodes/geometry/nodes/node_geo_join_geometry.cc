@@ -14,14 +14,12 @@
  * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 
+#include "BKE_geometry_set_instances.hh"
 #include "BKE_material.h"
 #include "BKE_mesh.h"
-#include "BKE_mesh_runtime.h"
-#include "BKE_pointcloud.h"
 #include "BKE_spline.hh"
 
 #include "DNA_mesh_types.h"
-#include "DNA_meshdata_types.h"
 
 #include "NOD_type_conversions.hh"
 
@@ -50,115 +48,23 @@ static bNodeSocketTemplate geo_node_join_geometry_out[] = {
 
 namespace blender::nodes {
 
-static Mesh *join_mesh_topology_and_builtin_attributes(Span<const MeshComponent *> src_components)
-{
-  int totverts = 0;
-  int totloops = 0;
-  int totedges = 0;
-  int totpolys = 0;
-
-  int64_t cd_dirty_vert = 0;
-  int64_t cd_dirty_poly = 0;
-  int64_t cd_dirty_edge = 0;
-  int64_t cd_dirty_loop = 0;
-
-  VectorSet<Material *> materials;
-
-  for (const MeshComponent *mesh_component : src_components) {
-    const Mesh *mesh = mesh_component->get_for_read();
-    totverts += mesh->totvert;
-    totloops += mesh->totloop;
-    totedges += mesh->totedge;
-    totpolys += mesh->totpoly;
-    cd_dirty_vert |= mesh->runtime.cd_dirty_vert;
-    cd_dirty_poly |= mesh->runtime.cd_dirty_poly;
-    cd_dirty_edge |= mesh->runtime.cd_dirty_edge;
-    cd_dirty_loop |= mesh->runtime.cd_dirty_loop;
-
-    for (const int slot_index : IndexRange(mesh->totcol)) {
-      Material *material = mesh->mat[slot_index];
-      materials.add(material);
-    }
-  }
-
-  const Mesh *first_input_mesh = src_components[0]->get_for_read();
-  Mesh *new_mesh = BKE_mesh_new_nomain(totverts, totedges, 0, totloops, totpolys);
-  BKE_mesh_copy_parameters_for_eval(new_mesh, first_input_mesh);
-
-  for (const int i : IndexRange(materials.size())) {
-    Material *material = materials[i];
-    BKE_id_material_eval_assign(&new_mesh->id, i + 1, material);
-  }
-
-  new_mesh->runtime.cd_dirty_vert = cd_dirty_vert;
-  new_mesh->runtime.cd_dirty_poly = cd_dirty_poly;
-  new_mesh->runtime.cd_dirty_edge = cd_dirty_edge;
-  new_mesh->runtime.cd_dirty_loop = cd_dirty_loop;
-
-  int vert_offset = 0;
-  int loop_offset = 0;
-  int edge_offset = 0;
-  int poly_offset = 0;
-  for (const MeshComponent *mesh_component : src_components) {
-    const Mesh *mesh = mesh_component->get_for_read();
-    if (mesh == nullptr) {
-      continue;
-    }
-
-    Array<int> material_index_map(mesh->totcol);
-    for (const int i : IndexRange(mesh->totcol)) {
-      Material *material = mesh->mat[i];
-      const int new_material_index = materials.index_of(material);
-      material_index_map[i] = new_material_index;
-    }
-
-    for (const int i : IndexRange(mesh->totvert)) {
-      const MVert &old_vert = mesh->mvert[i];
-      MVert &new_vert = new_mesh->mvert[vert_offset + i];
-      new_vert = old_vert;
-    }
-
-    for (const int i : IndexRange(mesh->totedge)) {
-      const MEdge &old_edge = mesh->medge[i];
-      MEdge &new_edge = new_mesh->medge[edge_offset + i];
-      new_edge = old_edge;
-      new_edge.v1 += vert_offset;
-      new_edge.v2 += vert_offset;
-    }
-    for (const int i : IndexRange(mesh->totloop)) {
-      const MLoop &old_loop = mesh->mloop[i];
-      MLoop &new_loop = new_mesh->mloop[loop_offset + i];
-      new_loop = old_loop;
-      new_loop.v += vert_offset;
-      new_loop.e += edge_offset;
-    }
-    for (const int i : IndexRange(mesh->totpoly)) {
-      const MPoly &old_poly = mesh->mpoly[i];
-      MPoly &new_poly = new_mesh->mpoly[poly_offset + i];
-      new_poly = old_poly;
-      new_poly.loopstart += loop_offset;
-      if (old_poly.mat_nr >= 0 && old_poly.mat_nr < mesh->totcol) {
-        new_poly.mat_nr = material_index_map[new_poly.mat_nr];
-      }
-      else {
-        /* The material index was invalid before. */
-        new_poly.mat_nr = 0;
-      }
-    }
-
-    vert_offset += mesh->totvert;
-    loop_offset += mesh->totloop;
-    edge_offset += mesh->totedge;
-    poly_offset += mesh->totpoly;
-  }
-
-  return new_mesh;
-}
-
+/**
+ * Wrap every component in an instance group with an identity transform, so that the joining
+ * code used for realizing instances can be used.
+ */
 template<typename Component>
-static Array<const GeometryComponent *> to_base_components(Span<const Component *> components)
+static Vector<bke::GeometryInstanceGroup> to_instance_groups(Span<const Component *> components)
 {
-  return components;
+  float4x4 unit_transform;
+  unit_m4(unit_transform.values);
+
+  Vector<bke::GeometryInstanceGroup> set_groups;
+  for (const Component *component : components) {
+    GeometrySet geometry_set;
+    geometry_set.add(*component);
+    set_groups.append({std::move(geometry_set), {unit_transform}});
+  }
+  return set_groups;
 }
 
 static Map<std::string, AttributeMetaData> get_final_attribute_info(
@@ -187,80 +93,31 @@ static Map<std::string, AttributeMetaData> get_final_attribute_info(
   return info;
 }
 
-static void fill_new_attribute(Span<const GeometryComponent *> src_components,
-                               StringRef attribute_name,
-                               const CustomDataType data_type,
-                               const AttributeDomain domain,
-                               GMutableSpan dst_span)
+static void join_components(Span<const MeshComponent *> src_components, GeometrySet &result)
 {
-  const CPPType *cpp_type = bke::custom_data_type_to_cpp_type(data_type);
-  BLI_assert(cpp_type != nullptr);
-
-  int offset = 0;
-  for (const GeometryComponent *component : src_components) {
-    const int domain_size = component->attribute_domain_size(domain);
-    if (domain_size == 0) {
-      continue;
-    }
-    GVArrayPtr read_attribute = component->attribute_get_for_read(
-        attribute_name, domain, data_type, nullptr);
-
-    GVArray_GSpan src_span{*read_attribute};
-    const void *src_buffer = src_span.data();
-    void *dst_buffer = dst_span[offset];
-    cpp_type->copy_assign_n(src_buffer, dst_buffer, domain_size);
-
-    offset += domain_size;
+  bke::join_instance_groups_mesh(to_instance_groups(src_components), false, result);
+  if (result.has_mesh()) {
+    return;
   }
-}
-
-static void join_attributes(Span<const GeometryComponent *> src_components,
-                            GeometryComponent &result,
-                            Span<StringRef> ignored_attributes = {})
-{
-  const Map<std::string, AttributeMetaData> info = get_final_attribute_info(src_components,
-                                                                            ignored_attributes);
-
-  for (const Map<std::string, AttributeMetaData>::Item &item : info.items()) {
-    const StringRef name = item.key;
-    const AttributeMetaData &meta_data = item.value;
-
-    OutputAttribute write_attribute = result.attribute_try_get_for_output_only(
-        name, meta_data.domain, meta_data.data_type);
-    if (!write_attribute) {
-      continue;
+  /* All input meshes are empty. The result is still an empty mesh, with their materials. */
+  Mesh *new_mesh = BKE_mesh_new_nomain(0, 0, 0, 0, 0);
+  BKE_mesh_copy_parameters_for_eval(new_mesh, src_components[0]->get_for_read());
+  VectorSet<Material *> materials;
+  for (const MeshComponent *component : src_components) {
+    const Mesh *mesh = component->get_for_read();
+    for (const int slot_index : IndexRange(mesh->totcol)) {
+      materials.add(mesh->mat[slot_index]);
     }
-    GMutableSpan dst_span = write_attribute.as_span();
-    fill_new_attribute(src_components, name, meta_data.data_type, meta_data.domain, dst_span);
-    write_attribute.save();
   }
-}
-
-static void join_components(Span<const MeshComponent *> src_components, GeometrySet &result)
-{
-  Mesh *new_mesh = join_mesh_topology_and_builtin_attributes(src_components);
-
-  MeshComponent &dst_component = result.get_component_for_write<MeshComponent>();
-  dst_component.replace(new_mesh);
-
-  /* Don't copy attributes that are stored directly in the mesh data structs. */
-  join_attributes(to_base_components(src_components),
-                  dst_component,
-                  {"position", "material_index", "normal", "shade_smooth", "crease"});
+  for (const int i : IndexRange(materials.size())) {
+    BKE_id_material_eval_assign(&new_mesh->id, i + 1, materials[i]);
+  }
+  result.replace_mesh(new_mesh);
 }
 
 static void join_components(Span<const PointCloudComponent *> src_components, GeometrySet &result)
 {
-  int totpoints = 0;
-  for (const PointCloudComponent *pointcloud_component : src_components) {
-    totpoints += pointcloud_component->attribute_domain_size(ATTR_DOMAIN_POINT);
-  }
-
-  PointCloudComponent &dst_component = result.get_component_for_write<PointCloudComponent>();
-  PointCloud *pointcloud = BKE_pointcloud_new_nomain(totpoints);
-  dst_component.replace(pointcloud);
-
-  join_attributes(to_base_components(src_components), dst_component);
+  bke::join_instance_groups_pointcloud(to_instance_groups(src_components), result);
 }
 
 static void join_components(Span<const InstancesComponent *> src_components, GeometrySet &result)
@@ -17,6 +17,7 @@
 #include "BLI_hash.h"
 #include "BLI_kdtree.h"
 #include "BLI_rand.hh"
+#include "BLI_task.hh"
 #include "BLI_timeit.hh"
 
 #include "DNA_mesh_types.h"
@@ -36,6 +37,10 @@
 
 #include "node_geometry_util.hh"
 
+#ifdef WITH_TBB
+#  include <tbb/parallel_sort.h>
+#endif
+
 using blender::bke::AttributeKind;
 using blender::bke::GeometryInstanceGroup;
 
@@ -88,6 +93,17 @@ static Span<MLoopTri> get_mesh_looptris(const Mesh &mesh)
   return {looptris, looptris_len};
 }
 
+static float looptri_density_factor(const MLoopTri &looptri, const VArray<float> *density_factors)
+{
+  if (density_factors == nullptr) {
+    return 1.0f;
+  }
+  const float v0_density_factor = std::max(0.0f, density_factors->get(looptri.tri[0]));
+  const float v1_density_factor = std::max(0.0f, density_factors->get(looptri.tri[1]));
+  const float v2_density_factor = std::max(0.0f, density_factors->get(looptri.tri[2]));
+  return (v0_density_factor + v1_density_factor + v2_density_factor) / 3.0f;
+}
+
 static void sample_mesh_surface(const Mesh &mesh,
                                 const float4x4 &transform,
                                 const float base_density,
@@ -99,44 +115,71 @@ static void sample_mesh_surface(const Mesh &mesh,
 {
   Span<MLoopTri> looptris = get_mesh_looptris(mesh);
 
-  for (const int looptri_index : looptris.index_range()) {
-    const MLoopTri &looptri = looptris[looptri_index];
-    const int v0_loop = looptri.tri[0];
-    const int v1_loop = looptri.tri[1];
-    const int v2_loop = looptri.tri[2];
-    const int v0_index = mesh.mloop[v0_loop].v;
-    const int v1_index = mesh.mloop[v1_loop].v;
-    const int v2_index = mesh.mloop[v2_loop].v;
-    const float3 v0_pos = transform * float3(mesh.mvert[v0_index].co);
-    const float3 v1_pos = transform * float3(mesh.mvert[v1_index].co);
-    const float3 v2_pos = transform * float3(mesh.mvert[v2_index].co);
-
-    float looptri_density_factor = 1.0f;
-    if (density_factors != nullptr) {
-      const float v0_density_factor = std::max(0.0f, density_factors->get(v0_loop));
-      const float v1_density_factor = std::max(0.0f, density_factors->get(v1_loop));
-      const float v2_density_factor = std::max(0.0f, density_factors->get(v2_loop));
-      looptri_density_factor = (v0_density_factor + v1_density_factor + v2_density_factor) / 3.0f;
+  auto get_looptri_positions = [&](const MLoopTri &looptri, float3 r_positions[3]) {
+    for (const int i : IndexRange(3)) {
+      r_positions[i] = transform * float3(mesh.mvert[mesh.mloop[looptri.tri[i]].v].co);
     }
-    const float area = area_tri_v3(v0_pos, v1_pos, v2_pos);
-
-    const int looptri_seed = BLI_hash_int(looptri_index + seed);
-    RandomNumberGenerator looptri_rng(looptri_seed);
-
-    const float points_amount_fl = area * base_density * looptri_density_factor;
-    const float add_point_probability = fractf(points_amount_fl);
-    const bool add_point = add_point_probability > looptri_rng.get_float();
-    const int point_amount = (int)points_amount_fl + (int)add_point;
-
-    for (int i = 0; i < point_amount; i++) {
-      const float3 bary_coord = looptri_rng.get_barycentric_coordinates();
-      float3 point_pos;
-      interp_v3_v3v3v3(point_pos, v0_pos, v1_pos, v2_pos, bary_coord);
-      r_positions.append(point_pos);
-      r_bary_coords.append(bary_coord);
-      r_looptri_indices.append(looptri_index);
+  };
+
+  /* Count the points on every triangle first, so that the points can be generated in parallel.
+   * The random number generator of every triangle only depends on its index and the seed, so the
+   * result does not depend on the number of threads. */
+  Array<int> looptri_offsets(looptris.size() + 1);
+  threading::parallel_for(looptris.index_range(), 2048, [&](IndexRange range) {
+    for (const int looptri_index : range) {
+      const MLoopTri &looptri = looptris[looptri_index];
+      float3 positions[3];
+      get_looptri_positions(looptri, positions);
+      const float area = area_tri_v3(positions[0], positions[1], positions[2]);
+
+      const int looptri_seed = BLI_hash_int(looptri_index + seed);
+      RandomNumberGenerator looptri_rng(looptri_seed);
+
+      const float points_amount_fl = area * base_density *
+                                     looptri_density_factor(looptri, density_factors);
+      const float add_point_probability = fractf(points_amount_fl);
+      const bool add_point = add_point_probability > looptri_rng.get_float();
+      looptri_offsets[looptri_index] = (int)points_amount_fl + (int)add_point;
     }
+  });
+
+  int offset = r_positions.size();
+  for (const int looptri_index : looptris.index_range()) {
+    const int point_amount = looptri_offsets[looptri_index];
+    looptri_offsets[looptri_index] = offset;
+    offset += point_amount;
   }
+  looptri_offsets.last() = offset;
+
+  r_positions.resize(offset);
+  r_bary_coords.resize(offset);
+  r_looptri_indices.resize(offset);
+
+  threading::parallel_for(looptris.index_range(), 2048, [&](IndexRange range) {
+    for (const int looptri_index : range) {
+      const IndexRange points_range(looptri_offsets[looptri_index],
+                                    looptri_offsets[looptri_index + 1] -
+                                        looptri_offsets[looptri_index]);
+      if (points_range.size() == 0) {
+        continue;
+      }
+      const MLoopTri &looptri = looptris[looptri_index];
+      float3 positions[3];
+      get_looptri_positions(looptri, positions);
+
+      const int looptri_seed = BLI_hash_int(looptri_index + seed);
+      RandomNumberGenerator looptri_rng(looptri_seed);
+      /* Skip the number used to decide whether an additional point is added. */
+      looptri_rng.get_float();
+
+      for (const int i : points_range) {
+        const float3 bary_coord = looptri_rng.get_barycentric_coordinates();
+        interp_v3_v3v3v3(r_positions[i], positions[0], positions[1], positions[2], bary_coord);
+        r_bary_coords[i] = bary_coord;
+        r_looptri_indices[i] = looptri_index;
+      }
+    }
+  });
 }
 
 BLI_NOINLINE static KDTree_3d *build_kdtree(Span<Vector<float3>> positions_all,
@@ -155,17 +198,13 @@ BLI_NOINLINE static KDTree_3d *build_kdtree(Span<Vector<float3>> positions_all,
   return kdtree;
 }
 
-BLI_NOINLINE static void update_elimination_mask_for_close_points(
+BLI_NOINLINE static void update_elimination_mask_for_close_points_kdtree(
     Span<Vector<float3>> positions_all,
     Span<int> instance_start_offsets,
     const float minimum_distance,
     MutableSpan<bool> elimination_mask,
     const int initial_points_len)
 {
-  if (minimum_distance <= 0.0f) {
-    return;
-  }
-
   KDTree_3d *kdtree = build_kdtree(positions_all, initial_points_len);
 
   /* The elimination mask is a flattened array for every point,
@@ -201,6 +240,259 @@ BLI_NOINLINE static void update_elimination_mask_for_close_points(
   BLI_kdtree_3d_free(kdtree);
 }
 
+/**
+ * The close points are eliminated using a uniform grid whose cells have the size of the minimum
+ * distance, so only points in neighboring cells have to be checked. The cells are grouped in
+ * tiles of #POISSON_TILE_SIZE cells on each axis. Tiles are far enough apart from the other tiles
+ * with the same coordinate parity that those can be processed in parallel without affecting each
+ * other. Processing the eight parity groups one after another makes the result independent from
+ * the number of threads.
+ *
+ * The grid cells and tiles are encoded in a single key that orders the points by tile first, so
+ * that the points of every cell and tile are contiguous after sorting.
+ *
+ * The points are visited in a different order than the KD-tree elimination, which visits them in
+ * the order they were generated, so a different set of points remains. Nodes from older files
+ * keep using the KD-tree, see #GEO_NODE_POINT_DISTRIBUTE_LEGACY_ORDER.
+ */
+static constexpr int POISSON_TILE_SIZE_BITS = 2;
+static constexpr int POISSON_TILE_SIZE = 1 << POISSON_TILE_SIZE_BITS;
+static constexpr int POISSON_TILE_COORD_BITS = 19;
+static constexpr int POISSON_CELL_COORD_BITS = POISSON_TILE_COORD_BITS + POISSON_TILE_SIZE_BITS;
+static constexpr int POISSON_MAX_CELLS_PER_AXIS = 1 << POISSON_CELL_COORD_BITS;
+
+static uint64_t poisson_cell_key(const int cell[3])
+{
+  uint64_t tile_key = 0;
+  uint64_t local_key = 0;
+  for (int axis = 2; axis >= 0; axis--) {
+    tile_key = (tile_key << POISSON_TILE_COORD_BITS) |
+               (uint64_t)(cell[axis] >> POISSON_TILE_SIZE_BITS);
+    local_key = (local_key << POISSON_TILE_SIZE_BITS) |
+                (uint64_t)(cell[axis] & (POISSON_TILE_SIZE - 1));
+  }
+  return (tile_key << (3 * POISSON_TILE_SIZE_BITS)) | local_key;
+}
+
+static uint64_t poisson_tile_key(const uint64_t cell_key)
+{
+  return cell_key >> (3 * POISSON_TILE_SIZE_BITS);
+}
+
+static void poisson_cell_from_key(const uint64_t cell_key, int r_cell[3])
+{
+  const uint64_t tile_key = poisson_tile_key(cell_key);
+  for (const int axis : IndexRange(3)) {
+    const int tile_coord = (int)(tile_key >> (axis * POISSON_TILE_COORD_BITS)) &
+                           ((1 << POISSON_TILE_COORD_BITS) - 1);
+    const int local_coord = (int)(cell_key >> (axis * POISSON_TILE_SIZE_BITS)) &
+                            (POISSON_TILE_SIZE - 1);
+    r_cell[axis] = (tile_coord << POISSON_TILE_SIZE_BITS) | local_coord;
+  }
+}
+
+/** Index of the group of tiles that can be processed in parallel. */
+static int poisson_tile_parity(const uint64_t tile_key)
+{
+  int parity = 0;
+  for (const int axis : IndexRange(3)) {
+    parity |= (int)((tile_key >> (axis * POISSON_TILE_COORD_BITS)) & 1) << axis;
+  }
+  return parity;
+}
+
+/**
+ * Eliminate the points close to the remaining points in one tile, in the sorted order.
+ * Only the elimination state of points in this tile is read, and only points in this tile and
+ * the directly neighboring tiles are modified.
+ */
+static void eliminate_close_points_in_tile(const IndexRange tile_range,
+                                           Span<uint64_t> sorted_keys,
+                                           Span<float3> sorted_positions,
+                                           const float minimum_distance,
+                                           MutableSpan<bool> sorted_elimination_mask)
+{
+  const float minimum_distance_sq = minimum_distance * minimum_distance;
+  Vector<IndexRange, 27> neighbor_ranges;
+
+  int64_t cell_start = tile_range.start();
+  while (cell_start < tile_range.one_after_last()) {
+    const uint64_t cell_key = sorted_keys[cell_start];
+    int64_t cell_end = cell_start + 1;
+    while (cell_end < tile_range.one_after_last() && sorted_keys[cell_end] == cell_key) {
+      cell_end++;
+    }
+
+    int cell[3];
+    poisson_cell_from_key(cell_key, cell);
+    neighbor_ranges.clear();
+    for (int z = cell[2] - 1; z <= cell[2] + 1; z++) {
+      for (int y = cell[1] - 1; y <= cell[1] + 1; y++) {
+        for (int x = cell[0] - 1; x <= cell[0] + 1; x++) {
+          if (std::min({x, y, z}) < 0 || std::max({x, y, z}) >= POISSON_MAX_CELLS_PER_AXIS) {
+            continue;
+          }
+          const int neighbor_cell[3] = {x, y, z};
+          const uint64_t neighbor_key = poisson_cell_key(neighbor_cell);
+          const uint64_t *begin = std::lower_bound(
+              sorted_keys.begin(), sorted_keys.end(), neighbor_key);
+          const uint64_t *end = std::upper_bound(begin, sorted_keys.end(), neighbor_key);
+          if (begin != end) {
+            neighbor_ranges.append(IndexRange(begin - sorted_keys.begin(), end - begin));
+          }
+        }
+      }
+    }
+
+    for (const int64_t i : IndexRange(cell_start, cell_end - cell_start)) {
+      if (sorted_elimination_mask[i]) {
+        continue;
+      }
+      const float3 position = sorted_positions[i];
+      for (const IndexRange neighbor_range : neighbor_ranges) {
+        for (const int64_t neighbor : neighbor_range) {
+          if (neighbor != i && float3::distance_squared(position, sorted_positions[neighbor]) <=
+                                   minimum_distance_sq) {
+            sorted_elimination_mask[neighbor] = true;
+          }
+        }
+      }
+    }
+    cell_start = cell_end;
+  }
+}
+
+void point_distribute_eliminate_close_points(Span<Vector<float3>> positions_all,
+                                             Span<int> instance_start_offsets,
+                                             const float minimum_distance,
+                                             const bool use_legacy_order,
+                                             MutableSpan<bool> elimination_mask)
+{
+  const int initial_points_len = elimination_mask.size();
+  if (minimum_distance <= 0.0f || initial_points_len == 0) {
+    return;
+  }
+
+  if (use_legacy_order) {
+    update_elimination_mask_for_close_points_kdtree(positions_all,
+                                                    instance_start_offsets,
+                                                    minimum_distance,
+                                                    elimination_mask,
+                                                    initial_points_len);
+    return;
+  }
+
+  float3 min(FLT_MAX, FLT_MAX, FLT_MAX);
+  float3 max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+  for (const Vector<float3> &positions : positions_all) {
+    for (const float3 &position : positions) {
+      minmax_v3v3_v3(min, max, position);
+    }
+  }
+
+  const float3 grid_size = (max - min) / minimum_distance;
+  if (std::max({grid_size.x, grid_size.y, grid_size.z}) >=
+      (float)(POISSON_MAX_CELLS_PER_AXIS - 1)) {
+    /* The grid would be too fine to be encoded in the cell keys. */
+    update_elimination_mask_for_close_points_kdtree(positions_all,
+                                                    instance_start_offsets,
+                                                    minimum_distance,
+                                                    elimination_mask,
+                                                    initial_points_len);
+    return;
+  }
+
+  Array<uint64_t> keys(initial_points_len);
+  threading::parallel_for(positions_all.index_range(), 1, [&](IndexRange instance_range) {
+    for (const int i_instance : instance_range) {
+      Span<float3> positions = positions_all[i_instance];
+      const int offset = instance_start_offsets[i_instance];
+      threading::parallel_for(positions.index_range(), 2048, [&](IndexRange range) {
+        for (const int i : range) {
+          const float3 grid_position = (positions[i] - min) / minimum_distance;
+          const int cell[3] = {(int)grid_position.x, (int)grid_position.y, (int)grid_position.z};
+          keys[offset + i] = poisson_cell_key(cell);
+        }
+      });
+    }
+  });
+
+  /* Sort the points by cell, and keep the original order within a cell. */
+  Array<int> sorted_indices(initial_points_len);
+  threading::parallel_for(sorted_indices.index_range(), 4096, [&](IndexRange range) {
+    for (const int i : range) {
+      sorted_indices[i] = i;
+    }
+  });
+  auto compare_keys = [&](const int a, const int b) {
+    return keys[a] < keys[b] || (keys[a] == keys[b] && a < b);
+  };
+#ifdef WITH_TBB
+  tbb::parallel_sort(sorted_indices.begin(), sorted_indices.end(), compare_keys);
+#else
+  std::sort(sorted_indices.begin(), sorted_indices.end(), compare_keys);
+#endif
+
+  /* Copy the data to the sorted order, so that the points that are close to each other are close
+   * in memory as well. */
+  Array<uint64_t> sorted_keys(initial_points_len);
+  Array<float3> sorted_positions(initial_points_len);
+  Array<bool> sorted_elimination_mask(initial_points_len);
+  threading::parallel_for(sorted_indices.index_range(), 2048, [&](IndexRange range) {
+    for (const int i : range) {
+      sorted_keys[i] = keys[sorted_indices[i]];
+      sorted_elimination_mask[i] = elimination_mask[sorted_indices[i]];
+    }
+  });
+  Array<int> sorted_ranks(initial_points_len);
+  threading::parallel_for(sorted_indices.index_range(), 2048, [&](IndexRange range) {
+    for (const int i : range) {
+      sorted_ranks[sorted_indices[i]] = i;
+    }
+  });
+  threading::parallel_for(positions_all.index_range(), 1, [&](IndexRange instance_range) {
+    for (const int i_instance : instance_range) {
+      Span<float3> positions = positions_all[i_instance];
+      const int offset = instance_start_offsets[i_instance];
+      threading::parallel_for(positions.index_range(), 2048, [&](IndexRange range) {
+        for (const int i : range) {
+          sorted_positions[sorted_ranks[offset + i]] = positions[i];
+        }
+      });
+    }
+  });
+
+  /* Group the tiles by the parity of their coordinates. */
+  std::array<Vector<IndexRange>, 8> tiles_by_parity;
+  int64_t tile_start = 0;
+  for (const int64_t i : sorted_keys.index_range()) {
+    const uint64_t tile_key = poisson_tile_key(sorted_keys[i]);
+    if (i + 1 == sorted_keys.size() || poisson_tile_key(sorted_keys[i + 1]) != tile_key) {
+      tiles_by_parity[poisson_tile_parity(tile_key)].append(
+          IndexRange(tile_start, i + 1 - tile_start));
+      tile_start = i + 1;
+    }
+  }
+
+  for (Span<IndexRange> tiles : tiles_by_parity) {
+    threading::parallel_for(tiles.index_range(), 1, [&](IndexRange range) {
+      for (const int i_tile : range) {
+        eliminate_close_points_in_tile(tiles[i_tile],
+                                       sorted_keys,
+                                       sorted_positions,
+                                       minimum_distance,
+                                       sorted_elimination_mask);
+      }
+    });
+  }
+
+  threading::parallel_for(sorted_indices.index_range(), 2048, [&](IndexRange range) {
+    for (const int i : range) {
+      elimination_mask[sorted_indices[i]] = sorted_elimination_mask[i];
+    }
+  });
+}
+
 BLI_NOINLINE static void update_elimination_mask_based_on_density_factors(
     const Mesh &mesh,
     const VArray<float> &density_factors,
@@ -209,30 +501,33 @@ BLI_NOINLINE static void update_elimination_mask_based_on_density_factors(
     MutableSpan<bool> elimination_mask)
 {
   Span<MLoopTri> looptris = get_mesh_looptris(mesh);
-  for (const int i : bary_coords.index_range()) {
-    if (elimination_mask[i]) {
-      continue;
-    }
+  threading::parallel_for(bary_coords.index_range(), 2048, [&](IndexRange range) {
+    for (const int i : range) {
+      if (elimination_mask[i]) {
+        continue;
+      }
 
-    const MLoopTri &looptri = looptris[looptri_indices[i]];
-    const float3 bary_coord = bary_coords[i];
+      const MLoopTri &looptri = looptris[looptri_indices[i]];
+      const float3 bary_coord = bary_coords[i];
 
-    const int v0_loop = looptri.tri[0];
-    const int v1_loop = looptri.tri[1];
-    const int v2_loop = looptri.tri[2];
+      const int v0_loop = looptri.tri[0];
+      const int v1_loop = looptri.tri[1];
+      const int v2_loop = looptri.tri[2];
 
-    const float v0_density_factor = std::max(0.0f, density_factors[v0_loop]);
-    const float v1_density_factor = std::max(0.0f, density_factors[v1_loop]);
-    const float v2_density_factor = std::max(0.0f, density_factors[v2_loop]);
+      const float v0_density_factor = std::max(0.0f, density_factors[v0_loop]);
+      const float v1_density_factor = std::max(0.0f, density_factors[v1_loop]);
+      const float v2_density_factor = std::max(0.0f, density_factors[v2_loop]);
 
-    const float probablity = v0_density_factor * bary_coord.x + v1_density_factor * bary_coord.y +
-                             v2_density_factor * bary_coord.z;
+      const float probablity = v0_density_factor * bary_coord.x +
+                               v1_density_factor * bary_coord.y +
+                               v2_density_factor * bary_coord.z;
 
-    const float hash = BLI_hash_int_01(bary_coord.hash());
-    if (hash > probablity) {
-      elimination_mask[i] = true;
+      const float hash = BLI_hash_int_01(bary_coord.hash());
+      if (hash > probablity) {
+        elimination_mask[i] = true;
+      }
     }
-  }
+  });
 }
 
 BLI_NOINLINE static void eliminate_points_based_on_mask(Span<bool> elimination_mask,
@@ -467,6 +762,7 @@ static void distribute_points_poisson_disk(Span<GeometryInstanceGroup> set_group
                                            const float density,
                                            const int seed,
                                            const float minimum_distance,
+                                           const bool use_legacy_order,
                                            MutableSpan<Vector<float3>> positions_all,
                                            MutableSpan<Vector<float3>> bary_coords_all,
                                            MutableSpan<Vector<int>> looptri_indices_all)
@@ -500,11 +796,8 @@ static void distribute_points_poisson_disk(Span<GeometryInstanceGroup> set_group
    * point, in order to simplify culling points from the KDTree (which needs to know about all
    * points at once). */
   Array<bool> elimination_mask(initial_points_len, false);
-  update_elimination_mask_for_close_points(positions_all,
-                                           instance_start_offsets,
-                                           minimum_distance,
-                                           elimination_mask,
-                                           initial_points_len);
+  point_distribute_eliminate_close_points(
+      positions_all, instance_start_offsets, minimum_distance, use_legacy_order, elimination_mask);
 
   i_instance = 0;
   for (const GeometryInstanceGroup &set_group : set_groups) {
@@ -600,11 +893,14 @@ static void geo_node_point_distribute_exec(GeoNodeExecParams params)
     }
     case GEO_NODE_POINT_DISTRIBUTE_POISSON: {
       const float minimum_distance = params.extract_input<float>("Distance Min");
+      const bool use_legacy_order = params.node().custom2 &
+                                    GEO_NODE_POINT_DISTRIBUTE_LEGACY_ORDER;
       distribute_points_poisson_disk(set_groups,
                                      density_attribute_name,
                                      density,
                                      seed,
                                      minimum_distance,
+                                     use_legacy_order,
                                      positions_all,
                                      bary_coords_all,
                                      looptri_indices_all);
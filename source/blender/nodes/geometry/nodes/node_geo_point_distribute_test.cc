@@ -0,0 +1,105 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "testing/testing.h"
+
+#include "BLI_array.hh"
+#include "BLI_rand.hh"
+
+#include "node_geometry_util.hh"
+
+namespace blender::nodes::tests {
+
+static Array<bool> eliminate_close_points(Span<Vector<float3>> positions_all,
+                                          const float minimum_distance,
+                                          const bool use_legacy_order)
+{
+  Array<int> instance_start_offsets(positions_all.size());
+  int points_len = 0;
+  for (const int i : positions_all.index_range()) {
+    instance_start_offsets[i] = points_len;
+    points_len += positions_all[i].size();
+  }
+  Array<bool> elimination_mask(points_len, false);
+  point_distribute_eliminate_close_points(
+      positions_all, instance_start_offsets, minimum_distance, use_legacy_order, elimination_mask);
+  return elimination_mask;
+}
+
+static Array<Vector<float3>> create_line_points()
+{
+  Array<Vector<float3>> positions_all(1);
+  for (const float x : {2.4f, 1.8f, 1.2f, 0.6f, 0.0f}) {
+    positions_all[0].append({x, 0.0f, 0.0f});
+  }
+  return positions_all;
+}
+
+TEST(point_distribute_poisson, LegacyOrder)
+{
+  /* Points are visited in the order they were generated. */
+  Array<bool> mask = eliminate_close_points(create_line_points(), 1.0f, true);
+  EXPECT_FALSE(mask[0]);
+  EXPECT_TRUE(mask[1]);
+  EXPECT_FALSE(mask[2]);
+  EXPECT_TRUE(mask[3]);
+  EXPECT_FALSE(mask[4]);
+}
+
+TEST(point_distribute_poisson, GridOrder)
+{
+  /* Points are visited by grid cell, so the point at 0.6 is visited before the one at 0.0. */
+  Array<bool> mask = eliminate_close_points(create_line_points(), 1.0f, false);
+  EXPECT_TRUE(mask[0]);
+  EXPECT_FALSE(mask[1]);
+  EXPECT_TRUE(mask[2]);
+  EXPECT_FALSE(mask[3]);
+  EXPECT_TRUE(mask[4]);
+}
+
+TEST(point_distribute_poisson, MinimumDistance)
+{
+  const float minimum_distance = 0.1f;
+  RandomNumberGenerator rng(42);
+  Array<Vector<float3>> positions_all(3);
+  Vector<float3> points;
+  for (Vector<float3> &positions : positions_all) {
+    for (int i = 0; i < 1000; i++) {
+      positions.append(rng.get_unit_float3() * rng.get_float());
+      points.append(positions.last());
+    }
+  }
+
+  for (const bool use_legacy_order : {true, false}) {
+    Array<bool> mask = eliminate_close_points(positions_all, minimum_distance, use_legacy_order);
+    for (const int i : points.index_range()) {
+      /* Kept points are far from each other, and every eliminated point is close to a kept one. */
+      bool has_close_kept_point = false;
+      for (const int j : points.index_range()) {
+        if (i == j || mask[j]) {
+          continue;
+        }
+        if (float3::distance(points[i], points[j]) <= minimum_distance) {
+          has_close_kept_point = true;
+        }
+      }
+      EXPECT_EQ(has_close_kept_point, mask[i]);
+    }
+  }
+}
+
+}  // namespace blender::nodes::tests
@@ -25,6 +25,7 @@
 #include "DNA_volume_types.h"
 
 #include "BKE_mesh.h"
+#include "BKE_pointcloud.h"
 #include "BKE_spline.hh"
 #include "BKE_volume.h"
 
@@ -96,6 +97,7 @@ static void transform_pointcloud(PointCloud *pointcloud,
       co = matrix * co;
     }
   }
+  BKE_pointcloud_tag_positions_changed(pointcloud);
 }
 
 static void transform_instances(InstancesComponent &instances,
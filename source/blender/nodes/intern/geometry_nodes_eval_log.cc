@@ -54,6 +54,13 @@ ModifierLog::ModifierLog(GeoLogger &logger)
                                                        node_with_warning.node);
       node_log.warnings_.append(node_with_warning.warning);
     }
+
+    for (NodeWithExecutionTime &node_with_exec_time : local_logger.node_exec_times_) {
+      NodeLog &node_log = this->lookup_or_add_node_log(log_by_tree_context,
+                                                       node_with_exec_time.node);
+      node_log.exec_time_ += node_with_exec_time.exec_time;
+      node_log.exec_count_++;
+    }
   }
 }
 
@@ -129,6 +136,18 @@ const TreeLog *TreeLog::lookup_child_log(StringRef node_name) const
   return tree_log->get();
 }
 
+std::chrono::microseconds TreeLog::execution_time() const
+{
+  std::chrono::microseconds exec_time{0};
+  for (const destruct_ptr<NodeLog> &node_log : node_logs_.values()) {
+    exec_time += node_log->execution_time();
+  }
+  for (const destruct_ptr<TreeLog> &child_log : child_logs_.values()) {
+    exec_time += child_log->execution_time();
+  }
+  return exec_time;
+}
+
 void TreeLog::foreach_node_log(FunctionRef<void(const NodeLog &)> fn) const
 {
   for (auto node_log : node_logs_.items()) {
@@ -376,4 +395,9 @@ void LocalGeoLogger::log_node_warning(DNode node, NodeWarningType type, std::str
   node_warnings_.append({node, {type, std::move(message)}});
 }
 
+void LocalGeoLogger::log_execution_time(DNode node, std::chrono::microseconds exec_time)
+{
+  node_exec_times_.append({node, exec_time});
+}
+
 }  // namespace blender::nodes::geometry_nodes_eval_log
@@ -30,6 +30,7 @@ namespace blender::nodes {
 
 void GeoNodeExecParams::error_message_add(const NodeWarningType type, std::string message) const
 {
+  provider_->has_reported_warning = true;
   if (provider_->logger == nullptr) {
     return;
   }
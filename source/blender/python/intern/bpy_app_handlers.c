@@ -40,6 +40,7 @@ void bpy_app_generic_callback(struct Main *main,
                               struct PointerRNA **pointers,
                               const int num_pointers,
                               void *arg);
+static bool bpy_app_generic_callback_poll(void *arg);
 
 static PyTypeObject BlenderAppCbType;
 
@@ -247,6 +248,7 @@ PyObject *BPY_app_handlers_struct(void)
     for (pos = 0; pos < BKE_CB_EVT_TOT; pos++) {
       funcstore = &funcstore_array[pos];
       funcstore->func = bpy_app_generic_callback;
+      funcstore->poll = bpy_app_generic_callback_poll;
       funcstore->alloc = 0;
       funcstore->arg = POINTER_FROM_INT(pos);
       BKE_callback_add(funcstore, pos);
@@ -314,6 +316,12 @@ static PyObject *choose_arguments(PyObject *func, PyObject *args_all, PyObject *
   return args_all;
 }
 
+static bool bpy_app_generic_callback_poll(void *arg)
+{
+  PyObject *cb_list = py_cb_array[POINTER_AS_INT(arg)];
+  return PyList_GET_SIZE(cb_list) > 0;
+}
+
 /* the actual callback - not necessarily called from py */
 void bpy_app_generic_callback(struct Main *UNUSED(main),
                               struct PointerRNA **pointers,
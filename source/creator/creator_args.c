@@ -589,6 +589,7 @@ static int arg_handle_print_help(int UNUSED(argc), const char **UNUSED(argv), vo
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-time");
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-pretty");
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-uuid");
+  BLI_args_print_arg_doc(ba, "--debug-depsgraph-trace");
   BLI_args_print_arg_doc(ba, "--debug-ghost");
   BLI_args_print_arg_doc(ba, "--debug-gpu");
   BLI_args_print_arg_doc(ba, "--debug-gpu-force-workarounds");
@@ -1006,6 +1007,23 @@ static int arg_handle_debug_mode_generic_set(int UNUSED(argc),
   return 0;
 }
 
+static const char arg_handle_debug_depsgraph_trace_doc[] =
+    "<filename>\n"
+    "\tRecord timeline of dependency graph evaluation and write it to a file on exit.\n"
+    "\tFiles with '.csv' extension are written as comma separated values,\n"
+    "\tall other files are written in Chrome trace JSON format.";
+static int arg_handle_debug_depsgraph_trace(int argc, const char **argv, void *UNUSED(data))
+{
+  const char *arg_id = "--debug-depsgraph-trace";
+  if (argc > 1) {
+    DEG_debug_trace_output_set(argv[1]);
+    DEG_debug_trace_start(0);
+    return 1;
+  }
+  printf("\nError: '%s' no args given.\n", arg_id);
+  return 0;
+}
+
 static const char arg_handle_debug_mode_io_doc[] =
     "\n\t"
     "Enable debug messages for I/O (Collada, ...).";
@@ -2199,6 +2217,8 @@ void main_args_setup(bContext *C, bArgs *ba)
                "--debug-depsgraph-uuid",
                CB_EX(arg_handle_debug_mode_generic_set, depsgraph_build),
                (void *)G_DEBUG_DEPSGRAPH_UUID);
+  BLI_args_add(
+      ba, NULL, "--debug-depsgraph-trace", CB(arg_handle_debug_depsgraph_trace), NULL);
   BLI_args_add(ba,
                NULL,
                "--debug-gpu-force-workarounds",